@@ -0,0 +1,438 @@
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark do enlace BLE - lado cliente (central)
+// Conecta ao `ble_bench_server` com os parâmetros do benchmark, assina a
+// característica de cargas sintéticas (server/lib/ble_bench) e informa, a cada
+// segundo, vazão, perda de pacotes e latência das notificações. Com
+// BENCH_DURATION_S, encerra após o tempo pedido com uma linha de
+// resultado (no build de host, o processo termina).
+////////////////////////////////////////////////////////////////////////////////
+
+// Tag deste módulo nos logs (ver `log_set_tag_level`).
+#define LOG_TAG "BENCH_CLI"
+
+#include "btstack.h"
+#include "pico/cyw43_arch.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+
+#include "log_vt100.h"
+#include "link_profile.h"
+#include "latency_hist.h"
+#include "latency_offset.h"
+#include "ble_bench.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Parâmetros do benchmark (definidos pelo CMake).
+// Maior ATT MTU pedido na troca de MTU.
+#ifndef BENCH_MTU
+#define BENCH_MTU 247U
+#endif
+// PHY pedido (LINK_PHY_1M, LINK_PHY_2M ou LINK_PHY_CODED).
+#ifndef BENCH_PHY
+#define BENCH_PHY LINK_PHY_2M
+#endif
+// Intervalo de conexão, em unidades de 1,25 ms.
+#ifndef BENCH_CONN_INTERVAL
+#define BENCH_CONN_INTERVAL 6U
+#endif
+// Duração da medição em segundos, contada da primeira notificação; 0
+// mede sem parar.
+#ifndef BENCH_DURATION_S
+#define BENCH_DURATION_S 0U
+#endif
+
+// Relógio comum a servidor e cliente (ver CLIENT_SHARED_CLOCK em
+// bt_client_setup.cpp): no host a latência é absoluta; no Pico W, medida
+// em relação à menor diferença entre os relógios já observada.
+#ifndef BENCH_SHARED_CLOCK
+#if PICO_NO_HARDWARE
+#define BENCH_SHARED_CLOCK 1
+#else
+#define BENCH_SHARED_CLOCK 0
+#endif
+#endif
+
+// Período do relatório no log, em milissegundos.
+#define BENCH_REPORT_PERIOD_MS 1000U
+
+// Supervisão da conexão, em unidades de 10 ms (4 s).
+#define BENCH_SUPERVISION_TIMEOUT 400U
+
+// Tag dos logs internos da BTstack e seu nível inicial (só avisos e erros).
+#define BTSTACK_LOG_TAG "BTSTACK"
+#define BTSTACK_LOG_LEVEL LOG_LEVEL_WARN
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    BENCH_IDLE,
+    BENCH_W4_SCAN_RESULT,
+    BENCH_W4_CONNECT,
+    BENCH_W4_MTU_EXCHANGE,
+    BENCH_W4_SERVICE_RESULT,
+    BENCH_W4_CHARACTERISTIC_RESULT,
+    BENCH_W4_ENABLE_NOTIFICATIONS,
+    BENCH_STREAMING,
+    BENCH_DONE,
+} bench_state_t;
+
+static const uint8_t bench_service_uuid128[16] = { BLE_BENCH_SERVICE_UUID128 };
+static const uint8_t bench_stream_uuid128[16] = { BLE_BENCH_STREAM_UUID128 };
+
+static bench_state_t state = BENCH_IDLE;
+static hci_con_handle_t con_handle = HCI_CON_HANDLE_INVALID;
+static gatt_client_service_t service;
+static gatt_client_characteristic_t characteristic;
+static bool characteristic_found;
+static gatt_client_notification_t notification_listener;
+static uint16_t mtu = ATT_DEFAULT_MTU;
+static uint8_t rx_phy = LINK_PHY_1M;
+static uint16_t max_rx_octets = LINK_DEFAULT_OCTETS;
+static uint16_t conn_interval;
+
+// Contadores desde a primeira notificação e seus valores no último
+// relatório; latências da janela do relatório e da medição inteira.
+static ble_bench_rx_t rx;
+static ble_bench_rx_t last_report;
+static latency_hist_t window_hist;
+static latency_hist_t total_hist;
+static latency_offset_t clock_offset;
+static uint32_t first_notification_us;
+static uint32_t last_report_us;
+
+static btstack_timer_source_t report_timer;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Perda em centésimos de ponto percentual (ex.: 125 = 1,25%).
+static uint32_t loss_basis_points(uint32_t lost, uint32_t received) {
+    uint32_t total = lost + received;
+    return total ? (uint32_t)((uint64_t)lost * 10000U / total) : 0;
+}
+
+// Latência de uma carga: direta com relógio comum; senão, relativa à
+// menor diferença observada entre os relógios (ver `latency_offset.h`).
+static void record_latency(uint32_t sent_us, uint32_t now_us) {
+    uint32_t latency_us;
+    if (BENCH_SHARED_CLOCK) {
+        int32_t raw_us = (int32_t)(now_us - sent_us);
+        latency_us = (raw_us > 0) ? (uint32_t)raw_us : 0;
+    } else {
+        latency_us = latency_offset_apply(&clock_offset, sent_us, now_us);
+    }
+    latency_hist_record(&window_hist, latency_us);
+    latency_hist_record(&total_hist, latency_us);
+}
+
+// Resultado final, numa linha "chave=valor" própria para comparar
+// execuções (regressões).
+static void report_result(void) {
+    uint32_t elapsed_us = time_us_32() - first_notification_us;
+    LOG_INFO("RESULT duration_ms=%u kbps=%u pps=%u received=%u lost=%u loss_bp=%u reordered=%u corrupted=%u lat_p50_us=%u lat_p99_us=%u lat_max_us=%u mtu=%u phy=%s pdu=%u interval_us=%u",
+             (unsigned)(elapsed_us / 1000U),
+             (unsigned)(elapsed_us ? (uint64_t)rx.bytes * 8000U / elapsed_us : 0),
+             (unsigned)(elapsed_us ? (uint64_t)rx.received * 1000000U / elapsed_us : 0),
+             (unsigned)rx.received, (unsigned)rx.lost, (unsigned)loss_basis_points(rx.lost, rx.received),
+             (unsigned)rx.reordered, (unsigned)rx.corrupted,
+             (unsigned)latency_hist_percentile(&total_hist, 500), (unsigned)latency_hist_percentile(&total_hist, 990),
+             (unsigned)total_hist.max_us, mtu, link_phy_name(rx_phy), max_rx_octets,
+             (unsigned)LINK_INTERVAL_US(conn_interval));
+}
+
+// Relatório periódico: uma linha "chave=valor" por segundo.
+static void report_handler(btstack_timer_source_t *ts) {
+    uint32_t now_us = time_us_32();
+    uint32_t elapsed_us = now_us - last_report_us;
+    if (state == BENCH_STREAMING && rx.received > 0 && elapsed_us > 0) {
+        uint32_t received = rx.received - last_report.received;
+        uint32_t lost = rx.lost - last_report.lost;
+        LOG_INFO("t=%us kbps=%u pps=%u lost=%u loss_bp=%u corrupted=%u lat_p50_us=%u lat_p99_us=%u lat_max_us=%u",
+                 (unsigned)((now_us - first_notification_us) / 1000000U),
+                 (unsigned)((uint64_t)(rx.bytes - last_report.bytes) * 8000U / elapsed_us),
+                 (unsigned)((uint64_t)received * 1000000U / elapsed_us),
+                 (unsigned)lost, (unsigned)loss_basis_points(lost, received),
+                 (unsigned)(rx.corrupted - last_report.corrupted),
+                 (unsigned)latency_hist_percentile(&window_hist, 500), (unsigned)latency_hist_percentile(&window_hist, 990),
+                 (unsigned)window_hist.max_us);
+        if (BENCH_DURATION_S > 0 && now_us - first_notification_us >= BENCH_DURATION_S * 1000000U) {
+            report_result();
+            state = BENCH_DONE;
+            gap_disconnect(con_handle);
+        }
+    }
+    last_report = rx;
+    last_report_us = now_us;
+    latency_hist_reset(&window_hist);
+    btstack_run_loop_set_timer(ts, BENCH_REPORT_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+// Recepção de uma carga.
+static void handle_notification(const uint8_t *value, uint16_t length) {
+    uint32_t now_us = time_us_32();
+    uint32_t seq, sent_us;
+    if (ble_bench_parse(value, length, &seq, &sent_us) != 0) {
+        rx.corrupted++;
+        return;
+    }
+    if (rx.received == 0) {
+        first_notification_us = last_report_us = now_us;
+        last_report = rx;
+    }
+    ble_bench_rx_record(&rx, seq, length);
+    record_latency(sent_us, now_us);
+}
+
+// Handler dos eventos do cliente GATT: MTU, descoberta, assinatura e
+// notificações.
+static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(size);
+    uint8_t event_type = hci_event_packet_get_type(packet);
+
+    if (event_type == GATT_EVENT_NOTIFICATION) {
+        if (state == BENCH_STREAMING) {
+            handle_notification(gatt_event_notification_get_value(packet), gatt_event_notification_get_value_length(packet));
+        }
+        return;
+    }
+
+    switch (state) {
+        case BENCH_W4_MTU_EXCHANGE:
+            if (event_type != GATT_EVENT_MTU) break;
+            mtu = gatt_event_mtu_get_MTU(packet);
+            LOG_INFO("ATT MTU negociado: %u bytes", mtu);
+            state = BENCH_W4_SERVICE_RESULT;
+            gatt_client_discover_primary_services_by_uuid128(handle_gatt_client_event, con_handle, bench_service_uuid128);
+            break;
+        case BENCH_W4_SERVICE_RESULT:
+            if (event_type == GATT_EVENT_SERVICE_QUERY_RESULT) {
+                gatt_event_service_query_result_get_service(packet, &service);
+                break;
+            }
+            if (event_type != GATT_EVENT_QUERY_COMPLETE) break;
+            if (gatt_event_query_complete_get_att_status(packet) != ATT_ERROR_SUCCESS) {
+                LOG_WARN("Serviço de benchmark não encontrado");
+                gap_disconnect(con_handle);
+                break;
+            }
+            characteristic_found = false;
+            state = BENCH_W4_CHARACTERISTIC_RESULT;
+            gatt_client_discover_characteristics_for_service_by_uuid128(handle_gatt_client_event, con_handle, &service, bench_stream_uuid128);
+            break;
+        case BENCH_W4_CHARACTERISTIC_RESULT:
+            if (event_type == GATT_EVENT_CHARACTERISTIC_QUERY_RESULT) {
+                gatt_event_characteristic_query_result_get_characteristic(packet, &characteristic);
+                characteristic_found = true;
+                break;
+            }
+            if (event_type != GATT_EVENT_QUERY_COMPLETE) break;
+            if (!characteristic_found) {
+                LOG_WARN("Característica de benchmark não encontrada");
+                gap_disconnect(con_handle);
+                break;
+            }
+            state = BENCH_W4_ENABLE_NOTIFICATIONS;
+            gatt_client_listen_for_characteristic_value_updates(&notification_listener, handle_gatt_client_event, con_handle, &characteristic);
+            gatt_client_write_client_characteristic_configuration(handle_gatt_client_event, con_handle, &characteristic,
+                                                                  GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+            break;
+        case BENCH_W4_ENABLE_NOTIFICATIONS:
+            if (event_type != GATT_EVENT_QUERY_COMPLETE) break;
+            if (gatt_event_query_complete_get_att_status(packet) != ATT_ERROR_SUCCESS) {
+                LOG_WARN("Falha ao assinar as notificações");
+                gap_disconnect(con_handle);
+                break;
+            }
+            ble_bench_rx_reset(&rx);
+            latency_hist_reset(&window_hist);
+            latency_hist_reset(&total_hist);
+            latency_offset_reset(&clock_offset);
+            state = BENCH_STREAMING;
+            LOG_INFO("Notificações assinadas; medindo%s", BENCH_SHARED_CLOCK ? "" : " (latência relativa à menor observada)");
+            break;
+        default:
+            break;
+    }
+}
+
+// Procura o UUID do serviço de benchmark no anúncio.
+static bool advertisement_has_bench_service(const uint8_t *adv_data, uint8_t adv_len) {
+    ad_context_t context;
+    for (ad_iterator_init(&context, adv_len, adv_data); ad_iterator_has_more(&context); ad_iterator_next(&context)) {
+        uint8_t data_type = ad_iterator_get_data_type(&context);
+        if (data_type != BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS &&
+            data_type != BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS) continue;
+        const uint8_t *data = ad_iterator_get_data(&context);
+        uint8_t data_len = ad_iterator_get_data_len(&context);
+        for (uint8_t i = 0; i + 16 <= data_len; i += 16) {
+            uint8_t uuid128[16];
+            reverse_128(&data[i], uuid128);
+            if (memcmp(uuid128, bench_service_uuid128, 16) == 0) return true;
+        }
+    }
+    return false;
+}
+
+static void start_scan(void) {
+    LOG_INFO("Procurando o servidor de benchmark...");
+    state = BENCH_W4_SCAN_RESULT;
+    gap_set_scan_parameters(0, 0x0030, 0x0030);
+    gap_start_scan();
+}
+
+// Handler de eventos HCI: scan, conexão, parâmetros do enlace e
+// desconexão.
+static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING && state == BENCH_IDLE) start_scan();
+            break;
+        case GAP_EVENT_ADVERTISING_REPORT: {
+            if (state != BENCH_W4_SCAN_RESULT) break;
+            if (!advertisement_has_bench_service(gap_event_advertising_report_get_data(packet),
+                                                 gap_event_advertising_report_get_data_length(packet))) break;
+            bd_addr_t addr;
+            gap_event_advertising_report_get_address(packet, addr);
+            LOG_INFO("Servidor de benchmark encontrado: %s", bd_addr_to_str(addr));
+            gap_stop_scan();
+            state = BENCH_W4_CONNECT;
+            gap_connect(addr, static_cast<bd_addr_type_t>(gap_event_advertising_report_get_address_type(packet)));
+            break;}
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)) {
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    if (state != BENCH_W4_CONNECT) break;
+                    if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                        start_scan();
+                        break;
+                    }
+                    con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+                    mtu = ATT_DEFAULT_MTU;
+                    rx_phy = LINK_PHY_1M;
+                    max_rx_octets = LINK_DEFAULT_OCTETS;
+                    LOG_INFO("Conectado (intervalo %u us); pedindo PHY %s e negociando ATT MTU",
+                             (unsigned)LINK_INTERVAL_US(conn_interval), link_phy_name(BENCH_PHY));
+                    gap_le_set_phy(con_handle, 0, LINK_PHY_MASK(BENCH_PHY), LINK_PHY_MASK(BENCH_PHY), 0);
+                    state = BENCH_W4_MTU_EXCHANGE;
+                    gatt_client_send_mtu_negotiation(handle_gatt_client_event, con_handle);
+                    break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    if (hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                    conn_interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                    LOG_INFO("Intervalo de conexão: %u us", (unsigned)LINK_INTERVAL_US(conn_interval));
+                    break;
+                case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE:
+                    if (hci_subevent_le_phy_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                        LOG_WARN("PHY %s recusado, segue em %s", link_phy_name(BENCH_PHY), link_phy_name(rx_phy));
+                        break;
+                    }
+                    rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+                    LOG_INFO("PHY TX %s, RX %s", link_phy_name(hci_subevent_le_phy_update_complete_get_tx_phy(packet)), link_phy_name(rx_phy));
+                    break;
+                case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+                    max_rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+                    LOG_INFO("PDUs de dados de até %u bytes (RX)", max_rx_octets);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            con_handle = HCI_CON_HANDLE_INVALID;
+            if (state == BENCH_DONE) {
+                LOG_INFO("Medição concluída");
+#if PICO_NO_HARDWARE
+                btstack_run_loop_trigger_exit();
+#endif
+                break;
+            }
+            LOG_WARN("Desconectado (motivo 0x%02X)", hci_event_disconnection_complete_get_reason(packet));
+            if (state == BENCH_STREAMING && rx.received > 0) report_result();
+            start_scan();
+            break;
+        default:
+            break;
+    }
+}
+
+// Encaminha os logs internos da BTstack para o log_vt100 (tag "BTSTACK").
+static log_site_t btstack_log_site = LOG_SITE_INIT(BTSTACK_LOG_TAG, "BTstack");
+
+static void btstack_log_reset(void) {
+}
+
+static void btstack_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    UNUSED(packet_type);
+    UNUSED(in);
+    UNUSED(packet);
+    UNUSED(len);
+}
+
+static void btstack_log_message(int log_level, const char * format, va_list argptr) {
+    log_level_t level = LOG_LEVEL_DEBUG;
+    if (log_level == HCI_DUMP_LOG_LEVEL_INFO) level = LOG_LEVEL_INFO;
+    if (log_level == HCI_DUMP_LOG_LEVEL_ERROR) level = LOG_LEVEL_WARN;
+    if (!log_site_check(&btstack_log_site, level)) return;
+    log_vwrite_tagged(level, BTSTACK_LOG_TAG, format, argptr);
+}
+
+static const hci_dump_t btstack_log_dump = {
+    &btstack_log_reset,
+    &btstack_log_packet,
+    &btstack_log_message,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+    stdio_init_all();
+    log_set_level(LOG_LEVEL_INFO);
+
+    LOG_INFO("Benchmark BLE (cliente): MTU %u, PHY %s, intervalo %u us, duração %u s",
+             BENCH_MTU, link_phy_name(BENCH_PHY), (unsigned)LINK_INTERVAL_US(BENCH_CONN_INTERVAL), BENCH_DURATION_S);
+
+    if (cyw43_arch_init()) {
+        LOG_WARN("Falha ao inicializar cyw43_arch");
+        return -1;
+    }
+    log_set_tag_level(BTSTACK_LOG_TAG, BTSTACK_LOG_LEVEL);
+    hci_dump_init(&btstack_log_dump);
+
+    l2cap_init();
+    l2cap_set_max_le_mtu(BENCH_MTU);
+    sm_init();
+    sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    gatt_client_init();
+    gatt_client_mtu_enable_auto_negotiation(0);
+
+    // Cada conexão já nasce com o intervalo do benchmark.
+    gap_set_connection_parameters(0x0060, 0x0030, BENCH_CONN_INTERVAL, BENCH_CONN_INTERVAL,
+                                  0, BENCH_SUPERVISION_TIMEOUT, 0, 0);
+
+    hci_event_callback_registration.callback = &hci_event_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    report_timer.process = &report_handler;
+    btstack_run_loop_set_timer(&report_timer, BENCH_REPORT_PERIOD_MS);
+    btstack_run_loop_add_timer(&report_timer);
+
+    hci_power_control(HCI_POWER_ON);
+    btstack_run_loop_execute();
+
+    // Só no build de host, depois de BENCH_DURATION_S: falha se nada
+    // chegou, para scripts de regressão.
+    return (rx.received > 0) ? 0 : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// End of file
+////////////////////////////////////////////////////////////////////////////////
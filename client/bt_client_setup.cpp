@@ -1,17 +1,127 @@
+// Tag deste módulo nos logs (ver `log_set_tag_level`).
+#define LOG_TAG "GATT_CLI"
+
 #include "btstack.h"
 #include "pico/cyw43_arch.h"
+#include "pico/time.h"
+#include "client_profile.h"
 
 #include "log_vt100.h"
+#include "sample_packet.h"
+#include "latency_hist.h"
+#include "latency_offset.h"
+#include "sample_broadcast.h"
+#include "sample_backlog.h"
+#include "time_sync.h"
 #include "bt_client_setup.h"
 
-// Máquina de estados do cliente GATT ("Temperature Client").
-// Cada valor representa uma fase do ciclo de vida da conexão BLE:
-//  - TC_OFF: pilha/desconectado, sem operação ativa;
-//  - TC_IDLE: reservado para estado ocioso (não utilizado neste exemplo);
-//  - TC_W4_SCAN_RESULT: aguardando resultados de varredura (scan) de anúncios;
+// Modo de recepção em lote (característica "Sample Stream").
+// 1: procura a característica de lotes e recorre à de temperatura apenas
+//    se o servidor não a oferecer; 0: usa sempre a característica de
+//    temperatura (uma amostra por notificação).
+#ifndef CLIENT_SAMPLE_BATCHING
+#define CLIENT_SAMPLE_BATCHING 1
+#endif
+
+// Relógio comum a servidor e cliente. No build de host os dois processos
+// leem o mesmo relógio monotônico, e a latência é medida diretamente; no
+// Pico W cada placa tem seu relógio, e a latência é medida com a
+// sincronização de relógios ou, sem ela, em relação à menor diferença já
+// observada (ver `record_latency`).
+#ifndef CLIENT_SHARED_CLOCK
+#if PICO_NO_HARDWARE
+#define CLIENT_SHARED_CLOCK 1
+#else
+#define CLIENT_SHARED_CLOCK 0
+#endif
+#endif
+
+// Sincronização com o relógio de cada servidor (característica "Time
+// Sync", ver lib/sample_stream/time_sync.h): intervalo, em milissegundos,
+// entre rodadas de trocas; 0 desliga. Com ela, o instante de captura das
+// amostras é traduzido para o relógio do cliente, e a latência deixa de
+// ser relativa à menor diferença observada.
+#ifndef CLIENT_TIME_SYNC_PERIOD_MS
+#define CLIENT_TIME_SYNC_PERIOD_MS 5000
+#endif
+
+// Nova tentativa de uma troca com o cliente GATT ocupado, em milissegundos.
+#define TIME_SYNC_RETRY_MS 50
+
+// Intervalo, em microssegundos, entre relatórios de latência no log.
+#define LATENCY_REPORT_PERIOD_US 10000000U
+
+// Handle da característica "Latency Stats" na base ATT do próprio
+// cliente (`client_profile.gatt`) e tamanho do seu valor.
+#define LATENCY_STATS_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0002_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define LATENCY_STATS_SIZE 28
+
+// Tag dos logs internos da BTstack e seu nível inicial (só avisos e erros).
+#define BTSTACK_LOG_TAG "BTSTACK"
+#define BTSTACK_LOG_LEVEL LOG_LEVEL_WARN
+
+// Tempo máximo, em milissegundos, de uma tentativa de conexão: se o
+// periférico sumir depois do anúncio, a tentativa é cancelada e o
+// próximo candidato (ou um novo scan) assume.
+#define CLIENT_CONNECT_TIMEOUT_MS 5000
+
+// Reconexão rápida: o endereço de cada servidor e os handles GATT
+// descobertos (característica de dados, seu CCCD e ponto de controle)
+// ficam guardados no banco TLV da BTstack (flash), um registro por
+// origem. 1: reconecta direto ao último endereço e pula a descoberta
+// quando há handles guardados; 0: sempre scan e descoberta completa.
+#ifndef CLIENT_FAST_RECONNECT
+#define CLIENT_FAST_RECONNECT 1
+#endif
+
+// Modo broadcast (definido pelo CMake): o cliente nunca conecta; em scan
+// passivo contínuo, extrai as amostras dos anúncios dos servidores em
+// SERVER_BROADCAST (ver lib/sample_stream/sample_broadcast.h). Cada
+// anunciante ocupa uma origem, até CLIENT_MAX_SERVERS.
+#ifndef CLIENT_BROADCAST
+#define CLIENT_BROADCAST 0
+#endif
+
+// Download do registro em flash do servidor (característica "Sample
+// Backlog", ver lib/sample_stream/sample_backlog.h). 1: antes de assinar
+// os lotes, baixa as amostras que o servidor gravou enquanto ninguém as
+// recebia, e o fluxo ao vivo continua de onde o download parou; 0: só o
+// fluxo ao vivo. Servidores sem a característica seguem direto.
+#ifndef CLIENT_BACKLOG
+#define CLIENT_BACKLOG 1
+#endif
+
+// Tag TLV do registro da origem `i` ("CSC" + origem).
+#define SERVER_CACHE_TAG(i) (((uint32_t)'C' << 24) | ((uint32_t)'S' << 16) | ((uint32_t)'C' << 8) | (uint32_t)(i))
+// Registro válido / servidor com característica de lotes / com
+// Database Hash.
+#define SERVER_CACHE_FLAG_VALID   0x01
+#define SERVER_CACHE_FLAG_BATCHES 0x02
+#define SERVER_CACHE_FLAG_HASH    0x04
+#define DATABASE_HASH_SIZE 16
+
+// Máquina de estados do cliente GATT ("Temperature Client"), uma por
+// periférico (sessão). Cada valor representa uma fase do ciclo de vida
+// da conexão BLE:
+//  - TC_OFF: sessão livre, sem operação ativa;
+//  - TC_IDLE: periférico encontrado no scan, aguardando a sua vez de
+//    conectar (o controlador cria uma conexão por vez);
+//  - TC_W4_SCAN_RESULT: reservado (o scan é único para todas as sessões);
 //  - TC_W4_CONNECT: aguardando conclusão da tentativa de conexão LE;
+//  - TC_W4_MTU_EXCHANGE: aguardando a negociação do ATT MTU;
+//  - TC_W4_DATABASE_HASH: aguardando a leitura do Database Hash do
+//    servidor, que valida os handles guardados;
 //  - TC_W4_SERVICE_RESULT: aguardando resultado da descoberta de serviço GATT;
+//  - TC_W4_CONTROL_CHARACTERISTIC_RESULT: aguardando descoberta do ponto
+//    de controle ("Sample Control"), opcional;
+//  - TC_W4_STREAM_CHARACTERISTIC_RESULT: aguardando descoberta da
+//    característica de lotes ("Sample Stream");
 //  - TC_W4_CHARACTERISTIC_RESULT: aguardando descoberta de característica;
+//  - TC_W4_BACKLOG_CHARACTERISTIC_RESULT: aguardando descoberta da
+//    característica do registro em flash ("Sample Backlog"), opcional;
+//  - TC_W4_CCCD_RESULT: aguardando descoberta do CCCD da característica;
+//  - TC_W4_BACKLOG_END: baixando o registro em flash, até a mensagem de
+//    fim (e a confirmação da escrita no CCCD que o pediu);
 //  - TC_W4_ENABLE_NOTIFICATIONS_COMPLETE: aguardando conclusão da escrita
 //    da configuração de notificação na característica (Client Characteristic Configuration);
 //  - TC_W4_READY: pronto para receber notificações do servidor.
@@ -20,49 +130,507 @@ typedef enum {
     TC_IDLE,
     TC_W4_SCAN_RESULT,
     TC_W4_CONNECT,
+    TC_W4_MTU_EXCHANGE,
+    TC_W4_DATABASE_HASH,
     TC_W4_SERVICE_RESULT,
+    TC_W4_CONTROL_CHARACTERISTIC_RESULT,
+    TC_W4_STREAM_CHARACTERISTIC_RESULT,
     TC_W4_CHARACTERISTIC_RESULT,
+    TC_W4_BACKLOG_CHARACTERISTIC_RESULT,
+    TC_W4_CCCD_RESULT,
+    TC_W4_BACKLOG_END,
     TC_W4_ENABLE_NOTIFICATIONS_COMPLETE,
     TC_W4_READY
 } gc_state_t;
 
+// Estado de cada periférico (servidor) conectado ou em conexão: máquina
+// de estados, endereço, conexão, características descobertas, listener
+// de notificações e estatísticas do fluxo. O índice na tabela é a origem
+// (`source`) informada à aplicação junto de cada valor.
+typedef struct {
+    // Estado atual da máquina de estados desta sessão.
+    gc_state_t state;
+    // Endereço Bluetooth LE do servidor e tipo de endereço.
+    bd_addr_t addr;
+    bd_addr_type_t addr_type;
+    // Handle da conexão HCI.
+    hci_con_handle_t connection_handle;
+    // Serviço GATT descoberto no servidor.
+    gatt_client_service_t service;
+    // Característica GATT utilizada para receber dados e handle do seu
+    // CCCD (0 = ainda não descoberto).
+    gatt_client_characteristic_t characteristic;
+    uint16_t cccd_handle;
+    // Conexão usando os handles guardados (`server_cache`), sem descoberta.
+    bool cached;
+    // Database Hash lido do servidor nesta conexão.
+    uint8_t database_hash[DATABASE_HASH_SIZE];
+    bool database_hash_valid;
+    // Listener de notificações GATT e flag que indica se está registrado.
+    gatt_client_notification_t notification_listener;
+    bool listener_registered;
+    // Ponto de controle ("Sample Control") e escrita em andamento, com o
+    // valor sendo escrito (precisa permanecer válido até a confirmação).
+    gatt_client_characteristic_t control_characteristic;
+    bool control_characteristic_found;
+    bool control_write_pending;
+    uint8_t control_write_value[SAMPLE_CONTROL_SIZE];
+    // Característica de lotes encontrada na descoberta e formato em uso.
+    bool stream_characteristic_found;
+    bool using_batches;
+    // Registro em flash ("Sample Backlog"): característica, listener,
+    // progresso do download nesta conexão (escrita no CCCD confirmada,
+    // fim recebido, concluído), totais recebidos e índice da primeira
+    // amostra ao vivo informado no fim.
+    gatt_client_characteristic_t backlog_characteristic;
+    bool backlog_characteristic_found;
+    gatt_client_notification_t backlog_listener;
+    bool backlog_listener_registered;
+    bool backlog_subscribed;
+    bool backlog_end_received;
+    bool backlog_done;
+    uint32_t backlog_seq;
+    uint32_t backlog_records;
+    uint32_t backlog_samples;
+    uint32_t backlog_bytes;
+    uint32_t backlog_start_us;
+    uint16_t backlog_next_index;
+    // Índice esperado da próxima amostra em lote, para detectar perdas.
+    uint16_t next_sample_index;
+    bool next_sample_index_valid;
+    // Amostras perdidas (saltos em `first_index`), recebidas em lotes e
+    // descartadas por chegarem fora de ordem (ou repetidas).
+    uint32_t lost_samples;
+    uint32_t received_samples;
+    uint32_t reordered_samples;
+    // Latências amostra→atuação dos lotes com instante de captura.
+    latency_hist_t latency_hist;
+    // Diferença entre os relógios do cliente e deste servidor (us), quando
+    // não há relógio comum nem sincronização: menor atraso bruto
+    // observado na conexão.
+    latency_offset_t clock_offset;
+    // Sincronização com o relógio deste servidor ("Time Sync"):
+    // estimativa, handle da característica (0 até a primeira leitura),
+    // trocas feitas na rodada, instante do pedido em curso e timer.
+    time_sync_t time_sync;
+    uint16_t time_sync_handle;
+    uint8_t time_sync_exchanges;
+    uint64_t time_sync_request_us;
+    btstack_timer_source_t time_sync_timer;
+    // Período entre amostras (us) estimado pelos instantes de captura de
+    // dois lotes, e o índice e o instante da última amostra do último lote
+    // com instante de captura.
+    uint32_t capture_period_us;
+    uint32_t last_capture_us;
+    uint16_t last_capture_index;
+    bool last_capture_valid;
+    // Instante do último relatório de latência no log.
+    uint32_t last_latency_report_us;
+    // Instante em que a sessão entrou na fila de conexão (descoberta no
+    // scan, desconexão ou partida), para medir o tempo até a primeira
+    // notificação.
+    uint32_t queued_us;
+    bool first_notification_pending;
+    // Parâmetros de conexão em uso (unidades do HCI: 1,25 ms, eventos e
+    // 10 ms).
+    uint16_t conn_interval;
+    uint16_t conn_latency;
+    uint16_t supervision_timeout;
+    // PHY e tamanho máximo das PDUs de dados em uso (BLE_HIGH_THROUGHPUT).
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint16_t max_tx_octets;
+    uint16_t max_rx_octets;
+} client_session_t;
+
+// Registro de um servidor guardado para a reconexão rápida (ver
+// CLIENT_FAST_RECONNECT), indexado pela origem.
+typedef struct {
+    bd_addr_t addr;
+    uint8_t addr_type;
+    uint8_t flags;
+    uint16_t value_handle;
+    uint16_t cccd_handle;
+    // Ponto de controle; 0 se o servidor não o oferece.
+    uint16_t control_value_handle;
+    // Registro em flash (valor, fim e propriedades da característica); 0
+    // se o servidor não o oferece. Sem as propriedades, a BTstack recusa
+    // a escrita no CCCD da característica restaurada.
+    uint16_t backlog_value_handle;
+    uint16_t backlog_end_handle;
+    uint16_t backlog_properties;
+    // Database Hash da base em que os handles foram descobertos.
+    uint8_t database_hash[DATABASE_HASH_SIZE];
+} server_cache_t;
+
+// Anunciante acompanhado no modo broadcast: endereço, janelas recebidas
+// e contadores no último relatório. O índice na tabela é a origem.
+typedef struct {
+    bool in_use;
+    bd_addr_t addr;
+    sample_broadcast_rx_t rx;
+    uint32_t report_reports;
+    uint32_t report_delivered;
+    uint32_t report_lost;
+    uint32_t report_us;
+} broadcast_source_t;
+
 // Registro para callback de eventos HCI (BTstack).
 static btstack_packet_callback_registration_t hci_event_callback_registration;
-// Estado atual da máquina de estados do cliente.
-static gc_state_t state = TC_OFF;
-// Endereço Bluetooth LE do servidor (dispositivo remoto) encontrado.
-static bd_addr_t server_addr;
-// Tipo de endereço (público, random, etc.).
-static bd_addr_type_t server_addr_type;
-// Handle da conexão HCI ativa.
-static hci_con_handle_t connection_handle;
-// Estrutura que representa o serviço GATT descoberto no servidor.
-static gatt_client_service_t server_service;
-// Estrutura que representa a característica GATT utilizada para receber dados.
-static gatt_client_characteristic_t server_characteristic;
-// Flag que indica se o listener de notificações está atualmente registrado.
-static bool listener_registered;
-// Estrutura de listener de notificações GATT (registro na BTstack).
-static gatt_client_notification_t notification_listener;
+// Sessões, uma por periférico (CLIENT_MAX_SERVERS, ver btstack_config.h).
+static client_session_t sessions[CLIENT_MAX_SERVERS];
+// Pilha em funcionamento (HCI_STATE_WORKING) e scan ativo.
+static bool stack_working;
+static bool scanning;
+// Sessão com criação de conexão em andamento (no máximo uma por vez), e
+// timer que limita a tentativa.
+static client_session_t *connecting_session;
+static btstack_timer_source_t connect_timer;
 // Timer periódico usado como "heartbeat" para piscar o LED indicando estado.
 static btstack_timer_source_t heartbeat;
+// UUID de 128 bits da característica de lotes ("Sample Stream").
+static const uint8_t sample_stream_uuid128[16] = SAMPLE_STREAM_CHARACTERISTIC_UUID128;
+// UUID de 128 bits da característica do ponto de controle ("Sample Control").
+static const uint8_t sample_control_uuid128[16] = SAMPLE_CONTROL_CHARACTERISTIC_UUID128;
+// UUID de 128 bits da característica do registro em flash ("Sample Backlog").
+static const uint8_t sample_backlog_uuid128[16] = SAMPLE_BACKLOG_CHARACTERISTIC_UUID128;
+// UUID de 128 bits da característica de sincronização ("Time Sync").
+static const uint8_t time_sync_uuid128[16] = TIME_SYNC_CHARACTERISTIC_UUID128;
+// Latências de todas as sessões juntas, expostas em "Latency Stats".
+static latency_hist_t latency_hist;
+// Servidores guardados (cópia em RAM do banco TLV), por origem.
+static server_cache_t server_cache[CLIENT_MAX_SERVERS];
+// Anunciantes do modo broadcast, por origem.
+static broadcast_source_t broadcasts[CLIENT_MAX_SERVERS];
+// Amostras do lote em decodificação (buffer estático, fora da pilha).
+static uint16_t batch_samples[SAMPLE_PACKET_MAX_SAMPLES];
+// Perfil de parâmetros de conexão aplicado pelo cliente
+// (`bt_client_set_link_profile`).
+static link_profile_t link_profile = LINK_PROFILE_BALANCED;
+// Valor escrito no CCCD para habilitar notificações.
+static const uint8_t cccd_enable_notifications[2] = {GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION, 0};
 
 // Ponteiro global para função de callback fornecida pela aplicação.
 // Esta função será chamada sempre que uma nova notificação GATT chegar.
 void(*global_callback_task)(void);
 // Ponteiro global para a variável onde o valor recebido (16 bits) será gravado.
 uint16_t* global_callback_message;
+// Callback da aplicação que recebe cada valor com a sua origem
+// (`bt_client_init_tagged`); NULL no modo de `bt_client_init`.
+void(*global_sample_handler)(uint8_t source, uint16_t value);
+// Callback da aplicação que recebe cada valor com a sua origem e o
+// instante de captura no relógio do cliente (`bt_client_init_timed`).
+void(*global_timed_handler)(uint8_t source, uint16_t value, uint64_t capture_us);
+// Callback da aplicação que recebe as amostras baixadas do registro em
+// flash (`bt_client_set_backlog_handler`); sem ele, elas só são contadas.
+void(*global_backlog_handler)(uint8_t source, uint32_t capture_us, uint32_t period_us, const uint16_t* samples, uint16_t count);
+// Callback da aplicação que recebe cada lote inteiro, antes da entrega
+// amostra por amostra (`bt_client_set_batch_handler`).
+void(*global_batch_handler)(uint8_t source, uint16_t first_index, uint64_t capture_us, uint32_t period_us,
+                            const uint16_t* samples, uint16_t count);
+
+static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+static void handle_time_sync_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+// Índice (origem) de uma sessão na tabela.
+static uint8_t session_index(const client_session_t *session) {
+    return (uint8_t)(session - sessions);
+}
+
+// Sessão da conexão `handle`, ou NULL.
+static client_session_t *session_for_handle(hci_con_handle_t handle) {
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state > TC_W4_CONNECT && sessions[i].connection_handle == handle) return &sessions[i];
+    }
+    return NULL;
+}
+
+// Sessão (em uso) do periférico `addr`, ou NULL.
+static client_session_t *session_for_addr(const bd_addr_t addr) {
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state != TC_OFF && bd_addr_cmp(sessions[i].addr, addr) == 0) return &sessions[i];
+    }
+    return NULL;
+}
+
+// Sessão livre para o servidor `addr`, ou NULL se todas estiverem em
+// uso. A origem de um servidor guardado é mantida; servidores novos
+// ocupam de preferência as origens sem registro.
+static client_session_t *free_session(const bd_addr_t addr) {
+    client_session_t *candidate = NULL;
+    bool candidate_cached = false;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state != TC_OFF) continue;
+        bool cached = (server_cache[i].flags & SERVER_CACHE_FLAG_VALID) != 0;
+        if (cached && bd_addr_cmp(server_cache[i].addr, addr) == 0) return &sessions[i];
+        if (candidate == NULL || (candidate_cached && !cached)) {
+            candidate = &sessions[i];
+            candidate_cached = cached;
+        }
+    }
+    return candidate;
+}
+
+// Coloca a sessão na fila de conexão (TC_IDLE) com o servidor `addr`,
+// usando os handles guardados se houver registro dele nesta origem.
+static void queue_session(client_session_t *session, const bd_addr_t addr, bd_addr_type_t addr_type) {
+    const server_cache_t *cache = &server_cache[session_index(session)];
+    memset(session, 0, sizeof(*session));
+    bd_addr_copy(session->addr, addr);
+    session->addr_type = addr_type;
+    session->connection_handle = HCI_CON_HANDLE_INVALID;
+    session->cached = CLIENT_FAST_RECONNECT && (cache->flags & SERVER_CACHE_FLAG_VALID) && bd_addr_cmp(cache->addr, addr) == 0;
+    session->queued_us = time_us_32();
+    session->first_notification_pending = true;
+    session->state = TC_IDLE;
+}
+
+// Lê do banco TLV os servidores guardados e os coloca na fila de
+// conexão direta, sem scan. Sem banco TLV (build de host), o registro
+// vale só enquanto o programa roda.
+static void server_cache_load(void) {
+#if CLIENT_FAST_RECONNECT
+    const btstack_tlv_t *tlv_impl;
+    void *tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        server_cache_t *cache = &server_cache[i];
+        int len = tlv_impl->get_tag(tlv_context, SERVER_CACHE_TAG(i), (uint8_t *)cache, sizeof(*cache));
+        if (len != (int)sizeof(*cache) || !(cache->flags & SERVER_CACHE_FLAG_VALID)) {
+            memset(cache, 0, sizeof(*cache));
+            continue;
+        }
+        LOG_INFO("[%u] Servidor guardado: %s", i, bd_addr_to_str(cache->addr));
+        queue_session(&sessions[i], cache->addr, static_cast<bd_addr_type_t>(cache->addr_type));
+    }
+#endif
+}
+
+// Guarda o endereço e os handles da sessão pronta; a flash só é escrita
+// quando o registro muda.
+static void server_cache_store(client_session_t *session) {
+#if CLIENT_FAST_RECONNECT
+    uint8_t source = session_index(session);
+    server_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+    bd_addr_copy(cache.addr, session->addr);
+    cache.addr_type = (uint8_t)session->addr_type;
+    cache.flags = SERVER_CACHE_FLAG_VALID | (session->using_batches ? SERVER_CACHE_FLAG_BATCHES : 0);
+    if (session->database_hash_valid) {
+        cache.flags |= SERVER_CACHE_FLAG_HASH;
+        memcpy(cache.database_hash, session->database_hash, DATABASE_HASH_SIZE);
+    }
+    cache.value_handle = session->characteristic.value_handle;
+    cache.cccd_handle = session->cccd_handle;
+    cache.control_value_handle = session->control_characteristic_found ? session->control_characteristic.value_handle : 0;
+    if (session->backlog_characteristic_found) {
+        cache.backlog_value_handle = session->backlog_characteristic.value_handle;
+        cache.backlog_end_handle = session->backlog_characteristic.end_handle;
+        cache.backlog_properties = session->backlog_characteristic.properties;
+    }
+    if (memcmp(&cache, &server_cache[source], sizeof(cache)) == 0) return;
+    server_cache[source] = cache;
+
+    const btstack_tlv_t *tlv_impl;
+    void *tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    tlv_impl->store_tag(tlv_context, SERVER_CACHE_TAG(source), (const uint8_t *)&cache, sizeof(cache));
+    LOG_INFO("[%u] Handles GATT guardados para reconexão rápida", source);
+#else
+    UNUSED(session);
+#endif
+}
+
+// Descarta o registro da origem (handles que deixaram de valer).
+static void server_cache_invalidate(uint8_t source) {
+    memset(&server_cache[source], 0, sizeof(server_cache[source]));
+    const btstack_tlv_t *tlv_impl;
+    void *tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    tlv_impl->delete_tag(tlv_context, SERVER_CACHE_TAG(source));
+}
+
+// Entrega um valor recebido à aplicação, com a sua origem.
+static void deliver_value(uint8_t source, uint16_t value) {
+    if (global_timed_handler != NULL) {
+        global_timed_handler(source, value, 0);
+        return;
+    }
+    if (global_sample_handler != NULL) {
+        global_sample_handler(source, value);
+        return;
+    }
+    *global_callback_message = value;
+    global_callback_task();
+}
+
+// Entrega um valor de uma sessão com o instante de captura no relógio do
+// cliente (0 se desconhecido).
+static void deliver_sample(client_session_t *session, uint16_t value, uint64_t capture_us) {
+    if (global_timed_handler != NULL) {
+        global_timed_handler(session_index(session), value, capture_us);
+        return;
+    }
+    deliver_value(session_index(session), value);
+}
+
+// Modo broadcast: origem do anunciante `addr`, ocupando uma livre na
+// primeira vez; NULL se todas estiverem em uso.
+static broadcast_source_t *broadcast_source_for(const bd_addr_t addr) {
+    broadcast_source_t *free_source = NULL;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (!broadcasts[i].in_use) {
+            if (free_source == NULL) free_source = &broadcasts[i];
+            continue;
+        }
+        if (bd_addr_cmp(broadcasts[i].addr, addr) == 0) return &broadcasts[i];
+    }
+    if (free_source == NULL) return NULL;
+    memset(free_source, 0, sizeof(*free_source));
+    free_source->in_use = true;
+    bd_addr_copy(free_source->addr, addr);
+    free_source->report_us = time_us_32();
+    LOG_INFO("Anunciante %s na origem %u", bd_addr_to_str(addr), (unsigned)(free_source - broadcasts));
+    return free_source;
+}
+
+// Relatório periódico de um anunciante: anúncios recebidos por segundo
+// (e o intervalo médio entre eles, a comparar com o intervalo de anúncio
+// do servidor), amostras entregues por segundo e perdidas.
+static void report_broadcast(broadcast_source_t *source) {
+    uint32_t now_us = time_us_32();
+    uint32_t elapsed_us = now_us - source->report_us;
+    if (elapsed_us < LATENCY_REPORT_PERIOD_US) return;
+    uint32_t reports = source->rx.reports - source->report_reports;
+    uint32_t delivered = source->rx.delivered - source->report_delivered;
+    uint32_t lost = source->rx.lost - source->report_lost;
+    source->report_us = now_us;
+    source->report_reports = source->rx.reports;
+    source->report_delivered = source->rx.delivered;
+    source->report_lost = source->rx.lost;
+    LOG_INFO("[%u] Broadcast: %u anúncios/s (1 a cada %u ms), %u amostras/s entregues, %u perdidas",
+             (unsigned)(source - broadcasts),
+             (unsigned)((uint64_t)reports * 1000000U / elapsed_us),
+             (unsigned)(reports ? elapsed_us / 1000U / reports : 0),
+             (unsigned)((uint64_t)delivered * 1000000U / elapsed_us), (unsigned)lost);
+}
+
+// Modo broadcast: extrai as amostras novas de um relatório de anúncio e
+// as entrega à aplicação com a origem do anunciante.
+static void handle_broadcast_report(uint8_t *packet) {
+    uint16_t first_index;
+    const uint8_t *samples;
+    int count = sample_broadcast_decode(gap_event_advertising_report_get_data(packet),
+                                        gap_event_advertising_report_get_data_length(packet), &first_index, &samples);
+    if (count <= 0) return;
+    bd_addr_t addr;
+    gap_event_advertising_report_get_address(packet, addr);
+    broadcast_source_t *source = broadcast_source_for(addr);
+    if (source == NULL) return;
+    uint8_t start = sample_broadcast_rx_update(&source->rx, first_index, (uint8_t)count);
+    if (global_batch_handler != NULL && start < count) {
+        for (uint8_t i = start; i < count; i++) batch_samples[i - start] = sample_packet_get(samples, i);
+        global_batch_handler((uint8_t)(source - broadcasts), (uint16_t)(first_index + start), 0, 0, batch_samples,
+                             (uint16_t)(count - start));
+    }
+    for (uint8_t i = start; i < count; i++) {
+        deliver_value((uint8_t)(source - broadcasts), sample_packet_get(samples, i));
+    }
+    report_broadcast(source);
+}
+
+// Liga ou desliga o processo de "scan" BLE em busca de servidores com o
+// serviço esperado (Environmental Sensing). O scan fica ativo enquanto
+// houver sessão livre e nenhuma conexão sendo criada ou aguardando a vez:
+// continua depois de cada conexão até CLIENT_MAX_SERVERS periféricos, e
+// recomeça após uma desconexão, para reconectar.
+static void update_scan(void) {
+    bool free_slot = false;
+    bool queued = false;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state == TC_OFF) free_slot = true;
+        if (sessions[i].state == TC_IDLE) queued = true;
+    }
+    bool want = stack_working && connecting_session == NULL && free_slot && !queued;
+    if (want == scanning) return;
+    scanning = want;
+    if (want) {
+        LOG_INFO("Iniciando Scan BLE (gap_start_scan)...");
+        gap_set_scan_parameters(0,0x0030, 0x0030);
+        gap_start_scan();
+    } else {
+        gap_stop_scan();
+    }
+}
+
+// Conecta ao próximo periférico encontrado (TC_IDLE), se nenhuma conexão
+// estiver sendo criada; senão, deixa o scan decidir. Cada periférico só
+// ocupa o controlador até a conexão ser criada: a troca de MTU e a
+// descoberta GATT de um correm em paralelo com a conexão do próximo.
+static void connect_next(void) {
+    if (connecting_session == NULL) {
+        for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+            if (sessions[i].state != TC_IDLE) continue;
+            client_session_t *session = &sessions[i];
+            // O scan para durante a criação da conexão.
+            connecting_session = session;
+            update_scan();
+            session->state = TC_W4_CONNECT;
+            LOG_INFO("Conectando a %s (origem %u)...", bd_addr_to_str(session->addr), session_index(session));
+            gap_connect(session->addr, session->addr_type);
+            btstack_run_loop_set_timer(&connect_timer, CLIENT_CONNECT_TIMEOUT_MS);
+            btstack_run_loop_add_timer(&connect_timer);
+            break;
+        }
+    }
+    update_scan();
+}
+
+// Tentativa de conexão sem resposta: cancela, libera a sessão e passa ao
+// próximo candidato.
+static void connect_timeout_handler(struct btstack_timer_source *ts) {
+    UNUSED(ts);
+    if (connecting_session == NULL) return;
+    LOG_WARN("Tempo esgotado conectando a %s", bd_addr_to_str(connecting_session->addr));
+    gap_connect_cancel();
+    connecting_session->state = TC_OFF;
+    connecting_session = NULL;
+    connect_next();
+}
+
+// Registra no log os parâmetros de conexão em uso.
+static void report_link_params(const client_session_t *session, const char *origin) {
+    uint32_t interval_us = LINK_INTERVAL_US(session->conn_interval);
+    LOG_INFO("[%u] Conexão (%s): intervalo %u.%02u ms, latência %u, supervisão %u ms%s", session_index(session), origin,
+             (unsigned)(interval_us / 1000U), (unsigned)((interval_us % 1000U) / 10U), session->conn_latency,
+             (unsigned)LINK_TIMEOUT_MS(session->supervision_timeout),
+             link_profile_matches(link_profile, session->conn_interval, session->conn_latency) ? "" : " (fora do perfil)");
+}
+
+// Aplica o perfil em uso a uma conexão estabelecida (HCI LE Connection
+// Update), se os parâmetros atuais não o atenderem.
+static void apply_link_profile(client_session_t *session) {
+    if (link_profile_matches(link_profile, session->conn_interval, session->conn_latency)) return;
+    const link_profile_params_t *params = link_profile_params(link_profile);
+    gap_update_connection_parameters(session->connection_handle, params->interval_min, params->interval_max,
+                                     params->latency, params->supervision_timeout);
+}
 
-// Inicia o processo de "scan" BLE em busca de um servidor com o
-// serviço esperado (Environmental Sensing). É chamada quando a
-// pilha Bluetooth entra em estado de funcionamento (HCI_STATE_WORKING)
-// ou após uma desconexão, para tentar reconectar.
-static void client_start(void){
-    // Inicia o processo de scan BLE.
-    LOG_INFO("Iniciando Scan BLE (gap_start_scan)...");
-    state = TC_W4_SCAN_RESULT;
-    gap_set_scan_parameters(0,0x0030, 0x0030);
-    gap_start_scan();
+// Modo de alta vazão: pede o PHY 2M nos dois sentidos. A Data Length
+// Extension é negociada pelo controlador com os valores sugeridos pela
+// BTstack na inicialização (ENABLE_LE_DATA_LENGTH_EXTENSION).
+static void request_high_throughput(client_session_t *session) {
+#if BLE_HIGH_THROUGHPUT
+    uint8_t status = gap_le_set_phy(session->connection_handle, 0, LINK_PHY_MASK_2M, LINK_PHY_MASK_2M, 0);
+    if (status != ERROR_CODE_SUCCESS) {
+        LOG_WARN("[%u] PHY 2M não pedido (status 0x%02x); conexão segue em 1M", session_index(session), status);
+    }
+#else
+    UNUSED(session);
+#endif
 }
 
 // Varre o conteúdo de um relatório de anúncio (advertising report)
@@ -92,8 +660,482 @@ static bool advertisement_report_contains_service(uint16_t service, uint8_t *adv
     return false;
 }
 
-// Callback de eventos do cliente GATT.
-// Responsável por:
+static void reset_stream_stats(client_session_t *session);
+static void start_backlog(client_session_t *session);
+
+// Registra o listener de notificações da característica escolhida
+// (`session->characteristic`) e habilita notificações escrevendo no CCCD.
+// Sem o handle do CCCD, descobre os descritores da característica antes;
+// o handle fica guardado para a próxima conexão. Com lotes, baixa antes
+// o registro em flash do servidor, se houver.
+static void enable_notifications(client_session_t *session) {
+    if (session->cccd_handle == 0) {
+        session->state = TC_W4_CCCD_RESULT;
+        LOG_INFO("[%u] Característica encontrada. Buscando CCCD...", session_index(session));
+        gatt_client_discover_characteristic_descriptors(handle_gatt_client_event, session->connection_handle, &session->characteristic);
+        return;
+    }
+    if (session->using_batches && session->backlog_characteristic_found && !session->backlog_done) {
+        start_backlog(session);
+        return;
+    }
+    if (session->using_batches) {
+        reset_stream_stats(session);
+        if (session->backlog_done && session->backlog_end_received) {
+            // O fluxo ao vivo continua da amostra seguinte à última baixada.
+            session->next_sample_index = session->backlog_next_index;
+            session->next_sample_index_valid = true;
+        }
+    }
+    // Registro do handler que receberá futuras
+    // notificações de valor dessa característica.
+    if (!session->listener_registered) {
+        session->listener_registered = true;
+        gatt_client_listen_for_characteristic_value_updates(&session->notification_listener, handle_gatt_client_event, session->connection_handle, &session->characteristic);
+    }
+    // Habilita notificações na característica escrevendo
+    // na Client Characteristic Configuration Descriptor.
+    LOG_INFO("[%u] Habilitando notificações (Write CCCD 0x%04x)...", session_index(session), session->cccd_handle);
+    session->state = TC_W4_ENABLE_NOTIFICATIONS_COMPLETE;
+    gatt_client_write_value_of_characteristic(handle_gatt_client_event, session->connection_handle,
+        session->cccd_handle, sizeof(cccd_enable_notifications), (uint8_t *)cccd_enable_notifications);
+}
+
+// Reconexão rápida: aplica os handles guardados da origem e vai direto à
+// escrita no CCCD, sem descoberta de serviço e características.
+static void enable_cached_notifications(client_session_t *session) {
+    const server_cache_t *cache = &server_cache[session_index(session)];
+    memset(&session->characteristic, 0, sizeof(session->characteristic));
+    session->characteristic.value_handle = cache->value_handle;
+    session->cccd_handle = cache->cccd_handle;
+    session->using_batches = (cache->flags & SERVER_CACHE_FLAG_BATCHES) != 0;
+    session->control_characteristic_found = cache->control_value_handle != 0;
+    memset(&session->control_characteristic, 0, sizeof(session->control_characteristic));
+    session->control_characteristic.value_handle = cache->control_value_handle;
+    session->backlog_characteristic_found = cache->backlog_value_handle != 0;
+    memset(&session->backlog_characteristic, 0, sizeof(session->backlog_characteristic));
+    session->backlog_characteristic.value_handle = cache->backlog_value_handle;
+    session->backlog_characteristic.end_handle = cache->backlog_end_handle;
+    session->backlog_characteristic.properties = cache->backlog_properties;
+    LOG_INFO("[%u] Usando handles guardados (dados 0x%04x, CCCD 0x%04x)", session_index(session), cache->value_handle, cache->cccd_handle);
+    enable_notifications(session);
+}
+
+// Lê o Database Hash do servidor (uma leitura por UUID, em toda a base):
+// com ele, os handles guardados só são usados se a base não mudou.
+static void read_database_hash(client_session_t *session) {
+    session->state = TC_W4_DATABASE_HASH;
+    session->database_hash_valid = false;
+    gatt_client_read_value_of_characteristics_by_uuid16(handle_gatt_client_event, session->connection_handle, 0x0001, 0xFFFF, ORG_BLUETOOTH_CHARACTERISTIC_DATABASE_HASH);
+}
+
+// Descoberta completa, a partir do serviço primário.
+static void discover_service(client_session_t *session) {
+    session->state = TC_W4_SERVICE_RESULT;
+    gatt_client_discover_primary_services_by_uuid16(handle_gatt_client_event, session->connection_handle, ORG_BLUETOOTH_SERVICE_ENVIRONMENTAL_SENSING);
+}
+
+// Inicia a descoberta da característica de temperatura (uma amostra por
+// notificação), usada quando o servidor não oferece lotes.
+static void discover_temperature_characteristic(client_session_t *session) {
+    session->state = TC_W4_CHARACTERISTIC_RESULT;
+    LOG_INFO("[%u] Serviço descoberto. Buscando característica Environmental Sensing...", session_index(session));
+    gatt_client_discover_characteristics_for_service_by_uuid16(handle_gatt_client_event, session->connection_handle, &session->service, ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE);
+}
+
+// Inicia a descoberta da característica de dados: a de lotes, se o modo
+// em lote estiver habilitado, ou diretamente a de temperatura.
+static void discover_sample_characteristic(client_session_t *session) {
+#if CLIENT_SAMPLE_BATCHING
+    session->state = TC_W4_STREAM_CHARACTERISTIC_RESULT;
+    session->stream_characteristic_found = false;
+    LOG_INFO("[%u] Buscando característica de lotes (Sample Stream)...", session_index(session));
+    gatt_client_discover_characteristics_for_service_by_uuid128(handle_gatt_client_event, session->connection_handle, &session->service, sample_stream_uuid128);
+#else
+    discover_temperature_characteristic(session);
+#endif
+}
+
+// Procura a característica do registro em flash, opcional: servidores
+// sem ela (ou com CLIENT_BACKLOG 0) seguem direto para os lotes.
+static void discover_backlog_characteristic(client_session_t *session) {
+    session->backlog_characteristic_found = false;
+#if CLIENT_BACKLOG
+    session->state = TC_W4_BACKLOG_CHARACTERISTIC_RESULT;
+    LOG_INFO("[%u] Buscando registro em flash (Sample Backlog)...", session_index(session));
+    gatt_client_discover_characteristics_for_service_by_uuid128(handle_gatt_client_event, session->connection_handle, &session->service, sample_backlog_uuid128);
+#else
+    enable_notifications(session);
+#endif
+}
+
+// Pede o download do registro em flash: registra o listener da
+// característica e habilita as suas notificações (o CCCD é procurado
+// pela própria BTstack entre o valor e o fim da característica). O
+// servidor começa a enviar assim que a escrita é aceita.
+static void start_backlog(client_session_t *session) {
+    session->state = TC_W4_BACKLOG_END;
+    session->backlog_subscribed = false;
+    session->backlog_end_received = false;
+    session->backlog_seq = 0;
+    session->backlog_records = 0;
+    session->backlog_samples = 0;
+    session->backlog_bytes = 0;
+    session->backlog_start_us = time_us_32();
+    if (!session->backlog_listener_registered) {
+        session->backlog_listener_registered = true;
+        gatt_client_listen_for_characteristic_value_updates(&session->backlog_listener, handle_gatt_client_event, session->connection_handle, &session->backlog_characteristic);
+    }
+    LOG_INFO("[%u] Baixando o registro em flash do servidor...", session_index(session));
+    uint8_t status = gatt_client_write_client_characteristic_configuration(handle_gatt_client_event, session->connection_handle,
+        &session->backlog_characteristic, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    if (status != ERROR_CODE_SUCCESS) {
+        LOG_WARN("[%u] Download do registro não iniciado (status 0x%02x)", session_index(session), status);
+        session->backlog_done = true;
+        enable_notifications(session);
+    }
+}
+
+// Com a escrita no CCCD confirmada e a mensagem de fim recebida, o
+// download terminou: segue para a assinatura dos lotes, que confirma o
+// recebimento ao servidor.
+static void continue_after_backlog(client_session_t *session) {
+    if (!session->backlog_subscribed || !session->backlog_end_received) return;
+    session->backlog_done = true;
+    enable_notifications(session);
+}
+
+// Trata uma notificação do registro em flash: entrega as amostras de cada
+// parte à aplicação (`bt_client_set_backlog_handler`) e, no fim, registra
+// o volume e a vazão do download.
+static void handle_backlog_notification(client_session_t *session, const uint8_t *value, uint16_t value_length) {
+    uint8_t source = session_index(session);
+    sample_backlog_t message;
+    if (sample_backlog_decode(value, value_length, &message, batch_samples) != 0) {
+        LOG_WARN("[%u] Parte do registro inválida (len: %d)", source, value_length);
+        return;
+    }
+    if (message.type == SAMPLE_BACKLOG_DATA) {
+        if (session->backlog_records == 0 || message.seq != session->backlog_seq) session->backlog_records++;
+        session->backlog_seq = message.seq;
+        session->backlog_samples += message.packet.count;
+        session->backlog_bytes += value_length;
+        if (global_backlog_handler != NULL) {
+            global_backlog_handler(source, message.capture_us, message.period_us, batch_samples, message.packet.count);
+        }
+        LOG_DEBUG("[%u] Registro #%u: %u amostras a partir de #%u", source, (unsigned)message.seq,
+                  message.packet.count, message.packet.first_index);
+        return;
+    }
+
+    uint32_t elapsed_us = time_us_32() - session->backlog_start_us;
+    LOG_INFO("[%u] Registro em flash baixado: %u registros, %u amostras (servidor: %u), %u bytes em %u ms (%u kbit/s)",
+             source, (unsigned)session->backlog_records, (unsigned)session->backlog_samples, (unsigned)message.samples,
+             (unsigned)session->backlog_bytes, (unsigned)(elapsed_us / 1000U),
+             (unsigned)(elapsed_us ? (uint64_t)session->backlog_bytes * 8000U / elapsed_us : 0));
+    session->backlog_next_index = message.next_index;
+    session->backlog_end_received = true;
+    continue_after_backlog(session);
+}
+
+// Callback da escrita no ponto de controle (fora da máquina de estados:
+// a escrita acontece com a sessão já em TC_W4_READY).
+static void handle_control_write_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(size);
+    if (hci_event_packet_get_type(packet) != GATT_EVENT_QUERY_COMPLETE) return;
+    client_session_t *session = session_for_handle(gatt_event_query_complete_get_handle(packet));
+    if (session == NULL) return;
+
+    session->control_write_pending = false;
+    uint8_t att_status = gatt_event_query_complete_get_att_status(packet);
+    if (att_status != ATT_ERROR_SUCCESS) {
+        LOG_WARN("[%u] Ponto de controle: escrita recusada pelo servidor, ATT Error 0x%02x", session_index(session), att_status);
+        return;
+    }
+    LOG_INFO("[%u] Ponto de controle: configuração aplicada pelo servidor", session_index(session));
+}
+
+// Agenda a próxima troca (ou rodada) de sincronização em `delay_ms`.
+static void schedule_time_sync(client_session_t *session, uint32_t delay_ms) {
+    btstack_run_loop_remove_timer(&session->time_sync_timer);
+    btstack_run_loop_set_timer(&session->time_sync_timer, delay_ms);
+    btstack_run_loop_add_timer(&session->time_sync_timer);
+}
+
+// Uma troca: lê "Time Sync" anotando o instante do pedido. A primeira
+// leitura é por UUID, o que dispensa a descoberta e o registro da
+// reconexão rápida; as seguintes usam o handle devolvido nela. Com o
+// cliente GATT ocupado (ex.: escrita no ponto de controle), tenta de
+// novo em pouco tempo.
+static void request_time_sync(client_session_t *session) {
+    uint8_t status;
+    session->time_sync_request_us = time_us_64();
+    if (session->time_sync_handle != 0) {
+        status = gatt_client_read_value_of_characteristic_using_value_handle(handle_time_sync_event,
+            session->connection_handle, session->time_sync_handle);
+    } else {
+        status = gatt_client_read_value_of_characteristics_by_uuid128(handle_time_sync_event,
+            session->connection_handle, 0x0001, 0xFFFF, time_sync_uuid128);
+    }
+    if (status != ERROR_CODE_SUCCESS) schedule_time_sync(session, TIME_SYNC_RETRY_MS);
+}
+
+static void time_sync_timer_handler(btstack_timer_source_t *ts) {
+    client_session_t *session = (client_session_t *)btstack_run_loop_get_timer_context(ts);
+    if (session->state != TC_W4_READY) return;
+    request_time_sync(session);
+}
+
+// Começa a sincronização com o servidor de uma sessão que acabou de
+// ficar pronta; a primeira rodada sai logo.
+static void start_time_sync(client_session_t *session) {
+    if (CLIENT_TIME_SYNC_PERIOD_MS == 0) return;
+    time_sync_reset(&session->time_sync);
+    session->time_sync_handle = 0;
+    session->time_sync_exchanges = 0;
+    session->time_sync_timer.process = &time_sync_timer_handler;
+    btstack_run_loop_set_timer_context(&session->time_sync_timer, session);
+    schedule_time_sync(session, 0);
+}
+
+// Qualidade da sincronização no log (USB), a cada rodada: diferença
+// atual entre os relógios, deriva, dispersão das trocas da rodada,
+// maior resíduo do ajuste sobre as últimas rodadas, menor ida e volta e
+// trocas ancoradas nos eventos de conexão.
+static void report_time_sync(client_session_t *session) {
+    const time_sync_t *sync = &session->time_sync;
+    LOG_INFO("[%u] Relógio: diferença %lld us, deriva %.2f ppm, dispersão %u us, resíduo %u us, "
+             "ida e volta mín. %u us, %u/%u trocas ancoradas (rodada %u)",
+             session_index(session), (long long)time_sync_offset_at(sync, time_us_64()), sync->drift_ppb / 1000.0,
+             (unsigned)sync->dispersion_us, (unsigned)sync->residual_us, (unsigned)sync->rtt_us,
+             sync->anchored, TIME_SYNC_ROUND_EXCHANGES, (unsigned)sync->rounds);
+}
+
+// Callback das leituras de "Time Sync" (fora da máquina de estados,
+// como o ponto de controle). O instante da resposta é anotado antes de
+// qualquer outro processamento.
+static void handle_time_sync_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(size);
+    uint64_t response_us = time_us_64();
+
+    client_session_t *session = session_for_handle(little_endian_read_16(packet, 2));
+    if (session == NULL) return;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT: {
+            uint32_t server_us;
+            if (time_sync_decode(gatt_event_characteristic_value_query_result_get_value(packet),
+                                 gatt_event_characteristic_value_query_result_get_value_length(packet), &server_us) != 0) {
+                break;
+            }
+            session->time_sync_handle = gatt_event_characteristic_value_query_result_get_value_handle(packet);
+            time_sync_add(&session->time_sync, session->time_sync_request_us, server_us, response_us,
+                          LINK_INTERVAL_US(session->conn_interval));
+            break;
+        }
+        case GATT_EVENT_QUERY_COMPLETE: {
+            if (session->state != TC_W4_READY) break;
+            uint8_t att_status = gatt_event_query_complete_get_att_status(packet);
+            if (att_status == ATT_ERROR_ATTRIBUTE_NOT_FOUND) {
+                LOG_INFO("[%u] Servidor sem sincronização de relógio", session_index(session));
+                break;
+            }
+            if (att_status != ATT_ERROR_SUCCESS) {
+                LOG_WARN("[%u] Sincronização de relógio: leitura recusada, ATT Error 0x%02x", session_index(session), att_status);
+                session->time_sync_exchanges = 0;
+                schedule_time_sync(session, CLIENT_TIME_SYNC_PERIOD_MS);
+                break;
+            }
+            if (++session->time_sync_exchanges < TIME_SYNC_ROUND_EXCHANGES) {
+                request_time_sync(session);
+                break;
+            }
+            session->time_sync_exchanges = 0;
+            bool was_valid = session->time_sync.valid;
+            if (time_sync_finish_round(&session->time_sync)) {
+                // As latências medidas até aqui eram relativas à mínima.
+                if (!was_valid) latency_hist_reset(&session->latency_hist);
+                report_time_sync(session);
+            }
+            schedule_time_sync(session, CLIENT_TIME_SYNC_PERIOD_MS);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Zera os contadores de sequência e de latência do fluxo em lote de uma
+// sessão (a cada nova conexão). O histograma agregado é zerado quando a
+// primeira sessão fica pronta.
+static void reset_stream_stats(client_session_t *session) {
+    session->next_sample_index_valid = false;
+    session->lost_samples = 0;
+    session->received_samples = 0;
+    session->reordered_samples = 0;
+    latency_hist_reset(&session->latency_hist);
+    latency_offset_reset(&session->clock_offset);
+    session->last_capture_valid = false;
+    session->capture_period_us = 0;
+    session->last_latency_report_us = time_us_32();
+    bool others_ready = false;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (&sessions[i] != session && sessions[i].state == TC_W4_READY) others_ready = true;
+    }
+    if (!others_ready) latency_hist_reset(&latency_hist);
+}
+
+// Registra a latência de um lote cuja última amostra foi capturada no
+// servidor em `capture_us` e acaba de ser aplicada pelo callback. O
+// cabeçalho do lote traz um único instante (o da última amostra); os das
+// demais são reconstruídos com `capture_period_us` (ver `deliver_sample`).
+// Sem relógio comum, o instante é traduzido pela sincronização com o
+// relógio do servidor. Antes da primeira rodada (ou com servidores sem
+// "Time Sync"), o atraso bruto inclui a diferença desconhecida entre os
+// relógios; o menor atraso observado é tomado como essa diferença, e
+// registra-se apenas o excedente (jitter de ponta a ponta). Cada
+// servidor tem o seu relógio, e portanto a sua diferença.
+static void record_latency(client_session_t *session, uint32_t capture_us) {
+    uint32_t latency_us;
+    if (!CLIENT_SHARED_CLOCK && !session->time_sync.valid) {
+        latency_us = latency_offset_apply(&session->clock_offset, capture_us, time_us_32());
+    } else {
+        int32_t raw_us = (int32_t)(time_us_32() - capture_us);
+        if (!CLIENT_SHARED_CLOCK) {
+            raw_us = (int32_t)(int64_t)(time_us_64() - time_sync_to_local(&session->time_sync, capture_us));
+        }
+        latency_us = (raw_us > 0) ? (uint32_t)raw_us : 0;
+    }
+    latency_hist_record(&session->latency_hist, latency_us);
+    latency_hist_record(&latency_hist, latency_us);
+}
+
+// Relatório periódico de sequência e latência de uma sessão no log (USB).
+static void report_latency(client_session_t *session) {
+    uint32_t now_us = time_us_32();
+    if (now_us - session->last_latency_report_us < LATENCY_REPORT_PERIOD_US) return;
+    session->last_latency_report_us = now_us;
+
+    LOG_INFO("[%u] Fluxo: %u amostras, %u perdidas, %u fora de ordem", session_index(session),
+             (unsigned)session->received_samples, (unsigned)session->lost_samples, (unsigned)session->reordered_samples);
+    if (session->latency_hist.count == 0) return;
+    LOG_INFO("[%u] Latência%s: p50 %u us, p99 %u us, máx. %u us, média %u us (%u lotes)", session_index(session),
+             CLIENT_SHARED_CLOCK ? "" : session->time_sync.valid ? " (relógios sincronizados)" : " (excedente sobre a mínima)",
+             (unsigned)latency_hist_percentile(&session->latency_hist, 500),
+             (unsigned)latency_hist_percentile(&session->latency_hist, 990),
+             (unsigned)session->latency_hist.max_us, (unsigned)latency_hist_mean(&session->latency_hist),
+             (unsigned)session->latency_hist.count);
+}
+
+// Estima o período entre amostras pelos instantes de captura da última
+// amostra de dois lotes com instante, separados por menos de meia volta
+// do índice.
+static void update_capture_period(client_session_t *session, const sample_packet_header_t *header) {
+    uint16_t last_index = (uint16_t)(header->first_index + header->count - 1);
+    if (session->last_capture_valid) {
+        uint16_t samples = (uint16_t)(last_index - session->last_capture_index);
+        if (samples != 0 && samples < 0x8000) {
+            session->capture_period_us = (header->capture_us - session->last_capture_us) / samples;
+        }
+    }
+    session->last_capture_us = header->capture_us;
+    session->last_capture_index = last_index;
+    session->last_capture_valid = true;
+}
+
+// Desempacota uma notificação em lote, em qualquer das codificações do
+// formato, e entrega à aplicação uma amostra por vez, na ordem de
+// captura. Lotes anteriores ao esperado (fora de ordem ou repetidos) são
+// descartados para não reaplicar valores antigos.
+static void handle_sample_batch(client_session_t *session, const uint8_t *value, uint16_t value_length) {
+    sample_packet_header_t header;
+    if (sample_packet_decode(value, value_length, &header, batch_samples) != 0) {
+        LOG_WARN("[%u] Lote inválido (len: %d)", session_index(session), value_length);
+        return;
+    }
+
+    if (session->next_sample_index_valid && header.first_index != session->next_sample_index) {
+        int16_t gap = (int16_t)(header.first_index - session->next_sample_index);
+        if (gap < 0) {
+            session->reordered_samples += header.count;
+            LOG_WARN("[%u] Lote fora de ordem descartado (esperado #%u, recebido #%u; total: %u)", session_index(session), session->next_sample_index, header.first_index, (unsigned)session->reordered_samples);
+            return;
+        }
+        session->lost_samples += (uint16_t)gap;
+        LOG_WARN("[%u] Perda de %u amostras (esperado #%u, recebido #%u; total perdido: %u)", session_index(session), (unsigned)gap, session->next_sample_index, header.first_index, (unsigned)session->lost_samples);
+    }
+    session->next_sample_index = (uint16_t)(header.first_index + header.count);
+    session->next_sample_index_valid = true;
+    session->received_samples += header.count;
+
+    // Instante de captura da última amostra no relógio do cliente; as
+    // anteriores recuam um período cada.
+    uint64_t last_capture_us = 0;
+    if (header.flags & SAMPLE_PACKET_FLAG_TIMESTAMP) {
+        update_capture_period(session, &header);
+        if (session->time_sync.valid) last_capture_us = time_sync_to_local(&session->time_sync, header.capture_us);
+    }
+    if (global_batch_handler != NULL) {
+        uint64_t first_capture_us = 0;
+        if (last_capture_us != 0 && (header.count == 1 || session->capture_period_us != 0)) {
+            first_capture_us = last_capture_us - (uint64_t)(header.count - 1) * session->capture_period_us;
+        }
+        global_batch_handler(session_index(session), header.first_index, first_capture_us, session->capture_period_us,
+                             batch_samples, header.count);
+    }
+    uint16_t sample = 0;
+    for (uint8_t i = 0; i < header.count; i++) {
+        sample = batch_samples[i];
+        uint32_t before_last = (uint32_t)(header.count - 1 - i);
+        uint64_t capture_us = 0;
+        if (last_capture_us != 0 && (before_last == 0 || session->capture_period_us != 0)) {
+            capture_us = last_capture_us - (uint64_t)before_last * session->capture_period_us;
+        }
+        deliver_sample(session, sample, capture_us);
+    }
+    if (header.flags & SAMPLE_PACKET_FLAG_TIMESTAMP) {
+        record_latency(session, header.capture_us);
+    }
+    LOG_DEBUG("[%u] Lote recebido: %u amostras a partir de #%u, última: %d", session_index(session), header.count, header.first_index, sample);
+    report_latency(session);
+}
+
+// Callback de leitura ATT da base do próprio cliente: expõe as
+// estatísticas do fluxo na característica "Latency Stats", como 7 valores
+// uint32 little endian: amostras recebidas, perdidas, fora de ordem,
+// lotes medidos, latência p50, p99 e máxima (us). As contagens somam as
+// sessões conectadas, e a latência vem do histograma de todas elas.
+static uint16_t att_read_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    UNUSED(con_handle);
+    if (att_handle != LATENCY_STATS_VALUE_HANDLE) return 0;
+
+    uint32_t received = 0;
+    uint32_t lost = 0;
+    uint32_t reordered = 0;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state != TC_W4_READY) continue;
+        received += sessions[i].received_samples;
+        lost += sessions[i].lost_samples;
+        reordered += sessions[i].reordered_samples;
+    }
+    uint8_t value[LATENCY_STATS_SIZE];
+    little_endian_store_32(value, 0, received);
+    little_endian_store_32(value, 4, lost);
+    little_endian_store_32(value, 8, reordered);
+    little_endian_store_32(value, 12, latency_hist.count);
+    little_endian_store_32(value, 16, latency_hist_percentile(&latency_hist, 500));
+    little_endian_store_32(value, 20, latency_hist_percentile(&latency_hist, 990));
+    little_endian_store_32(value, 24, latency_hist.max_us);
+    return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+}
+
+// Callback de eventos do cliente GATT, compartilhado por todas as sessões.
+// Todo evento GATT traz o handle da conexão logo após o cabeçalho (bytes
+// 2 e 3), que identifica a sessão. Responsável por:
 //  - tratar o resultado da descoberta de serviços;
 //  - tratar o resultado da descoberta de características;
 //  - registrar o listener de notificações e habilitar notificações;
@@ -103,29 +1145,140 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
     UNUSED(channel);
     UNUSED(size);
 
+    client_session_t *session = session_for_handle(little_endian_read_16(packet, 2));
+    if (session == NULL) return;
+    uint8_t source = session_index(session);
+
     uint8_t att_status;
-    switch(state){
+    switch(session->state){
+        case TC_W4_MTU_EXCHANGE:
+            // Aguarda a resposta da troca de MTU antes de iniciar a
+            // descoberta: com MTU maior, cada notificação carrega mais
+            // amostras.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_MTU:
+                    LOG_INFO("[%u] ATT MTU negociado: %u bytes. Lendo Database Hash...", source, gatt_event_mtu_get_MTU(packet));
+                    read_database_hash(session);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_DATABASE_HASH:
+            // Servidores sem Database Hash respondem com erro; os handles
+            // guardados deles são validados só pela escrita no CCCD.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT:
+                    if (gatt_event_characteristic_value_query_result_get_value_length(packet) != DATABASE_HASH_SIZE) break;
+                    memcpy(session->database_hash, gatt_event_characteristic_value_query_result_get_value(packet), DATABASE_HASH_SIZE);
+                    session->database_hash_valid = true;
+                    break;
+                case GATT_EVENT_QUERY_COMPLETE: {
+                    const server_cache_t *cache = &server_cache[source];
+                    if (session->cached && (cache->flags & SERVER_CACHE_FLAG_HASH) &&
+                        (!session->database_hash_valid || memcmp(cache->database_hash, session->database_hash, DATABASE_HASH_SIZE) != 0)) {
+                        LOG_INFO("[%u] Base GATT do servidor mudou; refazendo a descoberta", source);
+                        server_cache_invalidate(source);
+                        session->cached = false;
+                    }
+                    if (session->cached) {
+                        LOG_INFO("[%u] Reconexão rápida...", source);
+                        enable_cached_notifications(session);
+                        break;
+                    }
+                    LOG_INFO("[%u] Iniciando descoberta de serviços (Environmental Sensing)...", source);
+                    discover_service(session);
+                    break;}
+                default:
+                    break;
+            }
+            break;
         case TC_W4_SERVICE_RESULT:
             // Nesta fase, estamos aguardando a resposta da descoberta de serviços.
             switch(hci_event_packet_get_type(packet)) {
                 case GATT_EVENT_SERVICE_QUERY_RESULT:
                     // store service (we expect only one)
-                    LOG_INFO("Serviço encontrado. Armazenando...");
-                    gatt_event_service_query_result_get_service(packet, &server_service);
+                    LOG_INFO("[%u] Serviço encontrado. Armazenando...", source);
+                    gatt_event_service_query_result_get_service(packet, &session->service);
                     break;
                 case GATT_EVENT_QUERY_COMPLETE:
                     att_status = gatt_event_query_complete_get_att_status(packet);
                     if (att_status != ATT_ERROR_SUCCESS){
-                        LOG_WARN("Falha na descoberta de serviço. ATT Error 0x%02x", att_status);
-                        gap_disconnect(connection_handle);
+                        LOG_WARN("[%u] Falha na descoberta de serviço. ATT Error 0x%02x", source, att_status);
+                        gap_disconnect(session->connection_handle);
                         break;  
                     } 
                     // Descoberta de serviço concluída com sucesso;
-                    // agora passamos para a descoberta da característica
-                    // específica (por UUID) dentro desse serviço.
-                    state = TC_W4_CHARACTERISTIC_RESULT;
-                    LOG_INFO("Serviço descoberto. Buscando característica Environmental Sensing...");
-                    gatt_client_discover_characteristics_for_service_by_uuid16(handle_gatt_client_event, connection_handle, &server_service, ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE);
+                    // agora passamos para a descoberta das
+                    // características (por UUID) dentro desse serviço,
+                    // começando pelo ponto de controle.
+                    session->state = TC_W4_CONTROL_CHARACTERISTIC_RESULT;
+                    session->control_characteristic_found = false;
+                    LOG_INFO("[%u] Serviço descoberto. Buscando ponto de controle (Sample Control)...", source);
+                    gatt_client_discover_characteristics_for_service_by_uuid128(handle_gatt_client_event, session->connection_handle, &session->service, sample_control_uuid128);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_CONTROL_CHARACTERISTIC_RESULT:
+            // O ponto de controle é opcional: servidores antigos não o
+            // oferecem, e o fluxo de dados segue sem ele.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+                    gatt_event_characteristic_query_result_get_characteristic(packet, &session->control_characteristic);
+                    session->control_characteristic_found = true;
+                    break;
+                case GATT_EVENT_QUERY_COMPLETE:
+                    if (gatt_event_query_complete_get_att_status(packet) != ATT_ERROR_SUCCESS) {
+                        session->control_characteristic_found = false;
+                    }
+                    if (!session->control_characteristic_found) {
+                        LOG_INFO("[%u] Servidor sem ponto de controle", source);
+                    }
+                    discover_sample_characteristic(session);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_STREAM_CHARACTERISTIC_RESULT:
+            // Nesta fase, procuramos a característica de lotes; se o
+            // servidor não a oferecer, recorremos à de temperatura.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+                    gatt_event_characteristic_query_result_get_characteristic(packet, &session->characteristic);
+                    session->stream_characteristic_found = true;
+                    break;
+                case GATT_EVENT_QUERY_COMPLETE:
+                    att_status = gatt_event_query_complete_get_att_status(packet);
+                    if (att_status != ATT_ERROR_SUCCESS || !session->stream_characteristic_found) {
+                        LOG_INFO("[%u] Servidor sem característica de lotes; usando uma amostra por notificação", source);
+                        discover_temperature_characteristic(session);
+                        break;
+                    }
+                    session->using_batches = true;
+                    discover_backlog_characteristic(session);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_BACKLOG_CHARACTERISTIC_RESULT:
+            // O registro em flash é opcional, como o ponto de controle.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+                    gatt_event_characteristic_query_result_get_characteristic(packet, &session->backlog_characteristic);
+                    session->backlog_characteristic_found = true;
+                    break;
+                case GATT_EVENT_QUERY_COMPLETE:
+                    if (gatt_event_query_complete_get_att_status(packet) != ATT_ERROR_SUCCESS) {
+                        session->backlog_characteristic_found = false;
+                    }
+                    if (!session->backlog_characteristic_found) {
+                        LOG_INFO("[%u] Servidor sem registro em flash", source);
+                    }
+                    enable_notifications(session);
                     break;
                 default:
                     break;
@@ -136,27 +1289,68 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
             // característica desejada dentro do serviço encontrado.
             switch(hci_event_packet_get_type(packet)) {
                 case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
-                    LOG_INFO("Característica encontrada. Armazenando...");
-                    gatt_event_characteristic_query_result_get_characteristic(packet, &server_characteristic);
+                    LOG_INFO("[%u] Característica encontrada. Armazenando...", source);
+                    gatt_event_characteristic_query_result_get_characteristic(packet, &session->characteristic);
                     break;
                 case GATT_EVENT_QUERY_COMPLETE:
-                    LOG_INFO("Descoberta de característica concluída. Status: 0x%02x", gatt_event_query_complete_get_att_status(packet));
+                    LOG_INFO("[%u] Descoberta de característica concluída. Status: 0x%02x", source, gatt_event_query_complete_get_att_status(packet));
                     att_status = gatt_event_query_complete_get_att_status(packet);
                     if (att_status != ATT_ERROR_SUCCESS){
-                        LOG_WARN("Falha na descoberta de característica. ATT Error 0x%02x", att_status);
-                        gap_disconnect(connection_handle);
+                        LOG_WARN("[%u] Falha na descoberta de característica. ATT Error 0x%02x", source, att_status);
+                        gap_disconnect(session->connection_handle);
                         break;  
                     } 
-                    // Registro do handler que receberá futuras
-                    // notificações de valor dessa característica.
-                    listener_registered = true;
-                    gatt_client_listen_for_characteristic_value_updates(&notification_listener, handle_gatt_client_event, connection_handle, &server_characteristic);
-                    // Habilita notificações na característica escrevendo
-                    // na Client Characteristic Configuration Descriptor.
-                    LOG_INFO("Característica encontrada. Habilitando notificações (Write CCCD)...");
-                    state = TC_W4_ENABLE_NOTIFICATIONS_COMPLETE;
-                    gatt_client_write_client_characteristic_configuration(handle_gatt_client_event, connection_handle,
-                        &server_characteristic, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+                    session->using_batches = false;
+                    enable_notifications(session);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_CCCD_RESULT:
+            // Procura o CCCD entre os descritores da característica.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT: {
+                    gatt_client_characteristic_descriptor_t descriptor;
+                    gatt_event_all_characteristic_descriptors_query_result_get_characteristic_descriptor(packet, &descriptor);
+                    if (descriptor.uuid16 == ORG_BLUETOOTH_DESCRIPTOR_GATT_CLIENT_CHARACTERISTIC_CONFIGURATION) {
+                        session->cccd_handle = descriptor.handle;
+                    }
+                    break;}
+                case GATT_EVENT_QUERY_COMPLETE:
+                    if (session->cccd_handle == 0) {
+                        LOG_WARN("[%u] Característica sem CCCD", source);
+                        gap_disconnect(session->connection_handle);
+                        break;
+                    }
+                    enable_notifications(session);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case TC_W4_BACKLOG_END:
+            // Download do registro em flash: as notificações dele chegam
+            // antes de o fluxo ao vivo ser assinado. Uma recusa na escrita
+            // do CCCD (ex.: servidor sem registro) não impede o fluxo.
+            switch(hci_event_packet_get_type(packet)) {
+                case GATT_EVENT_NOTIFICATION:
+                    if (gatt_event_notification_get_value_handle(packet) != session->backlog_characteristic.value_handle) break;
+                    handle_backlog_notification(session, gatt_event_notification_get_value(packet),
+                                                gatt_event_notification_get_value_length(packet));
+                    break;
+                case GATT_EVENT_QUERY_COMPLETE:
+                    att_status = gatt_event_query_complete_get_att_status(packet);
+                    if (att_status != ATT_ERROR_SUCCESS) {
+                        LOG_WARN("[%u] Download do registro recusado, ATT Error 0x%02x", source, att_status);
+                        // Sem a mensagem de fim, o índice do fluxo ao vivo
+                        // vem do primeiro lote, como sem registro.
+                        session->backlog_done = true;
+                        enable_notifications(session);
+                        break;
+                    }
+                    session->backlog_subscribed = true;
+                    continue_after_backlog(session);
                     break;
                 default:
                     break;
@@ -168,10 +1362,24 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
             switch(hci_event_packet_get_type(packet)) {
                 case GATT_EVENT_QUERY_COMPLETE:
                     att_status = gatt_event_query_complete_get_att_status(packet);
-                    LOG_INFO("Notificações habilitadas, status ATT: 0x%02x", att_status);
+                    LOG_INFO("[%u] Notificações habilitadas, status ATT: 0x%02x", source, att_status);
+                    if (att_status != ATT_ERROR_SUCCESS && session->cached) {
+                        // Handles guardados não valem mais (firmware do
+                        // servidor mudou): descarta e descobre de novo.
+                        LOG_WARN("[%u] Handles guardados recusados; refazendo a descoberta", source);
+                        server_cache_invalidate(source);
+                        session->cached = false;
+                        session->cccd_handle = 0;
+                        session->listener_registered = false;
+                        gatt_client_stop_listening_for_characteristic_value_updates(&session->notification_listener);
+                        discover_service(session);
+                        break;
+                    }
                     if (att_status != ATT_ERROR_SUCCESS) break;
-                    state = TC_W4_READY;
-                    LOG_INFO("CLIENTE PRONTO! Aguardando notificações do servidor...");
+                    if (!session->cached) server_cache_store(session);
+                    session->state = TC_W4_READY;
+                    LOG_INFO("[%u] CLIENTE PRONTO! Aguardando notificações de %s...", source, bd_addr_to_str(session->addr));
+                    start_time_sync(session);
                     break;
                 default:
                     break;
@@ -185,36 +1393,92 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
                 case GATT_EVENT_NOTIFICATION: {
                     uint16_t value_length = gatt_event_notification_get_value_length(packet);
                     const uint8_t *value = gatt_event_notification_get_value(packet);
-                    LOG_INFO("Notificação recebida (len: %d)", value_length);
-                    // Neste exemplo, espera-se que a notificação tenha
-                    // 4 bytes; utilizamos os 2 primeiros como valor de
-                    // 16 bits em little endian, compatível com a
-                    // variável `global_callback_message`.
-                    if (value_length == 4) {    // apparently messages are 4bytes?
-                        *global_callback_message = little_endian_read_16(value, 0);
-                        // Chama a função de callback da aplicação para
-                        // reagir ao novo valor recebido.
-                        global_callback_task();
-                        LOG_INFO("Valor lido: %d", *global_callback_message);
+                    if (session->first_notification_pending) {
+                        // Tempo morto desde a entrada na fila de conexão.
+                        session->first_notification_pending = false;
+                        LOG_INFO("[%u] Primeira notificação %u ms após a fila de conexão (%s)", source,
+                                 (unsigned)((time_us_32() - session->queued_us) / 1000U),
+                                 session->cached ? "handles guardados" : "descoberta completa");
+                    }
+                    if (session->using_batches) {
+                        handle_sample_batch(session, value, value_length);
+                        break;
+                    }
+                    LOG_INFO("[%u] Notificação recebida (len: %d)", source, value_length);
+                    // O valor tem 2 bytes (uint16 little endian). Firmwares
+                    // antigos do servidor enviavam o tamanho de um
+                    // ponteiro (4 ou 8 bytes); os 2 primeiros são o valor.
+                    if (value_length >= 2) {
+                        uint16_t sample = little_endian_read_16(value, 0);
+                        if (global_batch_handler != NULL) {
+                            // Sem índice no valor: usa o contador local.
+                            global_batch_handler(source, (uint16_t)session->received_samples, 0, 0, &sample, 1);
+                        }
+                        session->received_samples++;
+                        // Entrega o valor à aplicação, com a origem.
+                        deliver_sample(session, sample, 0);
+                        LOG_INFO("[%u] Valor lido: %d", source, sample);
                     } else {
-                        LOG_WARN("Comprimento inesperado: %d", value_length);
+                        LOG_WARN("[%u] Comprimento inesperado: %d", source, value_length);
                     }
                     break;
                 }
                 default:
-                    LOG_WARN("Packet type desconhecido no estado READY: 0x%02x", hci_event_packet_get_type(packet));
+                    LOG_WARN("[%u] Packet type desconhecido no estado READY: 0x%02x", source, hci_event_packet_get_type(packet));
                     break;
             }
             break;
         default:
-            LOG_WARN("Estado desconhecido na máquina de estados GATT");
+            LOG_WARN("[%u] Estado desconhecido na máquina de estados GATT", source);
             break;
     }
 }
 
+// Conexão LE concluída (ou falha ao criar): a sessão em conexão passa à
+// troca de MTU, e o controlador fica livre para conectar o próximo
+// periférico enquanto esta sessão faz a descoberta.
+static void handle_connection_complete(uint8_t *packet) {
+    bd_addr_t peer;
+    hci_subevent_le_connection_complete_get_peer_address(packet, peer);
+    uint8_t status = hci_subevent_le_connection_complete_get_status(packet);
+    hci_con_handle_t handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+    client_session_t *session = session_for_addr(peer);
+    if (session == NULL || session->state != TC_W4_CONNECT) {
+        // Conexão que chegou depois de a tentativa ser cancelada.
+        if (status == ERROR_CODE_SUCCESS) gap_disconnect(handle);
+        return;
+    }
+    btstack_run_loop_remove_timer(&connect_timer);
+    if (connecting_session == session) connecting_session = NULL;
+    if (status != ERROR_CODE_SUCCESS) {
+        LOG_WARN("[%u] Falha ao conectar a %s (status 0x%02x)", session_index(session), bd_addr_to_str(peer), status);
+        session->state = TC_OFF;
+        connect_next();
+        return;
+    }
+    session->connection_handle = handle;
+    session->conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+    session->conn_latency = hci_subevent_le_connection_complete_get_conn_latency(packet);
+    session->supervision_timeout = hci_subevent_le_connection_complete_get_supervision_timeout(packet);
+    session->tx_phy = LINK_PHY_1M;
+    session->rx_phy = LINK_PHY_1M;
+    session->max_tx_octets = LINK_DEFAULT_OCTETS;
+    session->max_rx_octets = LINK_DEFAULT_OCTETS;
+    session->backlog_done = false;
+    session->backlog_end_received = false;
+    report_link_params(session, "criada");
+    request_high_throughput(session);
+    // Conexão LE estabelecida: negociamos o maior ATT MTU possível antes
+    // da descoberta do serviço primário de Environmental Sensing.
+    LOG_INFO("[%u] Conectado a %s! Negociando ATT MTU...", session_index(session), bd_addr_to_str(peer));
+    session->state = TC_W4_MTU_EXCHANGE;
+    gatt_client_send_mtu_negotiation(handle_gatt_client_event, handle);
+    connect_next();
+}
+
 // Handler de eventos HCI genéricos (nível GAP/HCI).
-// Ele coordena o início do scan, a conexão com o servidor, o
-// tratamento da conclusão da conexão e a reação à desconexão.
+// Ele coordena o scan, a conexão com cada servidor, o tratamento da
+// conclusão das conexões e a reação às desconexões.
 static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
     UNUSED(size);
     UNUSED(channel);
@@ -227,54 +1491,113 @@ static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
             if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING) {
                 gap_local_bd_addr(local_addr);
                 LOG_INFO("BTstack operacional no endereço %s", bd_addr_to_str(local_addr));
-                // Quando a pilha está pronta, iniciamos o processo de scan.
-                client_start();
+                // Quando a pilha está pronta, conectamos direto aos
+                // servidores guardados ou iniciamos o processo de scan.
+                stack_working = true;
+#if CLIENT_BROADCAST
+                // Broadcast: scan passivo contínuo, sem filtro de
+                // duplicados (o endereço se repete a cada anúncio).
+                LOG_INFO("Modo broadcast: scan passivo, sem conexões");
+                scanning = true;
+                gap_set_scan_duplicate_filter(false);
+                gap_set_scan_parameters(0, 0x0030, 0x0030);
+                gap_start_scan();
+                break;
+#endif
+                connect_next();
             } else {
-                state = TC_OFF;
+                stack_working = false;
+                scanning = false;
             }
             break;
-        case GAP_EVENT_ADVERTISING_REPORT:
-            if (state != TC_W4_SCAN_RESULT) return;
+        case GAP_EVENT_ADVERTISING_REPORT: {
+            if (CLIENT_BROADCAST) {
+                handle_broadcast_report(packet);
+                break;
+            }
+            if (!scanning && connecting_session == NULL) return;
             // Verifica se o anúncio contém o serviço desejado.
             if (!advertisement_report_contains_service(ORG_BLUETOOTH_SERVICE_ENVIRONMENTAL_SENSING, packet)) return;
-            // store address and type
-            gap_event_advertising_report_get_address(packet, server_addr);
-            server_addr_type = static_cast<bd_addr_type_t>(gap_event_advertising_report_get_address_type(packet));
-            // Para o scan e tenta conectar ao dispositivo encontrado.
-            state = TC_W4_CONNECT;
-            gap_stop_scan();
-            LOG_INFO("Servidor encontrado! Conectando a %s...", bd_addr_to_str(server_addr));
-            gap_connect(server_addr, server_addr_type);
-            break;
+            bd_addr_t addr;
+            gap_event_advertising_report_get_address(packet, addr);
+            // Servidor já conectado (ou na fila), ou nenhuma sessão livre.
+            if (session_for_addr(addr) != NULL) return;
+            client_session_t *session = free_session(addr);
+            if (session == NULL) return;
+            // Entra na fila de conexão; anúncios de outros servidores que
+            // chegarem antes de o scan parar também entram, e são
+            // conectados em seguida, sem novo scan.
+            queue_session(session, addr, static_cast<bd_addr_type_t>(gap_event_advertising_report_get_address_type(packet)));
+            LOG_INFO("Servidor encontrado: %s (origem %u)", bd_addr_to_str(addr), session_index(session));
+            connect_next();
+            break;}
         case HCI_EVENT_LE_META:
             // wait for connection complete
             switch (hci_event_le_meta_get_subevent_code(packet)) {
                 case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
-                    if (state != TC_W4_CONNECT) return;
-                    connection_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
-                    // Conexão LE estabelecida, iniciamos a descoberta
-                    // do serviço primário de Environmental Sensing.
-                    LOG_INFO("Conectado! Iniciando descoberta de serviços (Environmental Sensing)...");
-                    state = TC_W4_SERVICE_RESULT;
-                    gatt_client_discover_primary_services_by_uuid16(handle_gatt_client_event, connection_handle, ORG_BLUETOOTH_SERVICE_ENVIRONMENTAL_SENSING);
+                    handle_connection_complete(packet);
                     break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE: {
+                    // Novos parâmetros: pedidos por nós ou pelo servidor
+                    // (aceitos pela BTstack dentro da faixa padrão).
+                    client_session_t *session = session_for_handle(hci_subevent_le_connection_update_complete_get_connection_handle(packet));
+                    if (session == NULL || hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                    session->conn_interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                    session->conn_latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+                    session->supervision_timeout = hci_subevent_le_connection_update_complete_get_supervision_timeout(packet);
+                    report_link_params(session, "atualizada");
+                    break;}
+                case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE: {
+                    client_session_t *session = session_for_handle(hci_subevent_le_phy_update_complete_get_connection_handle(packet));
+                    if (session == NULL) break;
+                    uint8_t status = hci_subevent_le_phy_update_complete_get_status(packet);
+                    if (status != ERROR_CODE_SUCCESS) {
+                        LOG_WARN("[%u] PHY recusado (status 0x%02x), segue em %s", session_index(session), status, link_phy_name(session->tx_phy));
+                        break;
+                    }
+                    session->tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+                    session->rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+                    LOG_INFO("[%u] PHY TX %s, RX %s", session_index(session), link_phy_name(session->tx_phy), link_phy_name(session->rx_phy));
+                    break;}
+                case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE: {
+                    client_session_t *session = session_for_handle(hci_subevent_le_data_length_change_get_connection_handle(packet));
+                    if (session == NULL) break;
+                    session->max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+                    session->max_rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+                    LOG_INFO("[%u] PDUs de dados de até %u bytes (TX), %u bytes (RX)", session_index(session), session->max_tx_octets, session->max_rx_octets);
+                    break;}
                 default:
                     break;
             }
             break;
-        case HCI_EVENT_DISCONNECTION_COMPLETE:
+        case HCI_EVENT_DISCONNECTION_COMPLETE: {
+            client_session_t *session = session_for_handle(hci_event_disconnection_complete_get_connection_handle(packet));
+            if (session == NULL) break;
             // unregister listener
-            connection_handle = HCI_CON_HANDLE_INVALID;
-            if (listener_registered){
-                listener_registered = false;
-                gatt_client_stop_listening_for_characteristic_value_updates(&notification_listener);
+            if (session->listener_registered){
+                session->listener_registered = false;
+                gatt_client_stop_listening_for_characteristic_value_updates(&session->notification_listener);
             }
-            LOG_INFO("Desconectado de %s", bd_addr_to_str(server_addr));
-            if (state == TC_OFF) break;
-            // Se não foi um desligamento definitivo, tenta reiniciar o
-            // processo de scan para reconectar automaticamente.
-            client_start();
-            break;
+            if (session->backlog_listener_registered){
+                session->backlog_listener_registered = false;
+                gatt_client_stop_listening_for_characteristic_value_updates(&session->backlog_listener);
+            }
+            btstack_run_loop_remove_timer(&session->time_sync_timer);
+            LOG_INFO("[%u] Desconectado de %s", session_index(session), bd_addr_to_str(session->addr));
+#if CLIENT_FAST_RECONNECT
+            // Reconexão direta ao mesmo endereço, sem scan; se o servidor
+            // não responder a tempo, a sessão fica livre e o scan recomeça.
+            bd_addr_t addr;
+            bd_addr_copy(addr, session->addr);
+            queue_session(session, addr, session->addr_type);
+#else
+            // A sessão fica livre e o scan recomeça para reconectar
+            // automaticamente.
+            session->state = TC_OFF;
+            session->connection_handle = HCI_CON_HANDLE_INVALID;
+#endif
+            connect_next();
+            break;}
         default:
             break;
     }
@@ -284,13 +1607,18 @@ static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
 // estado visual do LED a bordo (CYW43_WL_GPIO_LED_PIN).
 // Comportamento:
 //  - pisca lentamente quando não há listener registrado;
-//  - alterna entre pulsos rápidos quando há notificações ativas,
-//    servindo como indicação visual do estado da conexão BLE.
+//  - alterna entre pulsos rápidos quando há notificações ativas em
+//    alguma sessão, servindo como indicação visual do estado da conexão BLE.
 static void heartbeat_handler(struct btstack_timer_source *ts) {
     // Invert the led
     static bool quick_flash;
     static bool led_on = true;
 
+    bool listener_registered = false;
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].listener_registered || broadcasts[i].in_use) listener_registered = true;
+    }
+
     led_on = !led_on;
     cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_on);
     if (listener_registered && led_on) {
@@ -304,10 +1632,42 @@ static void heartbeat_handler(struct btstack_timer_source *ts) {
     btstack_run_loop_add_timer(ts);
 }
 
+// Encaminha os logs internos da BTstack (log_info/log_error) para o
+// log_vt100 com a tag "BTSTACK". Todas as mensagens da pilha
+// compartilham um único ponto de chamada, com filtro de nível e
+// limitação de taxa aplicados antes da formatação. Pacotes HCI não são
+// registrados.
+static log_site_t btstack_log_site = LOG_SITE_INIT(BTSTACK_LOG_TAG, "BTstack");
+
+static void btstack_log_reset(void) {
+}
+
+static void btstack_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    UNUSED(packet_type);
+    UNUSED(in);
+    UNUSED(packet);
+    UNUSED(len);
+}
+
+static void btstack_log_message(int log_level, const char * format, va_list argptr) {
+    log_level_t level = LOG_LEVEL_DEBUG;
+    if (log_level == HCI_DUMP_LOG_LEVEL_INFO) level = LOG_LEVEL_INFO;
+    if (log_level == HCI_DUMP_LOG_LEVEL_ERROR) level = LOG_LEVEL_WARN;
+    if (!log_site_check(&btstack_log_site, level)) return;
+    log_vwrite_tagged(level, BTSTACK_LOG_TAG, format, argptr);
+}
+
+static const hci_dump_t btstack_log_dump = {
+    &btstack_log_reset,
+    &btstack_log_packet,
+    &btstack_log_message,
+};
+
 // Inicializa o cliente BLE:
 //  - armazena o callback da aplicação e a variável de mensagem;
 //  - inicializa o driver CYW43 (Wi-Fi/Bluetooth do Pico W);
-//  - configura a L2CAP, Security Manager (SM) e servidor ATT vazio;
+//  - configura a L2CAP, Security Manager (SM) e servidor ATT com a
+//    característica de estatísticas de latência;
 //  - inicializa o cliente GATT;
 //  - registra o handler de eventos HCI;
 //  - configura e agenda o timer de heartbeat para o LED.
@@ -323,19 +1683,36 @@ int bt_client_init(void(*task)(void), uint16_t* message) {
 
     LOG_DEBUG("cyw43_arch_init() sucesso");
 
+    // Logs internos da BTstack passam pelo log_vt100 (tag "BTSTACK").
+    log_set_tag_level(BTSTACK_LOG_TAG, BTSTACK_LOG_LEVEL);
+    hci_dump_init(&btstack_log_dump);
+
     l2cap_init();
     sm_init();
     sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
 
-    // setup empty ATT server - only needed if LE Peripheral does ATT queries on its own, e.g. Android and iOS
-    att_server_init(NULL, NULL, NULL);
+    // Servidor ATT com a base do cliente (`client_profile.gatt`): atende
+    // consultas do periférico (ex.: Android e iOS) e expõe a
+    // característica "Latency Stats".
+    latency_hist_reset(&latency_hist);
+    att_server_init(profile_data, att_read_callback, NULL);
+
+    // Servidores da última execução (banco TLV configurado pelo
+    // cyw43_arch_init), para reconectar sem scan.
+    server_cache_load();
 
     gatt_client_init();
+    // A troca de MTU é feita explicitamente logo após a conexão
+    // (estado TC_W4_MTU_EXCHANGE), e não de forma implícita na primeira
+    // consulta GATT.
+    gatt_client_mtu_enable_auto_negotiation(0);
     LOG_DEBUG("L2CAP, SM, ATT Server e GATT Client inicializados");
 
     hci_event_callback_registration.callback = &hci_event_handler;
     hci_add_event_handler(&hci_event_callback_registration);
 
+    connect_timer.process = &connect_timeout_handler;
+
     // set one-shot btstack timer
     heartbeat.process = &heartbeat_handler;
     btstack_run_loop_set_timer(&heartbeat, LED_SLOW_FLASH_DELAY_MS);
@@ -356,3 +1733,69 @@ void bt_client_start() {
     btstack_run_loop_execute();
 }
 
+// Inicializa o cliente BLE entregando cada valor com a sua origem.
+int bt_client_init_tagged(void(*task)(uint8_t source, uint16_t value)) {
+    global_sample_handler = task;
+    return bt_client_init(NULL, NULL);
+}
+
+// Escolhe o perfil de parâmetros de conexão: vale para as próximas
+// conexões (criadas já com ele) e é aplicado às atuais, sem reconectar.
+int bt_client_set_link_profile(link_profile_t profile) {
+    const link_profile_params_t *params = link_profile_params(profile);
+    if (params == NULL) return -1;
+    link_profile = profile;
+    LOG_INFO("Perfil de conexão: %s", params->name);
+    gap_set_connection_parameters(0x0060, 0x0030, params->interval_min, params->interval_max,
+                                  params->latency, params->supervision_timeout, 0, 0);
+    for (uint8_t i = 0; i < CLIENT_MAX_SERVERS; i++) {
+        if (sessions[i].state > TC_W4_CONNECT) apply_link_profile(&sessions[i]);
+    }
+    return 0;
+}
+
+// Escreve uma configuração no ponto de controle do servidor `source`.
+int bt_client_write_control(uint8_t source, const sample_control_t* control) {
+    if (source >= CLIENT_MAX_SERVERS) return -1;
+    client_session_t *session = &sessions[source];
+    if (session->state != TC_W4_READY || !session->control_characteristic_found) return -1;
+    if (session->control_write_pending) return -2;
+
+    uint16_t len = sample_control_encode(session->control_write_value, sizeof(session->control_write_value), control);
+    uint8_t status = gatt_client_write_value_of_characteristic(handle_control_write_event, session->connection_handle,
+        session->control_characteristic.value_handle, len, session->control_write_value);
+    if (status != ERROR_CODE_SUCCESS) {
+        LOG_WARN("[%u] Ponto de controle: escrita não iniciada (status 0x%02x)", source, status);
+        return -3;
+    }
+    session->control_write_pending = true;
+    LOG_INFO("[%u] Ponto de controle: enviando configuração (campos 0x%02X)", source, control->fields);
+    return 0;
+}
+
+// Inicializa o cliente BLE entregando cada valor com a sua origem e o
+// instante de captura no relógio do cliente.
+int bt_client_init_timed(void(*task)(uint8_t source, uint16_t value, uint64_t capture_us)) {
+    global_timed_handler = task;
+    return bt_client_init(NULL, NULL);
+}
+
+// Traduz um instante do relógio do servidor `source` para o do cliente.
+uint64_t bt_client_server_time_to_local(uint8_t source, uint32_t server_us) {
+    if (source >= CLIENT_MAX_SERVERS) return 0;
+    const client_session_t *session = &sessions[source];
+    if (session->state != TC_W4_READY) return 0;
+    return time_sync_to_local(&session->time_sync, server_us);
+}
+
+// Registra o callback das amostras baixadas do registro em flash.
+void bt_client_set_backlog_handler(void(*handler)(uint8_t source, uint32_t capture_us, uint32_t period_us,
+                                                  const uint16_t* samples, uint16_t count)) {
+    global_backlog_handler = handler;
+}
+
+// Registra o callback de lotes inteiros.
+void bt_client_set_batch_handler(void(*handler)(uint8_t source, uint16_t first_index, uint64_t capture_us,
+                                                uint32_t period_us, const uint16_t* samples, uint16_t count)) {
+    global_batch_handler = handler;
+}
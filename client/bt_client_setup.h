@@ -1,3 +1,6 @@
+#include "sample_control.h"
+#include "link_profile.h"
+
 // Tempo, em milissegundos, para o LED piscar rapidamente
 // usado para indicar atividade de comunicação BLE (notificações ativas)
 #define LED_QUICK_FLASH_DELAY_MS 100
@@ -17,7 +20,88 @@
 //  - valor negativo em caso de falha na inicialização do hardware/BLE.
 int bt_client_init(void(*task)(void), uint16_t* message);
 
+// Variante de `bt_client_init` para vários servidores
+// (CLIENT_MAX_SERVERS): cada valor recebido é entregue junto da sua
+// origem, em vez de gravado numa variável única.
+// Parâmetros:
+//  - task: callback chamado a cada valor recebido, com `source` = índice
+//          da sessão do servidor (0 a CLIENT_MAX_SERVERS - 1, atribuído
+//          na ordem de descoberta e reaproveitado após desconexão) e
+//          `value` = amostra de 16 bits.
+// Retorno: como em `bt_client_init`.
+int bt_client_init_tagged(void(*task)(uint8_t source, uint16_t value));
+
+// Variante de `bt_client_init_tagged` que entrega, junto de cada valor,
+// o instante em que ele foi capturado no servidor, já no relógio do
+// cliente (`time_us_64()`), pela sincronização de relógios com cada
+// servidor (característica "Time Sync"). O instante vem dos lotes com
+// instante de captura (servidor com SERVER_SAMPLE_TIMESTAMPS); é 0 antes
+// da primeira rodada de sincronização, sem instante no lote ou com o
+// servidor sem "Time Sync".
+// Retorno: como em `bt_client_init`.
+int bt_client_init_timed(void(*task)(uint8_t source, uint16_t value, uint64_t capture_us));
+
 // Inicia efetivamente o cliente BLE, ligando o controlador HCI e
 // entrando no laço de execução (run loop) da BTstack. Esta função
 // bloqueia a execução enquanto a pilha Bluetooth estiver ativa.
 void bt_client_start();
+
+// Escolhe o perfil de parâmetros de conexão (ver
+// lib/sample_stream/link_profile.h): baixa latência (7,5 ms), equilibrado
+// ou economia de energia. As próximas conexões já são criadas com ele, e
+// as atuais são atualizadas (HCI LE Connection Update) sem reconectar. Os
+// parâmetros concedidos pelo controlador aparecem no log. Pedidos do
+// servidor feitos depois prevalecem. Deve ser chamada depois de
+// `bt_client_init*` e, em funcionamento, do contexto da BTstack.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo se o perfil for inválido.
+int bt_client_set_link_profile(link_profile_t profile);
+
+// Ajusta o servidor em tempo de execução pelo ponto de controle
+// ("Sample Control"): taxa de amostragem, intervalo de notificação,
+// tamanho do lote, média, banda morta e keep-alive, sem derrubar a
+// conexão. Só os campos marcados em `control->fields` são alterados
+// (ver lib/sample_stream/sample_control.h). A escrita é assíncrona; o
+// resultado (aceita ou recusada pelo servidor) aparece no log.
+// `source` escolhe o servidor, como em `bt_client_init_tagged`.
+// Deve ser chamada do contexto da BTstack (ex.: callback da aplicação).
+// Retorno:
+//  - 0 se a escrita foi iniciada;
+//  - -1 se não houver conexão pronta com `source` ou o servidor não
+//    tiver o ponto de controle;
+//  - -2 se outra escrita ainda estiver em andamento;
+//  - -3 se a pilha recusar o pedido (cliente GATT ocupado).
+int bt_client_write_control(uint8_t source, const sample_control_t* control);
+
+// Recebe as amostras guardadas pelo servidor no registro em flash
+// (SERVER_FLASH_LOG) enquanto não havia cliente: ao conectar, antes de
+// assinar o fluxo ao vivo, o cliente baixa o registro (ver
+// lib/sample_stream/sample_backlog.h) e entrega cada parte a `handler`,
+// com a origem, o instante de captura da primeira amostra, o período
+// entre amostras (em microssegundos, no relógio do servidor) e as
+// amostras. O fluxo ao vivo continua logo depois da última amostra
+// baixada. Sem callback (ou com NULL), as amostras só são contadas no log.
+// Deve ser chamada antes de `bt_client_start`.
+void bt_client_set_backlog_handler(void(*handler)(uint8_t source, uint32_t capture_us, uint32_t period_us,
+                                                  const uint16_t* samples, uint16_t count));
+
+// Recebe cada lote inteiro, de uma vez, antes da entrega amostra por
+// amostra ao callback de `bt_client_init*` (ex.: para repassar o fluxo ao
+// PC sem custo por amostra). `handler` recebe a origem, o índice da
+// primeira amostra (nos servidores sem lotes, um contador local), o
+// instante de captura da primeira amostra no relógio do cliente e o
+// período entre amostras, em microssegundos (0 quando desconhecidos, como
+// em `bt_client_init_timed`), e as amostras. No modo broadcast, só as
+// amostras novas de cada anúncio são repassadas, sem instante.
+// Deve ser chamada antes de `bt_client_start`.
+void bt_client_set_batch_handler(void(*handler)(uint8_t source, uint16_t first_index, uint64_t capture_us,
+                                                uint32_t period_us, const uint16_t* samples, uint16_t count));
+
+// Traduz o instante `server_us` do relógio do servidor `source`
+// (`time_us_32()` dele, como nos lotes e no registro em flash) para o
+// relógio do cliente (`time_us_64()`). Vale para instantes até cerca de
+// 35 minutos antes ou depois da última rodada de sincronização.
+// Retorno: o instante no relógio do cliente, ou 0 se não houver conexão
+// pronta com `source` ou a sincronização ainda não tiver estimativa.
+uint64_t bt_client_server_time_to_local(uint8_t source, uint32_t server_us);
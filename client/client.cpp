@@ -8,10 +8,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "hardware/pwm.h"
+#include "pico/multicore.h"
 #include "pico/stdlib.h"
 
+#define LOG_TAG "APP"     // tag deste módulo nos logs
 #include "log_vt100.h" // Biblioteca de Logging VT100
 #include "bt_client_setup.h"  // interface de configuração e inicialização do cliente BLE
+#include "usb_stream.h"       // fluxo binário das amostras pela USB CDC
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -21,19 +24,105 @@
 // o brilho de um LED ou a velocidade de um motor.
 #define PIN_PWM 21U  // Constante que define o pino GPIO para PWM
 
-// Variável global que armazena o valor de duty cycle recebido via BLE.
-// O valor é de 0 a 65535 (16 bits), compatível com a resolução padrão do PWM.
-uint16_t _received_duty_;  // Variável global para armazenar o duty cycle recebido
+// Servidores conectados ao mesmo tempo (definido pelo CMake).
+#ifndef CLIENT_MAX_SERVERS
+#define CLIENT_MAX_SERVERS 1
+#endif
+
+// Perfil de parâmetros de conexão (definido pelo CMake): um dos
+// LINK_PROFILE_* de lib/sample_stream/link_profile.h.
+#ifndef CLIENT_LINK_PROFILE
+#define CLIENT_LINK_PROFILE LINK_PROFILE_LOW_LATENCY
+#endif
+
+// Pinos PWM por origem (servidor), quando o cliente conecta a vários
+// periféricos (CLIENT_MAX_SERVERS): a origem 0 usa PIN_PWM, as demais
+// seguem nos GPIOs abaixo dele.
+static const uint pwm_pins[] = {PIN_PWM, 20U, 19U, 18U};
+#define PWM_PIN_COUNT (sizeof(pwm_pins) / sizeof(pwm_pins[0]))
+
+// Variável global que armazena o valor de duty cycle recebido via BLE,
+// por origem. O valor é de 0 a 65535 (16 bits), compatível com a
+// resolução padrão do PWM.
+uint16_t _received_duty_[PWM_PIN_COUNT];  // duty cycle recebido de cada servidor
+
+// Intervalo, em milissegundos, entre drenagens do log assíncrono no core 1.
+#define LOG_DRAIN_PERIOD_MS 10U
+
+// Limitação de taxa dos logs: cada ponto de chamada emite até
+// LOG_RATE_BURST mensagens seguidas e, depois, no máximo
+// LOG_RATE_PER_SECOND por segundo.
+#define LOG_RATE_PER_SECOND 5U
+#define LOG_RATE_BURST      10U
+
+// Fluxo binário das amostras pela USB CDC (definido pelo CMake): cada
+// lote recebido vira um quadro, capturado no PC com
+// lib/usb_stream/tools/usb_stream_capture.py.
+#ifndef CLIENT_USB_STREAM
+#define CLIENT_USB_STREAM 0
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Laço do core 1: drena o log assíncrono para a saída padrão.
+// O core 0 fica preso no run loop da BTstack (`bt_client_start`), então a
+// escrita lenta na USB CDC é delegada ao outro núcleo; o caminho de
+// notificações apenas copia as mensagens para o anel do log.
+void log_drain_core1(void) {
+  // Permite que o core 0 pause este núcleo com segurança durante
+  // escritas na flash (servidores guardados no banco TLV da BTstack).
+  multicore_lockout_victim_init();
+  while (true) {
+    log_flush(0);
+    // Com o fluxo binário ativo, volta logo enquanto houver quadros.
+    if (CLIENT_USB_STREAM && usb_stream_flush() != 0) continue;
+    sleep_ms(LOG_DRAIN_PERIOD_MS);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Repassa um lote recebido ao fluxo binário (USB CDC). Só copia o quadro
+// para o anel; a escrita é feita pelo core 1.
+void stream_batch(uint8_t source, uint16_t first_index, uint64_t capture_us, uint32_t period_us,
+                  const uint16_t* samples, uint16_t count) {
+  usb_stream_samples_t header = {};
+  header.source = source;
+  header.flags = capture_us != 0 ? USB_STREAM_FLAG_CAPTURE : 0;
+  header.first_index = first_index;
+  header.count = count;
+  header.rx_us = time_us_64();
+  header.capture_us = capture_us;
+  header.period_us = period_us;
+  usb_stream_write_samples(&header, samples);
+}
+
+// Repassa ao fluxo binário uma parte do registro em flash do servidor. O
+// download acontece antes da sincronização de relógios: o instante fica
+// no relógio do servidor.
+void stream_backlog(uint8_t source, uint32_t capture_us, uint32_t period_us, const uint16_t* samples,
+                    uint16_t count) {
+  usb_stream_samples_t header = {};
+  header.source = source;
+  header.flags = USB_STREAM_FLAG_SERVER_CLOCK | USB_STREAM_FLAG_BACKLOG;
+  header.count = count;
+  header.rx_us = time_us_64();
+  header.capture_us = capture_us;
+  header.period_us = period_us;
+  usb_stream_write_samples(&header, samples);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
 // Função de callback chamada quando um novo valor é recebido via BLE.
-// Ela aplica o duty cycle armazenado em `_received_duty_` ao canal PWM
-// associado ao pino `PIN_PWM`.
-void set_duty(void) {
+// Ela guarda o duty cycle em `_received_duty_` e o aplica ao canal PWM
+// associado à origem (servidor) do valor.
+void set_duty(uint8_t source, uint16_t value) {
+  if (source >= PWM_PIN_COUNT) return;
+  _received_duty_[source] = value;
   // Atualiza o nível de saída do PWM com o novo duty cycle recebido
-  pwm_set_gpio_level(PIN_PWM, _received_duty_);
-  LOG_DEBUG("Callback set_duty acionado. PWM atualizado para: %u", _received_duty_);
+  pwm_set_gpio_level(pwm_pins[source], value);
+  LOG_DEBUG("Callback set_duty acionado. PWM %u atualizado para: %u", source, value);
  }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,12 +137,12 @@ void set_duty(void) {
 //     aumentando a resolução do duty cycle de forma adequada.
 //  5. Inicializa o slice com a configuração escolhida e habilita o PWM.
 //  6. Garante que o duty cycle inicial seja 0 (saída desligada).
-void init_pwm() {
-  LOG_INFO("Configurando PWM no pino %d...", PIN_PWM);
+void init_pwm(uint pin) {
+  LOG_INFO("Configurando PWM no pino %d...", pin);
   // Configura o pino GPIO para função PWM
-  gpio_set_function(PIN_PWM, GPIO_FUNC_PWM);
+  gpio_set_function(pin, GPIO_FUNC_PWM);
   // Obtém o "slice" de PWM associado ao pino
-  uint slice_num = pwm_gpio_to_slice_num(PIN_PWM);
+  uint slice_num = pwm_gpio_to_slice_num(pin);
   // Carrega a configuração padrão de PWM
   pwm_config config = pwm_get_default_config();
   // Ajusta o divisor de clock para reduzir a frequência
@@ -61,7 +150,7 @@ void init_pwm() {
   // Inicializa o slice com a configuração escolhida e habilita o PWM
   pwm_init(slice_num, &config, true);
   // Garante que o duty cycle inicial seja 0 (saída desligada)
-  pwm_set_gpio_level(PIN_PWM, 0U);
+  pwm_set_gpio_level(pin, 0U);
   LOG_DEBUG("PWM inicializado (slice %u, clkdiv 40.0)", slice_num);
 }
 
@@ -71,37 +160,50 @@ void init_pwm() {
 // Fluxo geral do algoritmo:
 //  1. Inicializa as rotinas de entrada/saída padrão (UART/USB) com
 //     `stdio_init_all`, permitindo uso de `printf` para depuração.
-//  2. Configura o módulo de PWM para controlar o pino definido.
+//  2. Configura o módulo de PWM para controlar um pino por servidor.
 //  3. Inicializa o cliente Bluetooth LE, registrando a função de
-//     callback `set_duty` e a variável `_received_duty_` como destino
-//     dos valores recebidos.
+//     callback `set_duty`, que recebe cada valor com a sua origem.
 //  4. Inicia a pilha BLE; a partir daqui o código entra no laço
 //     interno da BTstack e reage a eventos (notificações do servidor).
-//  5. Quando novas notificações chegam, o valor é armazenado em
-//     `_received_duty_` e `set_duty` é chamada, atualizando o PWM.
+//  5. Quando novas notificações chegam, `set_duty` é chamada com a
+//     origem e o valor, atualizando o PWM daquele servidor.
 int main() {
     // Inicializa as rotinas de entrada/saída padrão (UART/USB)
     stdio_init_all();
 
     // Configura nível de log padrão
     log_set_level(LOG_LEVEL_INFO);
+    log_set_rate_limit(LOG_RATE_PER_SECOND, LOG_RATE_BURST);
 
     LOG_INFO("Iniciando cliente BLE - Demo Pico W");
     LOG_INFO("Passo 1: Inicializando entrada/saída padrão");
 
-    // Configura o módulo de PWM para controlar o pino definido
+    // Configura o módulo de PWM: um pino por servidor
     LOG_INFO("Passo 2: Inicializando hardware PWM");
-    init_pwm();
+    for (uint i = 0; i < CLIENT_MAX_SERVERS && i < PWM_PIN_COUNT; i++) {
+      init_pwm(pwm_pins[i]);
+    }
 
     // Inicializa o cliente Bluetooth LE
-    LOG_INFO("Passo 3: Inicializando cliente Bluetooth LE (bt_client_init)");
-    if (bt_client_init(&set_duty, &_received_duty_) != 0) {
+    LOG_INFO("Passo 3: Inicializando cliente Bluetooth LE (bt_client_init_tagged)");
+    if (bt_client_init_tagged(&set_duty) != 0) {
         LOG_WARN("Falha ao inicializar cliente BT!");
         return -1;
     }
+    bt_client_set_link_profile(CLIENT_LINK_PROFILE);
+    if (CLIENT_USB_STREAM) {
+      LOG_INFO("Fluxo binário das amostras ativo na USB CDC");
+      bt_client_set_batch_handler(&stream_batch);
+      bt_client_set_backlog_handler(&stream_backlog);
+    }
+
+    // Delega a escrita do log ao core 1
+    LOG_INFO("Passo 4: Iniciando drenagem do log assíncrono no core 1");
+    log_set_mode(LOG_MODE_ASYNC);
+    multicore_launch_core1(log_drain_core1);
 
     // Inicia a pilha BLE
-    LOG_INFO("Passo 4: Iniciando pilha BLE e loop principal (bt_client_start)");
+    LOG_INFO("Passo 5: Iniciando pilha BLE e loop principal (bt_client_start)");
     bt_client_start();
 
     return 0;
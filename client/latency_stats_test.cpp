@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+// Testes da medição de latência (lib/latency_stats)
+// Só no build de host. Confere:
+//  - `latency_offset`: a primeira medida vale 0; as seguintes, o excedente
+//    sobre o menor atraso bruto; um atraso menor vira a nova referência;
+//    relógio do servidor adiantado (atraso bruto negativo), relógios de
+//    32 bits dando a volta e `reset`;
+//  - `latency_hist`: valores abaixo de 8 us exatos; mínimo, máximo e
+//    média exatos; histograma vazio; valores acima do último balde.
+// Depois simula um fluxo entre dois relógios com origens distintas e
+// atrasos aleatórios, e compara cada latência estimada com o excedente
+// real e os percentis do histograma com os exatos (erro até 1/8).
+//
+// Uso:
+//   latency_stats_test
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "latency_hist.h"
+#include "latency_offset.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Medidas da simulação.
+#define SIM_SAMPLES 20000U
+
+static int failures;
+
+static void check(bool ok, const char* name) {
+    if (ok) return;
+    printf("teste=%s FALHOU\n", name);
+    failures++;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_offset(void) {
+    latency_offset_t offset;
+    latency_offset_reset(&offset);
+    check(latency_offset_apply(&offset, 1000, 6000) == 0, "offset_primeira");
+    check(latency_offset_apply(&offset, 2000, 7250) == 250, "offset_excedente");
+    check(latency_offset_apply(&offset, 3000, 7900) == 0 && offset.offset_us == 4900, "offset_novo_minimo");
+    check(latency_offset_apply(&offset, 4000, 9000) == 100, "offset_apos_novo_minimo");
+
+    // Servidor adiantado: o atraso bruto é negativo.
+    latency_offset_reset(&offset);
+    check(!offset.valid, "offset_reset");
+    check(latency_offset_apply(&offset, 50000, 1000) == 0, "offset_negativo_primeira");
+    check(latency_offset_apply(&offset, 60000, 11300) == 300, "offset_negativo_excedente");
+
+    // Os dois relógios de 32 bits dando a volta em momentos diferentes.
+    latency_offset_reset(&offset);
+    latency_offset_apply(&offset, UINT32_MAX - 100, 2000);
+    check(latency_offset_apply(&offset, 900, 3501) == 500, "offset_volta_relogio");
+}
+
+static void test_hist(void) {
+    latency_hist_t hist;
+    latency_hist_reset(&hist);
+    check(latency_hist_percentile(&hist, 500) == 0 && latency_hist_mean(&hist) == 0, "hist_vazio");
+
+    for (uint32_t us = 0; us < 8; us++) latency_hist_record(&hist, us);
+    bool exact = true;
+    for (uint32_t k = 1; k <= 8; k++) exact = exact && latency_hist_percentile(&hist, k * 125) == k - 1;
+    check(exact, "hist_pequenos_exatos");
+    check(hist.min_us == 0 && hist.max_us == 7 && latency_hist_mean(&hist) == 3, "hist_min_max_media");
+
+    latency_hist_record(&hist, UINT32_MAX);
+    check(hist.max_us == UINT32_MAX && latency_hist_percentile(&hist, 1000) == UINT32_MAX, "hist_acima_do_ultimo");
+    check(latency_hist_percentile(&hist, 990) == UINT32_MAX, "hist_ultimo_balde_usa_maximo");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fluxo de SIM_SAMPLES medidas a cada 1 ms: o relógio do servidor está
+// ~5 s atrás do do cliente e dá a volta nos 32 bits durante a simulação;
+// o atraso real é de 3 ms mais até ~4 ms (quadrado de um uniforme, mais
+// denso perto do mínimo). A latência estimada deve ser o atraso menos o
+// menor atraso visto até ali.
+static void test_simulation(void) {
+    const uint32_t server_offset_us = UINT32_MAX - 5000000u;
+    uint32_t* latencies = (uint32_t*)malloc(SIM_SAMPLES * sizeof(uint32_t));
+    latency_offset_t offset;
+    latency_offset_reset(&offset);
+    latency_hist_t hist;
+    latency_hist_reset(&hist);
+
+    uint32_t noise = 0x1234567u;
+    uint32_t min_delay_us = UINT32_MAX;
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < SIM_SAMPLES; i++) {
+        uint32_t capture_local_us = 1000000u + i * 1000u;
+        noise = noise * 1664525u + 1013904223u;
+        uint32_t tail = noise >> 20;
+        uint32_t delay_us = 3000u + (tail * tail >> 12);
+        if (delay_us < min_delay_us) min_delay_us = delay_us;
+
+        uint32_t latency_us =
+            latency_offset_apply(&offset, capture_local_us + server_offset_us, capture_local_us + delay_us);
+        if (latency_us != delay_us - min_delay_us) mismatches++;
+        latency_hist_record(&hist, latency_us);
+        latencies[i] = latency_us;
+    }
+
+    qsort(latencies, SIM_SAMPLES, sizeof(uint32_t), compare_u32);
+    static const uint32_t per_mille[] = { 500, 900, 990, 999 };
+    uint32_t worst_error = 0;
+    bool percentiles_ok = true;
+    for (size_t k = 0; k < sizeof(per_mille) / sizeof(per_mille[0]); k++) {
+        uint32_t expected = latencies[(SIM_SAMPLES * per_mille[k] + 999) / 1000 - 1];
+        uint32_t actual = latency_hist_percentile(&hist, per_mille[k]);
+        if (actual < expected || actual > expected + expected / 8) percentiles_ok = false;
+        if (actual - expected > worst_error) worst_error = actual - expected;
+    }
+    bool ok = mismatches == 0 && percentiles_ok && hist.max_us == latencies[SIM_SAMPLES - 1];
+    printf("simulacao medidas=%u p50_us=%u p99_us=%u max_us=%u divergentes=%u erro_percentil_us=%u %s\n", hist.count,
+           latency_hist_percentile(&hist, 500), latency_hist_percentile(&hist, 990), hist.max_us, mismatches,
+           worst_error, ok ? "ok" : "FALHOU");
+    check(ok, "simulacao");
+    free(latencies);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+    test_offset();
+    test_hist();
+    printf("testes de unidade %s\n", failures ? "FALHOU" : "ok");
+
+    test_simulation();
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
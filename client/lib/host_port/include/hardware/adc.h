@@ -0,0 +1,30 @@
+#ifndef _HARDWARE_ADC_H
+#define _HARDWARE_ADC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Substituto de `hardware/adc.h` para o build de host. `adc_read` devolve
+// uma rampa triangular de 12 bits com período de 1 s, calculada a partir
+// de `time_us_64`, na entrada selecionada. Com round-robin, cada leitura
+// avança para a próxima entrada da máscara, como no hardware.
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint adc_get_selected_input(void);
+void adc_set_temp_sensor_enabled(bool enable);
+void adc_set_round_robin(uint input_mask);
+uint16_t adc_read(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _PICO_CYW43_ARCH_H
+#define _PICO_CYW43_ARCH_H
+
+#include <stdbool.h>
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Substituto de `pico/cyw43_arch.h` para o build de host: não há chip
+// CYW43, e `cyw43_arch_init` apenas prepara a BTstack sobre o run loop
+// POSIX e o controlador virtual (ver hci_transport_virtual.h).
+
+// GPIO do LED da placa, ligado ao CYW43 no Pico W.
+#define CYW43_WL_GPIO_LED_PIN 0
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_gpio_put(uint wl_gpio, bool value);
+bool cyw43_arch_gpio_get(uint wl_gpio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Substituto de `pico/multicore.h` para o build de host: o "core 1" é
+// uma thread POSIX.
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1(void);
+void multicore_lockout_victim_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
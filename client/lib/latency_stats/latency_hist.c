@@ -0,0 +1,61 @@
+#include "latency_hist.h"
+
+#include <string.h>
+
+// Índice do balde de `us`: os SUB_BITS bits seguintes ao bit mais
+// significativo escolhem o sub-balde dentro da potência de 2.
+static uint32_t bucket_index(uint32_t us) {
+    if (us < LATENCY_HIST_SUB_BUCKETS) return us;
+    uint32_t log2 = 31u - (uint32_t)__builtin_clz(us);
+    if (log2 >= LATENCY_HIST_MAX_LOG2) return LATENCY_HIST_BUCKETS - 1;
+    uint32_t shift = log2 - LATENCY_HIST_SUB_BITS;
+    uint32_t sub = (us >> shift) & (LATENCY_HIST_SUB_BUCKETS - 1);
+    return (shift + 1) * LATENCY_HIST_SUB_BUCKETS + sub;
+}
+
+// Maior valor representado pelo balde `index`.
+static uint32_t bucket_upper_bound(uint32_t index) {
+    if (index < LATENCY_HIST_SUB_BUCKETS) return index;
+    uint32_t shift = index / LATENCY_HIST_SUB_BUCKETS - 1;
+    uint32_t sub = index % LATENCY_HIST_SUB_BUCKETS;
+    uint32_t lower = (LATENCY_HIST_SUB_BUCKETS + sub) << shift;
+    return lower + ((1u << shift) - 1);
+}
+
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    hist->min_us = UINT32_MAX;
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t us) {
+    hist->buckets[bucket_index(us)]++;
+    hist->count++;
+    hist->sum_us += us;
+    if (us < hist->min_us) hist->min_us = us;
+    if (us > hist->max_us) hist->max_us = us;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t per_mille) {
+    if (hist->count == 0) return 0;
+    if (per_mille >= 1000) return hist->max_us;
+
+    // Posição (1..count) do valor procurado, arredondada para cima.
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * per_mille + 999) / 1000);
+    if (rank == 0) rank = 1;
+
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            if (i == LATENCY_HIST_BUCKETS - 1) return hist->max_us;
+            uint32_t bound = bucket_upper_bound(i);
+            return (bound < hist->max_us) ? bound : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+uint32_t latency_hist_mean(const latency_hist_t *hist) {
+    if (hist->count == 0) return 0;
+    return (uint32_t)(hist->sum_us / hist->count);
+}
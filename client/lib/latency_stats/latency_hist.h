@@ -0,0 +1,51 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Histograma de latências em microssegundos, com baldes log-lineares:
+// valores abaixo de 8 us têm um balde cada; a partir daí, cada potência
+// de 2 é dividida em LATENCY_HIST_SUB_BUCKETS baldes iguais. O erro
+// relativo dos percentis fica abaixo de 1/8 (12,5%) em qualquer escala,
+// com memória fixa e registro em tempo constante (sem divisões nem
+// ordenação), próprio para o caminho de recepção das notificações.
+//
+// Valores a partir de 2^LATENCY_HIST_MAX_LOG2 us (~67 s) caem no último
+// balde; `max_us` continua exato.
+
+#define LATENCY_HIST_SUB_BITS    3
+#define LATENCY_HIST_SUB_BUCKETS (1u << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_MAX_LOG2    26
+#define LATENCY_HIST_BUCKETS     ((LATENCY_HIST_MAX_LOG2 - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_BUCKETS)
+
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t count;     // total de valores registrados
+    uint32_t min_us;    // menor valor registrado (exato)
+    uint32_t max_us;    // maior valor registrado (exato)
+    uint64_t sum_us;    // soma, para a média
+} latency_hist_t;
+
+// Zera o histograma.
+void latency_hist_reset(latency_hist_t *hist);
+
+// Registra uma latência de `us` microssegundos.
+void latency_hist_record(latency_hist_t *hist, uint32_t us);
+
+// Percentil `per_mille` (ex.: 500 = p50, 990 = p99), em microssegundos:
+// limite superior do balde que contém o valor, limitado a `max_us`.
+// Retorna 0 se o histograma estiver vazio.
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t per_mille);
+
+// Média dos valores registrados, em microssegundos (0 se vazio).
+uint32_t latency_hist_mean(const latency_hist_t *hist);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_HIST_H
@@ -0,0 +1,16 @@
+#include "latency_offset.h"
+
+void latency_offset_reset(latency_offset_t *offset) {
+    offset->offset_us = 0;
+    offset->valid = false;
+}
+
+uint32_t latency_offset_apply(latency_offset_t *offset, uint32_t sent_us, uint32_t now_us) {
+    int32_t raw_us = (int32_t)(now_us - sent_us);
+    if (!offset->valid || raw_us < offset->offset_us) {
+        offset->offset_us = raw_us;
+        offset->valid = true;
+    }
+    // Sem estouro: raw_us >= offset_us, e a diferença cabe em 32 bits.
+    return (uint32_t)raw_us - (uint32_t)offset->offset_us;
+}
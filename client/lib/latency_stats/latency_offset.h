@@ -0,0 +1,39 @@
+#ifndef LATENCY_OFFSET_H
+#define LATENCY_OFFSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latência entre dois relógios não sincronizados, pela menor diferença.
+//
+// O atraso bruto (recepção no relógio local - envio no relógio remoto)
+// inclui a diferença desconhecida entre os relógios. O menor atraso bruto
+// já observado é tomado como essa diferença, e a latência é o excedente
+// sobre ele: mede o jitter de ponta a ponta, não a latência absoluta (a
+// mínima fica como 0). Um novo mínimo passa a ser a referência; a deriva
+// entre os relógios não é compensada.
+//
+// Com relógio comum ou sincronizado, a latência é o atraso bruto e esta
+// estimativa não é usada.
+typedef struct {
+    int32_t offset_us;  // menor atraso bruto observado
+    bool valid;         // false até a primeira medida
+} latency_offset_t;
+
+// Esquece a diferença (ex.: a cada nova conexão).
+void latency_offset_reset(latency_offset_t *offset);
+
+// Latência, em microssegundos, de uma medida enviada em `sent_us`
+// (relógio remoto) e recebida em `now_us` (relógio local): o excedente
+// do atraso bruto sobre o menor já observado, que é atualizado.
+uint32_t latency_offset_apply(latency_offset_t *offset, uint32_t sent_us, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_OFFSET_H
@@ -2,6 +2,8 @@
 #define LOG_H
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -21,10 +23,84 @@ typedef enum {
     LOG_LEVEL_WARN  = 3,
 } log_level_t;
 
+// Modo de escrita das mensagens:
+//  - SYNC: `log_write` formata e escreve imediatamente com `printf`
+//          (bloqueia enquanto a saída USB/UART estiver ocupada);
+//  - ASYNC: `log_write` apenas formata e copia o registro para um anel em
+//           memória; a escrita em `printf` é feita depois por `log_flush`,
+//           chamada de um laço ocioso, timer ou do outro núcleo. Com o anel
+//           cheio, o registro é descartado e contabilizado, sem bloquear.
+typedef enum {
+    LOG_MODE_SYNC  = 0,
+    LOG_MODE_ASYNC = 1,
+} log_mode_t;
+
 // Define o nível mínimo de log que será exibido em tempo de execução.
 // Mensagens abaixo desse nível são descartadas por `log_write`.
 void log_set_level(log_level_t level);
 
+// Alterna entre os modos síncrono e assíncrono em tempo de execução.
+// Ao voltar para SYNC, os registros pendentes são escritos antes.
+void log_set_mode(log_mode_t mode);
+
+// Modo de escrita atual.
+log_mode_t log_get_mode(void);
+
+// Escreve em `printf` até `max_records` registros pendentes do anel
+// assíncrono (0 = todos). Deve ser chamada por um único contexto (laço
+// ocioso, timer ou core 1). Se houve descartes desde a última chamada,
+// emite em seguida um aviso com a quantidade. Retorna quantos registros
+// foram escritos.
+uint32_t log_flush(uint32_t max_records);
+
+// Total de registros descartados por anel cheio desde a inicialização.
+uint32_t log_dropped_count(void);
+
+// Precisão máxima de `%f`/`%e`/`%g` em `log_vsnprintf`.
+#ifndef LOG_FLOAT_MAX_PRECISION
+#define LOG_FLOAT_MAX_PRECISION 64
+#endif
+
+// Número máximo de tags (módulos) com nível próprio.
+#ifndef LOG_MAX_TAGS
+#define LOG_MAX_TAGS 8
+#endif
+
+// Define o nível mínimo de log de um módulo (tag), sobrepondo o nível
+// global apenas para ele. Pode ser chamada antes ou depois de o módulo
+// registrar a tag em sua primeira mensagem. Retorna 0 em caso de sucesso
+// ou valor negativo se a tabela de tags estiver cheia.
+int log_set_tag_level(const char *tag, log_level_t level);
+
+// Remove o nível próprio de uma tag, que volta a seguir o nível global.
+void log_clear_tag_level(const char *tag);
+
+// Configura a limitação de taxa por ponto de chamada (token bucket):
+// cada macro LOG_* pode emitir até `burst` mensagens seguidas e, depois,
+// no máximo `per_second` mensagens por segundo. As mensagens excedentes
+// são descartadas antes de qualquer formatação, e a próxima mensagem
+// aceita daquele ponto é precedida de um resumo "N mensagens suprimidas".
+// `per_second` = 0 desativa a limitação (padrão).
+void log_set_rate_limit(uint16_t per_second, uint16_t burst);
+
+// Estado de um ponto de chamada das macros LOG_* (uma instância estática
+// por chamada). Guarda a tag resolvida na tabela e o balde de tokens.
+typedef struct {
+    const char *tag;         // tag do módulo (LOG_TAG) ou NULL
+    const char *fmt;         // string de formato, para o resumo de supressão
+    int8_t tag_index;        // índice na tabela; -1 = ainda não resolvido
+    uint32_t tokens_milli;   // tokens disponíveis, em milésimos (UINT32_MAX = balde ainda não usado)
+    uint32_t last_us;        // instante da última recarga do balde
+    uint32_t suppressed;     // mensagens suprimidas desde a última emitida
+} log_site_t;
+
+#define LOG_SITE_INIT(tag, fmt) { (tag), (fmt), -1, UINT32_MAX, 0, 0 }
+
+// Decide se uma mensagem de `level` no ponto `site` deve ser emitida,
+// aplicando o nível da tag (ou o global) e a limitação de taxa. Chamada
+// pelas macros LOG_* antes de avaliar argumentos e formatar o texto.
+bool log_site_check(log_site_t *site, log_level_t level);
+
 // Função principal de escrita de log.
 // Parâmetros:
 //  - level: nível da mensagem (TRACE/DEBUG/INFO/WARN).
@@ -34,6 +110,58 @@ void log_set_level(log_level_t level);
 //         da string de formato.
 void log_write(log_level_t level, const char *fmt, ...);
 
+// Igual a `log_write`, mas prefixa a mensagem com a tag do módulo e não
+// reaplica o filtro de nível (já feito por `log_site_check`).
+void log_write_tagged(log_level_t level, const char *tag, const char *fmt, ...);
+
+// Variante de `log_write_tagged` com `va_list`, para encaminhar logs de
+// outras bibliotecas (ex.: a BTstack) ao mesmo sistema de filtros.
+void log_vwrite_tagged(log_level_t level, const char *tag, const char *fmt, va_list ap);
+
+// Formatador próprio usado por todas as mensagens, exposto para reuso e
+// para o benchmark contra a libc. Formata `fmt` em `out` (até `size`
+// bytes, incluindo o '\0', sempre terminado se `size` > 0), truncando o
+// excesso. Retorna o número de caracteres escritos, sem o '\0' (ao
+// contrário de `vsnprintf`, não o tamanho que o texto completo teria).
+// Em `%f`, `%e` e `%g` a precisão vai até LOG_FLOAT_MAX_PRECISION casas
+// (acima disso é limitada a esse valor).
+size_t log_vsnprintf(char *out, size_t size, const char *fmt, va_list ap);
+size_t log_snprintf(char *out, size_t size, const char *fmt, ...);
+
+// Escrita de log "tokenizada" (formatação adiada).
+// Em vez de formatar o texto no microcontrolador, emite um quadro binário
+// compacto com o nível, o token da string de formato (seu endereço na
+// flash, fixo para cada firmware), o token da tag (idem; 0 sem tag), um
+// timestamp em microssegundos e os argumentos brutos. O texto é
+// reconstruído no PC por `tools/log_token_decode.py`, a partir do ELF do
+// firmware.
+//
+// Formato do quadro (little endian):
+//   0xA5 0x5A | len | level | token (4) | tag (4) | timestamp_us (4) | args | xor
+// onde `len` conta os bytes de `level` até o fim de `args` e `xor` é o
+// XOR desses mesmos bytes. Argumentos inteiros de até 32 bits ocupam 4
+// bytes; `l`, `ll`, `j`, `z`, `t`, ponteiros e ponto flutuante ocupam 8
+// (`long double` é convertido para `double`); strings são enviadas como
+// [tamanho (1 byte)][bytes].
+// O filtro de nível é aplicado antes, pelas macros LOG_*.
+void log_write_tokenized(log_level_t level, const char *fmt, ...);
+void log_write_tokenized_tagged(log_level_t level, const char *tag, const char *fmt, ...);
+
+// Backend das macros LOG_*:
+//  - 0: texto formatado com cores VT100 (`log_write`);
+//  - 1: quadros binários tokenizados (`log_write_tokenized`), ~5 a 10x
+//       menores e sem formatação de números no microcontrolador.
+// Normalmente definido pelo CMake (opção LOG_VT100_TOKENIZED).
+#ifndef LOG_BACKEND_TOKENIZED
+#define LOG_BACKEND_TOKENIZED 0
+#endif
+
+// Tamanho, em bytes, do anel do modo assíncrono (potência de 2). Cada
+// registro ocupa 2 bytes de cabeçalho mais o texto formatado.
+#ifndef LOG_ASYNC_BUFFER_SIZE
+#define LOG_ASYNC_BUFFER_SIZE 2048
+#endif
+
 // Nível padrão de log utilizado para inicializar o sistema de logging
 // caso nenhum outro seja configurado em tempo de execução.
 #ifndef LOG_DEFAULT_LEVEL
@@ -53,17 +181,34 @@ void log_write(log_level_t level, const char *fmt, ...);
 #endif
 
 // TAG opcional associada ao módulo/arquivo.
-// Pode ser usada futuramente para prefixar as mensagens com o nome
-// do subsistema; atualmente não é utilizada na formatação.
+// Defina antes de incluir este header (ex.: `#define LOG_TAG "BLE_SRV"`)
+// para prefixar as mensagens com o nome do subsistema e permitir ajustar
+// o nível desse módulo em tempo de execução com `log_set_tag_level`.
 #ifndef LOG_TAG
 #define LOG_TAG NULL
 #endif
 
-// Macro genérica que mapeia para a função `log_write`, convertendo
-// o nível simbólico (TRACE, DEBUG, etc.) para o valor do enum.
+// Função de escrita usada pelas macros, conforme o backend.
+#if LOG_BACKEND_TOKENIZED
+#define LOG_BACKEND_WRITE(level, tag, fmt, ...) \
+    log_write_tokenized_tagged(level, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_BACKEND_WRITE(level, tag, fmt, ...) \
+    log_write_tagged(level, tag, fmt, ##__VA_ARGS__)
+#endif
+
+// Macro genérica que mapeia para a função de escrita do backend,
+// convertendo o nível simbólico (TRACE, DEBUG, etc.) para o valor do
+// enum. Cada chamada mantém seu próprio `log_site_t`, e os filtros de
+// nível/tag e de taxa são aplicados antes de avaliar os argumentos.
 // Exemplo: LOG(INFO, "valor=%d", x);
 #define LOG(level, fmt, ...) \
-    log_write(LOG_LEVEL_##level, fmt, ##__VA_ARGS__)
+    do { \
+        static log_site_t log_site_ = LOG_SITE_INIT(LOG_TAG, fmt); \
+        if (log_site_check(&log_site_, LOG_LEVEL_##level)) { \
+            LOG_BACKEND_WRITE(LOG_LEVEL_##level, LOG_TAG, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 // Mapeamento de verbosidade em tempo de compilação.
 // Dependendo de LOG_LEVEL, algumas macros abaixo viram NOP (não geram
@@ -0,0 +1,60 @@
+#ifndef LINK_PROFILE_H
+#define LINK_PROFILE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Perfis de parâmetros da conexão BLE, escolhidos pela aplicação em
+// `bt_server_set_link_profile` / `bt_client_set_link_profile`.
+// Compartilhado entre o servidor (pede ao central, via L2CAP) e o
+// cliente (aplica como central). O intervalo de conexão domina a
+// latência de ponta a ponta: uma amostra pronta espera, em média, meio
+// intervalo pelo próximo evento de conexão.
+typedef enum {
+    LINK_PROFILE_LOW_LATENCY,   // 7,5 ms, sem latência de periférico
+    LINK_PROFILE_BALANCED,      // 30 a 50 ms, sem latência de periférico
+    LINK_PROFILE_POWER_SAVING,  // 100 a 200 ms, periférico pode pular 4 eventos
+    LINK_PROFILE_COUNT
+} link_profile_t;
+
+// Parâmetros de um perfil, nas unidades do HCI.
+typedef struct {
+    const char *name;
+    uint16_t interval_min;        // unidades de 1,25 ms
+    uint16_t interval_max;        // unidades de 1,25 ms
+    uint16_t latency;             // eventos que o periférico pode pular
+    uint16_t supervision_timeout; // unidades de 10 ms
+} link_profile_params_t;
+
+// Parâmetros do perfil, ou NULL se `profile` for inválido.
+const link_profile_params_t *link_profile_params(link_profile_t profile);
+
+// Os parâmetros em uso (`interval`, `latency`) atendem ao perfil?
+int link_profile_matches(link_profile_t profile, uint16_t interval, uint16_t latency);
+
+// Modo de alta vazão (BLE_HIGH_THROUGHPUT em btstack_config.h): os dois
+// lados pedem o PHY de 2 Mbit/s e PDUs de dados de até 251 bytes (Data
+// Length Extension) depois da conexão. Sem suporte do controlador ou do
+// par, a conexão continua em 1M e 27 bytes.
+#define LINK_PHY_1M    1   // valores de PHY nos eventos do HCI
+#define LINK_PHY_2M    2
+#define LINK_PHY_CODED 3
+#define LINK_PHY_MASK_2M 0x02  // preferência de PHY (HCI LE Set PHY)
+#define LINK_PHY_MASK(phy) ((uint8_t)(1U << ((phy) - 1U)))  // máscara de um LINK_PHY_*
+#define LINK_DEFAULT_OCTETS 27 // PDU de dados sem Data Length Extension
+
+// Nome de um PHY dos eventos do HCI ("1M", "2M", "Coded" ou "?").
+const char *link_phy_name(uint8_t phy);
+
+// Conversões das unidades do HCI para microssegundos e milissegundos.
+#define LINK_INTERVAL_US(units) ((uint32_t)(units) * 1250U)
+#define LINK_TIMEOUT_MS(units)  ((uint32_t)(units) * 10U)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_PROFILE_H
@@ -0,0 +1,61 @@
+#include "sample_backlog.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t sample_backlog_encode_data(uint8_t *out, uint16_t out_size, uint32_t seq, uint32_t capture_us,
+                                    uint32_t period_us, sample_packet_header_t *packet, const uint16_t *samples) {
+    if (out == NULL || out_size <= SAMPLE_BACKLOG_DATA_HEADER_SIZE) return 0;
+    uint16_t len = sample_packet_encode_best(out + SAMPLE_BACKLOG_DATA_HEADER_SIZE,
+                                             (uint16_t)(out_size - SAMPLE_BACKLOG_DATA_HEADER_SIZE), packet, samples);
+    if (len == 0 || packet->count == 0) return 0;
+    out[0] = SAMPLE_BACKLOG_DATA;
+    put_u32(out + 1, seq);
+    put_u32(out + 5, capture_us);
+    put_u32(out + 9, period_us);
+    return (uint16_t)(SAMPLE_BACKLOG_DATA_HEADER_SIZE + len);
+}
+
+uint16_t sample_backlog_encode_end(uint8_t *out, uint32_t records, uint32_t samples, uint16_t next_index) {
+    out[0] = SAMPLE_BACKLOG_END;
+    put_u32(out + 1, records);
+    put_u32(out + 5, samples);
+    out[9] = (uint8_t)(next_index & 0xFF);
+    out[10] = (uint8_t)(next_index >> 8);
+    return SAMPLE_BACKLOG_END_SIZE;
+}
+
+int sample_backlog_decode(const uint8_t *in, uint16_t len, sample_backlog_t *msg, uint16_t *samples) {
+    if (in == NULL || len < 1) return -1;
+    memset(msg, 0, sizeof(*msg));
+    msg->type = in[0];
+    switch (msg->type) {
+        case SAMPLE_BACKLOG_DATA:
+            if (len < SAMPLE_BACKLOG_DATA_HEADER_SIZE) return -1;
+            msg->seq = get_u32(in + 1);
+            msg->capture_us = get_u32(in + 5);
+            msg->period_us = get_u32(in + 9);
+            return (sample_packet_decode(in + SAMPLE_BACKLOG_DATA_HEADER_SIZE,
+                                         (uint16_t)(len - SAMPLE_BACKLOG_DATA_HEADER_SIZE), &msg->packet,
+                                         samples) < 0) ? -2 : 0;
+        case SAMPLE_BACKLOG_END:
+            if (len < SAMPLE_BACKLOG_END_SIZE) return -1;
+            msg->records = get_u32(in + 1);
+            msg->samples = get_u32(in + 5);
+            msg->next_index = (uint16_t)(in[9] | (in[10] << 8));
+            return 0;
+        default:
+            return -3;
+    }
+}
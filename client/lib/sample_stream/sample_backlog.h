@@ -0,0 +1,87 @@
+#ifndef SAMPLE_BACKLOG_H
+#define SAMPLE_BACKLOG_H
+
+#include <stdint.h>
+
+#include "sample_packet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Característica "Sample Backlog": download das amostras registradas em
+// flash enquanto nenhuma central recebia o fluxo ao vivo.
+//
+// Ao habilitar as notificações desta característica, a central recebe
+// todo o registro, do mais antigo ao mais recente, o mais rápido que o
+// enlace permitir, seguido de uma mensagem de fim. Depois do fim, ela
+// assina o "Sample Stream": isso confirma o recebimento (o servidor
+// libera o registro) e o fluxo ao vivo continua a partir da amostra
+// seguinte à última baixada. Se a conexão cair antes, nada é liberado e
+// o download recomeça na próxima conexão.
+//
+// Dados (SAMPLE_BACKLOG_DATA):
+//  byte 0      : SAMPLE_BACKLOG_DATA
+//  bytes 1..4  : seq        - número do registro na flash
+//  bytes 5..8  : capture_us - instante de captura da primeira amostra
+//  bytes 9..12 : period_us  - período entre amostras
+//  bytes 13..  : lote no formato do "Sample Stream" (sample_packet.h)
+//
+// Fim (SAMPLE_BACKLOG_END):
+//  byte 0      : SAMPLE_BACKLOG_END
+//  bytes 1..4  : records    - registros enviados
+//  bytes 5..8  : samples    - amostras enviadas
+//  bytes 9..10 : next_index - índice (uint16) da primeira amostra ao vivo
+//
+// Todos os campos em little endian.
+
+// UUID de 128 bits da característica "Sample Backlog" (mesmo valor usado
+// em `temp_sensor.gatt`), em ordem big endian como esperado pela BTstack.
+#define SAMPLE_BACKLOG_CHARACTERISTIC_UUID128 \
+    { 0x5A, 0x1E, 0x00, 0x04, 0x6C, 0x3B, 0x4D, 0x2C, \
+      0x9A, 0x5E, 0x2F, 0x0B, 0x7E, 0x1C, 0x0A, 0x01 }
+
+#define SAMPLE_BACKLOG_DATA 0x01
+#define SAMPLE_BACKLOG_END  0x02
+
+// Bytes antes do lote numa mensagem de dados.
+#define SAMPLE_BACKLOG_DATA_HEADER_SIZE 13
+
+// Tamanho da mensagem de fim.
+#define SAMPLE_BACKLOG_END_SIZE 11
+
+typedef struct {
+    uint8_t type;                   // SAMPLE_BACKLOG_DATA ou SAMPLE_BACKLOG_END
+    // Dados
+    uint32_t seq;
+    uint32_t capture_us;
+    uint32_t period_us;
+    sample_packet_header_t packet;  // cabeçalho do lote
+    // Fim
+    uint32_t records;
+    uint32_t samples;
+    uint16_t next_index;
+} sample_backlog_t;
+
+// Monta uma mensagem de dados em `out` (até `out_size` bytes) com as
+// amostras de `samples`, na codificação que leva mais delas
+// (`sample_packet_encode_best`); `packet->count` entra com as amostras
+// disponíveis e sai com as que couberam. Retorna o tamanho em bytes, ou
+// 0 se nenhuma couber.
+uint16_t sample_backlog_encode_data(uint8_t *out, uint16_t out_size, uint32_t seq, uint32_t capture_us,
+                                    uint32_t period_us, sample_packet_header_t *packet, const uint16_t *samples);
+
+// Monta a mensagem de fim em `out` (pelo menos SAMPLE_BACKLOG_END_SIZE
+// bytes). Retorna o tamanho em bytes.
+uint16_t sample_backlog_encode_end(uint8_t *out, uint32_t records, uint32_t samples, uint16_t next_index);
+
+// Interpreta uma notificação. Para dados, decodifica as amostras em
+// `samples` (espaço para SAMPLE_PACKET_MAX_SAMPLES). Retorna 0, ou valor
+// negativo se a mensagem estiver truncada ou for desconhecida.
+int sample_backlog_decode(const uint8_t *in, uint16_t len, sample_backlog_t *msg, uint16_t *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_BACKLOG_H
@@ -0,0 +1,67 @@
+#ifndef SAMPLE_BROADCAST_H
+#define SAMPLE_BROADCAST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modo broadcast (sem conexão): as amostras mais recentes vão no próprio
+// anúncio, num bloco "Service Data - 16-bit UUID" (tipo 0x16) com o UUID
+// de Environmental Sensing (0x181A), e os receptores as extraem dos
+// relatórios de anúncio em scan passivo, sem conectar.
+//
+//  byte 0     : len         - tamanho do bloco AD (sem este byte)
+//  byte 1     : 0x16        - Service Data, UUID de 16 bits
+//  bytes 2..3 : 0x181A      - UUID (little endian)
+//  bytes 4..5 : first_index - índice da primeira amostra (uint16, little endian)
+//  byte 6     : count       - número de amostras
+//  bytes 7..  : count * uint16 little endian, em ordem de captura
+//
+// Cada anúncio leva uma janela deslizante com as últimas amostras: um
+// receptor que perca algumas atualizações ainda recupera as amostras que
+// continuam na janela, e `first_index` permite descartar as repetidas e
+// contar as perdidas.
+
+#define SAMPLE_BROADCAST_UUID16 0x181A
+
+// Bytes do bloco antes das amostras (len, tipo, UUID, first_index, count).
+#define SAMPLE_BROADCAST_HEADER_SIZE 7
+
+// Amostras por anúncio: 31 bytes de dados de anúncio, menos as flags (3)
+// e o cabeçalho do bloco.
+#define SAMPLE_BROADCAST_MAX_SAMPLES ((31 - 3 - SAMPLE_BROADCAST_HEADER_SIZE) / 2)
+
+// Monta o bloco AD em `out` (até `out_size` bytes) com `count` amostras,
+// a primeira de índice `first_index`.
+// Retorna o tamanho do bloco em bytes ou 0 se não couber.
+uint8_t sample_broadcast_encode(uint8_t *out, uint8_t out_size, uint16_t first_index,
+                                const uint16_t *samples, uint8_t count);
+
+// Procura o bloco nos dados de um anúncio (`adv_data`, `adv_len`).
+// Em caso de sucesso, `*samples` aponta para a primeira amostra (ler com
+// `sample_packet_get`) e o retorno é o número de amostras; retorna valor
+// negativo se o anúncio não tiver um bloco válido.
+int sample_broadcast_decode(const uint8_t *adv_data, uint8_t adv_len, uint16_t *first_index,
+                            const uint8_t **samples);
+
+// Acompanhamento das janelas recebidas de um anunciante.
+typedef struct {
+    uint16_t next_index;   // índice da próxima amostra ainda não entregue
+    uint8_t valid;         // já recebeu alguma janela
+    uint32_t reports;      // anúncios com bloco válido
+    uint32_t delivered;    // amostras novas entregues
+    uint32_t lost;         // amostras que saíram da janela sem ser vistas
+} sample_broadcast_rx_t;
+
+// Registra uma janela recebida e retorna a posição, dentro dela, da
+// primeira amostra nova (`count` se nenhuma for nova). Uma janela muito
+// atrás da última vista é tomada como reinício do anunciante.
+uint8_t sample_broadcast_rx_update(sample_broadcast_rx_t *rx, uint16_t first_index, uint8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_BROADCAST_H
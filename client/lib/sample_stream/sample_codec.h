@@ -0,0 +1,70 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Codificações compactas das amostras de um lote, usadas por
+// `sample_packet_encode` / `sample_packet_decode` conforme o campo de
+// codificação de `flags` (SAMPLE_PACKET_ENCODING_*). O tempo de ar é o
+// gargalo do enlace: cada byte a menos por amostra é vazão a mais.
+//
+// 12 bits empacotados: duas amostras em 3 bytes, little endian,
+//  byte 0 : bits 0..7 da amostra par
+//  byte 1 : bits 8..11 da amostra par (nibble baixo) e bits 0..3 da ímpar
+//  byte 2 : bits 4..11 da amostra ímpar
+// Com `count` ímpar, a última amostra ocupa 2 bytes (byte 1 só com o
+// nibble baixo). Só vale para amostras de até 12 bits.
+//
+// Delta: a primeira amostra em uint16 little endian; as seguintes como a
+// diferença para a anterior (módulo 2^16, como int16), em zigzag e
+// varint (7 bits por byte, bit 7 = continua). Variações de até ±63
+// ocupam 1 byte, de até ±8191, 2 bytes; no pior caso, 3. O lote é
+// decodificável sozinho, sem depender dos anteriores.
+
+// Maior amostra representável em 12 bits.
+#define SAMPLE_CODEC_MAX_12BIT 0x0FFF
+
+// Bytes de `count` amostras de 12 bits empacotadas.
+#define SAMPLE_CODEC_PACKED12_SIZE(count) ((uint16_t)(((uint32_t)(count) * 3U + 1U) / 2U))
+
+// Bytes de uma amostra no pior caso da codificação delta.
+#define SAMPLE_CODEC_DELTA_MAX_BYTES 3
+
+// Zigzag: diferenças pequenas, positivas ou negativas, viram inteiros
+// pequenos (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...).
+static inline uint16_t sample_codec_zigzag(int16_t delta) {
+    return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+
+static inline int16_t sample_codec_unzigzag(uint16_t value) {
+    return (int16_t)((value >> 1) ^ (uint16_t)-(int16_t)(value & 1));
+}
+
+// Empacota `count` amostras de 12 bits em `out` (até `out_size` bytes).
+// Retorna o número de bytes escritos, ou 0 se não couber ou se alguma
+// amostra passar de SAMPLE_CODEC_MAX_12BIT.
+uint16_t sample_codec_pack12(uint8_t *out, uint16_t out_size, const uint16_t *samples, uint16_t count);
+
+// Desempacota `count` amostras de 12 bits de `in` (`len` bytes).
+// Retorna o número de bytes lidos, ou valor negativo se faltarem bytes.
+int sample_codec_unpack12(const uint8_t *in, uint16_t len, uint16_t *samples, uint16_t count);
+
+// Codifica em delta até `*count` amostras em `out` (até `out_size`
+// bytes): entram, em ordem, as que couberem, e `*count` passa a indicar
+// quantas. Retorna o número de bytes escritos (0 se nenhuma couber).
+uint16_t sample_codec_delta_encode(uint8_t *out, uint16_t out_size, const uint16_t *samples, uint16_t *count);
+
+// Decodifica `count` amostras em delta de `in` (`len` bytes).
+// Retorna o número de bytes lidos, ou valor negativo se o lote estiver
+// truncado ou tiver um varint inválido.
+int sample_codec_delta_decode(const uint8_t *in, uint16_t len, uint16_t *samples, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_CODEC_H
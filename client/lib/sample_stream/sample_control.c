@@ -0,0 +1,40 @@
+#include "sample_control.h"
+
+#include <stddef.h>
+
+static void put_16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint16_t sample_control_encode(uint8_t *out, uint16_t out_size, const sample_control_t *control) {
+    if (out == NULL || control == NULL || out_size < SAMPLE_CONTROL_SIZE) return 0;
+
+    out[0] = control->fields;
+    put_16(out + 1, (uint16_t)(control->sample_rate_hz & 0xFFFF));
+    put_16(out + 3, (uint16_t)(control->sample_rate_hz >> 16));
+    put_16(out + 5, control->notify_interval_ms);
+    out[7] = control->batch_size;
+    out[8] = control->averaging;
+    put_16(out + 9, control->deadband);
+    put_16(out + 11, control->keepalive_ms);
+    return SAMPLE_CONTROL_SIZE;
+}
+
+int sample_control_decode(const uint8_t *in, uint16_t len, sample_control_t *control) {
+    if (in == NULL || len != SAMPLE_CONTROL_SIZE) return -1;
+    if (in[0] & (uint8_t)~SAMPLE_CONTROL_ALL) return -2;
+
+    control->fields = in[0];
+    control->sample_rate_hz = (uint32_t)get_16(in + 1) | ((uint32_t)get_16(in + 3) << 16);
+    control->notify_interval_ms = get_16(in + 5);
+    control->batch_size = in[7];
+    control->averaging = in[8];
+    control->deadband = get_16(in + 9);
+    control->keepalive_ms = get_16(in + 11);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Característica "Time Sync": sincronização do relógio do servidor com o
+// do cliente, para traduzir o instante de captura das amostras
+// (`time_us_32()` do servidor) para o relógio do cliente
+// (`time_us_64()`).
+//
+// Cada troca é uma leitura da característica: o cliente anota o instante
+// do pedido (t1) e o da resposta (t4); o servidor responde com o seu
+// relógio no instante em que recebeu o pedido (t2):
+//  bytes 0..3 : t2 - `time_us_32()` do servidor (uint32, little endian)
+//
+// Ancoragem nos eventos de conexão: o pedido sai no primeiro evento
+// depois de t1 e chega ao servidor no início desse evento, instante
+// comum às duas placas; a resposta volta no evento seguinte, um
+// intervalo de conexão depois. O instante do cliente correspondente a t2
+// é, então, t4 menos um intervalo, sem a incerteza de até um intervalo
+// inteiro da estimativa pelo ponto médio (t1 + t4) / 2, que supõe ida e
+// volta simétricas. Com o intervalo desconhecido, ou quando a resposta
+// chega em menos de um intervalo (controlador virtual do build de host),
+// usa-se o ponto médio.
+//
+// As trocas são feitas em rodadas; a mediana de cada rodada descarta as
+// trocas atrasadas (retransmissões, eventos perdidos). Um ajuste linear
+// sobre os pontos das últimas rodadas dá a diferença entre os relógios e
+// a deriva entre os cristais.
+
+// UUID de 128 bits da característica "Time Sync" (mesmo valor usado em
+// `temp_sensor.gatt`), em ordem big endian como esperado pela BTstack.
+#define TIME_SYNC_CHARACTERISTIC_UUID128 \
+    { 0x5A, 0x1E, 0x00, 0x05, 0x6C, 0x3B, 0x4D, 0x2C, \
+      0x9A, 0x5E, 0x2F, 0x0B, 0x7E, 0x1C, 0x0A, 0x01 }
+
+// Tamanho do valor da característica, em bytes.
+#define TIME_SYNC_SIZE 4
+
+// Trocas por rodada e rodadas no ajuste da deriva.
+#define TIME_SYNC_ROUND_EXCHANGES 8
+#define TIME_SYNC_HISTORY 8
+
+// Maior deriva aceita entre os relógios, em partes por bilhão (cristais
+// comuns ficam bem abaixo de 100 ppm).
+#define TIME_SYNC_MAX_DRIFT_PPB 500000
+
+typedef struct {
+    // Rodada em andamento: instante local correspondente a t2 e diferença
+    // (servidor - cliente) de cada troca.
+    uint64_t round_local[TIME_SYNC_ROUND_EXCHANGES];
+    int64_t round_offset[TIME_SYNC_ROUND_EXCHANGES];
+    uint8_t round_count;
+    uint8_t round_anchored;     // trocas ancoradas nos eventos de conexão
+    uint32_t round_min_rtt_us;  // menor ida e volta da rodada
+
+    // Pontos (mediana) das últimas rodadas, em círculo.
+    uint64_t history_local[TIME_SYNC_HISTORY];
+    int64_t history_offset[TIME_SYNC_HISTORY];
+    uint8_t history_count;
+    uint8_t history_next;
+
+    // Relógio do servidor estendido a 64 bits na última troca.
+    uint64_t server_us;
+    bool server_valid;
+
+    // Estimativa: diferença `base_offset_us` no instante local
+    // `base_local_us` e deriva do relógio do servidor sobre o do cliente.
+    bool valid;
+    uint64_t base_local_us;
+    int64_t base_offset_us;
+    int32_t drift_ppb;
+
+    // Qualidade: dispersão (intervalo interquartil) da última rodada,
+    // maior resíduo do ajuste, menor ida e volta e trocas ancoradas.
+    uint32_t dispersion_us;
+    uint32_t residual_us;
+    uint32_t rtt_us;
+    uint8_t anchored;
+    uint32_t rounds;
+} time_sync_t;
+
+// Descarta a estimativa (ex.: a cada nova conexão).
+void time_sync_reset(time_sync_t *sync);
+
+// Valor da característica com o instante `server_us`. Retorna
+// TIME_SYNC_SIZE ou 0 se não couber em `out_size`.
+uint16_t time_sync_encode(uint8_t *out, uint16_t out_size, uint32_t server_us);
+
+// Lê o instante do servidor do valor da característica.
+// Retorna 0 em caso de sucesso ou -1 se o tamanho estiver errado.
+int time_sync_decode(const uint8_t *in, uint16_t len, uint32_t *server_us);
+
+// Registra uma troca da rodada em andamento: pedido em `request_us` e
+// resposta em `response_us` (relógio local), com o instante do servidor
+// `server_us`. `interval_us` é o intervalo de conexão (0 se
+// desconhecido).
+void time_sync_add(time_sync_t *sync, uint64_t request_us, uint32_t server_us, uint64_t response_us,
+                   uint32_t interval_us);
+
+// Encerra a rodada em andamento e atualiza a estimativa. Retorna true se
+// a rodada tinha alguma troca.
+bool time_sync_finish_round(time_sync_t *sync);
+
+// Diferença estimada (relógio do servidor - relógio local), em
+// microssegundos, no instante local `local_us`.
+int64_t time_sync_offset_at(const time_sync_t *sync, uint64_t local_us);
+
+// Instante local correspondente ao instante `server_us` do servidor (até
+// cerca de 35 minutos antes ou depois da última troca). Retorna 0 se
+// ainda não houver estimativa.
+uint64_t time_sync_to_local(const time_sync_t *sync, uint32_t server_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIME_SYNC_H
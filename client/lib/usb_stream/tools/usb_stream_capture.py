@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Capturador do fluxo binário de amostras do cliente (usb_stream).
+
+Lê os quadros emitidos por `usb_stream_flush` (porta serial, arquivo
+capturado ou stdin) e grava uma linha por amostra em um arquivo CSV, com as
+colunas:
+
+    source,index,value,capture_us,capture_clock,rx_us,backlog
+
+- capture_us: instante de captura da amostra (vazio se desconhecido);
+  capture_clock diz em que relógio ele está ("client" ou "server").
+- rx_us: instante de recepção do lote no cliente.
+- index: vazio nas amostras do registro em flash (backlog = 1).
+
+Os logs em texto que chegam entre os quadros vão para stderr (ou para
+`--log`). Ao final (fim do arquivo ou Ctrl+C), um resumo com quadros,
+amostras, erros de CRC e quadros perdidos (lacunas na sequência) é escrito
+em stderr.
+
+Uso:
+    stty -F /dev/ttyACM0 raw
+    usb_stream_capture.py /dev/ttyACM0 amostras.csv
+    ./client | usb_stream_capture.py - amostras.csv     # build de host
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\x5a\xc3"
+HEADER_SIZE = 7
+CRC_SIZE = 2
+MAX_PAYLOAD = 26 + 2 * 255
+
+TYPE_SAMPLES = 1
+SAMPLES_HEADER = struct.Struct("<BBHHQQI")
+
+FLAG_CAPTURE = 0x01
+FLAG_SERVER_CLOCK = 0x02
+FLAG_BACKLOG = 0x04
+
+COLUMNS = "source,index,value,capture_us,capture_clock,rx_us,backlog\n"
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Capture:
+    def __init__(self, out, log):
+        self.out = out
+        self.log = log
+        self.frames = 0
+        self.samples = 0
+        self.crc_errors = 0
+        self.lost_frames = 0
+        self.next_seq = None
+
+    def samples_frame(self, payload):
+        source, flags, first_index, count, rx_us, capture_us, period_us = SAMPLES_HEADER.unpack_from(payload)
+        if len(payload) != SAMPLES_HEADER.size + 2 * count:
+            return
+        values = struct.unpack_from(f"<{count}H", payload, SAMPLES_HEADER.size)
+        backlog = 1 if flags & FLAG_BACKLOG else 0
+        if flags & FLAG_CAPTURE:
+            clock = "client"
+        elif flags & FLAG_SERVER_CLOCK:
+            clock = "server"
+        else:
+            clock = ""
+        rows = []
+        for i, value in enumerate(values):
+            index = "" if backlog else str((first_index + i) & 0xFFFF)
+            capture = ""
+            if clock and (i == 0 or period_us):
+                capture = str(capture_us + i * period_us)
+            rows.append(f"{source},{index},{value},{capture},{clock if capture else ''},{rx_us},{backlog}\n")
+        self.out.write("".join(rows))
+        self.samples += count
+
+    def frame(self, frame_type, seq, payload):
+        self.frames += 1
+        if self.next_seq is not None and seq != self.next_seq:
+            self.lost_frames += (seq - self.next_seq) & 0xFFFF
+        self.next_seq = (seq + 1) & 0xFFFF
+        if frame_type == TYPE_SAMPLES:
+            self.samples_frame(payload)
+
+    def text(self, data):
+        if data:
+            self.log.write(data.decode("utf-8", errors="replace"))
+
+    def feed(self, buf):
+        """Processa os quadros completos de `buf` e retorna o que sobrar."""
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                # mantém um possível primeiro byte de sincronismo no fim
+                keep = 1 if buf.endswith(SYNC[:1]) else 0
+                self.text(buf[:len(buf) - keep])
+                return buf[len(buf) - keep:]
+            self.text(buf[:start])
+            buf = buf[start:]
+            if len(buf) < HEADER_SIZE:
+                return buf
+            length, frame_type, seq = struct.unpack_from("<HBH", buf, 2)
+            if length > MAX_PAYLOAD:
+                # falso sincronismo: repassa o byte e continua
+                self.text(buf[:1])
+                buf = buf[1:]
+                continue
+            end = HEADER_SIZE + length + CRC_SIZE
+            if len(buf) < end:
+                return buf
+            check, = struct.unpack_from("<H", buf, HEADER_SIZE + length)
+            if crc16(buf[2:HEADER_SIZE + length]) != check:
+                self.crc_errors += 1
+                self.text(buf[:1])
+                buf = buf[1:]
+                continue
+            self.frame(frame_type, seq, buf[HEADER_SIZE:HEADER_SIZE + length])
+            buf = buf[end:]
+
+    def summary(self):
+        return (f"quadros={self.frames} amostras={self.samples} "
+                f"erros_crc={self.crc_errors} quadros_perdidos={self.lost_frames}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Captura o fluxo binário de amostras do cliente (usb_stream)")
+    parser.add_argument("input", help="porta serial, arquivo capturado ou - (stdin)")
+    parser.add_argument("output", help="arquivo CSV de saída ou - (stdout)")
+    parser.add_argument("--log", help="arquivo para os logs em texto (padrão: stderr)")
+    args = parser.parse_args()
+
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb", buffering=0)
+    out = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+    log = open(args.log, "w") if args.log else sys.stderr
+    out.write(COLUMNS)
+
+    capture = Capture(out, log)
+    buf = b""
+    try:
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                break
+            buf = capture.feed(buf + chunk)
+            out.flush()
+            log.flush()
+    except KeyboardInterrupt:
+        pass
+    sys.stderr.write(capture.summary())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#include "usb_stream.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Escrita binária na USB CDC pelo driver de stdio do Pico SDK, sem
+// tradução de '\n' para "\r\n". No build de host, vai para a saída padrão.
+#if __has_include("pico/stdio.h") && !PICO_NO_HARDWARE
+#include "pico/stdio.h"
+#define USB_STREAM_WRITE(buf, len) stdio_put_string((const char *)(buf), (int)(len), false, false)
+#else
+#define USB_STREAM_WRITE(buf, len) do { fwrite((buf), 1, (len), stdout); fflush(stdout); } while (0)
+#endif
+
+#if (USB_STREAM_BUFFER_SIZE & (USB_STREAM_BUFFER_SIZE - 1)) != 0
+#error "USB_STREAM_BUFFER_SIZE deve ser potência de 2"
+#endif
+
+#define USB_STREAM_RING_MASK (USB_STREAM_BUFFER_SIZE - 1)
+
+// Anel de bytes com quadros completos. `stream_ring_head` só é escrito
+// pelo produtor (`usb_stream_write_samples`) e `stream_ring_tail` só pelo
+// consumidor (`usb_stream_flush`).
+static uint8_t stream_ring[USB_STREAM_BUFFER_SIZE];
+static volatile uint32_t stream_ring_head;
+static volatile uint32_t stream_ring_tail;
+static volatile uint32_t stream_dropped;
+static uint16_t stream_seq;
+
+// Quadro em montagem (buffer estático, fora da pilha).
+static uint8_t stream_frame[USB_STREAM_MAX_FRAME];
+
+static void put_u16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    put_u16(p, (uint16_t)value);
+    put_u16(p + 2, (uint16_t)(value >> 16));
+}
+
+static void put_u64(uint8_t *p, uint64_t value) {
+    put_u32(p, (uint32_t)value);
+    put_u32(p + 4, (uint32_t)(value >> 32));
+}
+
+// CRC-16/CCITT com tabela de 4 bits: no caminho das notificações, um
+// quadro cheio custa dois acessos à tabela por byte em vez de oito
+// deslocamentos.
+static uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint32_t len) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    while (len--) {
+        uint8_t byte = *data++;
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (byte >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (byte & 0x0F)]);
+    }
+    return crc;
+}
+
+uint16_t usb_stream_encode_samples(uint8_t *out, uint16_t out_size, uint16_t seq,
+                                   const usb_stream_samples_t *header, const uint16_t *samples) {
+    if (out == NULL || header == NULL || header->count > USB_STREAM_MAX_SAMPLES) return 0;
+    uint16_t payload = (uint16_t)(USB_STREAM_SAMPLES_HEADER_SIZE + 2u * header->count);
+    uint16_t size = (uint16_t)(USB_STREAM_HEADER_SIZE + payload + USB_STREAM_CRC_SIZE);
+    if (out_size < size) return 0;
+
+    out[0] = USB_STREAM_SYNC0;
+    out[1] = USB_STREAM_SYNC1;
+    put_u16(out + 2, payload);
+    out[4] = USB_STREAM_TYPE_SAMPLES;
+    put_u16(out + 5, seq);
+
+    uint8_t *p = out + USB_STREAM_HEADER_SIZE;
+    p[0] = header->source;
+    p[1] = header->flags;
+    put_u16(p + 2, header->first_index);
+    put_u16(p + 4, header->count);
+    put_u64(p + 6, header->rx_us);
+    put_u64(p + 14, header->capture_us);
+    put_u32(p + 22, header->period_us);
+    p += USB_STREAM_SAMPLES_HEADER_SIZE;
+    for (uint16_t i = 0; i < header->count; i++) {
+        put_u16(p + 2 * i, samples[i]);
+    }
+
+    put_u16(out + USB_STREAM_HEADER_SIZE + payload, crc16_update(0xFFFF, out + 2, (uint32_t)(size - 4)));
+    return size;
+}
+
+static void ring_copy_in(uint32_t pos, const void *src, uint32_t len) {
+    uint32_t first = pos & USB_STREAM_RING_MASK;
+    uint32_t chunk = USB_STREAM_BUFFER_SIZE - first;
+    if (chunk > len) chunk = len;
+    memcpy(&stream_ring[first], src, chunk);
+    memcpy(stream_ring, (const uint8_t *)src + chunk, len - chunk);
+}
+
+static void ring_copy_out(uint32_t pos, void *dst, uint32_t len) {
+    uint32_t first = pos & USB_STREAM_RING_MASK;
+    uint32_t chunk = USB_STREAM_BUFFER_SIZE - first;
+    if (chunk > len) chunk = len;
+    memcpy(dst, &stream_ring[first], chunk);
+    memcpy((uint8_t *)dst + chunk, stream_ring, len - chunk);
+}
+
+int usb_stream_write_samples(const usb_stream_samples_t *header, const uint16_t *samples) {
+    // A sequência avança mesmo no descarte, para o capturador ver a perda.
+    uint16_t seq = stream_seq++;
+    uint16_t size = usb_stream_encode_samples(stream_frame, sizeof(stream_frame), seq, header, samples);
+    if (size == 0) {
+        stream_dropped++;
+        return -1;
+    }
+
+    uint32_t head = stream_ring_head;
+    uint32_t tail = stream_ring_tail;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (USB_STREAM_BUFFER_SIZE - (head - tail) < size) {
+        stream_dropped++;
+        return -1;
+    }
+    ring_copy_in(head, stream_frame, size);
+    // Publica o quadro antes de avançar o índice lido por `usb_stream_flush`.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    stream_ring_head = head + size;
+    return 0;
+}
+
+uint32_t usb_stream_flush(void) {
+    uint32_t written = 0;
+    uint8_t packet[USB_STREAM_PACKET_SIZE];
+    while (true) {
+        uint32_t tail = stream_ring_tail;
+        uint32_t head = stream_ring_head;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t len = head - tail;
+        if (len == 0) break;
+        if (len > USB_STREAM_PACKET_SIZE) len = USB_STREAM_PACKET_SIZE;
+
+        ring_copy_out(tail, packet, len);
+        // Libera o espaço antes da escrita lenta na USB.
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        stream_ring_tail = tail + len;
+
+        USB_STREAM_WRITE(packet, len);
+        written += len;
+    }
+    return written;
+}
+
+uint32_t usb_stream_dropped_count(void) {
+    return stream_dropped;
+}
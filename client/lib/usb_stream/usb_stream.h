@@ -0,0 +1,109 @@
+#ifndef USB_STREAM_H
+#define USB_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fluxo binário das amostras recebidas pela USB CDC (saída padrão), para
+// captura no PC (`tools/usb_stream_capture.py`). Cada lote vira um quadro:
+//  bytes 0..1 : sincronismo 0x5A 0xC3
+//  bytes 2..3 : tamanho da carga (uint16, little endian)
+//  byte  4    : tipo do quadro (USB_STREAM_TYPE_*)
+//  bytes 5..6 : sequência do quadro (uint16, little endian)
+//  carga
+//  2 bytes    : CRC-16/CCITT (inicial 0xFFFF) dos bytes 2 até o fim da
+//               carga (uint16, little endian)
+//
+// A sequência avança também nos quadros descartados (anel cheio): uma
+// lacuna indica perda. Bytes fora de quadros (logs em texto do
+// `log_vt100`) podem aparecer entre eles; o capturador os separa.
+//
+// Carga de USB_STREAM_TYPE_SAMPLES (little endian):
+//  byte  0      : origem (servidor)
+//  byte  1      : flags (USB_STREAM_FLAG_*)
+//  bytes 2..3   : índice da primeira amostra
+//  bytes 4..5   : quantidade de amostras
+//  bytes 6..13  : instante de recepção no cliente (`time_us_64()`)
+//  bytes 14..21 : instante de captura da primeira amostra (0 se
+//                 desconhecido)
+//  bytes 22..25 : período entre amostras, em microssegundos (0 se
+//                 desconhecido)
+//  bytes 26..   : amostras (uint16 cada)
+
+#define USB_STREAM_SYNC0 0x5Au
+#define USB_STREAM_SYNC1 0xC3u
+
+#define USB_STREAM_HEADER_SIZE 7
+#define USB_STREAM_CRC_SIZE 2
+#define USB_STREAM_SAMPLES_HEADER_SIZE 26
+
+// Maior quantidade de amostras por quadro (a de um lote).
+#define USB_STREAM_MAX_SAMPLES 255
+
+#define USB_STREAM_MAX_FRAME \
+    (USB_STREAM_HEADER_SIZE + USB_STREAM_SAMPLES_HEADER_SIZE + 2 * USB_STREAM_MAX_SAMPLES + USB_STREAM_CRC_SIZE)
+
+// Tamanho do anel entre o caminho das notificações e a escrita na USB, em
+// bytes (potência de 2).
+#ifndef USB_STREAM_BUFFER_SIZE
+#define USB_STREAM_BUFFER_SIZE 8192
+#endif
+
+// Bytes entregues à USB CDC por escrita: o tamanho do pacote bulk da
+// TinyUSB em full speed (CFG_TUD_CDC_EP_BUFSIZE).
+#ifndef USB_STREAM_PACKET_SIZE
+#define USB_STREAM_PACKET_SIZE 64
+#endif
+
+typedef enum {
+    USB_STREAM_TYPE_SAMPLES = 1,
+} usb_stream_type_t;
+
+// O instante de captura está no relógio do cliente (sincronização de
+// relógios); sem ela, no relógio do servidor (`time_us_32()` dele).
+#define USB_STREAM_FLAG_CAPTURE      0x01u
+#define USB_STREAM_FLAG_SERVER_CLOCK 0x02u
+// Amostras baixadas do registro em flash do servidor; o índice não é
+// conhecido.
+#define USB_STREAM_FLAG_BACKLOG      0x04u
+
+typedef struct {
+    uint8_t source;
+    uint8_t flags;
+    uint16_t first_index;
+    uint16_t count;
+    uint64_t rx_us;
+    uint64_t capture_us;
+    uint32_t period_us;
+} usb_stream_samples_t;
+
+// Monta um quadro USB_STREAM_TYPE_SAMPLES em `out` com a sequência `seq`.
+// Retorna o tamanho do quadro ou 0 se não couber em `out_size` (ou
+// `header->count` passar de USB_STREAM_MAX_SAMPLES).
+uint16_t usb_stream_encode_samples(uint8_t *out, uint16_t out_size, uint16_t seq,
+                                   const usb_stream_samples_t *header, const uint16_t *samples);
+
+// Copia um quadro com as amostras para o anel. Nunca bloqueia: com o anel
+// cheio, o quadro é descartado e contado em `usb_stream_dropped_count()`.
+// Deve ser chamada de um único contexto (o da BTstack).
+// Retorna 0 em caso de sucesso ou -1 se o quadro foi descartado.
+int usb_stream_write_samples(const usb_stream_samples_t *header, const uint16_t *samples);
+
+// Escreve na saída padrão, sem tradução de fim de linha, o que estiver no
+// anel, em blocos de até USB_STREAM_PACKET_SIZE bytes. Deve ser chamada
+// de um único contexto (ex.: o laço do core 1, junto de `log_flush`).
+// Retorna a quantidade de bytes escritos.
+uint32_t usb_stream_flush(void);
+
+// Quadros descartados por falta de espaço no anel.
+uint32_t usb_stream_dropped_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USB_STREAM_H
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+// Simulação da sincronização de relógios (lib/sample_stream/time_sync.h)
+// Só no build de host. O relógio do cliente é o tempo de referência; o do
+// servidor tem outra origem e deriva constante. Os eventos de conexão
+// acontecem a cada intervalo, no mesmo instante para as duas placas, e
+// cada troca segue o caminho de uma leitura GATT:
+//  - o pedido sai no primeiro evento depois de t1 (mais o atraso da pilha
+//    do cliente) e o servidor o recebe no início do evento, mais o atraso
+//    da sua pilha (t2);
+//  - a resposta sai no evento seguinte (ou, às vezes, um evento depois,
+//    como numa retransmissão) e chega ao cliente com o atraso da pilha
+//    (t4).
+// A cada rodada, o erro da tradução de um instante do servidor para o
+// relógio do cliente é comparado com o valor real. Para comparação, a
+// mesma sequência é estimada sem a ancoragem nos eventos (ponto médio).
+//
+// Uso:
+//   time_sync_sim [segundos]
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "time_sync.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Duração simulada padrão de cada cenário e intervalo entre rodadas.
+#define SIM_DEFAULT_SECONDS 120U
+#define SIM_ROUND_PERIOD_US 5000000U
+
+// Rodadas descartadas antes de medir o erro (convergência da deriva).
+#define SIM_WARMUP_ROUNDS 3U
+
+// Erro máximo aceito depois da convergência, em microssegundos.
+#define SIM_MAX_ERROR_US 1000
+
+// Atraso da pilha (controlador -> aplicação), em microssegundos.
+#define SIM_STACK_MIN_US 150U
+#define SIM_STACK_MAX_US 450U
+
+typedef struct {
+    const char* name;
+    uint32_t interval_us;
+    int32_t drift_ppb;     // deriva do relógio do servidor
+    uint32_t late_pct;     // respostas atrasadas em um evento
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "7.5ms", 7500, 0, 0 },
+    { "7.5ms_deriva+40ppm", 7500, 40000, 5 },
+    { "30ms_deriva-25ppm", 30000, -25000, 10 },
+    { "100ms_deriva+60ppm", 100000, 60000, 10 },
+};
+
+static uint32_t sim_seconds = SIM_DEFAULT_SECONDS;
+static uint32_t rng_state = 12345;
+static int failures;
+
+static uint32_t rng(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static uint32_t rng_range(uint32_t min, uint32_t max) {
+    return min + rng() % (max - min + 1);
+}
+
+// Relógio do servidor (32 bits) no instante `t` do cliente.
+static uint32_t server_clock(const scenario_t* s, uint64_t t) {
+    int64_t drift = ((int64_t)t * s->drift_ppb) / 1000000000;
+    return (uint32_t)(0x9000000000ull + t + (uint64_t)drift);
+}
+
+static uint32_t abs_error(uint64_t estimated, uint64_t actual) {
+    int64_t e = (int64_t)(estimated - actual);
+    return (uint32_t)(e < 0 ? -e : e);
+}
+
+static void run(const scenario_t* s) {
+    time_sync_t anchored, midpoint;
+    time_sync_reset(&anchored);
+    time_sync_reset(&midpoint);
+    // Fase dos eventos de conexão em relação ao relógio do cliente.
+    uint64_t anchor = rng_range(0, s->interval_us);
+    uint32_t max_error = 0, max_error_mid = 0;
+    uint64_t t = 1000000;
+    uint64_t end = (uint64_t)sim_seconds * 1000000u;
+
+    for (uint32_t round = 0; t < end; round++, t += SIM_ROUND_PERIOD_US) {
+        uint64_t now = t;
+        for (uint32_t i = 0; i < TIME_SYNC_ROUND_EXCHANGES; i++) {
+            uint64_t t1 = now;
+            uint64_t ready = t1 + rng_range(SIM_STACK_MIN_US, SIM_STACK_MAX_US);
+            uint64_t event = anchor + ((ready - anchor) / s->interval_us + 1) * s->interval_us;
+            uint32_t t2 = server_clock(s, event + rng_range(SIM_STACK_MIN_US, SIM_STACK_MAX_US));
+            uint64_t reply = event + s->interval_us;
+            if (rng() % 100 < s->late_pct) reply += s->interval_us;
+            uint64_t t4 = reply + rng_range(SIM_STACK_MIN_US, SIM_STACK_MAX_US);
+            time_sync_add(&anchored, t1, t2, t4, s->interval_us);
+            time_sync_add(&midpoint, t1, t2, t4, 0);
+            now = t4 + rng_range(0, 500);
+        }
+        time_sync_finish_round(&anchored);
+        time_sync_finish_round(&midpoint);
+
+        // Erro na tradução de capturas ao longo do período até a próxima
+        // rodada (a deriva acumula até lá).
+        for (uint64_t c = now; c < now + SIM_ROUND_PERIOD_US; c += SIM_ROUND_PERIOD_US / 4) {
+            uint32_t e = abs_error(time_sync_to_local(&anchored, server_clock(s, c)), c);
+            uint32_t e_mid = abs_error(time_sync_to_local(&midpoint, server_clock(s, c)), c);
+            if (round < SIM_WARMUP_ROUNDS) continue;
+            if (e > max_error) max_error = e;
+            if (e_mid > max_error_mid) max_error_mid = e_mid;
+        }
+    }
+
+    bool ok = max_error <= SIM_MAX_ERROR_US;
+    printf("cenario=%s erro_max_us=%u ponto_medio_erro_max_us=%u deriva_ppb=%d estimada_ppb=%d dispersao_us=%u %s\n",
+           s->name, max_error, max_error_mid, s->drift_ppb, anchored.drift_ppb, anchored.dispersion_us,
+           ok ? "ok" : "FALHOU");
+    if (!ok) failures++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    if (argc > 1) sim_seconds = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (sim_seconds * 1000000ull < (SIM_WARMUP_ROUNDS + 2ull) * SIM_ROUND_PERIOD_US) {
+        fprintf(stderr, "duração curta demais (mínimo %u s)\n", (SIM_WARMUP_ROUNDS + 2U) * SIM_ROUND_PERIOD_US / 1000000U);
+        return 2;
+    }
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) run(&scenarios[i]);
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////////
+// Testes do anel de amostras e do ADC simulado (lib/adc_capture)
+// Só no build de host. Primeiro o anel (`sample_ring`), sem produtor:
+//  - parâmetros de `sample_ring_init` (tamanho potência de 2, >= 2);
+//  - ordem de leitura, `drain_latest`, `peek_latest` e `read_indexed`;
+//  - consumidor atrasado: descarte das amostras mais antigas, contado em
+//    `dropped`, com e sem janela de guarda;
+//  - segundo leitor (`peek_from`) atrás da janela válida;
+//  - contadores livres perto da volta de 32 bits.
+// Depois o ADC simulado (`adc_capture_host.c`), no relógio do host:
+//  - configurações e taxas recusadas, sem alterar a taxa em uso;
+//  - quantidade de amostras geradas pela taxa e pelo tempo decorrido;
+//  - continuidade da rampa, por entrada também em round-robin;
+//  - blocos entregues ao tratador iguais aos publicados no anel;
+//  - descarte quando o consumidor passa mais de um anel sem ler.
+//
+// Uso:
+//   adc_capture_test
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pico/stdlib.h"
+
+#include "adc_capture.h"
+#include "sample_ring.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Anel do ADC simulado nos testes de taxa.
+#define TEST_RING_SIZE 8192U
+
+// Tamanho de bloco (o do servidor no modo contínuo).
+#define TEST_BLOCK_LEN 128U
+
+static int failures;
+
+static void check(bool ok, const char* name) {
+    if (ok) return;
+    printf("teste=%s FALHOU\n", name);
+    failures++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_ring_init(void) {
+    sample_ring_t ring;
+    uint16_t storage[8];
+    check(sample_ring_init(&ring, storage, 8) == 0, "init");
+    check(sample_ring_init(&ring, storage, 6) < 0, "init_nao_potencia_de_2");
+    check(sample_ring_init(&ring, storage, 1) < 0, "init_tamanho_1");
+    check(sample_ring_init(&ring, NULL, 8) < 0, "init_sem_armazenamento");
+    check(sample_ring_init(NULL, storage, 8) < 0, "init_sem_anel");
+}
+
+static void test_ring_order(void) {
+    sample_ring_t ring;
+    uint16_t storage[8];
+    sample_ring_init(&ring, storage, 8);
+    uint16_t out[8];
+    uint16_t latest = 0xFFFF;
+    check(sample_ring_available(&ring) == 0, "vazio");
+    check(sample_ring_drain_latest(&ring, &latest) == 0 && latest == 0xFFFF, "drain_vazio");
+
+    for (uint16_t i = 0; i < 5; i++) sample_ring_push(&ring, (uint16_t)(100 + i));
+    check(sample_ring_peek_latest(&ring, &latest) == 5 && latest == 104, "peek_latest");
+    check(sample_ring_available(&ring) == 5, "peek_latest_nao_consome");
+
+    uint32_t first = 0;
+    uint32_t n = sample_ring_read_indexed(&ring, out, 3, &first);
+    check(n == 3 && first == 0 && out[0] == 100 && out[2] == 102, "read_indexed");
+    n = sample_ring_read_indexed(&ring, out, 8, &first);
+    check(n == 2 && first == 3 && out[0] == 103 && out[1] == 104, "read_indexed_resto");
+
+    for (uint16_t i = 0; i < 4; i++) sample_ring_push(&ring, (uint16_t)(200 + i));
+    check(sample_ring_drain_latest(&ring, &latest) == 4 && latest == 203, "drain_latest");
+    check(sample_ring_available(&ring) == 0 && ring.dropped == 0, "drain_consome");
+}
+
+static void test_ring_overrun(void) {
+    sample_ring_t ring;
+    uint16_t storage[8];
+    sample_ring_init(&ring, storage, 8);
+    uint16_t out[8];
+
+    // 13 amostras num anel de 8: as 5 mais antigas se perdem.
+    for (uint16_t i = 0; i < 13; i++) sample_ring_push(&ring, i);
+    uint32_t first = 0;
+    uint32_t n = sample_ring_read_indexed(&ring, out, 8, &first);
+    check(n == 8 && ring.dropped == 5, "atraso_descarta");
+    check(first == 5 && out[0] == 5 && out[7] == 12, "atraso_mais_recentes");
+
+    // Com guarda de 2, só 6 amostras ficam legíveis.
+    sample_ring_set_guard(&ring, 2);
+    for (uint16_t i = 0; i < 8; i++) sample_ring_push(&ring, (uint16_t)(20 + i));
+    n = sample_ring_read_indexed(&ring, out, 8, &first);
+    check(n == 6 && ring.dropped == 7 && out[0] == 22 && out[5] == 27, "guarda");
+
+    // Segundo leitor atrás da janela salta para a mais antiga válida.
+    uint32_t index = 0;
+    n = sample_ring_peek_from(&ring, &index, out, 8);
+    check(n == 6 && out[0] == 22 && index == ring.head, "peek_from_atrasado");
+    check(sample_ring_available(&ring) == 0, "peek_from_nao_consome");
+}
+
+static void test_ring_wrap(void) {
+    sample_ring_t ring;
+    uint16_t storage[8];
+    sample_ring_init(&ring, storage, 8);
+    ring.head = UINT32_MAX - 2;
+    ring.tail = UINT32_MAX - 2;
+    uint16_t out[8];
+    for (uint16_t i = 0; i < 6; i++) sample_ring_push(&ring, (uint16_t)(300 + i));
+    check(sample_ring_available(&ring) == 6, "volta_32_bits_pendentes");
+    uint32_t first = 0;
+    uint32_t n = sample_ring_read_indexed(&ring, out, 8, &first);
+    check(n == 6 && first == UINT32_MAX - 2 && out[0] == 300 && out[5] == 305, "volta_32_bits_leitura");
+    check(ring.tail == 3 && ring.dropped == 0, "volta_32_bits_contadores");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t ring_storage[TEST_RING_SIZE];
+static sample_ring_t capture_ring;
+static uint32_t handler_samples;
+
+static void count_block(const uint16_t* samples, uint32_t count) {
+    (void)samples;
+    handler_samples += count;
+}
+
+static void test_capture_rejects(void) {
+    sample_ring_init(&capture_ring, ring_storage, TEST_RING_SIZE);
+    adc_capture_config_t config = { 10000, 0, TEST_BLOCK_LEN, 0 };
+    check(adc_capture_init(NULL, &capture_ring) < 0, "captura_sem_config");
+    config.input = 5;
+    check(adc_capture_init(&config, &capture_ring) < 0, "captura_entrada_invalida");
+    config.input = 0;
+    config.block_len = 3000;
+    check(adc_capture_init(&config, &capture_ring) < 0, "captura_bloco_nao_divide_anel");
+    config.block_len = TEST_RING_SIZE / 2;
+    check(adc_capture_init(&config, &capture_ring) < 0, "captura_menos_de_3_blocos");
+    config.block_len = TEST_BLOCK_LEN;
+    config.sample_rate_hz = ADC_CAPTURE_MIN_RATE_HZ - 1;
+    check(adc_capture_init(&config, &capture_ring) < 0, "captura_taxa_baixa");
+    config.sample_rate_hz = ADC_CAPTURE_MAX_RATE_HZ + 1;
+    check(adc_capture_init(&config, &capture_ring) < 0, "captura_taxa_alta");
+
+    config.sample_rate_hz = 10000;
+    check(adc_capture_init(&config, &capture_ring) == 0, "captura_init");
+    check(adc_capture_set_rate(ADC_CAPTURE_MIN_RATE_HZ - 1) < 0 && adc_capture_get_rate() == 10000,
+          "set_rate_baixa_mantem_taxa");
+    check(adc_capture_set_rate(ADC_CAPTURE_MAX_RATE_HZ + 1) < 0 && adc_capture_get_rate() == 10000,
+          "set_rate_alta_mantem_taxa");
+    check(adc_capture_set_rate(ADC_CAPTURE_MIN_RATE_HZ) == 0 && adc_capture_get_rate() == ADC_CAPTURE_MIN_RATE_HZ,
+          "set_rate_minima");
+    check(adc_capture_set_rate(ADC_CAPTURE_MAX_RATE_HZ) == 0 && adc_capture_get_rate() == ADC_CAPTURE_MAX_RATE_HZ,
+          "set_rate_maxima");
+}
+
+// Captura `ms` milissegundos a `rate_hz` com as entradas de `round_robin`
+// e confere quantidade, continuidade por entrada e blocos entregues.
+static void run_capture(const char* name, uint32_t rate_hz, uint8_t round_robin, uint32_t channels, uint32_t ms) {
+    sample_ring_init(&capture_ring, ring_storage, TEST_RING_SIZE);
+    adc_capture_config_t config = { rate_hz, 0, TEST_BLOCK_LEN, round_robin };
+    if (adc_capture_init(&config, &capture_ring) != 0) {
+        check(false, name);
+        return;
+    }
+    handler_samples = 0;
+    adc_capture_set_block_handler(count_block);
+
+    uint64_t before_us = time_us_64();
+    adc_capture_start();
+    uint64_t started_us = time_us_64();
+    sleep_ms(ms);
+    uint64_t poll_start_us = time_us_64();
+    adc_capture_poll();
+    uint64_t poll_end_us = time_us_64();
+    adc_capture_stop();
+    adc_capture_set_block_handler(NULL);
+
+    // O simulador gera floor(decorrido * taxa / 1 s) amostras, com o
+    // decorrido medido em algum instante entre as leituras do relógio.
+    uint32_t generated = capture_ring.head;
+    uint64_t min_due = (poll_start_us - started_us) * rate_hz / 1000000u;
+    uint64_t max_due = (poll_end_us - before_us) * rate_hz / 1000000u;
+    bool rate_ok = generated >= min_due && generated <= max_due;
+    bool blocks_ok = handler_samples == generated;
+
+    // Rampa de 1 s por entrada: entre amostras vizinhas da mesma entrada
+    // o valor anda no máximo ceil(4095 / meio período), mais 2 do ruído
+    // no LSB (ex.: 3 ^ 1 = 2 e 4 ^ 1 = 5).
+    uint16_t* samples = (uint16_t*)malloc(TEST_RING_SIZE * sizeof(uint16_t));
+    uint32_t n = sample_ring_read(&capture_ring, samples, TEST_RING_SIZE);
+    uint32_t half_period = rate_hz / channels / 2;
+    int max_step = (int)((4095u + half_period - 1) / half_period) + 2;
+    int worst = 0;
+    for (uint32_t i = channels; i < n; i++) {
+        int step = abs((int)samples[i] - (int)samples[i - channels]);
+        if (step > worst) worst = step;
+    }
+    free(samples);
+    bool ramp_ok = n == generated && n > channels && worst <= max_step;
+
+    // Parada: nada mais é gerado.
+    sleep_ms(5);
+    adc_capture_poll();
+    bool stop_ok = capture_ring.head == generated;
+
+    printf("captura=%s taxa_hz=%u entradas=%u ms=%u amostras=%u esperado=%u..%u passo_max=%d/%d %s\n", name,
+           rate_hz, channels, ms, generated, (unsigned)min_due, (unsigned)max_due, worst, max_step,
+           (rate_ok && blocks_ok && ramp_ok && stop_ok) ? "ok" : "FALHOU");
+    check(rate_ok, "captura_taxa");
+    check(blocks_ok, "captura_blocos");
+    check(ramp_ok, "captura_rampa");
+    check(stop_ok, "captura_parada");
+}
+
+// Consumidor que passa mais de um anel sem ler: só as últimas `size`
+// amostras sobrevivem e as demais contam como descartadas.
+static void test_capture_overrun(void) {
+    static uint16_t small_storage[1024];
+    sample_ring_init(&capture_ring, small_storage, 1024);
+    adc_capture_config_t config = { 100000, 0, TEST_BLOCK_LEN, 0 };
+    check(adc_capture_init(&config, &capture_ring) == 0, "atraso_init");
+    adc_capture_start();
+    sleep_ms(50);
+    adc_capture_poll();
+    adc_capture_stop();
+
+    uint32_t head = capture_ring.head;
+    uint32_t available = sample_ring_available(&capture_ring);
+    uint16_t out[4];
+    uint32_t first = 0;
+    sample_ring_read_indexed(&capture_ring, out, 4, &first);
+    bool ok = head > 2048 && available == 1024 && capture_ring.dropped == head - 1024 && first == head - 1024;
+    printf("captura=atraso amostras=%u disponiveis=%u descartadas=%u %s\n", head, available, capture_ring.dropped,
+           ok ? "ok" : "FALHOU");
+    check(ok, "captura_atraso");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+    test_ring_init();
+    test_ring_order();
+    test_ring_overrun();
+    test_ring_wrap();
+    printf("anel %s\n", failures ? "FALHOU" : "ok");
+
+    test_capture_rejects();
+    run_capture("simples", 20000, 0, 1, 100);
+    run_capture("round_robin", 48000, 0x13, 3, 100);
+    test_capture_overrun();
+
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
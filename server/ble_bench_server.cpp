@@ -0,0 +1,320 @@
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark do enlace BLE - lado servidor (periférico)
+// Envia cargas sintéticas numeradas (lib/ble_bench) tão rápido quanto a
+// pilha permite (a cada ATT_EVENT_CAN_SEND_NOW) e informa, a cada
+// segundo, vazão, notificações por segundo e tempo de espera por buffer
+// (créditos) do controlador. Par de `ble_bench_client`, no cliente.
+////////////////////////////////////////////////////////////////////////////////
+
+// Tag deste módulo nos logs (ver `log_set_tag_level`).
+#define LOG_TAG "BENCH_SRV"
+
+#include "btstack.h"
+#include "pico/cyw43_arch.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "bench_profile.h"
+
+#include "log_vt100.h"
+#include "link_profile.h"
+#include "ble_bench.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Parâmetros do benchmark (definidos pelo CMake).
+// Tamanho da carga de cada notificação, em bytes (limitado ao ATT MTU - 3).
+#ifndef BENCH_PAYLOAD_SIZE
+#define BENCH_PAYLOAD_SIZE 244U
+#endif
+// Maior ATT MTU aceito na troca de MTU.
+#ifndef BENCH_MTU
+#define BENCH_MTU 247U
+#endif
+// PHY pedido à central (LINK_PHY_1M, LINK_PHY_2M ou LINK_PHY_CODED).
+#ifndef BENCH_PHY
+#define BENCH_PHY LINK_PHY_2M
+#endif
+// Intervalo de conexão pedido à central, em unidades de 1,25 ms.
+#ifndef BENCH_CONN_INTERVAL
+#define BENCH_CONN_INTERVAL 6U
+#endif
+
+#if BENCH_PAYLOAD_SIZE < BLE_BENCH_HEADER_SIZE || BENCH_PAYLOAD_SIZE > BLE_BENCH_MAX_PAYLOAD
+#error "BENCH_PAYLOAD_SIZE precisa estar entre BLE_BENCH_HEADER_SIZE e BLE_BENCH_MAX_PAYLOAD"
+#endif
+
+// Handles da característica de benchmark, gerados a partir de
+// `bench_profile.gatt`.
+#define BENCH_STREAM_VALUE_HANDLE ATT_CHARACTERISTIC_8C4B0101_2E57_4A19_B6D3_71F0C95A3E20_01_VALUE_HANDLE
+#define BENCH_STREAM_CCCD_HANDLE  ATT_CHARACTERISTIC_8C4B0101_2E57_4A19_B6D3_71F0C95A3E20_01_CLIENT_CONFIGURATION_HANDLE
+
+// Período do relatório no log, em milissegundos.
+#define BENCH_REPORT_PERIOD_MS 1000U
+
+// Supervisão pedida junto com o intervalo, em unidades de 10 ms (4 s).
+#define BENCH_SUPERVISION_TIMEOUT 400U
+
+// Tag dos logs internos da BTstack e seu nível inicial (só avisos e erros).
+#define BTSTACK_LOG_TAG "BTSTACK"
+#define BTSTACK_LOG_LEVEL LOG_LEVEL_WARN
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Anúncio: flags e o UUID de 128 bits do serviço de benchmark
+// (preenchido invertido em `main`).
+static uint8_t adv_data[] = {
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06,
+    0x11, BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+static const uint8_t bench_service_uuid128[16] = { BLE_BENCH_SERVICE_UUID128 };
+
+// Estado da conexão (uma central por vez).
+static hci_con_handle_t con_handle = HCI_CON_HANDLE_INVALID;
+static bool streaming;
+static uint16_t payload_len = BLE_BENCH_HEADER_SIZE;
+static uint16_t mtu = ATT_DEFAULT_MTU;
+static uint8_t tx_phy = LINK_PHY_1M;
+static uint16_t max_tx_octets = LINK_DEFAULT_OCTETS;
+static uint16_t conn_interval;
+static uint8_t payload[BLE_BENCH_MAX_PAYLOAD];
+
+// Contadores acumulados desde a assinatura e seus valores no último
+// relatório.
+typedef struct {
+    uint32_t notifications;
+    uint32_t bytes;
+    // Eventos ATT_EVENT_CAN_SEND_NOW e tempo total esperando por eles
+    // (buffers do controlador ocupados), em microssegundos.
+    uint32_t can_send_events;
+    uint64_t wait_us;
+} bench_counters_t;
+static bench_counters_t counters;
+static bench_counters_t last_report;
+static uint32_t next_seq;
+static uint32_t wait_start_us;
+static uint32_t stream_start_us;
+static uint32_t last_report_us;
+
+static btstack_timer_source_t report_timer;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_packet_callback_registration_t l2cap_event_callback_registration;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Pede o próximo ATT_EVENT_CAN_SEND_NOW e marca o início da espera.
+static void request_send(void) {
+    wait_start_us = time_us_32();
+    att_server_request_can_send_now_event(con_handle);
+}
+
+// Envia cargas enquanto houver buffer no controlador e volta a pedir
+// permissão. Uma carga só consome a sequência se foi aceita pela pilha.
+static void send_payloads(void) {
+    counters.can_send_events++;
+    counters.wait_us += time_us_32() - wait_start_us;
+    while (streaming && att_server_can_send_packet_now(con_handle)) {
+        ble_bench_fill(payload, payload_len, next_seq, time_us_32());
+        if (att_server_notify(con_handle, BENCH_STREAM_VALUE_HANDLE, payload, payload_len) != ERROR_CODE_SUCCESS) break;
+        next_seq++;
+        counters.notifications++;
+        counters.bytes += payload_len;
+    }
+    if (streaming) request_send();
+}
+
+// Relatório periódico: uma linha "chave=valor" por segundo, fácil de
+// filtrar para acompanhar regressões.
+static void report_handler(btstack_timer_source_t *ts) {
+    uint32_t now_us = time_us_32();
+    uint32_t elapsed_us = now_us - last_report_us;
+    if (streaming && elapsed_us > 0) {
+        uint32_t notifications = counters.notifications - last_report.notifications;
+        uint32_t bytes = counters.bytes - last_report.bytes;
+        uint32_t events = counters.can_send_events - last_report.can_send_events;
+        uint64_t wait_us = counters.wait_us - last_report.wait_us;
+        LOG_INFO("t=%us kbps=%u pps=%u payload=%u mtu=%u phy=%s pdu=%u interval_us=%u wait_pct=%u wait_avg_us=%u",
+                 (unsigned)((now_us - stream_start_us) / 1000000U),
+                 (unsigned)((uint64_t)bytes * 8000U / elapsed_us),
+                 (unsigned)((uint64_t)notifications * 1000000U / elapsed_us),
+                 payload_len, mtu, link_phy_name(tx_phy), max_tx_octets,
+                 (unsigned)LINK_INTERVAL_US(conn_interval),
+                 (unsigned)(wait_us * 100U / elapsed_us),
+                 (unsigned)(events ? wait_us / events : 0));
+    }
+    last_report = counters;
+    last_report_us = now_us;
+    btstack_run_loop_set_timer(ts, BENCH_REPORT_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+// Só o CCCD da característica de benchmark é gravável: ao assinar, a
+// sequência e os contadores recomeçam e o envio contínuo começa.
+static int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode,
+                              uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    if (att_handle != BENCH_STREAM_CCCD_HANDLE || buffer_size < 2) return 0;
+    streaming = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+    if (!streaming) {
+        LOG_INFO("Envio interrompido após %u notificações", (unsigned)counters.notifications);
+        return 0;
+    }
+    con_handle = connection_handle;
+    payload_len = (uint16_t)btstack_min(BENCH_PAYLOAD_SIZE, mtu - 3U);
+    memset(&counters, 0, sizeof(counters));
+    last_report = counters;
+    next_seq = 0;
+    stream_start_us = last_report_us = time_us_32();
+    LOG_INFO("Envio contínuo iniciado: cargas de %u bytes (MTU %u)", payload_len, mtu);
+    request_send();
+    return 0;
+}
+
+// Handler de eventos HCI, L2CAP e ATT.
+static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case BTSTACK_EVENT_STATE: {
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
+            bd_addr_t local_addr;
+            gap_local_bd_addr(local_addr);
+            LOG_INFO("BTstack operacional no endereço %s", bd_addr_to_str(local_addr));
+            bd_addr_t null_addr;
+            memset(null_addr, 0, 6);
+            // Anúncio rápido (100 ms) para encurtar a conexão.
+            gap_advertisements_set_params(160, 160, 0, 0, null_addr, 0x07, 0x00);
+            gap_advertisements_set_data(sizeof(adv_data), adv_data);
+            gap_advertisements_enable(1);
+            break;}
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)) {
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                    con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+                    mtu = ATT_DEFAULT_MTU;
+                    tx_phy = LINK_PHY_1M;
+                    max_tx_octets = LINK_DEFAULT_OCTETS;
+                    LOG_INFO("Central conectada (Handle: 0x%04X, intervalo %u us)", con_handle, (unsigned)LINK_INTERVAL_US(conn_interval));
+                    // A central decide; pedimos intervalo e PHY do benchmark.
+                    if (conn_interval != BENCH_CONN_INTERVAL) {
+                        gap_request_connection_parameter_update(con_handle, BENCH_CONN_INTERVAL, BENCH_CONN_INTERVAL, 0, BENCH_SUPERVISION_TIMEOUT);
+                    }
+                    gap_le_set_phy(con_handle, 0, LINK_PHY_MASK(BENCH_PHY), LINK_PHY_MASK(BENCH_PHY), 0);
+                    break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    if (hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                    conn_interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                    LOG_INFO("Intervalo de conexão: %u us", (unsigned)LINK_INTERVAL_US(conn_interval));
+                    break;
+                case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE:
+                    if (hci_subevent_le_phy_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                        LOG_WARN("PHY %s recusado, segue em %s", link_phy_name(BENCH_PHY), link_phy_name(tx_phy));
+                        break;
+                    }
+                    tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+                    LOG_INFO("PHY TX %s, RX %s", link_phy_name(tx_phy), link_phy_name(hci_subevent_le_phy_update_complete_get_rx_phy(packet)));
+                    break;
+                case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+                    max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+                    LOG_INFO("PDUs de dados de até %u bytes (TX)", max_tx_octets);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            LOG_INFO("Central desconectada (motivo 0x%02X)", hci_event_disconnection_complete_get_reason(packet));
+            con_handle = HCI_CON_HANDLE_INVALID;
+            streaming = false;
+            break;
+        case L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE:
+            if (l2cap_event_connection_parameter_update_response_get_result(packet) != 0) {
+                LOG_WARN("Central recusou o intervalo de conexão pedido");
+            }
+            break;
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            mtu = att_event_mtu_exchange_complete_get_MTU(packet);
+            LOG_INFO("ATT MTU negociado: %u bytes", mtu);
+            break;
+        case ATT_EVENT_CAN_SEND_NOW:
+            send_payloads();
+            break;
+        default:
+            break;
+    }
+}
+
+// Encaminha os logs internos da BTstack para o log_vt100 (tag "BTSTACK").
+static log_site_t btstack_log_site = LOG_SITE_INIT(BTSTACK_LOG_TAG, "BTstack");
+
+static void btstack_log_reset(void) {
+}
+
+static void btstack_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    UNUSED(packet_type);
+    UNUSED(in);
+    UNUSED(packet);
+    UNUSED(len);
+}
+
+static void btstack_log_message(int log_level, const char * format, va_list argptr) {
+    log_level_t level = LOG_LEVEL_DEBUG;
+    if (log_level == HCI_DUMP_LOG_LEVEL_INFO) level = LOG_LEVEL_INFO;
+    if (log_level == HCI_DUMP_LOG_LEVEL_ERROR) level = LOG_LEVEL_WARN;
+    if (!log_site_check(&btstack_log_site, level)) return;
+    log_vwrite_tagged(level, BTSTACK_LOG_TAG, format, argptr);
+}
+
+static const hci_dump_t btstack_log_dump = {
+    &btstack_log_reset,
+    &btstack_log_packet,
+    &btstack_log_message,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+    stdio_init_all();
+    log_set_level(LOG_LEVEL_INFO);
+
+    LOG_INFO("Benchmark BLE (servidor): carga %u bytes, MTU %u, PHY %s, intervalo %u us",
+             BENCH_PAYLOAD_SIZE, BENCH_MTU, link_phy_name(BENCH_PHY), (unsigned)LINK_INTERVAL_US(BENCH_CONN_INTERVAL));
+
+    if (cyw43_arch_init()) {
+        LOG_WARN("Falha ao inicializar cyw43_arch");
+        return -1;
+    }
+    log_set_tag_level(BTSTACK_LOG_TAG, BTSTACK_LOG_LEVEL);
+    hci_dump_init(&btstack_log_dump);
+
+    l2cap_init();
+    l2cap_set_max_le_mtu(BENCH_MTU);
+    sm_init();
+    att_server_init(profile_data, NULL, att_write_callback);
+    reverse_128(bench_service_uuid128, &adv_data[5]);
+
+    hci_event_callback_registration.callback = &packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+    l2cap_event_callback_registration.callback = &packet_handler;
+    l2cap_add_event_handler(&l2cap_event_callback_registration);
+    att_server_register_packet_handler(packet_handler);
+
+    report_timer.process = &report_handler;
+    btstack_run_loop_set_timer(&report_timer, BENCH_REPORT_PERIOD_MS);
+    btstack_run_loop_add_timer(&report_timer);
+
+    hci_power_control(HCI_POWER_ON);
+    // Os relatórios saem de forma síncrona, uma linha por segundo, fora
+    // do caminho de envio.
+    btstack_run_loop_execute();
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// End of file
+////////////////////////////////////////////////////////////////////////////////
@@ -1,11 +1,22 @@
 ////////////////////////////////////////////////////////////////////////////////
 
+// Tag deste módulo nos logs (ver `log_set_tag_level`).
+#define LOG_TAG "BLE_SRV"
+
 #include "btstack.h"
 #include "pico/cyw43_arch.h"
 #include "pico/btstack_cyw43.h"
+#include "pico/time.h"
 #include "temp_sensor.h"
 #include "pico.h"
 #include "log_vt100.h"
+#include "sample_packet.h"
+#include "sample_control.h"
+#include "notify_policy.h"
+#include "sample_broadcast.h"
+#include "sample_backlog.h"
+#include "time_sync.h"
+#include "flash_log.h"
 #include "bt_server_setup.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -14,17 +25,275 @@
 // + BR/EDR not supported), conforme especificação Bluetooth.
 #define APP_AD_FLAGS 0x06
 
+// Handles da característica "Sample Stream" (notificações em lote),
+// gerados a partir do UUID de 128 bits declarado em `temp_sensor.gatt`.
+#define SAMPLE_STREAM_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0001_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define SAMPLE_STREAM_CCCD_HANDLE  ATT_CHARACTERISTIC_5A1E0001_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_CLIENT_CONFIGURATION_HANDLE
+
+// Handle da característica "Sample Control" (ponto de controle).
+#define SAMPLE_CONTROL_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0003_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+
+// Handles da característica "Sample Backlog" (download do registro em
+// flash).
+#define SAMPLE_BACKLOG_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0004_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define SAMPLE_BACKLOG_CCCD_HANDLE  ATT_CHARACTERISTIC_5A1E0004_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_CLIENT_CONFIGURATION_HANDLE
+
+// Handle da característica "Time Sync" (sincronização de relógios).
+#define TIME_SYNC_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0005_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+
+// Handles das características das entradas extras do ADC (round-robin),
+// 5A1E0010 + entrada.
+#define CHANNEL_1_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0011_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define CHANNEL_1_CCCD_HANDLE  ATT_CHARACTERISTIC_5A1E0011_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_CLIENT_CONFIGURATION_HANDLE
+#define CHANNEL_2_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0012_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define CHANNEL_2_CCCD_HANDLE  ATT_CHARACTERISTIC_5A1E0012_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_CLIENT_CONFIGURATION_HANDLE
+#define CHANNEL_4_VALUE_HANDLE ATT_CHARACTERISTIC_5A1E0014_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_VALUE_HANDLE
+#define CHANNEL_4_CCCD_HANDLE  ATT_CHARACTERISTIC_5A1E0014_6C3B_4D2C_9A5E_2F0B7E1C0A01_01_CLIENT_CONFIGURATION_HANDLE
+
+// Número de entradas extras com característica própria.
+#define CHANNEL_COUNT 3
+
+// Handles do serviço GATT: Service Changed (e seu CCCD), Database Hash e
+// Client Supported Features.
+#define SERVICE_CHANGED_VALUE_HANDLE ATT_CHARACTERISTIC_GATT_SERVICE_CHANGED_01_VALUE_HANDLE
+#define SERVICE_CHANGED_CCCD_HANDLE  ATT_CHARACTERISTIC_GATT_SERVICE_CHANGED_01_CLIENT_CONFIGURATION_HANDLE
+#define DATABASE_HASH_VALUE_HANDLE   ATT_CHARACTERISTIC_GATT_DATABASE_HASH_01_VALUE_HANDLE
+#define CLIENT_FEATURES_VALUE_HANDLE ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES_01_VALUE_HANDLE
+// Bit "robust caching" de Client Supported Features.
+#define CLIENT_FEATURE_ROBUST_CACHING 0x01
+#define DATABASE_HASH_SIZE 16
+
+// Centrais pareadas (com bonding) lembradas pelo endereço de identidade,
+// com o Database Hash da base que viram por último e o CCCD de Service
+// Changed, para indicar Service Changed depois de uma atualização de
+// firmware. Cada uma ocupa um registro no banco TLV da BTstack ("SPH" +
+// índice).
+#define SERVER_KNOWN_PEERS 8
+#define KNOWN_PEER_TAG(i) (((uint32_t)'S' << 24) | ((uint32_t)'P' << 16) | ((uint32_t)'H' << 8) | (uint32_t)(i))
+
+// Menor período de heartbeat aceito pelo ponto de controle, em ms.
+#define HEARTBEAT_MIN_PERIOD_MS 10
+
+// Capacidade da fila de amostras usada para os lotes no modo de leitura
+// única (uma amostra por heartbeat). Potência de 2.
+#define HEARTBEAT_QUEUE_SIZE 64
+
+// Política de notificação (definida pelo CMake).
+// 1: notifica quando a amostra varia mais que SERVER_NOTIFY_DEADBAND, no
+//    máximo a cada SERVER_NOTIFY_MIN_INTERVAL_MS e ao menos a cada
+//    SERVER_NOTIFY_MAX_INTERVAL_MS (keep-alive), avaliando cada amostra;
+// 0: notifica a cada heartbeat (comportamento original).
+#ifndef SERVER_NOTIFY_POLICY
+#define SERVER_NOTIFY_POLICY 1
+#endif
+
+// Banda morta, em contagens do ADC.
+#ifndef SERVER_NOTIFY_DEADBAND
+#define SERVER_NOTIFY_DEADBAND 16U
+#endif
+
+// Intervalos mínimo (limite de taxa) e máximo (keep-alive) entre
+// notificações, em milissegundos.
+#ifndef SERVER_NOTIFY_MIN_INTERVAL_MS
+#define SERVER_NOTIFY_MIN_INTERVAL_MS 20U
+#endif
+#ifndef SERVER_NOTIFY_MAX_INTERVAL_MS
+#define SERVER_NOTIFY_MAX_INTERVAL_MS 1000U
+#endif
+
+// Período, em milissegundos, da avaliação da política nos modos contínuo
+// e de dois núcleos, em que as amostras chegam mais rápido que o
+// heartbeat. No modo de leitura única a avaliação é feita no heartbeat.
+#define NOTIFY_POLICY_POLL_MS 5
+
+// Amostras avaliadas por cópia do anel/fila.
+#define NOTIFY_POLICY_CHUNK 64
+
+// Capacidade do anel que recebe as amostras da fila SPSC no modo de dois
+// núcleos, lido por cada conexão com cursor próprio. Potência de 2.
+#define QUEUE_FANOUT_SIZE 1024
+
+// Período do relatório de vazão por conexão, em microssegundos.
+#define CONNECTION_REPORT_INTERVAL_US 10000000U
+
+// Modo de instrumentação (definido pelo CMake): cada lote leva o instante
+// de captura da sua última amostra (SAMPLE_PACKET_FLAG_TIMESTAMP), para
+// medição de latência de ponta a ponta no cliente.
+#ifndef SERVER_SAMPLE_TIMESTAMPS
+#define SERVER_SAMPLE_TIMESTAMPS 0
+#endif
+
+#if SERVER_SAMPLE_TIMESTAMPS
+#define SAMPLE_PACKET_FLAGS SAMPLE_PACKET_FLAG_TIMESTAMP
+#else
+#define SAMPLE_PACKET_FLAGS 0
+#endif
+
+// Codificação das amostras nos lotes (definida pelo CMake): uma das
+// SAMPLE_PACKET_ENCODING_* (ver lib/sample_stream/sample_codec.h) ou
+// SAMPLE_PACKET_ENCODING_AUTO, que escolhe a cada lote a codificação que
+// leva mais amostras. Em 12 bits, um lote com amostras maiores (filtros
+// que ganham bits) sai na codificação escolhida automaticamente.
+#define SAMPLE_PACKET_ENCODING_AUTO 0xFF
+#ifndef SERVER_SAMPLE_ENCODING
+#define SERVER_SAMPLE_ENCODING SAMPLE_PACKET_ENCODING_RAW16
+#endif
+
+// `flags` usadas no cálculo da capacidade de um lote. No modo automático,
+// o limite superior é o da codificação delta.
+#if SERVER_SAMPLE_ENCODING == SAMPLE_PACKET_ENCODING_AUTO
+#define SAMPLE_CAPACITY_FLAGS (SAMPLE_PACKET_FLAGS | SAMPLE_PACKET_ENCODING_DELTA)
+#else
+#define SAMPLE_CAPACITY_FLAGS (SAMPLE_PACKET_FLAGS | SERVER_SAMPLE_ENCODING)
+#endif
+
+// Modo broadcast (definido pelo CMake): as últimas amostras vão no
+// próprio anúncio (ver lib/sample_stream/sample_broadcast.h), atualizado
+// a cada heartbeat, e o anúncio deixa de aceitar conexões. Qualquer
+// número de receptores lê os valores em scan passivo.
+#ifndef SERVER_BROADCAST
+#define SERVER_BROADCAST 0
+#endif
+
+// Intervalo de anúncio no modo broadcast, em ms (100 ms é o mínimo para
+// anúncios não conectáveis antes do Bluetooth 5).
+#ifndef SERVER_BROADCAST_INTERVAL_MS
+#define SERVER_BROADCAST_INTERVAL_MS 100U
+#endif
+
+// Registro em flash (definido pelo CMake): enquanto nenhuma central
+// recebe o fluxo ao vivo, as amostras do anel dos lotes vão para um
+// registro circular na flash (ver lib/flash_log/flash_log.h), baixado
+// pela característica "Sample Backlog" na próxima conexão.
+#ifndef SERVER_FLASH_LOG
+#define SERVER_FLASH_LOG 0
+#endif
+
+// Setores de 4 KB da região do registro, cada um com até
+// FLASH_LOG_RECORD_SAMPLES amostras.
+#ifndef SERVER_FLASH_LOG_SECTORS
+#define SERVER_FLASH_LOG_SECTORS 64U
+#endif
+
+// Posição liberada do registro (seq e amostra), no banco TLV da BTstack.
+#define SAMPLE_LOG_TAIL_TAG (((uint32_t)'S' << 24) | ((uint32_t)'L' << 16) | ((uint32_t)'T' << 8))
+
+// Tag dos logs internos da BTstack e seu nível inicial (só avisos e erros).
+#define BTSTACK_LOG_TAG "BTSTACK"
+#define BTSTACK_LOG_LEVEL LOG_LEVEL_WARN
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Estrutura de timer usada como "heartbeat" periódico da aplicação.
 btstack_timer_source_t heartbeat;
+// Período atual do heartbeat, em ms: HEARTBEAT_PERIOD_MS até ser
+// alterado pelo ponto de controle.
+uint16_t heartbeat_period_ms = HEARTBEAT_PERIOD_MS;
+// Timer de avaliação da política de notificação (modos contínuo e de
+// dois núcleos).
+btstack_timer_source_t notify_policy_timer;
 // Registro para callback de eventos HCI (estado da pilha, conexões, etc.).
 btstack_packet_callback_registration_t hci_event_callback_registration;
 
-// Flag que indica se o cliente habilitou notificações na característica.
-int le_notification_enabled;
-// Handle da conexão atual com o cliente BLE.
-hci_con_handle_t con_handle;
+// Estado de cada central conectada: assinaturas (CCCDs), MTU, envios
+// pendentes, cursor próprio no fluxo de amostras e estatísticas. Um
+// registro livre tem `con_handle` igual a HCI_CON_HANDLE_INVALID.
+typedef struct {
+    hci_con_handle_t con_handle;
+    uint16_t mtu;                       // ATT MTU negociado
+    int le_notification_enabled;        // CCCD da característica de temperatura
+    int batch_notification_enabled;     // CCCD do "Sample Stream"
+    uint8_t channel_notifications;      // CCCDs das entradas extras (bit i = channel_attributes[i])
+    bool primary_send_pending;          // notificação ou lote do fluxo principal pendente
+    uint8_t channel_pending;            // entradas extras com notificação pendente (bits)
+    bool send_requested;                // pedido de envio registrado na pilha ATT
+    btstack_context_callback_registration_t send_request;
+    uint32_t batch_index;               // próxima amostra a enviar em lote
+    // Política de notificação do fluxo principal deste enlace: último
+    // valor notificado e instante, para que o envio a uma central não
+    // conte como notificação para as outras.
+    notify_policy_t policy;
+    // Download do registro em flash ("Sample Backlog"): registro e índice
+    // da próxima amostra a enviar, totais enviados, posição do fim (a
+    // liberar quando a central assinar o fluxo ao vivo) e índice da
+    // primeira amostra ao vivo.
+    bool backlog_active;                // download em andamento
+    bool backlog_done;                  // fim enviado; aguarda a assinatura ao vivo
+    bool backlog_started;               // `backlog_index` já aponta para `backlog_seq`
+    uint32_t backlog_seq;
+    uint32_t backlog_index;
+    uint32_t backlog_records;
+    uint32_t backlog_samples;
+    uint32_t backlog_bytes;
+    uint32_t backlog_start_us;
+    uint32_t backlog_end_seq;
+    uint16_t backlog_end_offset;
+    uint32_t backlog_next_index;
+    // Cache GATT da central: endereço da conexão, endereço de identidade
+    // (só de centrais pareadas, `bonded`), Client Supported Features,
+    // CCCD de Service Changed e estado "change-aware" (a central conhece
+    // a base atual). Uma central "change-unaware" com robust caching
+    // recebe Database Out Of Sync até confirmar o Service Changed.
+    bd_addr_t peer_addr;
+    bool bonded;
+    bd_addr_t identity_addr;
+    uint8_t identity_addr_type;
+    uint8_t client_features;
+    bool service_changed_indications;
+    bool change_aware;
+    bool out_of_sync_sent;
+    // Parâmetros de conexão em uso (unidades do HCI: 1,25 ms, eventos e
+    // 10 ms), informados pelo controlador.
+    uint16_t conn_interval;
+    uint16_t conn_latency;
+    uint16_t supervision_timeout;
+    // PHY e tamanho máximo das PDUs de dados em uso (BLE_HIGH_THROUGHPUT).
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint16_t max_tx_octets;
+    uint16_t max_rx_octets;
+    // Estatísticas desde a conexão e valores no último relatório.
+    uint32_t connected_us;
+    uint32_t notifications;
+    uint32_t bytes;
+    uint32_t samples;
+    uint32_t dropped;                   // amostras perdidas por atraso deste enlace
+    uint32_t deferred;                  // envios adiados pela cota de buffers
+    uint32_t report_notifications;
+    uint32_t report_bytes;
+    uint32_t report_samples;
+} server_connection_t;
+
+server_connection_t connections[SERVER_MAX_CONNECTIONS];
+
+// Central pareada lembrada: endereço de identidade, Database Hash da base
+// que ela viu por último e o seu CCCD de Service Changed, que vale entre
+// conexões para centrais pareadas.
+typedef struct {
+    bd_addr_t addr;
+    uint8_t addr_type;
+    uint8_t service_changed_indications;
+    uint8_t hash[DATABASE_HASH_SIZE];
+} known_peer_t;
+
+// Cópia em RAM dos registros TLV das centrais lembradas; o próximo
+// registro a ser sobrescrito quando a tabela está cheia.
+known_peer_t known_peers[SERVER_KNOWN_PEERS];
+bool known_peer_valid[SERVER_KNOWN_PEERS];
+uint8_t known_peer_next;
+// Database Hash da base compilada (`profile_data`).
+const uint8_t* database_hash;
+
+// Perfil de parâmetros de conexão pedido às centrais
+// (`bt_server_set_link_profile`).
+link_profile_t link_profile = LINK_PROFILE_BALANCED;
+// Registro para eventos L2CAP (resposta ao pedido de parâmetros).
+btstack_packet_callback_registration_t l2cap_event_callback_registration;
+// Registro para eventos do Security Manager (identidade das centrais
+// pareadas).
+btstack_packet_callback_registration_t sm_event_callback_registration;
+// Instante do último relatório de vazão por conexão.
+uint32_t connection_report_us;
 
 // Ponteiro global para a função de callback fornecida pela aplicação.
 // Tipicamente, esta função atualiza o valor da variável exposta via GATT
@@ -34,6 +303,85 @@ void(*global_callback_task)(void);
 // nas notificações GATT ao cliente.
 uint16_t* global_callback_message;
 
+// Anel de amostras consumido no modo de captura contínua
+// (`bt_server_init_stream`); NULL no modo de leitura única.
+sample_ring_t* global_sample_ring;
+// Fila SPSC alimentada pelo core 1 (`bt_server_init_queue`); NULL nos
+// demais modos.
+spsc_queue_t* global_sample_queue;
+// Anel que recebe tudo o que sai de `global_sample_queue`, para que cada
+// conexão leia os lotes com cursor próprio. O índice absoluto de cada
+// amostra é o total retirado da fila até ela.
+uint16_t queue_fanout_storage[QUEUE_FANOUT_SIZE];
+sample_ring_t queue_fanout;
+// Amostra mais recente retirada do anel ou da fila; nos modos contínuo e
+// de dois núcleos, `global_callback_message` aponta para esta variável.
+uint16_t stream_latest_sample;
+
+// Configuração da política de notificação (aplicada à de cada conexão e
+// de cada entrada extra) e índice absoluto da próxima amostra a ser
+// avaliada no anel ou na fila (cursor próprio, sem consumir).
+notify_policy_config_t notify_policy_config;
+uint32_t notify_policy_index;
+uint16_t notify_policy_samples[NOTIFY_POLICY_CHUNK];
+
+// Configuração exposta na característica "Sample Control" e callback da
+// aplicação que reprograma a amostragem (taxa e média).
+sample_control_t control_state;
+int(*global_control_handler)(const sample_control_t*);
+// Faixa de taxas aceita pelo ponto de controle nos modos contínuo e de
+// dois núcleos (`bt_server_set_control_rate_range`).
+uint32_t control_min_rate_hz = 1;
+uint32_t control_max_rate_hz = UINT32_MAX;
+// Máximo de amostras por lote definido pelo ponto de controle
+// (0 = o que couber no MTU).
+uint8_t batch_size_limit;
+
+// Fila de amostras para os lotes no modo de leitura única: recebe o
+// valor de `global_callback_message` a cada heartbeat.
+uint16_t heartbeat_queue_storage[HEARTBEAT_QUEUE_SIZE];
+sample_ring_t heartbeat_queue;
+// Instante de captura (us) de cada amostra de `heartbeat_queue`, na
+// mesma posição do anel.
+uint32_t heartbeat_queue_times[HEARTBEAT_QUEUE_SIZE];
+
+// Base de tempo dos modos contínuo e de dois núcleos
+// (`bt_server_set_sample_timebase`): a amostra de índice i foi capturada
+// em `sample_timebase_start_us + (i - sample_timebase_index) * 1 s / taxa`,
+// calculado em 64 bits a partir da âncora, sem período inteiro truncado.
+uint32_t sample_timebase_start_us;
+uint32_t sample_timebase_index;
+uint32_t sample_timebase_rate_hz;
+
+// Entradas extras do ADC expostas em características próprias: entrada
+// e handles de cada uma.
+typedef struct {
+    uint8_t input;
+    uint16_t value_handle;
+    uint16_t cccd_handle;
+} channel_attributes_t;
+
+const channel_attributes_t channel_attributes[CHANNEL_COUNT] = {
+    { 1, CHANNEL_1_VALUE_HANDLE, CHANNEL_1_CCCD_HANDLE },
+    { 2, CHANNEL_2_VALUE_HANDLE, CHANNEL_2_CCCD_HANDLE },
+    { 4, CHANNEL_4_VALUE_HANDLE, CHANNEL_4_CCCD_HANDLE },
+};
+
+// Estado de cada entrada extra, na mesma ordem de `channel_attributes`.
+typedef struct {
+    sample_ring_t* ring;          // anel da entrada (NULL = não amostrada)
+    uint32_t index;               // próxima amostra a avaliar (cursor próprio)
+    uint16_t latest;              // amostra mais recente
+    notify_policy_t policy;       // política com estado próprio
+} channel_state_t;
+
+channel_state_t channels[CHANNEL_COUNT];
+
+// Buffers estáticos para montar um lote (evita uso de pilha no
+// contexto do run loop da BTstack).
+uint16_t batch_samples[SAMPLE_PACKET_MAX_SAMPLES];
+uint8_t batch_packet[SAMPLE_PACKET_MAX_HEADER_SIZE + 2 * SAMPLE_PACKET_MAX_SAMPLES];
+
 // Dados de advertising (anúncio) BLE:
 //  - Flags gerais;
 //  - Nome completo do dispositivo ("Pico 00:00:00:00:00:00");
@@ -47,15 +395,1043 @@ uint8_t adv_data[] = {
 };
 const uint8_t adv_data_len = sizeof(adv_data);
 
+// Anúncio do modo broadcast: flags (sem modo descobrível, só LE) e o
+// bloco com a janela das últimas amostras, reescrito a cada heartbeat.
+uint8_t broadcast_adv_data[31] = {
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x04,
+};
+uint16_t broadcast_window[SAMPLE_BROADCAST_MAX_SAMPLES];
+// Índice (no anel dos lotes) da próxima amostra ainda não anunciada,
+// atualizações do anúncio e amostras novas anunciadas desde o início, e
+// seus valores no último relatório.
+uint32_t broadcast_index;
+uint32_t broadcast_updates;
+uint32_t broadcast_samples;
+uint32_t broadcast_report_updates;
+uint32_t broadcast_report_samples;
+uint32_t broadcast_report_us;
+
+// Registro em flash (SERVER_FLASH_LOG): região preparada, gravação em
+// andamento, índice (no anel dos lotes) da próxima amostra a registrar e
+// amostras sobrescritas no anel antes de serem registradas.
+flash_log_t sample_log;
+bool sample_log_ready;
+bool sample_log_recording;
+uint32_t sample_log_index;
+uint32_t sample_log_lost;
+
+// Instante (`time_us_32()`) em que chegou o último pedido de leitura de
+// "Time Sync", anotado na primeira chamada do callback de leitura.
+uint32_t time_sync_rx_us;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Callbacks ATT e funções de controle do servidor BLE.
 uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size);
 int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
 int bt_server_init(void(*task)(void), uint16_t* message);
+int bt_server_init_stream(void(*task)(void), sample_ring_t* ring);
+int bt_server_init_queue(void(*task)(void), spsc_queue_t* queue);
+void bt_server_set_sample_timebase(uint32_t first_sample_us, uint32_t first_index, uint32_t sample_rate_hz);
 int bt_server_start();
+void bt_server_set_notify_policy(uint16_t deadband, uint16_t min_interval_ms, uint16_t max_interval_ms);
+void bt_server_set_control_handler(int(*handler)(const sample_control_t*), uint32_t sample_rate_hz, uint8_t averaging);
+void bt_server_set_control_rate_range(uint32_t min_rate_hz, uint32_t max_rate_hz);
+void set_heartbeat_period(uint16_t period_ms);
+uint8_t apply_control(hci_con_handle_t connection_handle, const sample_control_t* control);
 void heartbeat_handler(struct btstack_timer_source *ts);
+void notify_policy_handler(struct btstack_timer_source *ts);
 void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+server_connection_t* find_connection(hci_con_handle_t handle);
+server_connection_t* get_connection(hci_con_handle_t handle);
+void remove_connection(hci_con_handle_t handle);
+void load_known_peers(void);
+int find_known_peer(const bd_addr_t addr, uint8_t addr_type);
+void remember_peer(const server_connection_t* conn);
+void bind_identity(server_connection_t* conn, const bd_addr_t addr, uint8_t addr_type);
+void send_service_changed(server_connection_t* conn);
+void request_link_profile(server_connection_t* conn);
+void report_link_params(const server_connection_t* conn, const char* origin);
+void request_high_throughput(server_connection_t* conn);
+int bt_server_set_link_profile(link_profile_t profile);
+uint8_t database_sync_error(hci_con_handle_t handle);
+bool connection_subscribed(const server_connection_t* conn);
+bool primary_subscribed(const server_connection_t* conn);
+bool any_batch_subscriber(void);
+uint8_t send_quota(void);
+void schedule_send(server_connection_t* conn);
+void schedule_sends(void);
+void connection_can_send_now(void* context);
+void report_connections(void);
+void update_broadcast(void);
+void report_broadcast(void);
+void drain_sample_queue(void);
+void init_sample_log(void);
+void store_sample_log_tail(void);
+uint32_t sample_period_us(void);
+void log_samples(void);
+void update_sample_log(void);
+void sample_log_skip_delivered(const server_connection_t* conn);
+void start_backlog(server_connection_t* conn);
+void send_backlog(server_connection_t* conn);
+void finish_backlog(server_connection_t* conn);
+void confirm_backlog(server_connection_t* conn);
+void update_latest_sample(void);
+sample_ring_t* batch_ring(void);
+uint32_t pending_samples(const server_connection_t* conn);
+uint32_t read_samples(server_connection_t* conn, uint16_t* dst, uint32_t max, uint32_t* first_index);
+void discard_samples(server_connection_t* conn);
+uint32_t sample_capture_us(uint32_t index);
+uint16_t batch_capacity(hci_con_handle_t handle);
+uint32_t batch_flush_threshold(const server_connection_t* conn);
+void send_sample_batch(server_connection_t* conn);
+void send_primary_notification(server_connection_t* conn);
+uint32_t peek_new_samples(uint16_t* dst, uint32_t max);
+void evaluate_notify_policy(void);
+void request_primary_send(server_connection_t* conn);
+int find_channel(uint16_t att_handle);
+void evaluate_channels(uint32_t now_us);
+bool send_channel_notification(server_connection_t* conn);
+int bt_server_set_channel(uint8_t input, sample_ring_t* ring);
+void btstack_log_reset(void);
+void btstack_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len);
+void btstack_log_message(int log_level, const char * format, va_list argptr);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Registro da conexão `handle`, ou NULL se ela não estiver na tabela.
+server_connection_t* find_connection(hci_con_handle_t handle) {
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        if (connections[i].con_handle == handle) return &connections[i];
+    }
+    return NULL;
+}
+
+// Registro da conexão `handle`, ocupando um livre se ela ainda não
+// estiver na tabela. Retorna NULL se a tabela estiver cheia.
+server_connection_t* get_connection(hci_con_handle_t handle) {
+    server_connection_t* conn = find_connection(handle);
+    if (conn != NULL) return conn;
+    conn = find_connection(HCI_CON_HANDLE_INVALID);
+    if (conn == NULL) return NULL;
+    memset(conn, 0, sizeof(*conn));
+    conn->con_handle = handle;
+    conn->mtu = ATT_DEFAULT_MTU;
+    conn->send_request.callback = &connection_can_send_now;
+    conn->send_request.context = conn;
+    conn->connected_us = time_us_32();
+    conn->tx_phy = LINK_PHY_1M;
+    conn->rx_phy = LINK_PHY_1M;
+    conn->max_tx_octets = LINK_DEFAULT_OCTETS;
+    conn->max_rx_octets = LINK_DEFAULT_OCTETS;
+    notify_policy_init(&conn->policy, &notify_policy_config);
+    return conn;
+}
+
+// Libera o registro da conexão `handle`, com suas assinaturas e envios
+// pendentes.
+void remove_connection(hci_con_handle_t handle) {
+    server_connection_t* conn = find_connection(handle);
+    if (conn == NULL) return;
+    LOG_INFO("Conexão 0x%04X encerrada: %u notificações, %u bytes, %u amostras, %u perdidas",
+             handle, (unsigned)conn->notifications, (unsigned)conn->bytes, (unsigned)conn->samples, (unsigned)conn->dropped);
+    sample_log_skip_delivered(conn);
+    memset(conn, 0, sizeof(*conn));
+    conn->con_handle = HCI_CON_HANDLE_INVALID;
+    // Sem a central, o registro pode voltar a gravar.
+    update_sample_log();
+}
+
+// Lê do banco TLV as centrais lembradas. Sem banco TLV (build de host),
+// a tabela vale só enquanto o programa roda.
+void load_known_peers(void) {
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    for (uint8_t i = 0; i < SERVER_KNOWN_PEERS; i++) {
+        int len = tlv_impl->get_tag(tlv_context, KNOWN_PEER_TAG(i), (uint8_t*)&known_peers[i], sizeof(known_peers[i]));
+        known_peer_valid[i] = len == (int)sizeof(known_peers[i]);
+    }
+}
+
+// Registro da central pareada com identidade `addr`/`addr_type`, ou -1.
+int find_known_peer(const bd_addr_t addr, uint8_t addr_type) {
+    for (uint8_t i = 0; i < SERVER_KNOWN_PEERS; i++) {
+        if (known_peer_valid[i] && known_peers[i].addr_type == addr_type && bd_addr_cmp(known_peers[i].addr, addr) == 0) return i;
+    }
+    return -1;
+}
+
+// Atualiza o registro da central pareada de `conn`: o CCCD de Service
+// Changed e, se ela estiver "change-aware", o Database Hash da base
+// atual. Centrais sem pareamento não são lembradas: para elas o estado
+// vale só durante a conexão. A flash só é escrita quando o registro muda.
+void remember_peer(const server_connection_t* conn) {
+    if (!conn->bonded) return;
+    int slot = find_known_peer(conn->identity_addr, conn->identity_addr_type);
+    known_peer_t peer;
+    memset(&peer, 0, sizeof(peer));
+    bd_addr_copy(peer.addr, conn->identity_addr);
+    peer.addr_type = conn->identity_addr_type;
+    peer.service_changed_indications = conn->service_changed_indications ? 1 : 0;
+    // Uma central "change-unaware" continua com o hash da base que viu.
+    memcpy(peer.hash, (conn->change_aware || slot < 0) ? database_hash : known_peers[slot].hash, DATABASE_HASH_SIZE);
+    if (slot >= 0 && memcmp(&known_peers[slot], &peer, sizeof(peer)) == 0) return;
+    if (slot < 0) {
+        for (uint8_t i = 0; i < SERVER_KNOWN_PEERS && slot < 0; i++) {
+            if (!known_peer_valid[i]) slot = i;
+        }
+    }
+    if (slot < 0) {
+        // Tabela cheia: sobrescreve em rodízio.
+        slot = known_peer_next;
+        known_peer_next = (uint8_t)((known_peer_next + 1) % SERVER_KNOWN_PEERS);
+    }
+    known_peers[slot] = peer;
+    known_peer_valid[slot] = true;
+
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    tlv_impl->store_tag(tlv_context, KNOWN_PEER_TAG(slot), (const uint8_t*)&known_peers[slot], sizeof(known_peers[slot]));
+}
+
+// Central pareada identificada pelo Security Manager (reconexão com a
+// identidade resolvida ou fim de um novo pareamento). Se ela já viu outra
+// versão da base (Database Hash diferente), fica "change-unaware"; com o
+// CCCD de Service Changed guardado da conexão anterior, a indicação sai
+// já, sem esperar uma nova escrita no CCCD. Centrais pareadas ainda sem
+// registro passam a ser lembradas a partir daqui.
+void bind_identity(server_connection_t* conn, const bd_addr_t addr, uint8_t addr_type) {
+    conn->bonded = true;
+    bd_addr_copy(conn->identity_addr, addr);
+    conn->identity_addr_type = addr_type;
+    int slot = find_known_peer(addr, addr_type);
+    if (slot < 0) {
+        remember_peer(conn);
+        return;
+    }
+    // O CCCD escrito nesta conexão antes do pareamento prevalece.
+    if (known_peers[slot].service_changed_indications) conn->service_changed_indications = true;
+    conn->change_aware = memcmp(known_peers[slot].hash, database_hash, DATABASE_HASH_SIZE) == 0;
+    if (conn->change_aware) {
+        remember_peer(conn);
+        return;
+    }
+    LOG_INFO("Central %s viu outra versão da base GATT (change-unaware)", bd_addr_to_str(addr));
+    if (conn->service_changed_indications) send_service_changed(conn);
+}
+
+// Indica Service Changed cobrindo toda a base; a central fica
+// "change-aware" quando confirmar (ATT_EVENT_HANDLE_VALUE_INDICATION_COMPLETE).
+void send_service_changed(server_connection_t* conn) {
+    uint8_t range[4];
+    little_endian_store_16(range, 0, 0x0001);
+    little_endian_store_16(range, 2, 0xFFFF);
+    uint8_t status = att_server_indicate(conn->con_handle, SERVICE_CHANGED_VALUE_HANDLE, range, sizeof(range));
+    LOG_INFO("Service Changed indicado à conexão 0x%04X (status 0x%02X)", conn->con_handle, status);
+}
+
+// Acesso de uma central "change-unaware" que habilitou robust caching a
+// um atributo da aplicação: responde Database Out Of Sync uma vez; o
+// pedido seguinte já a torna "change-aware" (Core Spec, Vol 3, Part G,
+// 2.5.2.1). Retorna 0 se o acesso pode seguir.
+uint8_t database_sync_error(hci_con_handle_t handle) {
+    server_connection_t* conn = find_connection(handle);
+    if (conn == NULL || conn->change_aware || !(conn->client_features & CLIENT_FEATURE_ROBUST_CACHING)) return 0;
+    if (conn->out_of_sync_sent) {
+        conn->change_aware = true;
+        remember_peer(conn);
+        return 0;
+    }
+    conn->out_of_sync_sent = true;
+    return ATT_ERROR_DATABASE_OUT_OF_SYNC;
+}
+
+// Pede à central os parâmetros do perfil em uso (L2CAP Connection
+// Parameter Update Request), se os atuais não o atenderem. Quem decide é
+// a central; o resultado chega em HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE.
+void request_link_profile(server_connection_t* conn) {
+    if (link_profile_matches(link_profile, conn->conn_interval, conn->conn_latency)) return;
+    const link_profile_params_t* params = link_profile_params(link_profile);
+    LOG_INFO("Pedindo perfil de conexão \"%s\" à conexão 0x%04X", params->name, conn->con_handle);
+    gap_request_connection_parameter_update(conn->con_handle, params->interval_min, params->interval_max,
+                                            params->latency, params->supervision_timeout);
+}
+
+// Registra no log os parâmetros de conexão em uso.
+void report_link_params(const server_connection_t* conn, const char* origin) {
+    uint32_t interval_us = LINK_INTERVAL_US(conn->conn_interval);
+    LOG_INFO("Conexão 0x%04X (%s): intervalo %u.%02u ms, latência %u, supervisão %u ms%s", conn->con_handle, origin,
+             (unsigned)(interval_us / 1000U), (unsigned)((interval_us % 1000U) / 10U), conn->conn_latency,
+             (unsigned)LINK_TIMEOUT_MS(conn->supervision_timeout),
+             link_profile_matches(link_profile, conn->conn_interval, conn->conn_latency) ? "" : " (fora do perfil)");
+}
+
+// Modo de alta vazão: pede o PHY 2M. A Data Length Extension é
+// negociada pelo próprio controlador, com os valores sugeridos pela
+// BTstack na inicialização (ENABLE_LE_DATA_LENGTH_EXTENSION). Os
+// resultados chegam em HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE e
+// HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE.
+void request_high_throughput(server_connection_t* conn) {
+#if BLE_HIGH_THROUGHPUT
+    uint8_t status = gap_le_set_phy(conn->con_handle, 0, LINK_PHY_MASK_2M, LINK_PHY_MASK_2M, 0);
+    if (status != ERROR_CODE_SUCCESS) {
+        LOG_WARN("PHY 2M não pedido (status 0x%02X); conexão 0x%04X segue em 1M", status, conn->con_handle);
+    }
+#else
+    UNUSED(conn);
+#endif
+}
+
+// A conexão assina alguma característica?
+bool connection_subscribed(const server_connection_t* conn) {
+    return conn->con_handle != HCI_CON_HANDLE_INVALID &&
+           (conn->le_notification_enabled || conn->batch_notification_enabled || conn->channel_notifications != 0 ||
+            conn->backlog_active);
+}
+
+// A conexão assina o fluxo principal (temperatura ou lotes)?
+bool primary_subscribed(const server_connection_t* conn) {
+    return conn->con_handle != HCI_CON_HANDLE_INVALID && (conn->le_notification_enabled || conn->batch_notification_enabled);
+}
+
+// Alguma conexão assina os lotes?
+bool any_batch_subscriber(void) {
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        if (connections[i].con_handle != HCI_CON_HANDLE_INVALID && connections[i].batch_notification_enabled) return true;
+    }
+    return false;
+}
+
+// Pacotes que cada enlace pode ter pendentes no controlador: os buffers
+// ACL (MAX_NR_CONTROLLER_ACL_BUFFERS) divididos entre as conexões
+// assinantes, para que um enlace lento (intervalo de conexão longo ou
+// sinal fraco) não ocupe todos os buffers e trave os demais.
+uint8_t send_quota(void) {
+    uint8_t active = 0;
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        if (connection_subscribed(&connections[i])) active++;
+    }
+    if (active <= 1) return MAX_NR_CONTROLLER_ACL_BUFFERS;
+    uint8_t quota = MAX_NR_CONTROLLER_ACL_BUFFERS / active;
+    return quota > 0 ? quota : 1;
+}
+
+// Registra na pilha ATT um pedido de envio para `conn`, se houver algo
+// pendente e o enlace estiver dentro da sua cota de buffers. Acima da
+// cota, o pedido fica para quando o controlador confirmar pacotes
+// (`HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS`) ou para a próxima avaliação.
+void schedule_send(server_connection_t* conn) {
+    if (conn->con_handle == HCI_CON_HANDLE_INVALID || conn->send_requested) return;
+    if (!conn->primary_send_pending && conn->channel_pending == 0 && !conn->backlog_active) return;
+    hci_connection_t* hci_conn = hci_connection_for_handle(conn->con_handle);
+    if (hci_conn != NULL && hci_conn->num_packets_sent >= send_quota()) {
+        conn->deferred++;
+        return;
+    }
+    conn->send_requested = true;
+    att_server_request_to_send_notification(&conn->send_request, conn->con_handle);
+}
+
+// Reagenda todas as conexões com envio pendente.
+void schedule_sends(void) {
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        schedule_send(&connections[i]);
+    }
+}
+
+// Chamado pela pilha ATT quando o enlace de `context` pode enviar. Cada
+// chamada envia um único pacote e volta ao fim da fila: a pilha atende as
+// conexões em rodízio, uma notificação por enlace a cada passada. O
+// download do registro em flash vem antes de tudo (o fluxo ao vivo só
+// começa depois dele) e o fluxo principal tem prioridade sobre as
+// entradas extras.
+void connection_can_send_now(void* context) {
+    server_connection_t* conn = (server_connection_t*)context;
+    conn->send_requested = false;
+    if (conn->con_handle == HCI_CON_HANDLE_INVALID) return;
+    if (conn->backlog_active) {
+        send_backlog(conn);
+    } else if (conn->primary_send_pending) {
+        conn->primary_send_pending = false;
+        if (conn->batch_notification_enabled) {
+            // Modo em lote: empacota o máximo de amostras no MTU.
+            send_sample_batch(conn);
+        } else if (conn->le_notification_enabled) {
+            send_primary_notification(conn);
+        }
+    } else {
+        send_channel_notification(conn);
+    }
+    schedule_send(conn);
+}
+
+// Registra a vazão de cada conexão desde o último relatório
+// (notificações, bytes e amostras por segundo), para dimensionar quantos
+// clientes um mesmo sensor consegue atender.
+void report_connections(void) {
+    uint32_t now_us = time_us_32();
+    uint32_t elapsed_us = now_us - connection_report_us;
+    if (elapsed_us < CONNECTION_REPORT_INTERVAL_US) return;
+    connection_report_us = now_us;
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        server_connection_t* conn = &connections[i];
+        if (conn->con_handle == HCI_CON_HANDLE_INVALID) continue;
+        uint32_t notifications = conn->notifications - conn->report_notifications;
+        uint32_t bytes = conn->bytes - conn->report_bytes;
+        uint32_t samples = conn->samples - conn->report_samples;
+        conn->report_notifications = conn->notifications;
+        conn->report_bytes = conn->bytes;
+        conn->report_samples = conn->samples;
+        uint32_t centibytes = samples ? (uint32_t)((uint64_t)bytes * 100U / samples) : 0;
+        LOG_INFO("Conexão 0x%04X: %u notificações/s, %u B/s, %u amostras/s, %u.%02u B/amostra (MTU %u, PHY %s, PDU %u B, %u perdidas, %u envios adiados)",
+                 conn->con_handle,
+                 (unsigned)((uint64_t)notifications * 1000000U / elapsed_us),
+                 (unsigned)((uint64_t)bytes * 1000000U / elapsed_us),
+                 (unsigned)((uint64_t)samples * 1000000U / elapsed_us),
+                 (unsigned)(centibytes / 100U), (unsigned)(centibytes % 100U),
+                 conn->mtu, link_phy_name(conn->tx_phy), conn->max_tx_octets,
+                 (unsigned)conn->dropped, (unsigned)conn->deferred);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Modo broadcast: reescreve o anúncio com as últimas amostras do anel dos
+// lotes, se houver alguma nova desde a atualização anterior. Até lá, o
+// controlador repete o mesmo anúncio a cada intervalo.
+void update_broadcast(void) {
+    sample_ring_t* ring = batch_ring();
+    uint32_t head = ring->head;
+    if (head == broadcast_index) return;
+    uint32_t index = head - SAMPLE_BROADCAST_MAX_SAMPLES;
+    if (head < SAMPLE_BROADCAST_MAX_SAMPLES) index = 0;
+    // `index` salta para a amostra mais antiga ainda no anel, se preciso.
+    uint8_t count = (uint8_t)sample_ring_peek_from(ring, &index, broadcast_window, SAMPLE_BROADCAST_MAX_SAMPLES);
+    if (count == 0) return;
+    uint8_t len = sample_broadcast_encode(&broadcast_adv_data[3], sizeof(broadcast_adv_data) - 3,
+                                          (uint16_t)(index - count), broadcast_window, count);
+    gap_advertisements_set_data((uint8_t)(3 + len), broadcast_adv_data);
+    uint32_t fresh = index - broadcast_index;
+    broadcast_samples += (fresh < count) ? fresh : count;
+    broadcast_index = index;
+    broadcast_updates++;
+}
+
+// Relatório periódico do modo broadcast: atualizações e amostras novas
+// anunciadas por segundo, contra o intervalo de anúncio. Cada atualização é emitida
+// em média (período da atualização / intervalo) vezes.
+void report_broadcast(void) {
+    uint32_t now_us = time_us_32();
+    uint32_t elapsed_us = now_us - broadcast_report_us;
+    if (elapsed_us < CONNECTION_REPORT_INTERVAL_US) return;
+    uint32_t updates = broadcast_updates - broadcast_report_updates;
+    uint32_t samples = broadcast_samples - broadcast_report_samples;
+    broadcast_report_us = now_us;
+    broadcast_report_updates = broadcast_updates;
+    broadcast_report_samples = broadcast_samples;
+    uint32_t adverts = elapsed_us / (SERVER_BROADCAST_INTERVAL_MS * 1000U);
+    LOG_INFO("Broadcast: %u atualizações/s, %u amostras/s, anúncio a cada %u ms (~%u anúncios por atualização)",
+             (unsigned)((uint64_t)updates * 1000000U / elapsed_us),
+             (unsigned)((uint64_t)samples * 1000000U / elapsed_us),
+             SERVER_BROADCAST_INTERVAL_MS, (unsigned)(updates ? adverts / updates : 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// No modo de dois núcleos, retira tudo o que o core 1 colocou na fila
+// SPSC para `queue_fanout`, de onde cada conexão lê com cursor próprio,
+// e atualiza `stream_latest_sample`. Nos demais modos não faz nada.
+void drain_sample_queue(void) {
+    if (global_sample_queue == NULL) return;
+    uint32_t n;
+    do {
+        // Até o fim físico do anel; o restante na próxima volta.
+        uint32_t contiguous = queue_fanout.size - (queue_fanout.head & queue_fanout.mask);
+        n = spsc_queue_pop_n(global_sample_queue, sample_ring_write_ptr(&queue_fanout), contiguous);
+        sample_ring_publish(&queue_fanout, n);
+    } while (n > 0);
+    sample_ring_peek_latest(&queue_fanout, &stream_latest_sample);
+}
+
+// Nos modos contínuo e de dois núcleos, atualiza `stream_latest_sample`
+// com a amostra mais recente. As conexões que assinam os lotes leem o
+// anel com cursor próprio, sem depender do consumo feito aqui. No modo
+// de leitura única não faz nada.
+void update_latest_sample(void) {
+    if (global_sample_queue != NULL) {
+        drain_sample_queue();
+        return;
+    }
+    if (global_sample_ring == NULL) return;
+    sample_ring_drain_latest(global_sample_ring, &stream_latest_sample);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Anel de onde saem as amostras dos lotes: o anel do modo contínuo, o que
+// recebe a fila SPSC no modo de dois núcleos ou, no modo de leitura
+// única, a fila alimentada pelo heartbeat.
+sample_ring_t* batch_ring(void) {
+    if (global_sample_ring != NULL) return global_sample_ring;
+    if (global_sample_queue != NULL) return &queue_fanout;
+    return &heartbeat_queue;
+}
+
+// Número de amostras aguardando envio em lote para `conn`.
+uint32_t pending_samples(const server_connection_t* conn) {
+    sample_ring_t* ring = batch_ring();
+    uint32_t pending = ring->head - conn->batch_index;
+    uint32_t window = ring->size - ring->guard;
+    return (pending < window) ? pending : window;
+}
+
+// Copia até `max` amostras pendentes de `conn` para `dst`, informando em
+// `*first_index` o índice da primeira delas. Amostras sobrescritas antes
+// de o enlace alcançá-las são contadas em `conn->dropped`.
+uint32_t read_samples(server_connection_t* conn, uint16_t* dst, uint32_t max, uint32_t* first_index) {
+    sample_ring_t* ring = batch_ring();
+    uint32_t behind = ring->head - conn->batch_index;
+    uint32_t window = ring->size - ring->guard;
+    if (behind > window) conn->dropped += behind - window;
+    uint32_t count = sample_ring_peek_from(ring, &conn->batch_index, dst, max);
+    *first_index = conn->batch_index - count;
+    return count;
+}
+
+// Descarta as amostras pendentes de `conn`: o fluxo recomeça da próxima.
+void discard_samples(server_connection_t* conn) {
+    conn->batch_index = batch_ring()->head;
+}
+
+// Instante de captura, em microssegundos, da amostra de índice `index`.
+// No modo de leitura única vem do registro feito no heartbeat; nos demais
+// modos é derivado da base de tempo da amostragem.
+uint32_t sample_capture_us(uint32_t index) {
+    if (global_sample_ring == NULL && global_sample_queue == NULL) {
+        return heartbeat_queue_times[index & heartbeat_queue.mask];
+    }
+    uint32_t rate = sample_timebase_rate_hz;
+    if (rate == 0) return sample_timebase_start_us;
+    // Mantém a âncora a menos de 2 s da amostra pedida, avançando segundos
+    // inteiros (`rate` amostras = 1000000 us, exato). Os índices pedidos
+    // estão no anel, perto do mais novo; os anteriores à âncora ficam com
+    // deslocamento negativo.
+    int32_t offset = (int32_t)(index - sample_timebase_index);
+    if (offset >= (int32_t)(2U * rate)) {
+        uint32_t seconds = (uint32_t)offset / rate - 1U;
+        sample_timebase_index += seconds * rate;
+        sample_timebase_start_us += seconds * 1000000U;
+        offset -= (int32_t)(seconds * rate);
+    }
+    // Deslocamento * 1 s / taxa, arredondado, em 64 bits.
+    int64_t scaled = (int64_t)offset * 1000000;
+    int64_t half = rate / 2U;
+    int64_t delta_us = (scaled >= 0 ? scaled + half : scaled - half) / rate;
+    return sample_timebase_start_us + (uint32_t)delta_us;
+}
+
+// Número de amostras que cabem em uma notificação com o ATT MTU
+// negociado na conexão `handle` (MTU - 3 bytes de cabeçalho ATT),
+// limitado por `batch_size_limit`. Na codificação delta é o limite
+// superior; o lote leva as que couberem.
+uint16_t batch_capacity(hci_con_handle_t handle) {
+    uint16_t mtu = att_server_get_mtu(handle);
+    uint16_t capacity = sample_packet_capacity((uint16_t)(mtu - 3), SAMPLE_CAPACITY_FLAGS);
+    // O ponto de controle pode limitar o lote para reduzir a latência.
+    if (batch_size_limit != 0 && batch_size_limit < capacity) capacity = batch_size_limit;
+    return capacity;
+}
+
+// Número de amostras pendentes a partir do qual um lote é enviado mesmo
+// sem disparo da política: um lote cheio ou, se menor, metade do anel de
+// origem, para que nada seja sobrescrito enquanto o lote espera.
+uint32_t batch_flush_threshold(const server_connection_t* conn) {
+    sample_ring_t* ring = batch_ring();
+    uint32_t limit = (ring->size - ring->guard) / 2;
+    uint32_t capacity = batch_capacity(conn->con_handle);
+    return (capacity < limit) ? capacity : limit;
+}
+
+// Envia a `conn` um lote com o máximo de amostras pendentes que cabem no
+// MTU. Se ainda restar ao menos um lote completo, o fluxo continua
+// pendente e sai no próximo envio do enlace; lotes parciais aguardam o
+// heartbeat ou, com a política de notificação, o seu próximo disparo.
+void send_sample_batch(server_connection_t* conn) {
+    uint16_t capacity = batch_capacity(conn->con_handle);
+    uint32_t first_index;
+    uint32_t count = read_samples(conn, batch_samples, capacity, &first_index);
+    if (count == 0) return;
+
+    sample_packet_header_t header = {
+        .count = (uint8_t)count,
+        .flags = (uint8_t)(SAMPLE_PACKET_FLAGS | (SERVER_SAMPLE_ENCODING & SAMPLE_PACKET_ENCODING_MASK)),
+        .first_index = (uint16_t)first_index,
+        .capture_us = SERVER_SAMPLE_TIMESTAMPS ? sample_capture_us(first_index + count - 1) : 0,
+    };
+    uint16_t payload_size = (uint16_t)(att_server_get_mtu(conn->con_handle) - 3);
+    uint16_t len = 0;
+    if (SERVER_SAMPLE_ENCODING != SAMPLE_PACKET_ENCODING_AUTO) {
+        len = sample_packet_encode(batch_packet, payload_size, &header, batch_samples);
+    }
+    if (len == 0) {
+        len = sample_packet_encode_best(batch_packet, payload_size, &header, batch_samples);
+    }
+    if (len == 0) {
+        conn->batch_index -= count;
+        return;
+    }
+    // As amostras que não couberam voltam para o próximo lote (este saiu
+    // cheio).
+    bool batch_full = header.count < count;
+    conn->batch_index -= count - header.count;
+    if (SERVER_SAMPLE_TIMESTAMPS && batch_full) {
+        // O instante passa a ser o da última amostra que coube.
+        header.capture_us = sample_capture_us(first_index + header.count - 1);
+        len = sample_packet_encode(batch_packet, payload_size, &header, batch_samples);
+    }
+    count = header.count;
+    att_server_notify(conn->con_handle, SAMPLE_STREAM_VALUE_HANDLE, batch_packet, len);
+    notify_policy_sent(&conn->policy, batch_samples[count - 1], time_us_32());
+    conn->notifications++;
+    conn->bytes += len;
+    conn->samples += count;
+    LOG_TRACE("Lote enviado a 0x%04X: %u amostras a partir de #%u (%u bytes)", conn->con_handle, (unsigned)count, (unsigned)(uint16_t)first_index, len);
+
+    if (batch_full || pending_samples(conn) >= capacity) {
+        conn->primary_send_pending = true;
+    }
+}
+
+// Envia a `conn` a notificação da característica de temperatura com o
+// conteúdo da variável apontada por `global_callback_message`.
+void send_primary_notification(server_connection_t* conn) {
+    update_latest_sample();
+    att_server_notify(conn->con_handle, ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE_01_VALUE_HANDLE, (uint8_t*)global_callback_message, sizeof(*global_callback_message));
+    notify_policy_sent(&conn->policy, *global_callback_message, time_us_32());
+    conn->notifications++;
+    conn->bytes += sizeof(*global_callback_message);
+    conn->samples++;
+    LOG_TRACE("Notificação enviada a 0x%04X: %d", conn->con_handle, *global_callback_message);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Prepara o registro em flash e recupera a posição liberada salva no
+// banco TLV. Sem banco TLV (build de host), os registros na flash valem
+// a partir do mais antigo.
+void init_sample_log(void) {
+#if SERVER_FLASH_LOG
+    uint32_t tail[2] = { 0, 0 };  // seq e amostra
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl != NULL) tlv_impl->get_tag(tlv_context, SAMPLE_LOG_TAIL_TAG, (uint8_t*)tail, sizeof(tail));
+    int status = flash_log_init(&sample_log, SERVER_FLASH_LOG_SECTORS, tail[0], (uint16_t)tail[1]);
+    if (status != 0) {
+        LOG_WARN("Registro em flash indisponível (%d): %u setores não cabem na flash", status, SERVER_FLASH_LOG_SECTORS);
+        return;
+    }
+    sample_log_ready = true;
+    LOG_INFO("Registro em flash: %u setores (%u amostras), %u amostras pendentes, %u setores inválidos",
+             SERVER_FLASH_LOG_SECTORS, (unsigned)(SERVER_FLASH_LOG_SECTORS * FLASH_LOG_RECORD_SAMPLES),
+             (unsigned)flash_log_pending_samples(&sample_log), (unsigned)sample_log.invalid);
+#endif
+}
+
+// Salva no banco TLV a posição liberada do registro.
+void store_sample_log_tail(void) {
+    uint32_t tail[2] = { sample_log.tail_seq, sample_log.tail_offset };
+    const btstack_tlv_t* tlv_impl;
+    void* tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+    tlv_impl->store_tag(tlv_context, SAMPLE_LOG_TAIL_TAG, (const uint8_t*)tail, sizeof(tail));
+}
+
+// Período entre as amostras do anel dos lotes, em microssegundos,
+// arredondado. Só o registro em flash o usa, com o instante exato da
+// primeira amostra de cada registro, então o erro não se acumula além de
+// um registro.
+uint32_t sample_period_us(void) {
+    if (global_sample_ring == NULL && global_sample_queue == NULL) return heartbeat_period_ms * 1000U;
+    uint32_t rate = sample_timebase_rate_hz;
+    return (rate == 0) ? 0 : (1000000U + rate / 2U) / rate;
+}
+
+// Registra na flash as amostras do anel dos lotes ainda não registradas.
+// As sobrescritas no anel antes disso (ex.: enquanto um setor era
+// gravado) são contadas em `sample_log_lost`.
+void log_samples(void) {
+    if (!sample_log_recording) return;
+    drain_sample_queue();
+    sample_ring_t* ring = batch_ring();
+    uint32_t behind = ring->head - sample_log_index;
+    uint32_t window = ring->size - ring->guard;
+    if (behind > window) {
+        sample_log_lost += behind - window;
+        behind = window;
+    }
+    // Só o que já estava no anel: com o produtor mais rápido que a
+    // gravação, o restante fica para a próxima chamada.
+    while (behind > 0) {
+        uint32_t max = (behind < SAMPLE_PACKET_MAX_SAMPLES) ? behind : SAMPLE_PACKET_MAX_SAMPLES;
+        uint32_t count = sample_ring_peek_from(ring, &sample_log_index, batch_samples, max);
+        if (count == 0) break;
+        behind -= count;
+        uint32_t first_index = sample_log_index - count;
+        if (flash_log_append(&sample_log, first_index, sample_capture_us(first_index), sample_period_us(),
+                             batch_samples, count) < 0) {
+            LOG_WARN("Registro em flash: falha na gravação de um setor (%u falhas)", (unsigned)sample_log.write_errors);
+        }
+    }
+}
+
+// Liga ou desliga a gravação do registro. Ele grava enquanto nenhuma
+// central recebe o fluxo ao vivo nem acabou de baixar o registro (ela
+// assina o fluxo ao vivo logo em seguida, a partir de onde o download
+// parou), e só então registra as amostras novas.
+void update_sample_log(void) {
+    if (!sample_log_ready) return;
+    bool live = false;
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        const server_connection_t* conn = &connections[i];
+        if (conn->con_handle == HCI_CON_HANDLE_INVALID) continue;
+        if (conn->batch_notification_enabled || conn->backlog_done) live = true;
+    }
+    if (live && sample_log_recording) {
+        // O que chegou antes do fluxo ao vivo ainda vai para a flash.
+        log_samples();
+        sample_log_recording = false;
+        LOG_INFO("Registro em flash pausado: %u amostras pendentes (%u gravadas, %u perdidas)",
+                 (unsigned)flash_log_pending_samples(&sample_log), (unsigned)sample_log.appended, (unsigned)sample_log_lost);
+    } else if (!live && !sample_log_recording) {
+        sample_log_recording = true;
+        LOG_INFO("Registro em flash gravando: nenhuma central recebe o fluxo ao vivo");
+    }
+    log_samples();
+}
+
+// A central `conn` deixa de receber o fluxo ao vivo: o que ela já
+// recebeu não volta a ser registrado.
+void sample_log_skip_delivered(const server_connection_t* conn) {
+    if (!conn->batch_notification_enabled) return;
+    if ((int32_t)(conn->batch_index - sample_log_index) > 0) sample_log_index = conn->batch_index;
+}
+
+// Começa o download do registro para `conn`, a partir do registro mais
+// antigo ainda não liberado. Sem registro em flash, sai só o fim.
+void start_backlog(server_connection_t* conn) {
+    conn->backlog_active = true;
+    conn->backlog_done = false;
+    conn->backlog_started = false;
+    conn->backlog_seq = sample_log.tail_seq;
+    conn->backlog_records = 0;
+    conn->backlog_samples = 0;
+    conn->backlog_bytes = 0;
+    conn->backlog_start_us = time_us_32();
+    LOG_INFO("Download do registro em flash pedido por 0x%04X (%u amostras pendentes)", conn->con_handle,
+             sample_log_ready ? (unsigned)flash_log_pending_samples(&sample_log) : 0U);
+    schedule_send(conn);
+}
+
+// Envia a `conn` a próxima parte do registro: uma notificação com o
+// máximo de amostras que cabem no MTU, na codificação que leva mais
+// delas. Registros inválidos (gravação interrompida) ou sobrescritos
+// durante o download são pulados. Ao alcançar o fim do registro em
+// montagem, envia a mensagem de fim.
+void send_backlog(server_connection_t* conn) {
+    flash_log_record_t record;
+    const uint8_t* data = NULL;
+    uint32_t offset = 0;
+    while (true) {
+        if (!sample_log_ready) {
+            finish_backlog(conn);
+            return;
+        }
+        if ((int32_t)(conn->backlog_seq - sample_log.tail_seq) < 0) {
+            conn->backlog_seq = sample_log.tail_seq;
+            conn->backlog_started = false;
+        }
+        // No registro em montagem, registra antes o que ainda está no anel.
+        if (conn->backlog_seq == sample_log.head_seq) log_samples();
+        if (flash_log_read(&sample_log, conn->backlog_seq, &record, &data) == 0 && record.count > 0) {
+            if (!conn->backlog_started || (int32_t)(conn->backlog_index - record.first_index) < 0) {
+                if (!conn->backlog_started) conn->backlog_records++;
+                conn->backlog_index = record.first_index;
+                conn->backlog_started = true;
+            }
+            offset = conn->backlog_index - record.first_index;
+            if (offset < record.count) break;
+        }
+        if (conn->backlog_seq == sample_log.head_seq) {
+            finish_backlog(conn);
+            return;
+        }
+        conn->backlog_seq++;
+        conn->backlog_started = false;
+    }
+
+    uint32_t count = record.count - offset;
+    if (count > SAMPLE_PACKET_MAX_SAMPLES) count = SAMPLE_PACKET_MAX_SAMPLES;
+    for (uint32_t i = 0; i < count; i++) {
+        batch_samples[i] = little_endian_read_16(data, (int)(2 * (offset + i)));
+    }
+    sample_packet_header_t header = {
+        .count = (uint8_t)count,
+        .flags = 0,
+        .first_index = (uint16_t)conn->backlog_index,
+        .capture_us = 0,
+    };
+    uint16_t payload_size = (uint16_t)(att_server_get_mtu(conn->con_handle) - 3);
+    if (payload_size > sizeof(batch_packet)) payload_size = sizeof(batch_packet);
+    uint16_t len = sample_backlog_encode_data(batch_packet, payload_size, record.seq,
+                                              record.capture_us + offset * record.period_us, record.period_us,
+                                              &header, batch_samples);
+    if (len == 0) {
+        LOG_WARN("MTU %u pequeno demais para o download do registro", att_server_get_mtu(conn->con_handle));
+        conn->backlog_active = false;
+        return;
+    }
+    att_server_notify(conn->con_handle, SAMPLE_BACKLOG_VALUE_HANDLE, batch_packet, len);
+    conn->backlog_index += header.count;
+    conn->backlog_samples += header.count;
+    conn->backlog_bytes += len;
+    conn->notifications++;
+    conn->bytes += len;
+}
+
+// Encerra o download de `conn` com a mensagem de fim, que informa o
+// índice da primeira amostra ao vivo. O registro só é liberado quando a
+// central assina o fluxo ao vivo (`confirm_backlog`); até lá, a gravação
+// fica pausada.
+void finish_backlog(server_connection_t* conn) {
+    uint8_t message[SAMPLE_BACKLOG_END_SIZE];
+    conn->backlog_next_index = sample_log_ready ? sample_log_index : batch_ring()->head;
+    conn->backlog_end_seq = sample_log.head_seq;
+    conn->backlog_end_offset = sample_log.pending.count;
+    uint16_t len = sample_backlog_encode_end(message, conn->backlog_records, conn->backlog_samples,
+                                             (uint16_t)conn->backlog_next_index);
+    att_server_notify(conn->con_handle, SAMPLE_BACKLOG_VALUE_HANDLE, message, len);
+    conn->backlog_active = false;
+    conn->backlog_done = true;
+
+    uint32_t elapsed_us = time_us_32() - conn->backlog_start_us;
+    LOG_INFO("Registro em flash baixado por 0x%04X: %u registros, %u amostras, %u bytes em %u ms (%u kbit/s)",
+             conn->con_handle, (unsigned)conn->backlog_records, (unsigned)conn->backlog_samples,
+             (unsigned)conn->backlog_bytes, (unsigned)(elapsed_us / 1000U),
+             (unsigned)(elapsed_us ? (uint64_t)conn->backlog_bytes * 8000U / elapsed_us : 0));
+    update_sample_log();
+}
+
+// A central `conn` assinou o fluxo ao vivo depois do fim do download: o
+// registro baixado é liberado (posição salva no TLV) e o fluxo continua
+// da amostra seguinte à última baixada.
+void confirm_backlog(server_connection_t* conn) {
+    conn->backlog_done = false;
+    conn->batch_index = conn->backlog_next_index;
+    if (sample_log_ready && flash_log_release(&sample_log, conn->backlog_end_seq, conn->backlog_end_offset)) {
+        store_sample_log_tail();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Copia, sem consumir, as amostras do anel ainda não avaliadas pela
+// política de notificação (até `max`), avançando `notify_policy_index`.
+uint32_t peek_new_samples(uint16_t* dst, uint32_t max) {
+    drain_sample_queue();
+    return sample_ring_peek_from(batch_ring(), &notify_policy_index, dst, max);
+}
+
+// Passa cada amostra nova (no modo de leitura única, a leitura do
+// heartbeat) pela política de notificação de cada conexão que assina o
+// fluxo principal; cada enlace compara com o que ele mesmo recebeu por
+// último. Quando a política de uma conexão dispara, o fluxo principal
+// dela fica pendente. Lotes saem para cada conexão quando a sua política
+// dispara ou quando as amostras pendentes daquele enlace chegam a
+// `batch_flush_threshold`.
+void evaluate_notify_policy(void) {
+    uint32_t now_us = time_us_32();
+    bool fire[SERVER_MAX_CONNECTIONS] = {};
+    if (global_sample_ring == NULL && global_sample_queue == NULL) {
+        for (uint8_t c = 0; c < SERVER_MAX_CONNECTIONS; c++) {
+            if (!primary_subscribed(&connections[c])) continue;
+            fire[c] = notify_policy_update(&connections[c].policy, *global_callback_message, now_us);
+        }
+    } else {
+        uint32_t n;
+        while ((n = peek_new_samples(notify_policy_samples, NOTIFY_POLICY_CHUNK)) > 0) {
+            for (uint8_t c = 0; c < SERVER_MAX_CONNECTIONS; c++) {
+                server_connection_t* conn = &connections[c];
+                if (!primary_subscribed(conn)) continue;
+                for (uint32_t i = 0; i < n; i++) {
+                    fire[c] |= notify_policy_update(&conn->policy, notify_policy_samples[i], now_us);
+                }
+            }
+            stream_latest_sample = notify_policy_samples[n - 1];
+        }
+    }
+
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        server_connection_t* conn = &connections[i];
+        if (conn->con_handle == HCI_CON_HANDLE_INVALID) continue;
+        bool request = conn->le_notification_enabled && fire[i];
+        if (conn->batch_notification_enabled) {
+            uint32_t pending = pending_samples(conn);
+            request = pending > 0 && (fire[i] || pending >= batch_flush_threshold(conn));
+        }
+        if (request) conn->primary_send_pending = true;
+    }
+    evaluate_channels(now_us);
+    schedule_sends();
+}
+
+// Timer da política de notificação nos modos contínuo e de dois núcleos:
+// avalia as amostras novas a cada NOTIFY_POLICY_POLL_MS, bem mais rápido
+// que o heartbeat, para que degraus sejam notificados com pouca latência.
+void notify_policy_handler(struct btstack_timer_source *ts) {
+    evaluate_notify_policy();
+    // O registro em flash acompanha o anel no mesmo ritmo.
+    log_samples();
+    btstack_run_loop_set_timer(ts, NOTIFY_POLICY_POLL_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Marca o fluxo principal (característica de temperatura ou lotes) de
+// `conn` como pendente e agenda o envio.
+void request_primary_send(server_connection_t* conn) {
+    conn->primary_send_pending = true;
+    schedule_send(conn);
+}
+
+// Índice da entrada extra dona de `att_handle` (valor ou CCCD), ou -1.
+int find_channel(uint16_t att_handle) {
+    for (int i = 0; i < CHANNEL_COUNT; i++) {
+        if (att_handle == channel_attributes[i].value_handle || att_handle == channel_attributes[i].cccd_handle) return i;
+    }
+    return -1;
+}
+
+// Passa as amostras novas de cada entrada extra pela sua política de
+// notificação (sem a política, toda avaliação notifica) e marca a entrada
+// como pendente nas conexões que a assinam. O envio é agendado por quem
+// chama (`schedule_sends`).
+void evaluate_channels(uint32_t now_us) {
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        channel_state_t* channel = &channels[i];
+        if (channel->ring == NULL) continue;
+        bool fire = !SERVER_NOTIFY_POLICY;
+        uint32_t n;
+        while ((n = sample_ring_peek_from(channel->ring, &channel->index, notify_policy_samples, NOTIFY_POLICY_CHUNK)) > 0) {
+            for (uint32_t k = 0; k < n; k++) {
+                fire |= notify_policy_update(&channel->policy, notify_policy_samples[k], now_us);
+            }
+            channel->latest = notify_policy_samples[n - 1];
+        }
+        if (!fire) continue;
+        for (uint8_t c = 0; c < SERVER_MAX_CONNECTIONS; c++) {
+            server_connection_t* conn = &connections[c];
+            if (conn->con_handle != HCI_CON_HANDLE_INVALID && (conn->channel_notifications & (1u << i))) {
+                conn->channel_pending |= (uint8_t)(1u << i);
+            }
+        }
+    }
+}
+
+// Envia a `conn` a notificação de uma entrada extra pendente. Retorna
+// false se nenhuma estava pendente.
+bool send_channel_notification(server_connection_t* conn) {
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        uint8_t bit = (uint8_t)(1u << i);
+        if (!(conn->channel_pending & bit)) continue;
+        conn->channel_pending &= (uint8_t)~bit;
+        if (!(conn->channel_notifications & bit)) continue;
+        channel_state_t* channel = &channels[i];
+        uint8_t value[2];
+        little_endian_store_16(value, 0, channel->latest);
+        att_server_notify(conn->con_handle, channel_attributes[i].value_handle, value, sizeof(value));
+        notify_policy_sent(&channel->policy, channel->latest, time_us_32());
+        conn->notifications++;
+        conn->bytes += sizeof(value);
+        LOG_TRACE("Entrada %u notificada a 0x%04X: %u", channel_attributes[i].input, conn->con_handle, channel->latest);
+        return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Troca o período do heartbeat, reprogramando o timer de imediato.
+// No modo de leitura única o heartbeat é também a taxa de amostragem.
+void set_heartbeat_period(uint16_t period_ms) {
+    heartbeat_period_ms = period_ms;
+    if (global_sample_ring == NULL && global_sample_queue == NULL) {
+        control_state.sample_rate_hz = 1000U / period_ms;
+    }
+    if (!SERVER_NOTIFY_POLICY) control_state.notify_interval_ms = period_ms;
+    btstack_run_loop_remove_timer(&heartbeat);
+    btstack_run_loop_set_timer(&heartbeat, heartbeat_period_ms);
+    btstack_run_loop_add_timer(&heartbeat);
+}
+
+// Aplica uma escrita no ponto de controle. Todos os campos marcados são
+// validados antes de qualquer um ser aplicado; taxa de amostragem e média
+// são repassadas à aplicação (`global_control_handler`), exceto no modo
+// de leitura única, em que a taxa é a do heartbeat.
+// A configuração é única e vale para todas as conexões; `connection_handle`
+// é a que escreveu, usada apenas no registro.
+// Retorna 0 ou o código de erro ATT a devolver ao cliente.
+uint8_t apply_control(hci_con_handle_t connection_handle, const sample_control_t* control) {
+    bool single_read = global_sample_ring == NULL && global_sample_queue == NULL;
+    uint8_t fields = control->fields;
+
+    if (fields & SAMPLE_CONTROL_SAMPLE_RATE) {
+        // Leitura única: a taxa é a do heartbeat. Demais modos: a faixa
+        // informada pela aplicação (limites do ADC ou do core 1).
+        uint32_t min_rate_hz = single_read ? 1U : control_min_rate_hz;
+        uint32_t max_rate_hz = single_read ? 1000U / HEARTBEAT_MIN_PERIOD_MS : control_max_rate_hz;
+        if (control->sample_rate_hz == 0 || control->sample_rate_hz < min_rate_hz || control->sample_rate_hz > max_rate_hz) {
+            return ATT_ERROR_VALUE_NOT_ALLOWED;
+        }
+    }
+    if ((fields & SAMPLE_CONTROL_AVERAGING) && control->averaging == 0) return ATT_ERROR_VALUE_NOT_ALLOWED;
+    if (!SERVER_NOTIFY_POLICY && (fields & SAMPLE_CONTROL_NOTIFY_INTERVAL) && control->notify_interval_ms < HEARTBEAT_MIN_PERIOD_MS) return ATT_ERROR_VALUE_NOT_ALLOWED;
+
+    if (fields & (SAMPLE_CONTROL_SAMPLE_RATE | SAMPLE_CONTROL_AVERAGING)) {
+        if (global_control_handler == NULL || global_control_handler(control) != 0) return ATT_ERROR_VALUE_NOT_ALLOWED;
+    }
+
+    if (fields & SAMPLE_CONTROL_SAMPLE_RATE) {
+        control_state.sample_rate_hz = control->sample_rate_hz;
+        if (single_read) set_heartbeat_period((uint16_t)(1000U / control->sample_rate_hz));
+    }
+    if (fields & SAMPLE_CONTROL_AVERAGING) control_state.averaging = control->averaging;
+    if (fields & SAMPLE_CONTROL_BATCH_SIZE) {
+        control_state.batch_size = control->batch_size;
+        batch_size_limit = control->batch_size;
+    }
+    if (fields & SAMPLE_CONTROL_NOTIFY_INTERVAL) {
+        control_state.notify_interval_ms = control->notify_interval_ms;
+        // Sem a política, as notificações saem a cada heartbeat.
+        if (!SERVER_NOTIFY_POLICY) set_heartbeat_period(control->notify_interval_ms);
+    }
+    if (fields & (SAMPLE_CONTROL_NOTIFY_INTERVAL | SAMPLE_CONTROL_DEADBAND | SAMPLE_CONTROL_KEEPALIVE)) {
+        bt_server_set_notify_policy((fields & SAMPLE_CONTROL_DEADBAND) ? control->deadband : control_state.deadband,
+                                    control_state.notify_interval_ms,
+                                    (fields & SAMPLE_CONTROL_KEEPALIVE) ? control->keepalive_ms : control_state.keepalive_ms);
+    }
+
+    LOG_INFO("Ponto de controle (0x%04X): %u Hz, média de %u, notificação a cada %u ms (banda %u, keep-alive %u ms), lote até %u amostras",
+             connection_handle, (unsigned)control_state.sample_rate_hz, control_state.averaging, control_state.notify_interval_ms,
+             control_state.deadband, control_state.keepalive_ms, batch_capacity(connection_handle));
+    return 0;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -63,13 +1439,52 @@ void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint
 // Quando o cliente faz uma leitura direta da característica de
 // temperatura, este callback é chamado para fornecer o valor atual.
 uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size) {
-    UNUSED(connection_handle);
+    if (att_handle == CLIENT_FEATURES_VALUE_HANDLE){
+        server_connection_t* conn = find_connection(connection_handle);
+        uint8_t features = (conn != NULL) ? conn->client_features : 0;
+        return att_read_callback_handle_blob(&features, sizeof(features), offset, buffer, buffer_size);
+    }
+    // A primeira chamada (buffer NULL) só consulta o tamanho; o erro de
+    // sincronização é decidido nela.
+    if (buffer == NULL) {
+        uint8_t sync_error = database_sync_error(connection_handle);
+        if (sync_error != 0) return (uint16_t)(ATT_READ_ERROR_CODE_OFFSET + sync_error);
+    }
 
     if (att_handle == ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE_01_VALUE_HANDLE){
         // Retorna o conteúdo da variável apontada por
         // `global_callback_message` para o cliente.
         LOG_DEBUG("ATT Read Callback: Enviando valor atual (%d) para o cliente", *global_callback_message);
-        return att_read_callback_handle_blob((const uint8_t *)&global_callback_message, sizeof(global_callback_message), offset, buffer, buffer_size);
+        return att_read_callback_handle_blob((const uint8_t *)global_callback_message, sizeof(*global_callback_message), offset, buffer, buffer_size);
+    }
+    if (att_handle == SAMPLE_STREAM_VALUE_HANDLE){
+        // Leitura direta do "Sample Stream": lote com apenas o valor atual.
+        uint8_t packet[SAMPLE_PACKET_HEADER_SIZE + 2];
+        sample_packet_header_t header = { .count = 1, .flags = 0, .first_index = 0, .capture_us = 0 };
+        uint16_t len = sample_packet_encode(packet, sizeof(packet), &header, global_callback_message);
+        return att_read_callback_handle_blob(packet, len, offset, buffer, buffer_size);
+    }
+    int channel = find_channel(att_handle);
+    if (channel >= 0 && att_handle == channel_attributes[channel].value_handle){
+        // Leitura direta de uma entrada extra: valor mais recente.
+        uint8_t value[2];
+        little_endian_store_16(value, 0, channels[channel].latest);
+        return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+    }
+    if (att_handle == SAMPLE_CONTROL_VALUE_HANDLE){
+        // Leitura do ponto de controle: configuração em uso.
+        uint8_t value[SAMPLE_CONTROL_SIZE];
+        sample_control_encode(value, sizeof(value), &control_state);
+        return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+    }
+    if (att_handle == TIME_SYNC_VALUE_HANDLE){
+        // Sincronização de relógios: o instante é anotado na consulta do
+        // tamanho, o mais perto possível da chegada do pedido, e a
+        // segunda chamada devolve o mesmo valor.
+        if (buffer == NULL) time_sync_rx_us = time_us_32();
+        uint8_t value[TIME_SYNC_SIZE];
+        time_sync_encode(value, sizeof(value), time_sync_rx_us);
+        return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
     }
     return 0;
 }
@@ -80,23 +1495,103 @@ uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t att_hand
 // Usado aqui para tratar escritas no Client Characteristic Configuration
 // Descriptor (CCCD), que habilitam ou desabilitam notificações.
 int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
-    UNUSED(transaction_mode);
-    UNUSED(offset);
-    UNUSED(buffer_size);
-    
+    if (att_handle == CLIENT_FEATURES_VALUE_HANDLE || att_handle == SERVICE_CHANGED_CCCD_HANDLE) {
+        // Serviço GATT: fora do bloqueio de sincronização, pois é por ele
+        // que a central volta a conhecer a base.
+        server_connection_t* conn = get_connection(connection_handle);
+        if (conn == NULL) return ATT_ERROR_INSUFFICIENT_RESOURCES;
+        if (att_handle == CLIENT_FEATURES_VALUE_HANDLE) {
+            if (transaction_mode != ATT_TRANSACTION_MODE_NONE || offset != 0 || buffer_size < 1) return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
+            // Recursos já habilitados não podem ser desligados.
+            if ((conn->client_features & ~buffer[0]) != 0) return ATT_ERROR_VALUE_NOT_ALLOWED;
+            conn->client_features = buffer[0];
+            LOG_INFO("Client Supported Features: 0x%02X (Handle: 0x%04X)", conn->client_features, connection_handle);
+            return 0;
+        }
+        conn->service_changed_indications = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION;
+        // Centrais pareadas guardam o CCCD para as próximas conexões.
+        remember_peer(conn);
+        if (conn->service_changed_indications && !conn->change_aware) send_service_changed(conn);
+        return 0;
+    }
+    uint8_t sync_error = database_sync_error(connection_handle);
+    if (sync_error != 0) return sync_error;
+    if (att_handle == SAMPLE_CONTROL_VALUE_HANDLE) {
+        // Escrita no ponto de controle: ajusta amostragem e notificações
+        // sem derrubar a conexão.
+        sample_control_t control;
+        if (transaction_mode != ATT_TRANSACTION_MODE_NONE || offset != 0) return ATT_ERROR_REQUEST_NOT_SUPPORTED;
+        if (sample_control_decode(buffer, buffer_size, &control) != 0) return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
+        uint8_t status = apply_control(connection_handle, &control);
+        if (status != 0) LOG_WARN("Ponto de controle: escrita recusada (campos 0x%02X)", control.fields);
+        return status;
+    }
+    // Os CCCDs são guardados no registro de cada conexão.
+    server_connection_t* conn = get_connection(connection_handle);
+    if (conn == NULL) return ATT_ERROR_INSUFFICIENT_RESOURCES;
+    if (att_handle == SAMPLE_STREAM_CCCD_HANDLE) {
+        bool enabled = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+        if (!enabled) sample_log_skip_delivered(conn);
+        conn->batch_notification_enabled = enabled;
+        if (conn->batch_notification_enabled) {
+            update_latest_sample();
+            if (conn->backlog_done) {
+                // Depois do download do registro: o fluxo continua da
+                // amostra seguinte à última baixada.
+                confirm_backlog(conn);
+            } else {
+                // Descarta amostras antigas: o fluxo começa a partir de agora.
+                discard_samples(conn);
+            }
+            notify_policy_reset(&conn->policy);
+            LOG_INFO("Notificações em lote ativadas (Handle: 0x%04X, MTU: %u, %u amostras/notificação)", connection_handle, att_server_get_mtu(connection_handle), batch_capacity(connection_handle));
+        } else {
+            LOG_INFO("Notificações em lote desativadas pelo cliente");
+        }
+        update_sample_log();
+        return 0;
+    }
+    if (att_handle == SAMPLE_BACKLOG_CCCD_HANDLE) {
+        // Habilitar as notificações do "Sample Backlog" pede o download do
+        // registro em flash.
+        if (little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) {
+            start_backlog(conn);
+        } else {
+            conn->backlog_active = false;
+        }
+        return 0;
+    }
+    int index = find_channel(att_handle);
+    if (index >= 0 && att_handle == channel_attributes[index].cccd_handle) {
+        // CCCD de uma entrada extra: estado de notificação independente.
+        channel_state_t* channel = &channels[index];
+        uint8_t bit = (uint8_t)(1u << index);
+        if (little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) {
+            conn->channel_notifications |= bit;
+            notify_policy_reset(&channel->policy);
+            if (channel->ring != NULL) {
+                conn->channel_pending |= bit;
+                schedule_send(conn);
+            }
+            LOG_INFO("Notificações da entrada %u do ADC ativadas%s", channel_attributes[index].input, channel->ring != NULL ? "" : " (entrada não amostrada)");
+        } else {
+            conn->channel_notifications &= (uint8_t)~bit;
+            LOG_INFO("Notificações da entrada %u do ADC desativadas", channel_attributes[index].input);
+        }
+        return 0;
+    }
     if (att_handle != ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE_01_CLIENT_CONFIGURATION_HANDLE) return 0;
     // Interpreta o valor escrito pelo cliente: se igual a
     // `GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION`,
     // significa que o cliente deseja receber notificações.
-    le_notification_enabled = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
-    con_handle = connection_handle;
+    conn->le_notification_enabled = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
     
-    if (le_notification_enabled) {
-        LOG_INFO("Notificações ativadas pelo cliente (Handle: 0x%04X)", con_handle);
-        // Solicita à pilha ATT a geração de um evento
-        // `ATT_EVENT_CAN_SEND_NOW`, no qual será enviada
-        // a próxima notificação.
-        att_server_request_can_send_now_event(con_handle);
+    if (conn->le_notification_enabled) {
+        LOG_INFO("Notificações ativadas pelo cliente (Handle: 0x%04X)", connection_handle);
+        notify_policy_reset(&conn->policy);
+        // Agenda o envio da próxima notificação, feito quando a pilha
+        // ATT chamar `connection_can_send_now` para esta conexão.
+        request_primary_send(conn);
     } else {
         LOG_INFO("Notificações desativadas pelo cliente");
     }
@@ -105,6 +1600,39 @@ int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Encaminha os logs internos da BTstack (log_info/log_error) para o
+// log_vt100 com a tag "BTSTACK". Todas as mensagens da pilha
+// compartilham um único ponto de chamada, com filtro de nível e
+// limitação de taxa aplicados antes da formatação. Pacotes HCI não são
+// registrados.
+log_site_t btstack_log_site = LOG_SITE_INIT(BTSTACK_LOG_TAG, "BTstack");
+
+void btstack_log_reset(void) {
+}
+
+void btstack_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    UNUSED(packet_type);
+    UNUSED(in);
+    UNUSED(packet);
+    UNUSED(len);
+}
+
+void btstack_log_message(int log_level, const char * format, va_list argptr) {
+    log_level_t level = LOG_LEVEL_DEBUG;
+    if (log_level == HCI_DUMP_LOG_LEVEL_INFO) level = LOG_LEVEL_INFO;
+    if (log_level == HCI_DUMP_LOG_LEVEL_ERROR) level = LOG_LEVEL_WARN;
+    if (!log_site_check(&btstack_log_site, level)) return;
+    log_vwrite_tagged(level, BTSTACK_LOG_TAG, format, argptr);
+}
+
+const hci_dump_t btstack_log_dump = {
+    &btstack_log_reset,
+    &btstack_log_packet,
+    &btstack_log_message,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 // Inicializa o servidor BLE:
 //  - armazena o callback da aplicação e o ponteiro para a variável
 //    de dados que será exposta via GATT;
@@ -116,32 +1644,183 @@ int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle,
 int bt_server_init(void(*task)(void), uint16_t* message) {
     global_callback_task = task;
     global_callback_message = message;
+    sample_ring_init(&heartbeat_queue, heartbeat_queue_storage, HEARTBEAT_QUEUE_SIZE);
+    sample_ring_init(&queue_fanout, queue_fanout_storage, QUEUE_FANOUT_SIZE);
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        connections[i].con_handle = HCI_CON_HANDLE_INVALID;
+    }
 
     // initialize CYW43 driver architecture (will enable BT if/because CYW43_ENABLE_BLUETOOTH == 1)
     if (cyw43_arch_init()) {
-        printf("failed to initialise cyw43_arch\n");
+        LOG_WARN("Falha ao inicializar cyw43_arch");
         return -1;
     }
 
+    // Logs internos da BTstack passam pelo log_vt100 (tag "BTSTACK").
+    log_set_tag_level(BTSTACK_LOG_TAG, BTSTACK_LOG_LEVEL);
+    hci_dump_init(&btstack_log_dump);
+
     // Inicializa o restante da pilha BTstack.
     l2cap_init();
     sm_init();
+    // Pareamento "Just Works" com bonding: só centrais pareadas têm o
+    // estado do cache GATT lembrado entre conexões.
+    sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    sm_set_authentication_requirements(SM_AUTHREQ_BONDING);
     att_server_init(profile_data, att_read_callback, att_write_callback);
 
+    // Database Hash gerado no build e centrais que viram a base (banco
+    // TLV configurado pelo cyw43_arch_init).
+    uint16_t hash_len = 0;
+    database_hash = gatt_server_get_const_value_for_handle(DATABASE_HASH_VALUE_HANDLE, &hash_len);
+    if (database_hash == NULL || hash_len != DATABASE_HASH_SIZE) {
+        LOG_WARN("Base GATT sem Database Hash");
+        return -1;
+    }
+    load_known_peers();
+    init_sample_log();
+
     // Registra callback para ser informado sobre mudanças de estado
     // da BTstack (ex.: quando entra em HCI_STATE_WORKING).
     hci_event_callback_registration.callback = &packet_handler;
     hci_add_event_handler(&hci_event_callback_registration);
 
-    // Registra o handler para eventos ATT (incluindo CAN_SEND_NOW).
+    // Registra o handler para eventos ATT (ex.: MTU negociado).
     att_server_register_packet_handler(packet_handler);
+    // E para eventos L2CAP (resposta ao pedido de parâmetros de conexão).
+    l2cap_event_callback_registration.callback = &packet_handler;
+    l2cap_add_event_handler(&l2cap_event_callback_registration);
+    // E para eventos do Security Manager (identidade de centrais pareadas).
+    sm_event_callback_registration.callback = &packet_handler;
+    sm_add_event_handler(&sm_event_callback_registration);
 
     // Configura o timer de heartbeat para disparar periodicamente,
     // chamando `heartbeat_handler` e atualizando o LED/dados.
     heartbeat.process = &heartbeat_handler;
-    btstack_run_loop_set_timer(&heartbeat, HEARTBEAT_PERIOD_MS);
+    btstack_run_loop_set_timer(&heartbeat, heartbeat_period_ms);
     btstack_run_loop_add_timer(&heartbeat);
 
+    notify_policy_config.deadband = SERVER_NOTIFY_DEADBAND;
+    notify_policy_config.min_interval_us = SERVER_NOTIFY_MIN_INTERVAL_MS * 1000U;
+    notify_policy_config.max_interval_us = SERVER_NOTIFY_MAX_INTERVAL_MS * 1000U;
+    notify_policy_index = 0;
+
+    // Configuração inicial exposta no ponto de controle. Taxa e média vêm
+    // de `bt_server_set_control_handler`; sem ele, valem as do heartbeat.
+    control_state.fields = SAMPLE_CONTROL_ALL;
+    if (control_state.sample_rate_hz == 0) {
+        control_state.sample_rate_hz = 1000U / heartbeat_period_ms;
+        control_state.averaging = 1;
+    }
+    control_state.notify_interval_ms = SERVER_NOTIFY_POLICY ? SERVER_NOTIFY_MIN_INTERVAL_MS : heartbeat_period_ms;
+    control_state.batch_size = batch_size_limit;
+    control_state.deadband = SERVER_NOTIFY_DEADBAND;
+    control_state.keepalive_ms = SERVER_NOTIFY_MAX_INTERVAL_MS;
+#if SERVER_NOTIFY_POLICY
+    // Nos modos contínuo e de dois núcleos, a política avalia as amostras
+    // em um timer próprio, mais rápido que o heartbeat.
+    if (global_sample_ring != NULL || global_sample_queue != NULL) {
+        notify_policy_timer.process = &notify_policy_handler;
+        btstack_run_loop_set_timer(&notify_policy_timer, NOTIFY_POLICY_POLL_MS);
+        btstack_run_loop_add_timer(&notify_policy_timer);
+    }
+#endif
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Inicializa o servidor BLE no modo de dois núcleos: as amostras são
+// produzidas pelo core 1 em `queue` e drenadas aqui, no core 0.
+int bt_server_init_queue(void(*task)(void), spsc_queue_t* queue) {
+    global_sample_queue = queue;
+    return bt_server_init(task, &stream_latest_sample);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Inicializa o servidor BLE no modo de captura contínua: as amostras
+// passam a vir de `ring`, e a variável exposta via GATT é a amostra
+// mais recente consumida do anel.
+int bt_server_init_stream(void(*task)(void), sample_ring_t* ring) {
+    global_sample_ring = ring;
+    return bt_server_init(task, &stream_latest_sample);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Ajusta a política de notificação em tempo de execução.
+void bt_server_set_notify_policy(uint16_t deadband, uint16_t min_interval_ms, uint16_t max_interval_ms) {
+    notify_policy_config_t config = {
+        .deadband = deadband,
+        .min_interval_us = min_interval_ms * 1000U,
+        .max_interval_us = max_interval_ms * 1000U,
+    };
+    notify_policy_config = config;
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        notify_policy_configure(&connections[i].policy, &config);
+    }
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        notify_policy_configure(&channels[i].policy, &config);
+    }
+    control_state.deadband = deadband;
+    control_state.keepalive_ms = max_interval_ms;
+    if (SERVER_NOTIFY_POLICY) control_state.notify_interval_ms = min_interval_ms;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Registra o callback da aplicação para o ponto de controle e a
+// configuração de amostragem em uso.
+void bt_server_set_control_handler(int(*handler)(const sample_control_t*), uint32_t sample_rate_hz, uint8_t averaging) {
+    global_control_handler = handler;
+    control_state.sample_rate_hz = sample_rate_hz;
+    control_state.averaging = averaging;
+}
+
+// Registra a faixa de taxas aceita pelo ponto de controle.
+void bt_server_set_control_rate_range(uint32_t min_rate_hz, uint32_t max_rate_hz) {
+    control_min_rate_hz = min_rate_hz;
+    control_max_rate_hz = max_rate_hz;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Associa uma entrada extra do ADC ao seu anel. A política começa com a
+// configuração em uso na entrada principal.
+int bt_server_set_channel(uint8_t input, sample_ring_t* ring) {
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        channel_state_t* channel = &channels[i];
+        if (channel_attributes[i].input != input) continue;
+        notify_policy_init(&channel->policy, &notify_policy_config);
+        channel->index = ring->head;
+        channel->ring = ring;
+        return 0;
+    }
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Registra a base de tempo usada por `sample_capture_us` nos modos
+// contínuo e de dois núcleos.
+void bt_server_set_sample_timebase(uint32_t first_sample_us, uint32_t first_index, uint32_t sample_rate_hz) {
+    sample_timebase_start_us = first_sample_us;
+    sample_timebase_index = first_index;
+    sample_timebase_rate_hz = sample_rate_hz;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Escolhe o perfil de parâmetros de conexão e o pede às centrais já
+// conectadas, sem reconectar; as próximas conexões o pedem ao conectar.
+int bt_server_set_link_profile(link_profile_t profile) {
+    if (link_profile_params(profile) == NULL) return -1;
+    link_profile = profile;
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        if (connections[i].con_handle != HCI_CON_HANDLE_INVALID) request_link_profile(&connections[i]);
+    }
     return 0;
 }
 
@@ -170,11 +1849,47 @@ void heartbeat_handler(struct btstack_timer_source *ts) {
 
     // Atualiza os dados de aplicação (ex.: nova leitura ADC).
     global_callback_task();
+    update_latest_sample();
     // Opcional: LOG_TRACE("Heartbeat #%u - Valor atual: %d", counter, *global_callback_message);
     LOG_INFO("Heartbeat #%u - Valor atual: %d", counter, *global_callback_message);
-    if (le_notification_enabled) {
-        att_server_request_can_send_now_event(con_handle);
+    if ((any_batch_subscriber() || SERVER_BROADCAST || sample_log_recording) && global_sample_ring == NULL && global_sample_queue == NULL) {
+        // No modo de leitura única, a amostra do heartbeat entra na fila
+        // de lotes (e do anúncio, no modo broadcast, ou do registro em
+        // flash).
+        heartbeat_queue_times[heartbeat_queue.head & heartbeat_queue.mask] = time_us_32();
+        sample_ring_push(&heartbeat_queue, *global_callback_message);
+    }
+    update_sample_log();
+#if SERVER_NOTIFY_POLICY
+    // A política decide se há notificação (ou lote parcial) a enviar.
+    evaluate_notify_policy();
+    static uint32_t last_report_us = 0;
+    if (time_us_32() - last_report_us >= 10000000U) {
+        last_report_us = time_us_32();
+        for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+            const server_connection_t* conn = &connections[i];
+            if (!primary_subscribed(conn)) continue;
+            LOG_INFO("Política de notificação da conexão 0x%04X: %u amostras avaliadas, %u notificações", conn->con_handle,
+                     (unsigned)conn->policy.evaluated, (unsigned)conn->policy.sent);
+        }
+    }
+#else
+    for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+        server_connection_t* conn = &connections[i];
+        if (conn->con_handle == HCI_CON_HANDLE_INVALID) continue;
+        // Lotes parciais são enviados a cada heartbeat.
+        if (conn->le_notification_enabled || (conn->batch_notification_enabled && pending_samples(conn) > 0)) {
+            conn->primary_send_pending = true;
+        }
     }
+    evaluate_channels(time_us_32());
+    schedule_sends();
+#endif
+    report_connections();
+#if SERVER_BROADCAST
+    update_broadcast();
+    report_broadcast();
+#endif
 
     // Inverte o estado do LED on-board.
     static int led_on = true;
@@ -182,7 +1897,7 @@ void heartbeat_handler(struct btstack_timer_source *ts) {
     cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_on);
 
     // Reinicia o timer para o próximo "tick" do heartbeat.
-    btstack_run_loop_set_timer(ts, HEARTBEAT_PERIOD_MS);
+    btstack_run_loop_set_timer(ts, heartbeat_period_ms);
     btstack_run_loop_add_timer(ts);
 }
 
@@ -191,8 +1906,11 @@ void heartbeat_handler(struct btstack_timer_source *ts) {
 // Handler principal de pacotes HCI/ATT.
 // Trata:
 //  - entrada da pilha em estado operacional (configuração de advertising);
-//  - fim de conexões (limpando flag de notificação);
-//  - eventos CAN_SEND_NOW para efetivamente enviar notificações.
+//  - início e fim de conexões (tabela de conexões);
+//  - pacotes confirmados pelo controlador, que liberam a cota de envio;
+//  - confirmação do Service Changed pela central;
+//  - parâmetros de conexão concedidos (ou recusados) pela central;
+//  - PHY e tamanho das PDUs negociados (modo de alta vazão).
 void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
     UNUSED(size);
     UNUSED(channel);
@@ -204,7 +1922,7 @@ void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint
         case BTSTACK_EVENT_STATE:{
             if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
             gap_local_bd_addr(local_addr);
-            printf("BTstack up and running on %s.\n", bd_addr_to_str(local_addr));
+            LOG_INFO("BTstack operacional no endereço %s", bd_addr_to_str(local_addr));
 
             // Configura os parâmetros de advertising (intervalo, tipo,
             // endereço) e registra o bloco de dados `adv_data`.
@@ -213,25 +1931,139 @@ void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint
             uint8_t adv_type = 0;
             bd_addr_t null_addr;
             memset(null_addr, 0, 6);
+#if SERVER_BROADCAST
+            // Broadcast: anúncio não conectável (ADV_NONCONN_IND), mais
+            // frequente, com as amostras no lugar do nome.
+            adv_int_min = adv_int_max = (uint16_t)(SERVER_BROADCAST_INTERVAL_MS * 8U / 5U);
+            adv_type = 0x03;
+            broadcast_report_us = time_us_32();
+            LOG_INFO("Modo broadcast: anúncio a cada %u ms, atualizado a cada %u ms, até %u amostras por anúncio",
+                     SERVER_BROADCAST_INTERVAL_MS, heartbeat_period_ms, SAMPLE_BROADCAST_MAX_SAMPLES);
+#endif
             gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
             assert(adv_data_len <= 31); // ble limitation
+#if SERVER_BROADCAST
+            // Até a primeira amostra, só as flags.
+            gap_advertisements_set_data(3, broadcast_adv_data);
+#else
             gap_advertisements_set_data(adv_data_len, (uint8_t*) adv_data);
+#endif
+            // O advertising volta sozinho após cada conexão enquanto houver
+            // espaço para mais centrais.
+            gap_set_max_number_peripheral_connections(SERVER_MAX_CONNECTIONS);
             gap_advertisements_enable(1);
 
             global_callback_task();
 
+            break;}
+        case HCI_EVENT_LE_META: {
+            if (hci_event_le_meta_get_subevent_code(packet) == HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE) {
+                // Parâmetros concedidos pela central.
+                server_connection_t* conn = find_connection(hci_subevent_le_connection_update_complete_get_connection_handle(packet));
+                if (conn == NULL || hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                conn->conn_interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                conn->conn_latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+                conn->supervision_timeout = hci_subevent_le_connection_update_complete_get_supervision_timeout(packet);
+                report_link_params(conn, "concedidos");
+                break;
+            }
+            if (hci_event_le_meta_get_subevent_code(packet) == HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE) {
+                server_connection_t* conn = find_connection(hci_subevent_le_phy_update_complete_get_connection_handle(packet));
+                if (conn == NULL) break;
+                uint8_t status = hci_subevent_le_phy_update_complete_get_status(packet);
+                if (status != ERROR_CODE_SUCCESS) {
+                    LOG_WARN("Conexão 0x%04X: PHY recusado (status 0x%02X), segue em %s", conn->con_handle, status, link_phy_name(conn->tx_phy));
+                    break;
+                }
+                conn->tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+                conn->rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+                LOG_INFO("Conexão 0x%04X: PHY TX %s, RX %s", conn->con_handle, link_phy_name(conn->tx_phy), link_phy_name(conn->rx_phy));
+                break;
+            }
+            if (hci_event_le_meta_get_subevent_code(packet) == HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE) {
+                server_connection_t* conn = find_connection(hci_subevent_le_data_length_change_get_connection_handle(packet));
+                if (conn == NULL) break;
+                conn->max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+                conn->max_rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+                LOG_INFO("Conexão 0x%04X: PDUs de dados de até %u bytes (TX), %u bytes (RX)", conn->con_handle, conn->max_tx_octets, conn->max_rx_octets);
+                break;
+            }
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            hci_con_handle_t handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+            server_connection_t* conn = get_connection(handle);
+            if (conn == NULL) {
+                LOG_WARN("Conexão 0x%04X sem registro livre (máximo de %u)", handle, SERVER_MAX_CONNECTIONS);
+                break;
+            }
+            hci_subevent_le_connection_complete_get_peer_address(packet, conn->peer_addr);
+            // Sem pareamento a central começa "change-aware" (Core Spec,
+            // Vol 3, Part G, 2.5.2.1); se for pareada, o estado guardado
+            // vem com a identidade, em SM_EVENT_IDENTITY_*.
+            conn->change_aware = true;
+            conn->conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+            conn->conn_latency = hci_subevent_le_connection_complete_get_conn_latency(packet);
+            conn->supervision_timeout = hci_subevent_le_connection_complete_get_supervision_timeout(packet);
+            report_link_params(conn, "escolhidos pela central");
+            request_link_profile(conn);
+            request_high_throughput(conn);
+            uint8_t active = 0;
+            for (uint8_t i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+                if (connections[i].con_handle != HCI_CON_HANDLE_INVALID) active++;
+            }
+            LOG_INFO("Central conectada (Handle: 0x%04X, %u de %u conexões)", handle, active, SERVER_MAX_CONNECTIONS);
             break;}
         case HCI_EVENT_DISCONNECTION_COMPLETE:
-            // Ao desconectar, desabilita o envio de notificações.
-            le_notification_enabled = 0;
+            // Ao desconectar, libera o registro da conexão: as demais
+            // continuam recebendo notificações normalmente.
+            remove_connection(hci_event_disconnection_complete_get_connection_handle(packet));
+            break;
+        case HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS:
+            // O controlador liberou buffers: enlaces que estavam na cota
+            // podem voltar a enviar.
+            schedule_sends();
             break;
-        case ATT_EVENT_CAN_SEND_NOW:
-            // Momento em que a pilha garante que podemos enviar um
-            // pacote de notificação. Enviamos o conteúdo da variável
-            // apontada por `global_callback_message` ao cliente.
-            att_server_notify(con_handle, ATT_CHARACTERISTIC_ORG_BLUETOOTH_CHARACTERISTIC_TEMPERATURE_01_VALUE_HANDLE, (uint8_t*)global_callback_message, sizeof(global_callback_message));
-            printf("wrote %d\n", *global_callback_message);
+        case L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE:
+            // Resultado 0: aceito (os novos parâmetros chegam depois, na
+            // atualização da conexão); diferente de 0: recusado.
+            if (l2cap_event_connection_parameter_update_response_get_result(packet) != 0) {
+                LOG_WARN("Central recusou o perfil de conexão (Handle: 0x%04X)", l2cap_event_connection_parameter_update_response_get_handle(packet));
+            }
             break;
+        case SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED: {
+            // Central pareada reconectando: endereço resolvido para a
+            // identidade guardada no pareamento.
+            server_connection_t* conn = find_connection(sm_event_identity_resolving_succeeded_get_handle(packet));
+            if (conn == NULL) break;
+            bd_addr_t addr;
+            sm_event_identity_resolving_succeeded_get_identity_address(packet, addr);
+            bind_identity(conn, addr, sm_event_identity_resolving_succeeded_get_identity_addr_type(packet));
+            break;}
+        case SM_EVENT_IDENTITY_CREATED: {
+            // Novo pareamento concluído: a central passa a ser lembrada.
+            server_connection_t* conn = find_connection(sm_event_identity_created_get_handle(packet));
+            if (conn == NULL) break;
+            bd_addr_t addr;
+            sm_event_identity_created_get_identity_address(packet, addr);
+            bind_identity(conn, addr, sm_event_identity_created_get_identity_addr_type(packet));
+            break;}
+        case ATT_EVENT_HANDLE_VALUE_INDICATION_COMPLETE: {
+            // Service Changed confirmado: a central passa a conhecer a base.
+            server_connection_t* conn = find_connection(att_event_handle_value_indication_complete_get_conn_handle(packet));
+            if (conn == NULL || att_event_handle_value_indication_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            if (att_event_handle_value_indication_complete_get_attribute_handle(packet) != SERVICE_CHANGED_VALUE_HANDLE) break;
+            conn->change_aware = true;
+            remember_peer(conn);
+            LOG_INFO("Service Changed confirmado (Handle: 0x%04X)", conn->con_handle);
+            break;}
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE: {
+            // O cliente negociou um novo ATT MTU; os próximos lotes para
+            // esta conexão passam a usar a nova capacidade.
+            uint16_t mtu = att_event_mtu_exchange_complete_get_MTU(packet);
+            server_connection_t* conn = get_connection(att_event_mtu_exchange_complete_get_handle(packet));
+            if (conn != NULL) conn->mtu = mtu;
+            LOG_INFO("ATT MTU negociado: %u bytes (até %u amostras/notificação)", mtu, sample_packet_capacity((uint16_t)(mtu - 3), SAMPLE_CAPACITY_FLAGS));
+            break;}
         default:
             break;
     }
@@ -4,8 +4,15 @@
 //    (por exemplo, para nova leitura do ADC);
 //  - solicitar à pilha BLE permissão para enviar notificações;
 //  - atualizar o estado visual do LED a bordo.
+// É o valor inicial: o cliente pode alterá-lo pelo ponto de controle
+// ("Sample Control").
 #define HEARTBEAT_PERIOD_MS 100
 
+#include "sample_ring.h"
+#include "spsc_queue.h"
+#include "sample_control.h"
+#include "link_profile.h"
+
 // Inicializa a pilha Bluetooth LE do lado servidor.
 // Parâmetros:
 //  - task: função de callback chamada a cada "tick" do heartbeat
@@ -17,6 +24,105 @@
 //  - valor negativo em caso de falha na inicialização.
 int bt_server_init(void(*task)(void), uint16_t* message);
 
+// Variante de `bt_server_init` para captura contínua.
+// Em vez de uma única variável de 16 bits atualizada a cada heartbeat,
+// o servidor consome as amostras produzidas em `ring` (por exemplo, pelo
+// DMA do ADC) e notifica ao cliente a amostra mais recente.
+// Parâmetros:
+//  - task: callback chamado a cada "tick" do heartbeat (pode ser usado
+//          para avançar produtores por software, ex.: ADC simulado);
+//  - ring: anel de amostras alimentado pelo produtor.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo em caso de falha na inicialização.
+int bt_server_init_stream(void(*task)(void), sample_ring_t* ring);
+
+// Variante de `bt_server_init` para o pipeline de dois núcleos.
+// As amostras (uint16_t) são produzidas por outro núcleo em `queue`, uma
+// fila SPSC lock-free, e drenadas pela pilha BLE a cada
+// `ATT_EVENT_CAN_SEND_NOW`.
+// Parâmetros:
+//  - task: callback chamado a cada "tick" do heartbeat, no core 0;
+//  - queue: fila SPSC de amostras de 16 bits.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo em caso de falha na inicialização.
+int bt_server_init_queue(void(*task)(void), spsc_queue_t* queue);
+
+// Ajusta a política de notificação dirigida por mudança
+// (SERVER_NOTIFY_POLICY), que substitui a notificação incondicional a
+// cada heartbeat.
+// Parâmetros:
+//  - deadband: variação mínima da amostra, em contagens do ADC, para
+//              que uma notificação seja enviada;
+//  - min_interval_ms: intervalo mínimo entre notificações (limite de taxa);
+//  - max_interval_ms: intervalo máximo sem notificação (keep-alive);
+//                     0 desativa.
+// Sem a política compilada, os valores são guardados mas não usados.
+void bt_server_set_notify_policy(uint16_t deadband, uint16_t min_interval_ms, uint16_t max_interval_ms);
+
+// Registra o callback que aplica as escritas do cliente no ponto de
+// controle ("Sample Control") que dependem da aplicação: taxa de
+// amostragem e média. Os demais campos (intervalo de notificação,
+// tamanho do lote, banda morta, keep-alive) são tratados pelo próprio
+// servidor BLE, sem derrubar a conexão.
+// Parâmetros:
+//  - handler: chamado com os campos marcados em `control->fields`; deve
+//             validar e reprogramar o ADC/timer, retornando 0, ou
+//             retornar valor negativo para recusar a escrita inteira;
+//  - sample_rate_hz, averaging: configuração em uso, exposta na leitura.
+// No modo de leitura única a taxa de amostragem é a do heartbeat, que o
+// servidor ajusta por conta própria depois de `handler` aceitar.
+void bt_server_set_control_handler(int(*handler)(const sample_control_t*), uint32_t sample_rate_hz, uint8_t averaging);
+
+// Informa a faixa de taxas de amostragem (Hz) aceita pelo ponto de
+// controle nos modos contínuo e de dois núcleos; escritas fora dela são
+// recusadas com ATT_ERROR_VALUE_NOT_ALLOWED antes de chegar ao callback.
+// No modo de leitura única a faixa é a do heartbeat (1 a 100 Hz). Sem
+// esta chamada, só a taxa 0 é recusada pelo servidor BLE.
+void bt_server_set_control_rate_range(uint32_t min_rate_hz, uint32_t max_rate_hz);
+
+// Expõe uma entrada extra do ADC (amostrada em round-robin com a entrada
+// principal) na sua própria característica (5A1E0010 + entrada), com
+// estado de notificação independente: CCCD, política de notificação e
+// último valor próprios. O servidor acompanha `ring` com um cursor
+// próprio, sem consumir as amostras.
+// Parâmetros:
+//  - input: entrada do ADC (1, 2 ou 4 = sensor de temperatura);
+//  - ring: anel alimentado com as amostras desentrelaçadas da entrada.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo se a entrada não tiver característica no GATT.
+int bt_server_set_channel(uint8_t input, sample_ring_t* ring);
+
+// Informa a base de tempo das amostras nos modos contínuo e de dois
+// núcleos, usada no modo de instrumentação (SERVER_SAMPLE_TIMESTAMPS)
+// para calcular o instante de captura de cada lote.
+// Parâmetros:
+//  - first_sample_us: instante (`time_us_32()`) da captura da amostra
+//    de índice `first_index`;
+//  - first_index: índice da amostra de referência (0 no início, o
+//    próximo índice depois de uma mudança de taxa);
+//  - sample_rate_hz: taxa das amostras entregues.
+// A amostra de índice i é considerada capturada em
+// `first_sample_us + (i - first_index) * 1 s / sample_rate_hz`, calculado
+// em 64 bits, sem o erro acumulado de um período inteiro truncado. No
+// modo de dois núcleos, amostras descartadas pelo core 1 (fila cheia)
+// deslocam essa relação.
+void bt_server_set_sample_timebase(uint32_t first_sample_us, uint32_t first_index, uint32_t sample_rate_hz);
+
+// Escolhe o perfil de parâmetros de conexão (ver
+// lib/sample_stream/link_profile.h): baixa latência (7,5 ms), equilibrado
+// ou economia de energia. O servidor pede os parâmetros a cada central
+// (L2CAP Connection Parameter Update Request) ao conectar e, ao trocar de
+// perfil, às já conectadas, sem reconectar. A central decide; os
+// parâmetros concedidos aparecem no log. Deve ser chamada depois de
+// `bt_server_init*` e, em funcionamento, do contexto da BTstack.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo se o perfil for inválido.
+int bt_server_set_link_profile(link_profile_t profile);
+
 // Inicia efetivamente o servidor BLE, ligando o controlador HCI.
 // Depois desta chamada, o dispositivo passa a anunciar (advertising)
 // e a responder conexões/notificações conforme configurado.
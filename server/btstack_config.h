@@ -11,10 +11,25 @@
 #define ENABLE_LOG_ERROR
 #define ENABLE_PRINTF_HEXDUMP
 
+// Modo de alta vazão (definido pelo CMake): Data Length Extension, com
+// PDUs de até 251 bytes sugeridos ao controlador na inicialização, e
+// pedido do PHY 2M a cada conexão (ver lib/sample_stream/link_profile.h).
+#ifndef BLE_HIGH_THROUGHPUT
+#define BLE_HIGH_THROUGHPUT 1
+#endif
+#if BLE_HIGH_THROUGHPUT
+#define ENABLE_LE_DATA_LENGTH_EXTENSION
+#endif
+
 // for the client
 #if RUNNING_AS_CLIENT
 #define ENABLE_LE_CENTRAL
-#define MAX_NR_GATT_CLIENTS 1
+// Servidores (periféricos) conectados ao mesmo tempo pelo cliente
+// (definido pelo CMake).
+#ifndef CLIENT_MAX_SERVERS
+#define CLIENT_MAX_SERVERS 1
+#endif
+#define MAX_NR_GATT_CLIENTS CLIENT_MAX_SERVERS
 #else
 #define MAX_NR_GATT_CLIENTS 0
 #endif
@@ -23,7 +38,15 @@
 #define HCI_OUTGOING_PRE_BUFFER_SIZE 4
 #define HCI_ACL_PAYLOAD_SIZE (255 + 4)
 #define HCI_ACL_CHUNK_SIZE_ALIGNMENT 4
-#define MAX_NR_HCI_CONNECTIONS 1
+#if RUNNING_AS_CLIENT
+#define MAX_NR_HCI_CONNECTIONS CLIENT_MAX_SERVERS
+#else
+// Centrais conectadas ao mesmo tempo ao servidor (definido pelo CMake).
+#ifndef SERVER_MAX_CONNECTIONS
+#define SERVER_MAX_CONNECTIONS 3
+#endif
+#define MAX_NR_HCI_CONNECTIONS SERVER_MAX_CONNECTIONS
+#endif
 #define MAX_NR_SM_LOOKUP_ENTRIES 3
 #define MAX_NR_WHITELIST_ENTRIES 16
 #define MAX_NR_LE_DEVICE_DB_ENTRIES 16
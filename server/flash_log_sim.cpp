@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////
+// Simulação do registro de amostras em flash (lib/flash_log/flash_log.h)
+// Só no build de host, sobre a flash simulada em RAM. Cada cenário grava
+// uma rampa de amostras (valor = índice módulo 4096), reinicia a placa
+// (nova chamada de `flash_log_init` sobre a mesma memória) e confere que
+// tudo o que é lido de volta está íntegro e na ordem:
+//  - volta: a região enche várias vezes; os registros mais antigos são
+//    sobrescritos e o desgaste fica igual entre os setores;
+//  - reinício: a posição liberada e o próximo seq são recuperados;
+//  - gravação interrompida: a falta de energia no meio do apagamento ou
+//    da programação, em vários pontos, invalida só o setor afetado;
+//  - descontinuidade: um salto no índice fecha o registro em montagem;
+//  - download: ler tudo, liberar e reiniciar deixa o registro vazio.
+//
+// Uso:
+//   flash_log_sim [setores]
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "flash_log.h"
+#include "flash_log_host.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Setores da região simulada (pequena, para dar várias voltas).
+#define SIM_DEFAULT_SECTORS 8U
+
+// Período simulado entre amostras.
+#define SIM_PERIOD_US 1000U
+
+// Amostras por chamada de `flash_log_append` (como um lote do anel).
+#define SIM_CHUNK 100U
+
+static flash_log_t sim_log;
+static uint32_t sim_sectors = SIM_DEFAULT_SECTORS;
+static uint16_t chunk[SIM_CHUNK];
+static int failures;
+
+static uint16_t ramp(uint32_t index) {
+    return (uint16_t)(index & 0x0FFF);
+}
+
+// Acrescenta a rampa de `first` a `first + count - 1`, em pedaços.
+// Retorna o menor status devolvido por `flash_log_append`.
+static int append_ramp(uint32_t first, uint32_t count) {
+    int worst = 0;
+    while (count > 0) {
+        uint32_t n = (count < SIM_CHUNK) ? count : SIM_CHUNK;
+        for (uint32_t i = 0; i < n; i++) chunk[i] = ramp(first + i);
+        int status = flash_log_append(&sim_log, first, first * SIM_PERIOD_US, SIM_PERIOD_US, chunk, n);
+        if (status < worst) worst = status;
+        first += n;
+        count -= n;
+    }
+    return worst;
+}
+
+typedef struct {
+    uint32_t records;
+    uint32_t invalid;
+    uint32_t samples;
+    uint32_t first_index;
+    uint32_t next_index;
+    bool ordered;
+} scan_t;
+
+// Lê a janela inteira, de `tail_seq` a `head_seq`, conferindo cada
+// amostra contra a rampa e a continuidade dos índices entre registros.
+static scan_t scan(void) {
+    scan_t result = {};
+    result.ordered = true;
+    bool first = true;
+    for (uint32_t seq = sim_log.tail_seq; seq != sim_log.head_seq + 1; seq++) {
+        flash_log_record_t record;
+        const uint8_t* data;
+        int status = flash_log_read(&sim_log, seq, &record, &data);
+        if (status != 0) {
+            result.invalid++;
+            continue;
+        }
+        if (record.count == 0) continue;
+        if (first) {
+            result.first_index = record.first_index;
+            first = false;
+        } else if ((int32_t)(record.first_index - result.next_index) < 0) {
+            result.ordered = false;
+        }
+        if (record.capture_us != record.first_index * SIM_PERIOD_US) result.ordered = false;
+        for (uint16_t i = 0; i < record.count; i++) {
+            uint16_t value = (uint16_t)(data[2 * i] | (data[2 * i + 1] << 8));
+            if (value != ramp(record.first_index + i)) result.ordered = false;
+        }
+        result.records++;
+        result.samples += record.count;
+        result.next_index = record.first_index + record.count;
+    }
+    return result;
+}
+
+static void reboot(void) {
+    flash_log_init(&sim_log, sim_sectors, sim_log.tail_seq, sim_log.tail_offset);
+}
+
+static void report(const char* name, bool ok, const char* detail) {
+    printf("cenario=%s %s %s\n", name, detail, ok ? "ok" : "FALHOU");
+    if (!ok) failures++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_wraparound(void) {
+    flash_log_host_erase_all();
+    flash_log_init(&sim_log, sim_sectors, 0, 0);
+    uint32_t total = 3U * sim_sectors * FLASH_LOG_RECORD_SAMPLES + 1234U;
+    int status = append_ramp(0, total);
+    scan_t s = scan();
+
+    uint32_t min_wear = UINT32_MAX, max_wear = 0;
+    for (uint32_t i = 0; i < sim_sectors; i++) {
+        uint32_t wear = flash_log_host_erase_count(i);
+        if (wear < min_wear) min_wear = wear;
+        if (wear > max_wear) max_wear = wear;
+    }
+
+    // Sobram os `sectors` registros mais recentes e o em montagem.
+    bool ok = status >= 0 && s.ordered && s.invalid == 0 && s.next_index == total &&
+              s.samples == sim_sectors * FLASH_LOG_RECORD_SAMPLES + 1234U &&
+              sim_log.overwritten == 2U * sim_sectors && max_wear - min_wear <= 1;
+    char detail[160];
+    snprintf(detail, sizeof(detail), "records=%u samples=%u overwritten=%u wear=%u..%u", s.records, s.samples,
+             sim_log.overwritten, min_wear, max_wear);
+    report("volta", ok, detail);
+}
+
+static void test_reboot(void) {
+    flash_log_host_erase_all();
+    flash_log_init(&sim_log, sim_sectors, 0, 0);
+    uint32_t total = (sim_sectors + 2U) * FLASH_LOG_RECORD_SAMPLES + 500U;
+    append_ramp(0, total);
+    uint32_t head = sim_log.head_seq;
+
+    // Libera metade do registro mais antigo e reinicia: o em montagem
+    // (500 amostras) se perde; o resto continua legível.
+    flash_log_release(&sim_log, sim_log.tail_seq, FLASH_LOG_RECORD_SAMPLES / 2U);
+    uint32_t tail = sim_log.tail_seq;
+    reboot();
+    scan_t s = scan();
+
+    bool ok = sim_log.head_seq == head && sim_log.tail_seq == tail && s.ordered && s.invalid == 0 &&
+              s.next_index == total - 500U &&
+              s.samples == sim_sectors * FLASH_LOG_RECORD_SAMPLES - FLASH_LOG_RECORD_SAMPLES / 2U;
+
+    // Depois do reinício o fluxo continua em novos registros.
+    append_ramp(total, 3U * FLASH_LOG_RECORD_SAMPLES);
+    scan_t after = scan();
+    ok = ok && after.ordered && after.invalid == 0 && after.next_index == total + 3U * FLASH_LOG_RECORD_SAMPLES;
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "head=%u tail=%u samples=%u", sim_log.head_seq, sim_log.tail_seq, s.samples);
+    report("reinicio", ok, detail);
+}
+
+static void test_torn_writes(void) {
+    // Pontos de falha: durante o apagamento (0 = antes de começar) e
+    // durante a programação (cabeçalho, meio das amostras, último byte).
+    static const uint32_t points[] = {
+        0, 1, 2048, FLASH_LOG_SECTOR_SIZE - 1, FLASH_LOG_SECTOR_SIZE, FLASH_LOG_SECTOR_SIZE + 10,
+        FLASH_LOG_SECTOR_SIZE + FLASH_LOG_HEADER_SIZE, FLASH_LOG_SECTOR_SIZE + 2000,
+        2 * FLASH_LOG_SECTOR_SIZE - 1,
+    };
+    for (uint32_t k = 0; k < sizeof(points) / sizeof(points[0]); k++) {
+        // Com a região já em volta, a falha atinge um setor que guardava
+        // um registro antigo válido.
+        flash_log_host_erase_all();
+        flash_log_init(&sim_log, sim_sectors, 0, 0);
+        uint32_t total = (sim_sectors + 3U) * FLASH_LOG_RECORD_SAMPLES;
+        append_ramp(0, total);
+        uint32_t head = sim_log.head_seq;
+
+        flash_log_host_fail_after(points[k]);
+        int status = append_ramp(total, FLASH_LOG_RECORD_SAMPLES);
+        reboot();
+        scan_t s = scan();
+
+        // O setor interrompido não pode ser aceito: ou o registro novo
+        // some (e o próximo seq volta para ele), ou ele é pulado como
+        // inválido. Nada do que é lido pode estar corrompido.
+        bool ok = status < 0 && s.ordered && sim_log.head_seq <= head + 1 &&
+                  s.next_index == total && s.invalid <= 1;
+
+        // A gravação seguinte funciona normalmente.
+        uint32_t next = total + FLASH_LOG_RECORD_SAMPLES;
+        status = append_ramp(next, FLASH_LOG_RECORD_SAMPLES);
+        scan_t after = scan();
+        ok = ok && status >= 0 && after.ordered && after.next_index == next + FLASH_LOG_RECORD_SAMPLES;
+
+        char name[32], detail[160];
+        snprintf(name, sizeof(name), "interrompida@%u", points[k]);
+        snprintf(detail, sizeof(detail), "head=%u invalid=%u scan_invalid=%u", sim_log.head_seq, sim_log.invalid,
+                 s.invalid);
+        report(name, ok, detail);
+    }
+}
+
+static void test_discontinuity(void) {
+    flash_log_host_erase_all();
+    flash_log_init(&sim_log, sim_sectors, 0, 0);
+    append_ramp(0, 300);
+    append_ramp(1000, 300);  // salto: fecha o primeiro registro
+    scan_t s = scan();
+    bool ok = sim_log.committed == 1 && s.records == 2 && s.samples == 600 && s.ordered;
+    char detail[160];
+    snprintf(detail, sizeof(detail), "records=%u committed=%u", s.records, sim_log.committed);
+    report("descontinuidade", ok, detail);
+}
+
+static void test_download(void) {
+    flash_log_host_erase_all();
+    flash_log_init(&sim_log, sim_sectors, 0, 0);
+    append_ramp(0, 4U * FLASH_LOG_RECORD_SAMPLES + 700U);
+    scan_t s = scan();
+    uint32_t pending = flash_log_pending_samples(&sim_log);
+
+    // Tudo baixado: libera até o fim do registro em montagem. Ele é
+    // descartado sem gravar quando o registro seguinte começa.
+    flash_log_release(&sim_log, sim_log.head_seq, sim_log.pending.count);
+    uint32_t committed = sim_log.committed;
+    append_ramp(5000000, 10);
+    bool ok = pending == s.samples && sim_log.committed == committed &&
+              flash_log_pending_samples(&sim_log) == 10;
+    reboot();
+    ok = ok && flash_log_pending_samples(&sim_log) == 0;
+
+    char detail[160];
+    snprintf(detail, sizeof(detail), "downloaded=%u", s.samples);
+    report("download", ok, detail);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    if (argc > 1) sim_sectors = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (sim_sectors < 2 || sim_sectors > FLASH_LOG_MAX_SECTORS) {
+        fprintf(stderr, "setores fora da faixa (2 a %u)\n", FLASH_LOG_MAX_SECTORS);
+        return 2;
+    }
+    printf("sectors=%u record_samples=%u\n", sim_sectors, FLASH_LOG_RECORD_SAMPLES);
+
+    test_wraparound();
+    test_reboot();
+    test_torn_writes();
+    test_discontinuity();
+    test_download();
+
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
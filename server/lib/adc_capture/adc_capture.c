@@ -0,0 +1,145 @@
+#include "adc_capture.h"
+
+#include <stddef.h>
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pico/stdlib.h"
+
+// Frequência do clock do ADC (clk_adc), fixa em 48 MHz no RP2040.
+#define ADC_CLOCK_HZ 48000000u
+
+static sample_ring_t *capture_ring;
+static uint32_t capture_rate_hz;
+static uint32_t capture_block_len;
+static uint32_t capture_num_blocks;
+static int capture_dma_chan[2] = {-1, -1};
+// Bloco do anel que cada canal está (ou estará) preenchendo.
+static uint32_t capture_next_block[2];
+// Canal cuja conclusão é a próxima esperada, para publicar em ordem.
+static uint8_t capture_expected;
+// Tratador chamado a cada bloco publicado (opcional).
+static adc_capture_block_handler_t capture_block_handler;
+
+static uint16_t *block_ptr(uint32_t block) {
+    return capture_ring->buffer + block * capture_block_len;
+}
+
+static void __isr adc_capture_dma_irq_handler(void) {
+    // Publica os blocos na ordem de captura, mesmo que ambos os canais
+    // tenham terminado antes do atendimento da interrupção.
+    while (dma_channel_get_irq1_status(capture_dma_chan[capture_expected])) {
+        uint8_t i = capture_expected;
+        uint channel = (uint)capture_dma_chan[i];
+        dma_channel_acknowledge_irq1(channel);
+
+        const uint16_t *block = block_ptr(capture_next_block[i]);
+        sample_ring_publish(capture_ring, capture_block_len);
+
+        // O canal será disparado novamente pelo encadeamento do outro
+        // canal; apenas aponta para o próximo bloco livre (o contador
+        // de transferências é recarregado automaticamente).
+        capture_next_block[i] = (capture_next_block[i] + 2) % capture_num_blocks;
+        dma_channel_set_write_addr(channel, block_ptr(capture_next_block[i]), false);
+
+        capture_expected ^= 1;
+
+        if (capture_block_handler != NULL) {
+            capture_block_handler(block, capture_block_len);
+        }
+    }
+}
+
+static void configure_channel(uint8_t i) {
+    uint channel = (uint)capture_dma_chan[i];
+    dma_channel_config cfg = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, (uint)capture_dma_chan[i ^ 1]);
+    dma_channel_configure(channel, &cfg, block_ptr(capture_next_block[i]), &adc_hw->fifo, capture_block_len, false);
+    dma_channel_set_irq1_enabled(channel, true);
+}
+
+int adc_capture_set_rate(uint32_t sample_rate_hz) {
+    if (sample_rate_hz < ADC_CAPTURE_MIN_RATE_HZ || sample_rate_hz > ADC_CAPTURE_MAX_RATE_HZ) {
+        return -1;
+    }
+    capture_rate_hz = sample_rate_hz;
+    // Período de amostragem = (1 + div) ciclos de clk_adc; abaixo de 96
+    // ciclos as conversões ficam back-to-back (500 kS/s).
+    adc_set_clkdiv((float)ADC_CLOCK_HZ / (float)sample_rate_hz - 1.0f);
+    return 0;
+}
+
+uint32_t adc_capture_get_rate(void) {
+    return capture_rate_hz;
+}
+
+int adc_capture_init(const adc_capture_config_t *config, sample_ring_t *ring) {
+    if (config == NULL || ring == NULL || config->block_len == 0 || config->input > 4) {
+        return -1;
+    }
+    if (ring->size % config->block_len != 0 || ring->size / config->block_len < 3) {
+        return -2;
+    }
+
+    capture_ring = ring;
+    capture_block_len = config->block_len;
+    capture_num_blocks = ring->size / config->block_len;
+
+    // Dois blocos podem estar em escrita pelo DMA (o atual e o já armado).
+    sample_ring_set_guard(ring, 2 * capture_block_len);
+
+    adc_select_input(config->input);
+    adc_set_round_robin(config->round_robin);
+    // FIFO habilitado, DREQ a cada amostra, sem bit de erro e sem
+    // deslocamento para 8 bits: amostras de 12 bits em palavras de 16.
+    adc_fifo_setup(true, true, 1, false, false);
+    if (adc_capture_set_rate(config->sample_rate_hz) != 0) {
+        return -3;
+    }
+
+    if (capture_dma_chan[0] < 0) {
+        capture_dma_chan[0] = dma_claim_unused_channel(true);
+        capture_dma_chan[1] = dma_claim_unused_channel(true);
+        irq_add_shared_handler(DMA_IRQ_1, adc_capture_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_1, true);
+    }
+
+    return 0;
+}
+
+void adc_capture_start(void) {
+    capture_next_block[0] = (capture_ring->head / capture_block_len) % capture_num_blocks;
+    capture_next_block[1] = (capture_next_block[0] + 1) % capture_num_blocks;
+    capture_expected = 0;
+
+    configure_channel(0);
+    configure_channel(1);
+
+    adc_fifo_drain();
+    dma_channel_start((uint)capture_dma_chan[0]);
+    adc_run(true);
+}
+
+void adc_capture_stop(void) {
+    adc_run(false);
+    for (int i = 0; i < 2; i++) {
+        uint channel = (uint)capture_dma_chan[i];
+        dma_channel_set_irq1_enabled(channel, false);
+        dma_channel_abort(channel);
+        dma_channel_acknowledge_irq1(channel);
+    }
+    adc_fifo_drain();
+}
+
+void adc_capture_set_block_handler(adc_capture_block_handler_t handler) {
+    capture_block_handler = handler;
+}
+
+void adc_capture_poll(void) {
+    // A captura é inteiramente conduzida pelo DMA no hardware real.
+}
@@ -0,0 +1,77 @@
+#ifndef ADC_CAPTURE_H
+#define ADC_CAPTURE_H
+
+#include <stdint.h>
+
+#include "sample_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Taxa máxima de conversão do ADC do RP2040 (48 MHz / 96 ciclos).
+#define ADC_CAPTURE_MAX_RATE_HZ 500000u
+
+// Taxa mínima: a parte inteira do divisor do ADC tem 16 bits, então o
+// período não passa de 65536 ciclos de 48 MHz (ceil(48 MHz / 65536)).
+// Taxas menores precisam de outro ritmo (ex.: leituras por timer).
+#define ADC_CAPTURE_MIN_RATE_HZ 733u
+
+// Configuração da captura contínua do ADC.
+//  - sample_rate_hz: taxa de amostragem desejada
+//    (ADC_CAPTURE_MIN_RATE_HZ .. ADC_CAPTURE_MAX_RATE_HZ);
+//  - input: entrada do ADC (0..3 = GPIO 26..29, 4 = sensor de temperatura);
+//  - block_len: amostras por bloco de DMA. O tamanho do anel precisa ser
+//    múltiplo de `block_len` e conter pelo menos 3 blocos;
+//  - round_robin: máscara de entradas convertidas em sequência pelo
+//    hardware (bit n = entrada n, incluindo `input`), a partir de
+//    `input` e em ordem crescente; 0 converte só `input`. As amostras chegam entrelaçadas
+//    no anel e `sample_rate_hz` é a taxa total de conversões.
+typedef struct {
+    uint32_t sample_rate_hz;
+    uint8_t input;
+    uint32_t block_len;
+    uint8_t round_robin;
+} adc_capture_config_t;
+
+// Configura o ADC em modo FIFO livre e dois canais de DMA encadeados
+// (ping-pong) que escrevem diretamente em `ring`, bloco a bloco. A cada
+// bloco completo, a interrupção do DMA publica as amostras no anel e
+// rearma o canal para o próximo bloco livre, sem cópia pela CPU.
+//
+// No build de host (PICO_NO_HARDWARE) um ADC simulado gera uma forma de
+// onda sintética na mesma taxa, alimentando o mesmo anel.
+//
+// Retorna 0 em caso de sucesso ou valor negativo se a configuração for
+// inválida.
+int adc_capture_init(const adc_capture_config_t *config, sample_ring_t *ring);
+
+// Inicia / interrompe a conversão contínua.
+void adc_capture_start(void);
+void adc_capture_stop(void);
+
+// Altera a taxa de amostragem sem interromper a captura.
+// Retorna 0 em caso de sucesso ou valor negativo se fora da faixa.
+int adc_capture_set_rate(uint32_t sample_rate_hz);
+
+// Taxa de amostragem atualmente configurada, em Hz.
+uint32_t adc_capture_get_rate(void);
+
+// Função chamada com as amostras de cada bloco logo após sua publicação
+// no anel (em contexto de interrupção no hardware real). Serve a um
+// estágio de processamento em blocos (ex.: filtro) sem cópia prévia.
+typedef void (*adc_capture_block_handler_t)(const uint16_t *samples, uint32_t count);
+
+// Registra (ou remove, com NULL) o tratador de blocos.
+void adc_capture_set_block_handler(adc_capture_block_handler_t handler);
+
+// Avança o produtor simulado até o instante atual (build de host).
+// No hardware real a captura é feita pelo DMA e esta função não faz nada;
+// pode ser chamada incondicionalmente pelo consumidor.
+void adc_capture_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADC_CAPTURE_H
@@ -0,0 +1,126 @@
+// ADC simulado para o build de host (PICO_NO_HARDWARE).
+//
+// Gera, sob demanda, as amostras que um ADC real teria convertido desde a
+// última chamada de `adc_capture_poll`, usando o relógio de `time_us_64`.
+// A forma de onda é uma rampa triangular de 12 bits com período de 1 s e
+// um pequeno ruído pseudoaleatório no bit menos significativo, o que
+// permite validar ordem, perdas e taxa das amostras no lado consumidor.
+// Em round-robin as entradas são entrelaçadas como no hardware, cada uma
+// defasada de 1/5 de período.
+
+#include "adc_capture.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pico/stdlib.h"
+
+static sample_ring_t *capture_ring;
+static uint32_t capture_rate_hz;
+static bool capture_running;
+static uint64_t capture_start_us;
+static uint64_t capture_generated;
+static uint32_t noise_state = 0x1234567u;
+static adc_capture_block_handler_t capture_block_handler;
+// Ordem das entradas no round-robin e quantidade de entradas.
+static uint8_t capture_order[5];
+static uint32_t capture_channels = 1;
+
+static uint16_t fake_sample(uint64_t index) {
+    uint32_t input = capture_order[index % capture_channels];
+    uint32_t period = capture_rate_hz / capture_channels;
+    if (period < 2) period = 2;
+    uint64_t n = index / capture_channels + (uint64_t)input * (period / 5);
+    uint32_t phase = (uint32_t)(n % period);
+    uint32_t half = period / 2;
+    uint32_t value = (phase < half)
+        ? (uint32_t)(((uint64_t)phase * 4095u) / half)
+        : (uint32_t)(((uint64_t)(period - phase) * 4095u) / (period - half));
+
+    noise_state = noise_state * 1664525u + 1013904223u;
+    value ^= (noise_state >> 31);
+    return (uint16_t)(value & 0x0FFFu);
+}
+
+int adc_capture_set_rate(uint32_t sample_rate_hz) {
+    if (sample_rate_hz < ADC_CAPTURE_MIN_RATE_HZ || sample_rate_hz > ADC_CAPTURE_MAX_RATE_HZ) {
+        return -1;
+    }
+    // Gera as amostras devidas na taxa anterior e recomeça a contagem a
+    // partir do instante atual para manter a taxa exata após a mudança.
+    adc_capture_poll();
+    capture_start_us = time_us_64();
+    capture_generated = 0;
+    capture_rate_hz = sample_rate_hz;
+    return 0;
+}
+
+uint32_t adc_capture_get_rate(void) {
+    return capture_rate_hz;
+}
+
+int adc_capture_init(const adc_capture_config_t *config, sample_ring_t *ring) {
+    if (config == NULL || ring == NULL || config->block_len == 0 || config->input > 4) {
+        return -1;
+    }
+    if (ring->size % config->block_len != 0 || ring->size / config->block_len < 3) {
+        return -2;
+    }
+    capture_ring = ring;
+    sample_ring_set_guard(ring, 0);
+
+    capture_channels = 0;
+    for (uint32_t i = 0; i < 5; i++) {
+        uint8_t input = (uint8_t)((config->input + i) % 5);
+        if (input == config->input || (config->round_robin & (1u << input))) {
+            capture_order[capture_channels++] = input;
+        }
+    }
+    return adc_capture_set_rate(config->sample_rate_hz) == 0 ? 0 : -3;
+}
+
+void adc_capture_start(void) {
+    capture_start_us = time_us_64();
+    capture_generated = 0;
+    capture_running = true;
+}
+
+void adc_capture_stop(void) {
+    adc_capture_poll();
+    capture_running = false;
+}
+
+void adc_capture_poll(void) {
+    if (!capture_running) return;
+
+    uint64_t elapsed_us = time_us_64() - capture_start_us;
+    uint64_t due = (elapsed_us * capture_rate_hz) / 1000000u;
+
+    // Se o consumidor ficou muito tempo sem chamar, só as últimas `size`
+    // amostras sobreviveriam no anel; as demais contam como descartadas.
+    if (due - capture_generated > capture_ring->size) {
+        uint64_t skipped = due - capture_generated - capture_ring->size;
+        capture_ring->head += (uint32_t)skipped;
+        capture_generated += skipped;
+    }
+
+    // Gera em trechos contíguos do anel, entregues ao tratador de blocos
+    // como faria a interrupção do DMA.
+    while (capture_generated < due) {
+        uint16_t *block = sample_ring_write_ptr(capture_ring);
+        uint32_t room = capture_ring->size - (capture_ring->head & capture_ring->mask);
+        uint32_t count = 0;
+        while (capture_generated < due && count < room) {
+            block[count++] = fake_sample(capture_generated);
+            capture_generated++;
+        }
+        sample_ring_publish(capture_ring, count);
+        if (capture_block_handler != NULL) {
+            capture_block_handler(block, count);
+        }
+    }
+}
+
+void adc_capture_set_block_handler(adc_capture_block_handler_t handler) {
+    capture_block_handler = handler;
+}
@@ -0,0 +1,107 @@
+#include "sample_ring.h"
+
+#include <stddef.h>
+
+int sample_ring_init(sample_ring_t *ring, uint16_t *storage, uint32_t size) {
+    if (ring == NULL || storage == NULL || size < 2 || (size & (size - 1)) != 0) {
+        return -1;
+    }
+    ring->buffer = storage;
+    ring->size = size;
+    ring->mask = size - 1;
+    ring->guard = 0;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    return 0;
+}
+
+void sample_ring_set_guard(sample_ring_t *ring, uint32_t guard) {
+    ring->guard = (guard < ring->size) ? guard : ring->size - 1;
+}
+
+void sample_ring_publish(sample_ring_t *ring, uint32_t count) {
+    // Garante que os dados escritos fiquem visíveis antes do novo `head`.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ring->head = ring->head + count;
+}
+
+void sample_ring_push(sample_ring_t *ring, uint16_t value) {
+    ring->buffer[ring->head & ring->mask] = value;
+    sample_ring_publish(ring, 1);
+}
+
+uint32_t sample_ring_available(sample_ring_t *ring) {
+    uint32_t head = ring->head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    uint32_t window = ring->size - ring->guard;
+    uint32_t pending = head - ring->tail;
+    if (pending > window) {
+        // O produtor deu a volta no anel: as amostras mais antigas já
+        // foram sobrescritas e são descartadas.
+        ring->dropped += pending - window;
+        ring->tail = head - window;
+        pending = window;
+    }
+    return pending;
+}
+
+uint32_t sample_ring_read(sample_ring_t *ring, uint16_t *dst, uint32_t max) {
+    return sample_ring_read_indexed(ring, dst, max, NULL);
+}
+
+uint32_t sample_ring_read_indexed(sample_ring_t *ring, uint16_t *dst, uint32_t max, uint32_t *first_index) {
+    uint32_t n = sample_ring_available(ring);
+    if (n > max) n = max;
+
+    uint32_t tail = ring->tail;
+    if (first_index != NULL) *first_index = tail;
+    for (uint32_t i = 0; i < n; i++) {
+        dst[i] = ring->buffer[(tail + i) & ring->mask];
+    }
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ring->tail = tail + n;
+    return n;
+}
+
+uint32_t sample_ring_drain_latest(sample_ring_t *ring, uint16_t *latest) {
+    uint32_t n = sample_ring_available(ring);
+    if (n == 0) return 0;
+
+    uint32_t head = ring->tail + n;
+    *latest = ring->buffer[(head - 1) & ring->mask];
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ring->tail = head;
+    return n;
+}
+
+uint32_t sample_ring_peek_latest(sample_ring_t *ring, uint16_t *latest) {
+    uint32_t n = sample_ring_available(ring);
+    if (n == 0) return 0;
+
+    *latest = ring->buffer[(ring->tail + n - 1) & ring->mask];
+    return n;
+}
+
+uint32_t sample_ring_peek_from(const sample_ring_t *ring, uint32_t *index, uint16_t *dst, uint32_t max) {
+    uint32_t head = ring->head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    uint32_t window = ring->size - ring->guard;
+    uint32_t n = head - *index;
+    if (n > window) {
+        *index = head - window;
+        n = window;
+    }
+    if (n > max) n = max;
+
+    uint32_t start = *index;
+    for (uint32_t i = 0; i < n; i++) {
+        dst[i] = ring->buffer[(start + i) & ring->mask];
+    }
+    *index = start + n;
+    return n;
+}
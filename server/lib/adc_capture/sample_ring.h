@@ -0,0 +1,92 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Anel de amostras de 16 bits com um único produtor e um único consumidor.
+//
+// O produtor (DMA do ADC, IRQ ou gerador simulado) nunca bloqueia: ele
+// escreve a partir de `head` e publica blocos já completos com
+// `sample_ring_publish`. O consumidor (pilha BLE) lê a partir de `tail`.
+// Se o consumidor ficar para trás mais do que a capacidade útil do anel,
+// as amostras mais antigas são descartadas e contabilizadas em `dropped`.
+//
+// `head` e `tail` são contadores livres (não mascarados), de modo que
+// `head - tail` é sempre o número de amostras pendentes, mesmo após o
+// estouro do contador de 32 bits.
+typedef struct {
+    uint16_t *buffer;        // área de armazenamento (tamanho potência de 2)
+    uint32_t size;           // número de amostras do anel
+    uint32_t mask;           // size - 1
+    uint32_t guard;          // amostras após `head` que o produtor pode estar escrevendo
+    volatile uint32_t head;  // total de amostras publicadas pelo produtor
+    volatile uint32_t tail;  // total de amostras consumidas
+    uint32_t dropped;        // amostras descartadas por atraso do consumidor
+} sample_ring_t;
+
+// Inicializa o anel sobre `storage`, que deve ter `size` amostras.
+// `size` precisa ser potência de 2. Retorna 0 em caso de sucesso ou
+// valor negativo se o tamanho for inválido.
+int sample_ring_init(sample_ring_t *ring, uint16_t *storage, uint32_t size);
+
+// Define quantas amostras logo após `head` podem estar em escrita pelo
+// produtor (ex.: blocos de DMA já armados). O consumidor nunca lê dados
+// dessa janela; ela reduz a capacidade útil para `size - guard`.
+void sample_ring_set_guard(sample_ring_t *ring, uint32_t guard);
+
+// --- Lado produtor ---------------------------------------------------------
+
+// Ponteiro para a posição de escrita atual (`head`).
+static inline uint16_t *sample_ring_write_ptr(sample_ring_t *ring) {
+    return &ring->buffer[ring->head & ring->mask];
+}
+
+// Publica `count` amostras já escritas a partir de `head`.
+void sample_ring_publish(sample_ring_t *ring, uint32_t count);
+
+// Escreve e publica uma única amostra (produtores por software).
+void sample_ring_push(sample_ring_t *ring, uint16_t value);
+
+// --- Lado consumidor -------------------------------------------------------
+
+// Número de amostras prontas para leitura. Descarta as mais antigas caso
+// o produtor tenha ultrapassado a capacidade útil do anel.
+uint32_t sample_ring_available(sample_ring_t *ring);
+
+// Copia até `max` amostras para `dst`, na ordem de captura.
+// Retorna o número de amostras copiadas.
+uint32_t sample_ring_read(sample_ring_t *ring, uint16_t *dst, uint32_t max);
+
+// Igual a `sample_ring_read`, informando também em `*first_index` o
+// índice absoluto (contador livre) da primeira amostra copiada. Saltos
+// nesse índice entre leituras indicam amostras descartadas.
+uint32_t sample_ring_read_indexed(sample_ring_t *ring, uint16_t *dst, uint32_t max, uint32_t *first_index);
+
+// Consome todas as amostras pendentes, mantendo apenas a mais recente
+// em `*latest`. Retorna quantas amostras foram consumidas (0 se vazio,
+// caso em que `*latest` não é alterado).
+uint32_t sample_ring_drain_latest(sample_ring_t *ring, uint16_t *latest);
+
+// Copia a amostra mais recente para `*latest` sem consumir nada.
+// Retorna o número de amostras pendentes (0 se vazio, caso em que
+// `*latest` não é alterado).
+uint32_t sample_ring_peek_latest(sample_ring_t *ring, uint16_t *latest);
+
+// Copia até `max` amostras para `dst` sem consumir nada, a partir do
+// índice absoluto `*index`, que é avançado. Serve a um segundo leitor
+// com cursor próprio (ex.: política de notificação), inclusive sobre
+// amostras já consumidas que ainda não foram sobrescritas. Se `*index`
+// ficou para trás da janela válida, salta para a amostra mais antiga
+// ainda disponível. Retorna o número de amostras copiadas.
+uint32_t sample_ring_peek_from(const sample_ring_t *ring, uint32_t *index, uint16_t *dst, uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,53 @@
+#include "ble_bench.h"
+
+#include <string.h>
+
+static void store_u32(uint8_t *buffer, uint32_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t read_u32(const uint8_t *buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) |
+           ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+void ble_bench_fill(uint8_t *buffer, uint16_t len, uint32_t seq, uint32_t sent_us) {
+    store_u32(buffer, seq);
+    store_u32(buffer + 4, sent_us);
+    for (uint16_t i = BLE_BENCH_HEADER_SIZE; i < len; i++) {
+        buffer[i] = (uint8_t)(seq + i);
+    }
+}
+
+int ble_bench_parse(const uint8_t *buffer, uint16_t len, uint32_t *seq, uint32_t *sent_us) {
+    if (len < BLE_BENCH_HEADER_SIZE) return -1;
+    uint32_t value = read_u32(buffer);
+    for (uint16_t i = BLE_BENCH_HEADER_SIZE; i < len; i++) {
+        if (buffer[i] != (uint8_t)(value + i)) return -2;
+    }
+    *seq = value;
+    *sent_us = read_u32(buffer + 4);
+    return 0;
+}
+
+void ble_bench_rx_reset(ble_bench_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+uint32_t ble_bench_rx_record(ble_bench_rx_t *rx, uint32_t seq, uint16_t len) {
+    uint32_t lost = 0;
+    if ((int32_t)(seq - rx->next_seq) < 0) {
+        // Atrasada ou repetida: já contada como perdida (ou recebida).
+        rx->reordered++;
+    } else {
+        lost = seq - rx->next_seq;
+        rx->next_seq = seq + 1;
+    }
+    rx->lost += lost;
+    rx->received++;
+    rx->bytes += len;
+    return lost;
+}
@@ -0,0 +1,63 @@
+#ifndef BLE_BENCH_H
+#define BLE_BENCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Carga sintética dos alvos de benchmark do enlace BLE
+// (`ble_bench_server` / `ble_bench_client`). Cada notificação leva:
+//
+//   [0..3]  número de sequência (uint32, little-endian), a partir de 0 a
+//           cada conexão;
+//   [4..7]  instante do envio no relógio do servidor (`time_us_32()`);
+//   [8..]   padrão derivado da sequência (byte i = seq + i), para
+//           detectar corrupção.
+//
+// O tamanho da carga é escolhido no build e limitado ao ATT MTU - 3.
+#define BLE_BENCH_HEADER_SIZE 8
+#define BLE_BENCH_MAX_PAYLOAD 244  // ATT MTU 247 - 3
+
+// UUIDs do serviço (8C4B0100-...) e da característica (8C4B0101-...) de
+// benchmark, em big-endian, como nas consultas GATT da BTstack; no
+// anúncio o UUID vai invertido (little-endian).
+#define BLE_BENCH_SERVICE_UUID128 \
+    0x8C, 0x4B, 0x01, 0x00, 0x2E, 0x57, 0x4A, 0x19, 0xB6, 0xD3, 0x71, 0xF0, 0xC9, 0x5A, 0x3E, 0x20
+#define BLE_BENCH_STREAM_UUID128 \
+    0x8C, 0x4B, 0x01, 0x01, 0x2E, 0x57, 0x4A, 0x19, 0xB6, 0xD3, 0x71, 0xF0, 0xC9, 0x5A, 0x3E, 0x20
+
+// Preenche `len` bytes (>= BLE_BENCH_HEADER_SIZE) de `buffer` com a carga
+// de número `seq`.
+void ble_bench_fill(uint8_t *buffer, uint16_t len, uint32_t seq, uint32_t sent_us);
+
+// Lê sequência e instante de envio de uma carga recebida.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - -1 se a carga for menor que o cabeçalho;
+//  - -2 se o padrão não corresponder à sequência (carga corrompida).
+int ble_bench_parse(const uint8_t *buffer, uint16_t len, uint32_t *seq, uint32_t *sent_us);
+
+// Contadores da recepção, acumulados desde `ble_bench_rx_reset`.
+typedef struct {
+    uint32_t next_seq;   // próxima sequência esperada
+    uint32_t received;   // cargas válidas
+    uint32_t bytes;      // bytes das cargas válidas
+    uint32_t lost;       // sequências que não chegaram
+    uint32_t reordered;  // sequências atrasadas ou repetidas
+    uint32_t corrupted;  // cargas recusadas por `ble_bench_parse`
+} ble_bench_rx_t;
+
+// Zera os contadores (a cada conexão).
+void ble_bench_rx_reset(ble_bench_rx_t *rx);
+
+// Registra uma carga válida de `len` bytes. Retorna quantas sequências
+// foram perdidas imediatamente antes dela.
+uint32_t ble_bench_rx_record(ble_bench_rx_t *rx, uint32_t seq, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLE_BENCH_H
@@ -0,0 +1,239 @@
+#include "flash_log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    put_u16(p, (uint16_t)value);
+    put_u16(p + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint32_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t sector_crc(const uint8_t *sector, uint16_t count) {
+    uint16_t crc = crc16_update(0xFFFF, sector, 22);
+    return crc16_update(crc, sector + FLASH_LOG_HEADER_SIZE, 2u * count);
+}
+
+// Valida o setor `sector` e extrai seu cabeçalho. Um setor apagado, com
+// gravação interrompida ou de outra configuração da região é rejeitado.
+static bool parse_sector(const flash_log_t *log, uint32_t sector, flash_log_record_t *record) {
+    const uint8_t *p = flash_log_port_sector(sector);
+    if (get_u32(p) != FLASH_LOG_MAGIC) return false;
+    record->seq = get_u32(p + 4);
+    record->first_index = get_u32(p + 8);
+    record->capture_us = get_u32(p + 12);
+    record->period_us = get_u32(p + 16);
+    record->count = get_u16(p + 20);
+    if (record->count == 0 || record->count > FLASH_LOG_RECORD_SAMPLES) return false;
+    if (record->seq % log->sectors != sector) return false;
+    return sector_crc(p, record->count) == get_u16(p + 22);
+}
+
+static void set_valid(flash_log_t *log, uint32_t sector, bool valid) {
+    uint8_t bit = (uint8_t)(1u << (sector & 7));
+    if (valid) {
+        log->valid[sector >> 3] |= bit;
+    } else {
+        log->valid[sector >> 3] &= (uint8_t)~bit;
+    }
+}
+
+static bool is_valid(const flash_log_t *log, uint32_t sector) {
+    return (log->valid[sector >> 3] >> (sector & 7)) & 1u;
+}
+
+static void reset_pending(flash_log_t *log) {
+    memset(&log->pending, 0, sizeof(log->pending));
+    log->pending.seq = log->head_seq;
+}
+
+// Grava o registro em montagem no setor `head_seq % sectors` e confere o
+// resultado relendo o setor. Um registro inteiramente liberado (ex.: já
+// baixado pelo cliente) é descartado sem gastar uma gravação.
+static int commit(flash_log_t *log) {
+    flash_log_record_t *pending = &log->pending;
+    if (pending->count == 0) return 0;
+    if (log->tail_seq == log->head_seq && log->tail_offset >= pending->count) {
+        log->tail_offset = 0;
+        reset_pending(log);
+        return 0;
+    }
+
+    uint8_t *p = log->buffer;
+    put_u32(p, FLASH_LOG_MAGIC);
+    put_u32(p + 4, pending->seq);
+    put_u32(p + 8, pending->first_index);
+    put_u32(p + 12, pending->capture_us);
+    put_u32(p + 16, pending->period_us);
+    put_u16(p + 20, pending->count);
+    put_u16(p + 22, sector_crc(p, pending->count));
+
+    uint32_t sector = pending->seq % log->sectors;
+    int status = flash_log_port_write(sector, p);
+    flash_log_record_t check;
+    bool ok = (status == 0) && parse_sector(log, sector, &check) && check.seq == pending->seq;
+    set_valid(log, sector, ok);
+    if (!ok) log->write_errors++;
+
+    log->committed++;
+    log->head_seq++;
+    if (log->head_seq - log->tail_seq > log->sectors) {
+        // Região cheia: o registro mais antigo acabou de ser sobrescrito.
+        uint32_t oldest = log->head_seq - log->sectors;
+        log->overwritten += oldest - log->tail_seq;
+        log->tail_seq = oldest;
+        log->tail_offset = 0;
+    }
+    reset_pending(log);
+    return ok ? 1 : -1;
+}
+
+int flash_log_init(flash_log_t *log, uint32_t sectors, uint32_t tail_seq, uint16_t tail_offset) {
+    if (log == NULL || sectors < 2 || sectors > FLASH_LOG_MAX_SECTORS) return -1;
+    memset(log, 0, sizeof(*log));
+    log->sectors = sectors;
+    if (flash_log_port_init(sectors) != 0) return -2;
+
+    bool found = false;
+    uint32_t max_seq = 0;
+    for (uint32_t sector = 0; sector < sectors; sector++) {
+        flash_log_record_t record;
+        if (!parse_sector(log, sector, &record)) {
+            if (get_u32(flash_log_port_sector(sector)) != 0xFFFFFFFFu) log->invalid++;
+            continue;
+        }
+        set_valid(log, sector, true);
+        if (!found || (int32_t)(record.seq - max_seq) > 0) max_seq = record.seq;
+        found = true;
+    }
+
+    log->head_seq = found ? max_seq + 1 : tail_seq;
+    if ((int32_t)(tail_seq - log->head_seq) > 0) log->head_seq = tail_seq;
+    uint32_t oldest = (log->head_seq > sectors) ? log->head_seq - sectors : 0;
+    if ((int32_t)(tail_seq - oldest) < 0) {
+        tail_seq = oldest;
+        tail_offset = 0;
+    }
+    if (tail_seq == log->head_seq) tail_offset = 0;
+    log->tail_seq = tail_seq;
+    log->tail_offset = tail_offset;
+    reset_pending(log);
+    return 0;
+}
+
+int flash_log_append(flash_log_t *log, uint32_t first_index, uint32_t capture_us, uint32_t period_us,
+                     const uint16_t *samples, uint32_t count) {
+    int written = 0;
+    bool failed = false;
+    while (count > 0) {
+        flash_log_record_t *pending = &log->pending;
+        if (pending->count != 0 &&
+            (first_index != pending->first_index + pending->count || period_us != pending->period_us)) {
+            int status = commit(log);
+            if (status < 0) failed = true;
+            if (status != 0) written++;
+        }
+        if (pending->count == 0) {
+            pending->first_index = first_index;
+            pending->capture_us = capture_us;
+            pending->period_us = period_us;
+        }
+
+        uint32_t n = FLASH_LOG_RECORD_SAMPLES - pending->count;
+        if (n > count) n = count;
+        uint8_t *p = log->buffer + FLASH_LOG_HEADER_SIZE + 2u * pending->count;
+        for (uint32_t i = 0; i < n; i++) {
+            put_u16(p + 2u * i, samples[i]);
+        }
+        pending->count = (uint16_t)(pending->count + n);
+        log->appended += n;
+        samples += n;
+        count -= n;
+        first_index += n;
+        capture_us += n * period_us;
+
+        if (pending->count == FLASH_LOG_RECORD_SAMPLES) {
+            int status = commit(log);
+            if (status < 0) failed = true;
+            if (status != 0) written++;
+        }
+    }
+    return failed ? -1 : written;
+}
+
+int flash_log_flush(flash_log_t *log) {
+    return commit(log);
+}
+
+int flash_log_read(const flash_log_t *log, uint32_t seq, flash_log_record_t *record, const uint8_t **samples) {
+    if ((int32_t)(seq - log->tail_seq) < 0 || (int32_t)(seq - log->head_seq) > 0) return -1;
+
+    if (seq == log->head_seq) {
+        *record = log->pending;
+        *samples = log->buffer + FLASH_LOG_HEADER_SIZE;
+    } else {
+        uint32_t sector = seq % log->sectors;
+        if (!is_valid(log, sector)) return -2;
+        const uint8_t *p = flash_log_port_sector(sector);
+        if (get_u32(p + 4) != seq) return -2;
+        record->seq = seq;
+        record->first_index = get_u32(p + 8);
+        record->capture_us = get_u32(p + 12);
+        record->period_us = get_u32(p + 16);
+        record->count = get_u16(p + 20);
+        *samples = p + FLASH_LOG_HEADER_SIZE;
+    }
+
+    if (seq == log->tail_seq && log->tail_offset != 0) {
+        uint16_t skip = (log->tail_offset < record->count) ? log->tail_offset : record->count;
+        record->first_index += skip;
+        record->capture_us += skip * record->period_us;
+        record->count = (uint16_t)(record->count - skip);
+        *samples += 2u * skip;
+    }
+    return 0;
+}
+
+bool flash_log_release(flash_log_t *log, uint32_t seq, uint16_t offset) {
+    if ((int32_t)(seq - log->head_seq) > 0) {
+        seq = log->head_seq;
+        offset = log->pending.count;
+    }
+    if ((int32_t)(seq - log->tail_seq) < 0) return false;
+    if (seq == log->tail_seq && offset <= log->tail_offset) return false;
+    log->tail_seq = seq;
+    log->tail_offset = offset;
+    return true;
+}
+
+uint32_t flash_log_pending_samples(const flash_log_t *log) {
+    uint32_t total = 0;
+    for (uint32_t seq = log->tail_seq; seq != log->head_seq + 1; seq++) {
+        flash_log_record_t record;
+        const uint8_t *samples;
+        if (flash_log_read(log, seq, &record, &samples) == 0) total += record.count;
+    }
+    return total;
+}
@@ -0,0 +1,129 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Registro circular de amostras em flash ("store-and-forward").
+//
+// A região é dividida em setores de 4 KB; cada setor guarda um registro:
+// um cabeçalho e até FLASH_LOG_RECORD_SAMPLES amostras consecutivas de
+// 16 bits. As amostras se acumulam num registro em montagem na RAM e só
+// vão para a flash quando ele enche (ou quando o fluxo tem uma
+// descontinuidade), um setor por vez: um apagamento e uma gravação, de
+// modo que cada parada do XIP é limitada a um setor.
+//
+// Cada registro recebe um número de sequência crescente e ocupa o setor
+// `seq % sectors`: a região é usada em círculo, o que distribui o
+// desgaste igualmente entre os setores. Quando a região enche, o registro
+// mais antigo é sobrescrito.
+//
+// O cabeçalho e as amostras são protegidos por um CRC. Na inicialização
+// a região é varrida e os setores com CRC inválido (gravação interrompida
+// por falta de energia) são ignorados; o próximo número de sequência é
+// recuperado a partir do maior registro válido. Uma falta de energia perde
+// no máximo o registro em montagem na RAM, além do setor que estava sendo
+// gravado.
+//
+// Formato do setor (little endian):
+//  bytes 0..3   : FLASH_LOG_MAGIC
+//  bytes 4..7   : seq
+//  bytes 8..11  : índice da primeira amostra
+//  bytes 12..15 : instante de captura da primeira amostra (us)
+//  bytes 16..19 : período entre amostras (us)
+//  bytes 20..21 : número de amostras
+//  bytes 22..23 : CRC-16/CCITT dos bytes 0..21 e das amostras
+//  bytes 24..   : amostras (uint16)
+
+#define FLASH_LOG_SECTOR_SIZE 4096u
+#define FLASH_LOG_HEADER_SIZE 24u
+#define FLASH_LOG_RECORD_SAMPLES ((FLASH_LOG_SECTOR_SIZE - FLASH_LOG_HEADER_SIZE) / 2u)
+#define FLASH_LOG_MAGIC 0x474F4C53u  // "SLOG"
+
+// Maior número de setores da região (limite do mapa de validade).
+#define FLASH_LOG_MAX_SECTORS 256u
+
+typedef struct {
+    uint32_t seq;          // número de sequência
+    uint32_t first_index;  // índice da primeira amostra (contador livre)
+    uint32_t capture_us;   // instante de captura da primeira amostra
+    uint32_t period_us;    // período entre amostras
+    uint16_t count;        // número de amostras
+} flash_log_record_t;
+
+typedef struct {
+    uint32_t sectors;     // setores da região
+    uint32_t head_seq;    // seq do registro em montagem (próximo a gravar)
+    uint32_t tail_seq;    // registro mais antigo ainda não liberado (nunca
+                          // mais de `sectors` atrás de `head_seq`)
+    uint16_t tail_offset; // amostras já liberadas do registro `tail_seq`
+    uint8_t valid[FLASH_LOG_MAX_SECTORS / 8];  // setores com registro íntegro
+
+    // Registro em montagem: cabeçalho e amostras já no formato do setor.
+    flash_log_record_t pending;
+    uint8_t buffer[FLASH_LOG_SECTOR_SIZE];
+
+    uint32_t appended;     // amostras recebidas
+    uint32_t committed;    // registros gravados
+    uint32_t overwritten;  // registros não liberados sobrescritos (região cheia)
+    uint32_t invalid;      // setores inválidos encontrados na varredura
+    uint32_t write_errors; // gravações que falharam na verificação
+} flash_log_t;
+
+// Prepara a região de `sectors` setores e recupera os registros já
+// gravados. `tail_seq`/`tail_offset` são a posição liberada salva pela
+// aplicação (ex.: no TLV); valores fora da janela de registros válidos
+// são ajustados. Retorna 0, ou valor negativo se a região não puder ser
+// usada.
+int flash_log_init(flash_log_t *log, uint32_t sectors, uint32_t tail_seq, uint16_t tail_offset);
+
+// Acrescenta `count` amostras consecutivas, a primeira com índice
+// `first_index` e capturada em `capture_us`, espaçadas de `period_us`.
+// Uma descontinuidade (índice ou período diferente do esperado) fecha o
+// registro em montagem. Cada registro cheio é gravado na flash. Retorna
+// o número de setores gravados, ou valor negativo se uma gravação falhou.
+int flash_log_append(flash_log_t *log, uint32_t first_index, uint32_t capture_us, uint32_t period_us,
+                     const uint16_t *samples, uint32_t count);
+
+// Grava o registro em montagem, mesmo incompleto. Retorna 1 se gravou,
+// 0 se não havia amostras, ou valor negativo em caso de falha.
+int flash_log_flush(flash_log_t *log);
+
+// Lê o registro `seq` (o em montagem, se `seq == head_seq`): o cabeçalho
+// em `*record` e, em `*samples`, um ponteiro para as amostras (uint16
+// little endian, direto na flash ou no buffer em RAM). A janela vai de
+// `tail_seq` a `head_seq`; amostras já liberadas do registro `tail_seq`
+// são omitidas. Retorna 0, -1 se `seq` está fora da janela, ou -2 se o
+// setor está inválido.
+int flash_log_read(const flash_log_t *log, uint32_t seq, flash_log_record_t *record, const uint8_t **samples);
+
+// Libera tudo o que vem antes da amostra `offset` do registro `seq`
+// (ex.: após o cliente confirmar o download). Retorna true se a posição
+// liberada avançou.
+bool flash_log_release(flash_log_t *log, uint32_t seq, uint16_t offset);
+
+// Amostras ainda não liberadas (na flash e em montagem).
+uint32_t flash_log_pending_samples(const flash_log_t *log);
+
+// --- Porta da flash (flash_log_pico.c ou flash_log_host.c) -----------------
+
+// Prepara a região de `sectors` setores. Retorna 0, ou valor negativo se
+// ela não couber.
+int flash_log_port_init(uint32_t sectors);
+
+// Conteúdo do setor `sector` (leitura direta; XIP no RP2040).
+const uint8_t *flash_log_port_sector(uint32_t sector);
+
+// Apaga e grava o setor `sector` com `data` (FLASH_LOG_SECTOR_SIZE
+// bytes). Retorna 0, ou valor negativo em caso de falha.
+int flash_log_port_write(uint32_t sector, const uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_LOG_H
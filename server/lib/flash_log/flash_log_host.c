@@ -0,0 +1,70 @@
+// Flash simulada em RAM para o build de host (PICO_NO_HARDWARE).
+//
+// Reproduz o comportamento da NOR: o apagamento leva o setor a 0xFF e a
+// programação só zera bits (AND com o conteúdo atual). Uma falha pode ser
+// injetada no meio de uma gravação com `flash_log_host_fail_after`,
+// deixando o setor parcialmente apagado ou programado, como após uma
+// falta de energia.
+
+#include "flash_log.h"
+#include "flash_log_host.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+static uint8_t memory[FLASH_LOG_MAX_SECTORS][FLASH_LOG_SECTOR_SIZE];
+static uint32_t erase_count[FLASH_LOG_MAX_SECTORS];
+static uint32_t region_sectors;
+static bool memory_ready;
+static bool fail_armed;
+static uint32_t fail_bytes;
+
+void flash_log_host_erase_all(void) {
+    memset(memory, 0xFF, sizeof(memory));
+    memset(erase_count, 0, sizeof(erase_count));
+    memory_ready = true;
+}
+
+void flash_log_host_fail_after(uint32_t bytes) {
+    fail_armed = true;
+    fail_bytes = bytes;
+}
+
+uint32_t flash_log_host_erase_count(uint32_t sector) {
+    return (sector < FLASH_LOG_MAX_SECTORS) ? erase_count[sector] : 0;
+}
+
+int flash_log_port_init(uint32_t sectors) {
+    if (sectors > FLASH_LOG_MAX_SECTORS) return -1;
+    if (!memory_ready) flash_log_host_erase_all();
+    region_sectors = sectors;
+    return 0;
+}
+
+const uint8_t *flash_log_port_sector(uint32_t sector) {
+    return memory[sector];
+}
+
+int flash_log_port_write(uint32_t sector, const uint8_t *data) {
+    if (sector >= region_sectors) return -1;
+    uint8_t *p = memory[sector];
+    uint32_t limit = 2u * FLASH_LOG_SECTOR_SIZE;
+    if (fail_armed) {
+        limit = fail_bytes;
+        fail_armed = false;
+    }
+
+    uint32_t erase = (limit < FLASH_LOG_SECTOR_SIZE) ? limit : FLASH_LOG_SECTOR_SIZE;
+    if (erase == 0) return -1;
+    memset(p, 0xFF, erase);
+    erase_count[sector]++;
+    if (erase < FLASH_LOG_SECTOR_SIZE) return -1;
+
+    uint32_t program = limit - FLASH_LOG_SECTOR_SIZE;
+    if (program > FLASH_LOG_SECTOR_SIZE) program = FLASH_LOG_SECTOR_SIZE;
+    for (uint32_t i = 0; i < program; i++) {
+        p[i] &= data[i];
+    }
+    return (program < FLASH_LOG_SECTOR_SIZE) ? -1 : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef FLASH_LOG_HOST_H
+#define FLASH_LOG_HOST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Controle da flash simulada do build de host (flash_log_host.c).
+//
+// A memória simulada sobrevive a uma nova chamada de `flash_log_init`,
+// o que equivale a reiniciar a placa sem perder a flash.
+
+// Apaga toda a região simulada (0xFF), como uma flash nova.
+void flash_log_host_erase_all(void);
+
+// Interrompe a próxima gravação depois de `bytes` bytes de progresso,
+// simulando uma falta de energia: de 0 a FLASH_LOG_SECTOR_SIZE, durante
+// o apagamento; acima disso, durante a programação. O setor fica como
+// estava no instante da falha e a gravação retorna erro.
+void flash_log_host_fail_after(uint32_t bytes);
+
+// Número de apagamentos do setor `sector` (desgaste).
+uint32_t flash_log_host_erase_count(uint32_t sector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_LOG_HOST_H
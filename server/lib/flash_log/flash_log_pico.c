@@ -0,0 +1,65 @@
+// Porta da flash do RP2040 para o registro de amostras.
+//
+// A região fica logo abaixo do banco TLV da BTstack, no fim da flash, e
+// é lida diretamente pelo XIP. Cada gravação apaga e programa um único
+// setor dentro de `flash_safe_execute`, que desliga as interrupções e
+// pausa o outro núcleo (se ele chamou `multicore_lockout_victim_init`)
+// enquanto o XIP está indisponível.
+
+#include "flash_log.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/stdlib.h"
+
+// Mesmo padrão de pico/btstack_flash_bank.h: o banco TLV ocupa os dois
+// últimos setores da flash.
+#ifndef PICO_FLASH_BANK_TOTAL_SIZE
+#define PICO_FLASH_BANK_TOTAL_SIZE (FLASH_SECTOR_SIZE * 2u)
+#endif
+
+#ifndef PICO_FLASH_BANK_STORAGE_OFFSET
+#define PICO_FLASH_BANK_STORAGE_OFFSET (PICO_FLASH_SIZE_BYTES - PICO_FLASH_BANK_TOTAL_SIZE)
+#endif
+
+// Tempo máximo para pausar o outro núcleo antes de desistir da gravação.
+#ifndef FLASH_LOG_SAFE_TIMEOUT_MS
+#define FLASH_LOG_SAFE_TIMEOUT_MS 100
+#endif
+
+extern char __flash_binary_end;
+
+static uint32_t region_offset;
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;
+} sector_write_t;
+
+static void __not_in_flash_func(write_sector)(void *param) {
+    const sector_write_t *write = (const sector_write_t *)param;
+    flash_range_erase(write->offset, FLASH_SECTOR_SIZE);
+    flash_range_program(write->offset, write->data, FLASH_SECTOR_SIZE);
+}
+
+int flash_log_port_init(uint32_t sectors) {
+    static_assert(FLASH_LOG_SECTOR_SIZE == FLASH_SECTOR_SIZE, "setor do registro difere do setor da flash");
+    uint32_t size = sectors * FLASH_SECTOR_SIZE;
+    if (size > PICO_FLASH_BANK_STORAGE_OFFSET) return -1;
+    region_offset = PICO_FLASH_BANK_STORAGE_OFFSET - size;
+    // A região não pode invadir o firmware.
+    if ((uintptr_t)&__flash_binary_end - XIP_BASE > region_offset) return -2;
+    return 0;
+}
+
+const uint8_t *flash_log_port_sector(uint32_t sector) {
+    return (const uint8_t *)(XIP_BASE + region_offset + sector * FLASH_SECTOR_SIZE);
+}
+
+int flash_log_port_write(uint32_t sector, const uint8_t *data) {
+    sector_write_t write = { region_offset + sector * FLASH_SECTOR_SIZE, data };
+    return (flash_safe_execute(write_sector, &write, FLASH_LOG_SAFE_TIMEOUT_MS) == PICO_OK) ? 0 : -1;
+}
@@ -0,0 +1,883 @@
+// Controlador BLE virtual para o build de host (ver hci_transport_virtual.h).
+//
+// O controlador fica inteiro neste arquivo: os comandos HCI enviados pela
+// BTstack são tratados em `vhci_handle_command`, e os eventos e pacotes
+// ACL destinados à pilha vão para uma fila entregue por um timer do run
+// loop, como faria um transporte real (nunca de forma reentrante dentro
+// de `send_packet`).
+//
+// Mensagens do ar virtual (um datagrama por mensagem):
+//   [tipo][endereço de origem (6)][dados do tipo]
+// Endereços são guardados em `bd_addr_t` (ordem legível) e invertidos
+// apenas ao montar os pacotes HCI.
+
+#include "hci_transport_virtual.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "bluetooth.h"
+
+// Opcodes HCI tratados pelo controlador (OGF << 10 | OCF).
+#define VHCI_OP_DISCONNECT                      0x0406
+#define VHCI_OP_SET_EVENT_MASK                  0x0C01
+#define VHCI_OP_RESET                           0x0C03
+#define VHCI_OP_READ_LOCAL_NAME                 0x0C14
+#define VHCI_OP_SET_CONTROLLER_TO_HOST_FLOW     0x0C31
+#define VHCI_OP_HOST_BUFFER_SIZE                0x0C33
+#define VHCI_OP_HOST_NUM_COMPLETED_PACKETS      0x0C35
+#define VHCI_OP_WRITE_LE_HOST_SUPPORTED         0x0C6D
+#define VHCI_OP_READ_LOCAL_VERSION              0x1001
+#define VHCI_OP_READ_LOCAL_COMMANDS             0x1002
+#define VHCI_OP_READ_LOCAL_FEATURES             0x1003
+#define VHCI_OP_READ_BUFFER_SIZE                0x1005
+#define VHCI_OP_READ_BD_ADDR                    0x1009
+#define VHCI_OP_READ_RSSI                       0x1405
+#define VHCI_OP_LE_SET_EVENT_MASK               0x2001
+#define VHCI_OP_LE_READ_BUFFER_SIZE             0x2002
+#define VHCI_OP_LE_READ_LOCAL_FEATURES          0x2003
+#define VHCI_OP_LE_SET_RANDOM_ADDRESS           0x2005
+#define VHCI_OP_LE_SET_ADV_PARAMETERS           0x2006
+#define VHCI_OP_LE_SET_ADV_DATA                 0x2008
+#define VHCI_OP_LE_SET_SCAN_RESPONSE_DATA       0x2009
+#define VHCI_OP_LE_SET_ADV_ENABLE               0x200A
+#define VHCI_OP_LE_SET_SCAN_PARAMETERS          0x200B
+#define VHCI_OP_LE_SET_SCAN_ENABLE              0x200C
+#define VHCI_OP_LE_CREATE_CONNECTION            0x200D
+#define VHCI_OP_LE_CREATE_CONNECTION_CANCEL     0x200E
+#define VHCI_OP_LE_READ_ACCEPT_LIST_SIZE        0x200F
+#define VHCI_OP_LE_CLEAR_ACCEPT_LIST            0x2010
+#define VHCI_OP_LE_ADD_TO_ACCEPT_LIST           0x2011
+#define VHCI_OP_LE_REMOVE_FROM_ACCEPT_LIST      0x2012
+#define VHCI_OP_LE_CONNECTION_UPDATE            0x2013
+#define VHCI_OP_LE_READ_REMOTE_FEATURES         0x2016
+#define VHCI_OP_LE_RAND                         0x2018
+#define VHCI_OP_LE_READ_SUPPORTED_STATES        0x201C
+#define VHCI_OP_LE_SET_PHY                      0x2032
+
+// Códigos de status/motivo HCI usados.
+#define VHCI_STATUS_SUCCESS                     0x00
+#define VHCI_STATUS_UNKNOWN_COMMAND             0x01
+#define VHCI_STATUS_UNKNOWN_CONNECTION          0x02
+#define VHCI_STATUS_CONNECTION_TIMEOUT          0x08
+#define VHCI_STATUS_CONNECTION_LIMIT            0x09
+#define VHCI_STATUS_COMMAND_DISALLOWED          0x0C
+#define VHCI_REASON_LOCAL_HOST_TERMINATED       0x16
+
+// Capacidade do controlador virtual.
+#define VHCI_MAX_CONNECTIONS    4
+#define VHCI_ACL_BUFFER_LEN     251
+#define VHCI_ACL_BUFFER_NUM     8
+#define VHCI_QUEUE_SIZE         32
+#define VHCI_MAX_PACKET         (4 + VHCI_ACL_BUFFER_LEN)
+#define VHCI_FIRST_HANDLE       0x0040
+#define VHCI_RSSI               (-40)
+
+// Tipos de mensagem do ar virtual.
+typedef enum {
+    AIR_ADV = 1,         // [tipo adv][len][31 bytes][len scan rsp][31 bytes]
+    AIR_CONNECT,         // [intervalo u16][latência u16][timeout u16]
+    AIR_CONNECT_ACK,     // idem
+    AIR_ACL,             // [flags u8][len u16][dados]
+    AIR_DISCONNECT,      // [motivo]
+    AIR_CONN_UPDATE,     // [intervalo u16][latência u16][timeout u16]
+} air_type_t;
+
+#define AIR_HEADER_SIZE 7
+#define AIR_MAX_MESSAGE (AIR_HEADER_SIZE + 3 + VHCI_ACL_BUFFER_LEN)
+
+typedef struct {
+    uint8_t type;
+    uint16_t len;
+    uint8_t data[VHCI_MAX_PACKET];
+} vhci_packet_t;
+
+typedef struct {
+    int active;
+    hci_con_handle_t handle;
+    bd_addr_t peer;
+    uint8_t role;        // 0 = central, 1 = periférico
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+} vhci_connection_t;
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// Fila de pacotes para a pilha e timer que a esvazia.
+static vhci_packet_t queue[VHCI_QUEUE_SIZE];
+static uint32_t queue_head;
+static uint32_t queue_tail;
+static btstack_timer_source_t queue_timer;
+static int queue_timer_active;
+
+// Ar virtual.
+static int air_fd = -1;
+static char air_dir[96];
+static char air_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static btstack_data_source_t air_source;
+static bd_addr_t local_addr;
+
+// Advertising.
+static int adv_enabled;
+static uint8_t adv_type;
+static uint16_t adv_interval;
+static uint8_t adv_data[31];
+static uint8_t adv_data_len;
+static uint8_t scan_rsp_data[31];
+static uint8_t scan_rsp_len;
+static btstack_timer_source_t adv_timer;
+
+// Scan e conexão em andamento (central).
+static int scan_enabled;
+static uint8_t scan_type;
+static int connect_pending;
+static bd_addr_t connect_peer;
+static uint16_t connect_interval;
+static uint16_t connect_latency;
+static uint16_t connect_timeout;
+
+static vhci_connection_t connections[VHCI_MAX_CONNECTIONS];
+static hci_con_handle_t next_handle = VHCI_FIRST_HANDLE;
+
+////////////////////////////////////////////////////////////////////////////////
+// Fila de entrega para a BTstack
+
+static void queue_timer_handler(btstack_timer_source_t *ts) {
+    UNUSED(ts);
+    queue_timer_active = 0;
+    static vhci_packet_t packet;
+    while (queue_tail != queue_head) {
+        // Copia antes de entregar: o handler pode enfileirar novos pacotes.
+        packet = queue[queue_tail % VHCI_QUEUE_SIZE];
+        queue_tail++;
+        if (packet_handler) packet_handler(packet.type, packet.data, packet.len);
+    }
+}
+
+static uint8_t *queue_reserve(uint8_t type, uint16_t len) {
+    if (queue_head - queue_tail >= VHCI_QUEUE_SIZE) {
+        log_error("vhci: fila cheia, pacote tipo %u descartado", type);
+        return NULL;
+    }
+    vhci_packet_t *p = &queue[queue_head % VHCI_QUEUE_SIZE];
+    queue_head++;
+    p->type = type;
+    p->len = len;
+    memset(p->data, 0, len);
+
+    if (!queue_timer_active) {
+        queue_timer_active = 1;
+        btstack_run_loop_set_timer_handler(&queue_timer, &queue_timer_handler);
+        btstack_run_loop_set_timer(&queue_timer, 0);
+        btstack_run_loop_add_timer(&queue_timer);
+    }
+    return p->data;
+}
+
+// Reserva um evento HCI com `params` bytes de parâmetros.
+static uint8_t *event_reserve(uint8_t event, uint8_t params) {
+    uint8_t *e = queue_reserve(HCI_EVENT_PACKET, (uint16_t)(2 + params));
+    if (!e) return NULL;
+    e[0] = event;
+    e[1] = params;
+    return e + 2;
+}
+
+static uint8_t *command_complete(uint16_t opcode, uint8_t status, uint8_t return_len) {
+    uint8_t *p = event_reserve(HCI_EVENT_COMMAND_COMPLETE, (uint8_t)(3 + 1 + return_len));
+    if (!p) return NULL;
+    p[0] = 1;  // num_hci_command_packets
+    little_endian_store_16(p, 1, opcode);
+    p[3] = status;
+    return p + 4;
+}
+
+static void command_status(uint16_t opcode, uint8_t status) {
+    uint8_t *p = event_reserve(HCI_EVENT_COMMAND_STATUS, 4);
+    if (!p) return;
+    p[0] = status;
+    p[1] = 1;
+    little_endian_store_16(p, 2, opcode);
+}
+
+static uint8_t *le_meta_event(uint8_t subevent, uint8_t params) {
+    uint8_t *p = event_reserve(HCI_EVENT_LE_META, (uint8_t)(1 + params));
+    if (!p) return NULL;
+    p[0] = subevent;
+    return p + 1;
+}
+
+static void emit_connection_complete(uint8_t status, const vhci_connection_t *c, const bd_addr_t peer, uint8_t role) {
+    uint8_t *p = le_meta_event(HCI_SUBEVENT_LE_CONNECTION_COMPLETE, 18);
+    if (!p) return;
+    p[0] = status;
+    little_endian_store_16(p, 1, c ? c->handle : 0);
+    p[3] = role;
+    p[4] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(peer, &p[5]);
+    little_endian_store_16(p, 11, c ? c->interval : 0);
+    little_endian_store_16(p, 13, c ? c->latency : 0);
+    little_endian_store_16(p, 15, c ? c->timeout : 0);
+    p[17] = 0;  // precisão do relógio
+}
+
+static void emit_connection_update_complete(const vhci_connection_t *c) {
+    uint8_t *p = le_meta_event(HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE, 9);
+    if (!p) return;
+    p[0] = VHCI_STATUS_SUCCESS;
+    little_endian_store_16(p, 1, c->handle);
+    little_endian_store_16(p, 3, c->interval);
+    little_endian_store_16(p, 5, c->latency);
+    little_endian_store_16(p, 7, c->timeout);
+}
+
+static void emit_disconnection_complete(hci_con_handle_t handle, uint8_t reason) {
+    uint8_t *p = event_reserve(HCI_EVENT_DISCONNECTION_COMPLETE, 4);
+    if (!p) return;
+    p[0] = VHCI_STATUS_SUCCESS;
+    little_endian_store_16(p, 1, handle);
+    p[3] = reason;
+}
+
+static void emit_completed_packets(hci_con_handle_t handle) {
+    uint8_t *p = event_reserve(HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5);
+    if (!p) return;
+    p[0] = 1;
+    little_endian_store_16(p, 1, handle);
+    little_endian_store_16(p, 3, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Conexões
+
+static vhci_connection_t *connection_for_handle(hci_con_handle_t handle) {
+    for (int i = 0; i < VHCI_MAX_CONNECTIONS; i++) {
+        if (connections[i].active && connections[i].handle == handle) return &connections[i];
+    }
+    return NULL;
+}
+
+static vhci_connection_t *connection_for_peer(const bd_addr_t peer) {
+    for (int i = 0; i < VHCI_MAX_CONNECTIONS; i++) {
+        if (connections[i].active && bd_addr_cmp(connections[i].peer, peer) == 0) return &connections[i];
+    }
+    return NULL;
+}
+
+static vhci_connection_t *connection_add(const bd_addr_t peer, uint8_t role,
+                                         uint16_t interval, uint16_t latency, uint16_t timeout) {
+    for (int i = 0; i < VHCI_MAX_CONNECTIONS; i++) {
+        vhci_connection_t *c = &connections[i];
+        if (c->active) continue;
+        c->active = 1;
+        c->handle = next_handle;
+        if (++next_handle > 0x0EFF) next_handle = VHCI_FIRST_HANDLE;
+        bd_addr_copy(c->peer, peer);
+        c->role = role;
+        c->interval = interval;
+        c->latency = latency;
+        c->timeout = timeout;
+        return c;
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Ar virtual
+
+static void air_path_for(char *out, size_t size, const bd_addr_t addr) {
+    snprintf(out, size, "%s/%02X%02X%02X%02X%02X%02X", air_dir,
+             addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+}
+
+static uint8_t *air_begin(uint8_t *msg, air_type_t type) {
+    msg[0] = (uint8_t)type;
+    bd_addr_copy(&msg[1], local_addr);
+    return msg + AIR_HEADER_SIZE;
+}
+
+static int air_send_to_path(const char *path, const uint8_t *msg, size_t len) {
+    struct sockaddr_un to;
+    memset(&to, 0, sizeof to);
+    to.sun_family = AF_UNIX;
+    strncpy(to.sun_path, path, sizeof to.sun_path - 1);
+    return (int)sendto(air_fd, msg, len, 0, (struct sockaddr *)&to, sizeof to);
+}
+
+static int air_send(const bd_addr_t peer, const uint8_t *msg, size_t len) {
+    char path[sizeof air_path];
+    air_path_for(path, sizeof path, peer);
+    return air_send_to_path(path, msg, len);
+}
+
+// Envia `msg` para todos os dispositivos presentes no ar, exceto este.
+static void air_broadcast(const uint8_t *msg, size_t len) {
+    DIR *dir = opendir(air_dir);
+    if (!dir) return;
+    struct dirent *entry;
+    char path[sizeof air_path];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof path, "%s/%s", air_dir, entry->d_name);
+        if (strcmp(path, air_path) == 0) continue;
+        air_send_to_path(path, msg, len);
+    }
+    closedir(dir);
+}
+
+static void air_send_params(const bd_addr_t peer, air_type_t type, const vhci_connection_t *c) {
+    uint8_t msg[AIR_HEADER_SIZE + 6];
+    uint8_t *p = air_begin(msg, type);
+    little_endian_store_16(p, 0, c->interval);
+    little_endian_store_16(p, 2, c->latency);
+    little_endian_store_16(p, 4, c->timeout);
+    air_send(peer, msg, sizeof msg);
+}
+
+static void air_send_disconnect(const bd_addr_t peer, uint8_t reason) {
+    uint8_t msg[AIR_HEADER_SIZE + 1];
+    uint8_t *p = air_begin(msg, AIR_DISCONNECT);
+    p[0] = reason;
+    air_send(peer, msg, sizeof msg);
+}
+
+static void adv_timer_handler(btstack_timer_source_t *ts) {
+    if (!adv_enabled) return;
+
+    uint8_t msg[AIR_HEADER_SIZE + 2 + 31 + 1 + 31];
+    uint8_t *p = air_begin(msg, AIR_ADV);
+    p[0] = adv_type;
+    p[1] = adv_data_len;
+    memcpy(&p[2], adv_data, sizeof adv_data);
+    p[33] = scan_rsp_len;
+    memcpy(&p[34], scan_rsp_data, sizeof scan_rsp_data);
+    air_broadcast(msg, sizeof msg);
+
+    // Intervalo em unidades de 0,625 ms, com mínimo de 20 ms.
+    uint32_t interval_ms = ((uint32_t)adv_interval * 5u) / 8u;
+    if (interval_ms < 20) interval_ms = 20;
+    btstack_run_loop_set_timer(ts, interval_ms);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void adv_set_enabled(int enable) {
+    btstack_run_loop_remove_timer(&adv_timer);
+    adv_enabled = enable;
+    if (!enable) return;
+    btstack_run_loop_set_timer_handler(&adv_timer, &adv_timer_handler);
+    btstack_run_loop_set_timer(&adv_timer, 0);
+    btstack_run_loop_add_timer(&adv_timer);
+}
+
+static void emit_advertising_report(const bd_addr_t addr, uint8_t event_type, const uint8_t *data, uint8_t len) {
+    uint8_t *p = le_meta_event(HCI_SUBEVENT_LE_ADVERTISING_REPORT, (uint8_t)(11 + len));
+    if (!p) return;
+    p[0] = 1;  // número de relatórios
+    p[1] = event_type;
+    p[2] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(addr, &p[3]);
+    p[9] = len;
+    memcpy(&p[10], data, len);
+    p[10 + len] = (uint8_t)VHCI_RSSI;
+}
+
+static void air_handle_adv(const bd_addr_t src, const uint8_t *p, size_t len) {
+    if (len < 2 + 31 + 1 + 31) return;
+    uint8_t type = p[0];
+    uint8_t data_len = p[1] > 31 ? 31 : p[1];
+    uint8_t rsp_len = p[33] > 31 ? 31 : p[33];
+    int connectable = (type == 0 || type == 1);
+
+    // Conexão pendente com este anunciante: pede a conexão.
+    if (connect_pending && connectable && bd_addr_cmp(connect_peer, src) == 0) {
+        uint8_t msg[AIR_HEADER_SIZE + 6];
+        uint8_t *q = air_begin(msg, AIR_CONNECT);
+        little_endian_store_16(q, 0, connect_interval);
+        little_endian_store_16(q, 2, connect_latency);
+        little_endian_store_16(q, 4, connect_timeout);
+        air_send(src, msg, sizeof msg);
+    }
+
+    if (!scan_enabled) return;
+    emit_advertising_report(src, type, &p[2], data_len);
+    // Scan ativo: o anunciante "responde" com os dados de scan response.
+    if (scan_type == 1 && rsp_len > 0 && (type == 0 || type == 2)) {
+        emit_advertising_report(src, 4, &p[34], rsp_len);
+    }
+}
+
+static void air_handle_connect(const bd_addr_t src, const uint8_t *p, size_t len) {
+    if (len < 6) return;
+    if (!adv_enabled || !(adv_type == 0 || adv_type == 1)) return;
+    if (connection_for_peer(src)) return;
+
+    vhci_connection_t *c = connection_add(src, 1, little_endian_read_16(p, 0),
+                                          little_endian_read_16(p, 2), little_endian_read_16(p, 4));
+    if (!c) return;
+    // Como num controlador real, o advertising para ao conectar.
+    adv_set_enabled(0);
+    emit_connection_complete(VHCI_STATUS_SUCCESS, c, src, 1);
+    air_send_params(src, AIR_CONNECT_ACK, c);
+}
+
+static void air_handle_connect_ack(const bd_addr_t src, const uint8_t *p, size_t len) {
+    if (len < 6) return;
+    if (!connect_pending || bd_addr_cmp(connect_peer, src) != 0) {
+        // Conexão cancelada enquanto o periférico aceitava.
+        air_send_disconnect(src, VHCI_REASON_LOCAL_HOST_TERMINATED);
+        return;
+    }
+    connect_pending = 0;
+    vhci_connection_t *c = connection_add(src, 0, little_endian_read_16(p, 0),
+                                          little_endian_read_16(p, 2), little_endian_read_16(p, 4));
+    if (!c) {
+        air_send_disconnect(src, VHCI_STATUS_CONNECTION_LIMIT);
+        emit_connection_complete(VHCI_STATUS_CONNECTION_LIMIT, NULL, src, 0);
+        return;
+    }
+    emit_connection_complete(VHCI_STATUS_SUCCESS, c, src, 0);
+}
+
+static void air_handle_acl(const bd_addr_t src, const uint8_t *p, size_t len) {
+    vhci_connection_t *c = connection_for_peer(src);
+    if (!c || len < 3) return;
+    uint16_t acl_len = little_endian_read_16(p, 1);
+    if (acl_len > VHCI_ACL_BUFFER_LEN || len < 3u + acl_len) return;
+
+    // Do controlador para o host, o início de um pacote L2CAP é marcado
+    // como "first automatically flushable" (0b10).
+    uint8_t pb = p[0] & 0x03;
+    if (pb == 0x00) pb = 0x02;
+
+    uint8_t *acl = queue_reserve(HCI_ACL_DATA_PACKET, (uint16_t)(4 + acl_len));
+    if (!acl) return;
+    little_endian_store_16(acl, 0, (uint16_t)(c->handle | (pb << 12)));
+    little_endian_store_16(acl, 2, acl_len);
+    memcpy(&acl[4], &p[3], acl_len);
+}
+
+static void air_handle_disconnect(const bd_addr_t src, const uint8_t *p, size_t len) {
+    vhci_connection_t *c = connection_for_peer(src);
+    if (!c) return;
+    c->active = 0;
+    emit_disconnection_complete(c->handle, len > 0 ? p[0] : VHCI_STATUS_CONNECTION_TIMEOUT);
+}
+
+static void air_handle_conn_update(const bd_addr_t src, const uint8_t *p, size_t len) {
+    vhci_connection_t *c = connection_for_peer(src);
+    if (!c || len < 6) return;
+    c->interval = little_endian_read_16(p, 0);
+    c->latency = little_endian_read_16(p, 2);
+    c->timeout = little_endian_read_16(p, 4);
+    emit_connection_update_complete(c);
+}
+
+static void air_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
+    UNUSED(ds);
+    if (callback_type != DATA_SOURCE_CALLBACK_READ) return;
+
+    uint8_t msg[AIR_MAX_MESSAGE];
+    ssize_t n;
+    while ((n = recv(air_fd, msg, sizeof msg, 0)) >= AIR_HEADER_SIZE) {
+        bd_addr_t src;
+        bd_addr_copy(src, &msg[1]);
+        const uint8_t *p = msg + AIR_HEADER_SIZE;
+        size_t len = (size_t)n - AIR_HEADER_SIZE;
+        switch (msg[0]) {
+            case AIR_ADV:         air_handle_adv(src, p, len); break;
+            case AIR_CONNECT:     air_handle_connect(src, p, len); break;
+            case AIR_CONNECT_ACK: air_handle_connect_ack(src, p, len); break;
+            case AIR_ACL:         air_handle_acl(src, p, len); break;
+            case AIR_DISCONNECT:  air_handle_disconnect(src, p, len); break;
+            case AIR_CONN_UPDATE: air_handle_conn_update(src, p, len); break;
+            default: break;
+        }
+    }
+}
+
+// Ao sair, avisa os pares conectados e remove o socket do ar.
+static void air_cleanup(void) {
+    for (int i = 0; i < VHCI_MAX_CONNECTIONS; i++) {
+        if (connections[i].active) air_send_disconnect(connections[i].peer, 0x13);
+    }
+    if (air_path[0]) unlink(air_path);
+}
+
+// SIGINT/SIGTERM encerram como `exit`: os pares recebem a desconexão na
+// hora, em vez de percebê-la só no próximo envio ACL.
+static void air_signal_handler(int sig) {
+    air_cleanup();
+    _exit(128 + sig);
+}
+
+static int air_open(void) {
+    const char *dir = getenv("PICO_HOST_AIR_DIR");
+    snprintf(air_dir, sizeof air_dir, "%s", dir ? dir : "/tmp/pico-ble-air");
+    mkdir(air_dir, 0777);
+
+    const char *addr = getenv("PICO_HOST_BD_ADDR");
+    if (addr == NULL || !sscanf_bd_addr(addr, local_addr)) {
+        uint32_t pid = (uint32_t)getpid();
+        bd_addr_t fallback = { 0xC0, 0xFF, 0xEE, (uint8_t)(pid >> 16), (uint8_t)(pid >> 8), (uint8_t)pid };
+        bd_addr_copy(local_addr, fallback);
+    }
+
+    air_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (air_fd < 0) return -1;
+    fcntl(air_fd, F_SETFL, fcntl(air_fd, F_GETFL) | O_NONBLOCK);
+
+    struct sockaddr_un self;
+    memset(&self, 0, sizeof self);
+    self.sun_family = AF_UNIX;
+    air_path_for(air_path, sizeof air_path, local_addr);
+    strncpy(self.sun_path, air_path, sizeof self.sun_path - 1);
+    unlink(air_path);
+    if (bind(air_fd, (struct sockaddr *)&self, sizeof self) < 0) {
+        close(air_fd);
+        air_fd = -1;
+        return -1;
+    }
+    atexit(&air_cleanup);
+    signal(SIGINT, &air_signal_handler);
+    signal(SIGTERM, &air_signal_handler);
+
+    btstack_run_loop_set_data_source_fd(&air_source, air_fd);
+    btstack_run_loop_set_data_source_handler(&air_source, &air_process);
+    btstack_run_loop_enable_data_source_callbacks(&air_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&air_source);
+    log_info("vhci: dispositivo %s em %s", bd_addr_to_str(local_addr), air_path);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Comandos HCI
+
+static void controller_reset(void) {
+    adv_set_enabled(0);
+    scan_enabled = 0;
+    connect_pending = 0;
+    memset(connections, 0, sizeof connections);
+}
+
+static void vhci_handle_command(const uint8_t *cmd, int size) {
+    if (size < 3) return;
+    uint16_t opcode = little_endian_read_16(cmd, 0);
+    const uint8_t *p = cmd + 3;
+    uint8_t *r;
+
+    switch (opcode) {
+        case VHCI_OP_RESET:
+            controller_reset();
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_HOST_NUM_COMPLETED_PACKETS:
+            // Sem evento de resposta (controle de fluxo controlador -> host).
+            break;
+
+        case VHCI_OP_SET_EVENT_MASK:
+        case VHCI_OP_SET_CONTROLLER_TO_HOST_FLOW:
+        case VHCI_OP_HOST_BUFFER_SIZE:
+        case VHCI_OP_WRITE_LE_HOST_SUPPORTED:
+        case VHCI_OP_LE_SET_EVENT_MASK:
+        case VHCI_OP_LE_SET_RANDOM_ADDRESS:
+        case VHCI_OP_LE_CLEAR_ACCEPT_LIST:
+        case VHCI_OP_LE_ADD_TO_ACCEPT_LIST:
+        case VHCI_OP_LE_REMOVE_FROM_ACCEPT_LIST:
+            // Configuração da inicialização e da conexão da BTstack: as
+            // máscaras de eventos não filtram nada (o controlador só gera
+            // os eventos que a pilha espera), o controle de fluxo segue
+            // os buffers do host pelo Number Of Completed Packets, o
+            // endereço é sempre o de `local_addr` e a lista de aceitação
+            // não é usada no ar virtual.
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_READ_LOCAL_NAME:
+            // Nome vazio (248 bytes terminados em zero).
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 248);
+            break;
+
+        case VHCI_OP_READ_LOCAL_VERSION:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 8);
+            if (!r) break;
+            r[0] = 0x09;                        // HCI 5.0
+            little_endian_store_16(r, 1, 0);
+            r[3] = 0x09;                        // LMP 5.0
+            little_endian_store_16(r, 4, 0xFFFF);  // fabricante: uso em testes
+            little_endian_store_16(r, 6, 0);
+            break;
+
+        case VHCI_OP_READ_LOCAL_COMMANDS:
+            // Nenhum comando opcional anunciado: a BTstack usa apenas o
+            // conjunto básico tratado aqui.
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 64);
+            break;
+
+        case VHCI_OP_READ_LOCAL_FEATURES:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 8);
+            if (r) r[4] = 0x60;                 // LE suportado, BR/EDR não
+            break;
+
+        case VHCI_OP_READ_BUFFER_SIZE:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 7);
+            if (!r) break;
+            little_endian_store_16(r, 0, VHCI_ACL_BUFFER_LEN);
+            little_endian_store_16(r, 3, VHCI_ACL_BUFFER_NUM);
+            break;
+
+        case VHCI_OP_READ_BD_ADDR:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 6);
+            if (r) reverse_bd_addr(local_addr, r);
+            break;
+
+        case VHCI_OP_READ_RSSI:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 3);
+            if (!r) break;
+            little_endian_store_16(r, 0, little_endian_read_16(p, 0));
+            r[2] = (uint8_t)VHCI_RSSI;
+            break;
+
+        case VHCI_OP_LE_READ_BUFFER_SIZE:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 3);
+            if (!r) break;
+            little_endian_store_16(r, 0, VHCI_ACL_BUFFER_LEN);
+            r[2] = VHCI_ACL_BUFFER_NUM;
+            break;
+
+        case VHCI_OP_LE_READ_LOCAL_FEATURES:
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 8);
+            break;
+
+        case VHCI_OP_LE_READ_SUPPORTED_STATES:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 8);
+            if (r) memset(r, 0xFF, 8);
+            break;
+
+        case VHCI_OP_LE_READ_ACCEPT_LIST_SIZE:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 1);
+            if (r) r[0] = 16;
+            break;
+
+        case VHCI_OP_LE_RAND:
+            r = command_complete(opcode, VHCI_STATUS_SUCCESS, 8);
+            for (int i = 0; r && i < 8; i++) r[i] = (uint8_t)rand();
+            break;
+
+        case VHCI_OP_LE_SET_ADV_PARAMETERS:
+            adv_interval = little_endian_read_16(p, 2);
+            adv_type = p[4];
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_SET_ADV_DATA:
+            adv_data_len = p[0] > 31 ? 31 : p[0];
+            memcpy(adv_data, &p[1], 31);
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_SET_SCAN_RESPONSE_DATA:
+            scan_rsp_len = p[0] > 31 ? 31 : p[0];
+            memcpy(scan_rsp_data, &p[1], 31);
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_SET_ADV_ENABLE:
+            adv_set_enabled(p[0]);
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_SET_SCAN_PARAMETERS:
+            scan_type = p[0];
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_SET_SCAN_ENABLE:
+            scan_enabled = p[0];
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            break;
+
+        case VHCI_OP_LE_CREATE_CONNECTION:
+            if (connect_pending) {
+                command_status(opcode, VHCI_STATUS_COMMAND_DISALLOWED);
+                break;
+            }
+            // Conecta no próximo anúncio recebido desse endereço.
+            connect_pending = 1;
+            reverse_bd_addr(&p[6], connect_peer);
+            connect_interval = little_endian_read_16(p, 15);
+            connect_latency = little_endian_read_16(p, 17);
+            connect_timeout = little_endian_read_16(p, 19);
+            command_status(opcode, VHCI_STATUS_SUCCESS);
+            break;
+
+        case VHCI_OP_LE_CREATE_CONNECTION_CANCEL:
+            if (!connect_pending) {
+                command_complete(opcode, VHCI_STATUS_COMMAND_DISALLOWED, 0);
+                break;
+            }
+            connect_pending = 0;
+            command_complete(opcode, VHCI_STATUS_SUCCESS, 0);
+            emit_connection_complete(VHCI_STATUS_UNKNOWN_CONNECTION, NULL, connect_peer, 0);
+            break;
+
+        case VHCI_OP_LE_CONNECTION_UPDATE: {
+            vhci_connection_t *c = connection_for_handle(little_endian_read_16(p, 0) & 0x0FFF);
+            if (!c) {
+                command_status(opcode, VHCI_STATUS_UNKNOWN_CONNECTION);
+                break;
+            }
+            command_status(opcode, VHCI_STATUS_SUCCESS);
+            c->interval = little_endian_read_16(p, 4);  // intervalo máximo pedido
+            c->latency = little_endian_read_16(p, 6);
+            c->timeout = little_endian_read_16(p, 8);
+            air_send_params(c->peer, AIR_CONN_UPDATE, c);
+            emit_connection_update_complete(c);
+            break;
+        }
+
+        case VHCI_OP_LE_READ_REMOTE_FEATURES: {
+            hci_con_handle_t handle = little_endian_read_16(p, 0) & 0x0FFF;
+            if (!connection_for_handle(handle)) {
+                command_status(opcode, VHCI_STATUS_UNKNOWN_CONNECTION);
+                break;
+            }
+            command_status(opcode, VHCI_STATUS_SUCCESS);
+            r = le_meta_event(HCI_SUBEVENT_LE_READ_REMOTE_FEATURES_COMPLETE, 11);
+            if (r) little_endian_store_16(r, 1, handle);
+            break;
+        }
+
+        case VHCI_OP_LE_SET_PHY: {
+            // O ar virtual não tem PHY: o pedido é aceito e a conexão
+            // continua em 1M, como num controlador sem suporte ao 2M.
+            hci_con_handle_t handle = little_endian_read_16(p, 0) & 0x0FFF;
+            if (!connection_for_handle(handle)) {
+                command_status(opcode, VHCI_STATUS_UNKNOWN_CONNECTION);
+                break;
+            }
+            command_status(opcode, VHCI_STATUS_SUCCESS);
+            r = le_meta_event(HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE, 5);
+            if (!r) break;
+            r[0] = VHCI_STATUS_SUCCESS;
+            little_endian_store_16(r, 1, handle);
+            r[3] = 1;  // TX: LE 1M
+            r[4] = 1;  // RX: LE 1M
+            break;
+        }
+
+        case VHCI_OP_DISCONNECT: {
+            vhci_connection_t *c = connection_for_handle(little_endian_read_16(p, 0) & 0x0FFF);
+            if (!c) {
+                command_status(opcode, VHCI_STATUS_UNKNOWN_CONNECTION);
+                break;
+            }
+            command_status(opcode, VHCI_STATUS_SUCCESS);
+            air_send_disconnect(c->peer, p[2]);
+            c->active = 0;
+            emit_disconnection_complete(c->handle, VHCI_REASON_LOCAL_HOST_TERMINATED);
+            break;
+        }
+
+        default:
+            // Como num controlador real, um comando não implementado é
+            // recusado em vez de aceito com parâmetros de retorno zerados;
+            // a pilha vê o erro e o log mostra o opcode.
+            log_info("vhci: comando HCI 0x%04X desconhecido", opcode);
+            command_complete(opcode, VHCI_STATUS_UNKNOWN_COMMAND, 0);
+            break;
+    }
+}
+
+// Envia um pacote ACL do host para o par da conexão.
+static void vhci_handle_acl(const uint8_t *acl, int size) {
+    if (size < 4) return;
+    uint16_t handle_flags = little_endian_read_16(acl, 0);
+    hci_con_handle_t handle = handle_flags & 0x0FFF;
+    uint16_t len = little_endian_read_16(acl, 2);
+    vhci_connection_t *c = connection_for_handle(handle);
+    if (!c || len > VHCI_ACL_BUFFER_LEN || size < 4 + len) return;
+
+    uint8_t msg[AIR_MAX_MESSAGE];
+    uint8_t *p = air_begin(msg, AIR_ACL);
+    p[0] = (uint8_t)(handle_flags >> 12);
+    little_endian_store_16(p, 1, len);
+    memcpy(&p[3], &acl[4], len);
+    if (air_send(c->peer, msg, AIR_HEADER_SIZE + 3u + len) < 0 && errno != EAGAIN) {
+        // O outro processo saiu: equivale a perder o enlace.
+        c->active = 0;
+        emit_disconnection_complete(handle, VHCI_STATUS_CONNECTION_TIMEOUT);
+        return;
+    }
+    emit_completed_packets(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// hci_transport_t
+
+static void vhci_init(const void *transport_config) {
+    UNUSED(transport_config);
+}
+
+static int vhci_open(void) {
+    queue_head = queue_tail = 0;
+    controller_reset();
+    if (air_fd >= 0) return 0;
+    return air_open();
+}
+
+static int vhci_close(void) {
+    controller_reset();
+    return 0;
+}
+
+static void vhci_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)) {
+    packet_handler = handler;
+}
+
+static int vhci_send_packet(uint8_t packet_type, uint8_t *packet, int size) {
+    switch (packet_type) {
+        case HCI_COMMAND_DATA_PACKET:
+            vhci_handle_command(packet, size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            vhci_handle_acl(packet, size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+// `can_send_packet_now` nulo: transporte síncrono, o pacote é
+// consumido dentro de `send_packet`.
+static const hci_transport_t vhci_transport = {
+    .name = "VIRTUAL",
+    .init = &vhci_init,
+    .open = &vhci_open,
+    .close = &vhci_close,
+    .register_packet_handler = &vhci_register_packet_handler,
+    .can_send_packet_now = NULL,
+    .send_packet = &vhci_send_packet,
+    .set_baudrate = NULL,
+    .reset_link = NULL,
+    .set_sco_config = NULL,
+};
+
+const hci_transport_t *hci_transport_virtual_instance(void) {
+    return &vhci_transport;
+}
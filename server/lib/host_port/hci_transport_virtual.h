@@ -0,0 +1,30 @@
+#ifndef HCI_TRANSPORT_VIRTUAL_H
+#define HCI_TRANSPORT_VIRTUAL_H
+
+#include "hci_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Transporte HCI com um controlador BLE virtual, para o build de host
+// (PICO_PLATFORM=host).
+//
+// O controlador responde aos comandos HCI que a BTstack usa (reset,
+// leitura de versão/endereço/buffers, advertising, scan, conexão,
+// atualização de parâmetros e desconexão) e leva anúncios e pacotes ACL
+// até os outros processos por um "ar" virtual: um diretório com um
+// socket UNIX de datagramas por dispositivo, cujo nome é o endereço
+// Bluetooth. Cada processo (servidor, cliente) é um dispositivo.
+//
+// Variáveis de ambiente:
+//  - PICO_HOST_AIR_DIR: diretório do ar virtual (padrão /tmp/pico-ble-air);
+//  - PICO_HOST_BD_ADDR: endereço deste dispositivo, "AA:BB:CC:DD:EE:FF"
+//    (padrão derivado do PID).
+const hci_transport_t *hci_transport_virtual_instance(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HCI_TRANSPORT_VIRTUAL_H
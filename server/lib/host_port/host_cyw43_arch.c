@@ -0,0 +1,46 @@
+// Inicialização da BTstack no build de host, no lugar do driver CYW43.
+//
+// Equivale ao que `btstack_cyw43_init` faz no Pico W, trocando o run loop
+// do async_context pelo run loop POSIX, o transporte HCI do CYW43 pelo
+// controlador virtual e o banco de dispositivos em flash (TLV) pelo
+// banco em memória.
+
+#include "pico/cyw43_arch.h"
+#include "pico/time.h"
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "hci.h"
+#include "hal_time_ms.h"
+
+#include "hci_transport_virtual.h"
+
+static bool led_state;
+
+int cyw43_arch_init(void) {
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    hci_init(hci_transport_virtual_instance(), NULL);
+    return 0;
+}
+
+void cyw43_arch_deinit(void) {
+    hci_power_control(HCI_POWER_OFF);
+    hci_close();
+    btstack_run_loop_deinit();
+    btstack_memory_deinit();
+}
+
+void cyw43_arch_gpio_put(uint wl_gpio, bool value) {
+    if (wl_gpio == CYW43_WL_GPIO_LED_PIN) led_state = value;
+}
+
+bool cyw43_arch_gpio_get(uint wl_gpio) {
+    return (wl_gpio == CYW43_WL_GPIO_LED_PIN) ? led_state : false;
+}
+
+// Relógio usado pela BTstack com HAVE_EMBEDDED_TIME_MS.
+uint32_t hal_time_ms(void) {
+    return (uint32_t)(time_us_64() / 1000u);
+}
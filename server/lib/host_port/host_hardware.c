@@ -0,0 +1,134 @@
+// Substitutos de ADC, PWM e multicore para o build de host.
+
+#include <pthread.h>
+
+#include "hardware/adc.h"
+#include "hardware/pwm.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+
+#define HOST_NUM_GPIOS      30
+#define HOST_ADC_INPUTS     5
+#define HOST_ADC_PERIOD_US  1000000u
+
+////////////////////////////////////////////////////////////////////////////////
+// ADC
+
+static uint adc_input;
+static uint adc_round_robin;
+
+void adc_init(void) {
+    adc_input = 0;
+    adc_round_robin = 0;
+}
+
+void adc_gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void adc_select_input(uint input) {
+    if (input < HOST_ADC_INPUTS) adc_input = input;
+}
+
+uint adc_get_selected_input(void) {
+    return adc_input;
+}
+
+void adc_set_temp_sensor_enabled(bool enable) {
+    (void)enable;
+}
+
+void adc_set_round_robin(uint input_mask) {
+    adc_round_robin = input_mask & ((1u << HOST_ADC_INPUTS) - 1);
+}
+
+uint16_t adc_read(void) {
+    // Cada entrada é defasada de 1/5 de período para distinguir canais.
+    uint64_t t = time_us_64() + (uint64_t)adc_input * (HOST_ADC_PERIOD_US / HOST_ADC_INPUTS);
+    uint32_t phase = (uint32_t)(t % HOST_ADC_PERIOD_US);
+    uint32_t half = HOST_ADC_PERIOD_US / 2;
+    uint32_t value = (phase < half)
+        ? (uint32_t)(((uint64_t)phase * 4095u) / half)
+        : (uint32_t)(((uint64_t)(HOST_ADC_PERIOD_US - phase) * 4095u) / half);
+
+    // Round-robin: a próxima conversão usa a entrada seguinte da máscara.
+    if (adc_round_robin != 0) {
+        do {
+            adc_input = (adc_input + 1) % HOST_ADC_INPUTS;
+        } while ((adc_round_robin & (1u << adc_input)) == 0);
+    }
+    return (uint16_t)value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PWM
+
+static uint16_t pwm_levels[HOST_NUM_GPIOS];
+
+uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = { 0, 1u << 4, 0xFFFFu };
+    return c;
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, float div) {
+    c->div = (uint32_t)(div * (float)(1u << 4));
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    (void)slice_num;
+    (void)c;
+    (void)start;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    (void)slice_num;
+    (void)wrap;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    (void)slice_num;
+    (void)enabled;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    if (gpio < HOST_NUM_GPIOS) pwm_levels[gpio] = level;
+}
+
+uint16_t pwm_get_gpio_level(uint gpio) {
+    return (gpio < HOST_NUM_GPIOS) ? pwm_levels[gpio] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Multicore: o core 1 é uma thread
+
+static pthread_t core1_thread;
+static bool core1_running;
+
+static void *core1_trampoline(void *arg) {
+    void (*entry)(void) = (void (*)(void))arg;
+    entry();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    if (core1_running) return;
+    core1_running = pthread_create(&core1_thread, NULL, &core1_trampoline, (void *)entry) == 0;
+}
+
+void multicore_reset_core1(void) {
+    if (!core1_running) return;
+    pthread_cancel(core1_thread);
+    pthread_join(core1_thread, NULL);
+    core1_running = false;
+}
+
+void multicore_lockout_victim_init(void) {
+}
@@ -0,0 +1,38 @@
+#ifndef _HARDWARE_PWM_H
+#define _HARDWARE_PWM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Substituto de `hardware/pwm.h` para o build de host: guarda a
+// configuração e o nível de cada GPIO, sem gerar sinal.
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+uint pwm_gpio_to_slice_num(uint gpio);
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_clkdiv(pwm_config *c, float div);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_enabled(uint slice_num, bool enabled);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
+// Nível atual de um GPIO (apenas no host, para inspeção).
+uint16_t pwm_get_gpio_level(uint gpio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
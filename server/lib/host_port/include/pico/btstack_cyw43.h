@@ -0,0 +1,7 @@
+#ifndef _PICO_BTSTACK_CYW43_H
+#define _PICO_BTSTACK_CYW43_H
+
+// Substituto vazio de `pico/btstack_cyw43.h` para o build de host: a
+// integração com a BTstack fica em `cyw43_arch_init` (host_cyw43_arch.c).
+
+#endif
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Teste ponta a ponta do servidor e do cliente no ar virtual (build de host).
+
+Roda os executáveis do build de host (`-DPICO_PLATFORM=host`) em processos
+separados, num diretório de ar próprio, e acompanha o log do cliente:
+
+- notificacao: scan, conexão, descoberta e a primeira notificação;
+- reconexao: o mesmo, depois encerra o servidor com SIGTERM e o inicia de
+  novo no mesmo endereço; o cliente deve reconectar com os handles
+  guardados (sem descoberta), baixar o registro em flash e voltar a
+  receber notificações. O servidor precisa de `-DSERVER_FLASH_LOG=ON`.
+
+Cada etapa tem um prazo; a primeira que não aparecer no log (ou uma falha
+conhecida, como o download do registro não iniciado) encerra o teste com
+código 1 e as últimas linhas dos dois logs em stderr.
+
+Uso:
+    host_link_test.py build-host-server/server build-host-client/client
+    host_link_test.py build-host-server/server build-host-client/client --cenario reconexao
+"""
+
+import argparse
+import os
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+
+SERVER_ADDR = "C0:FF:EE:00:00:01"
+CLIENT_ADDR = "C0:FF:EE:00:00:02"
+
+# Sequências de escape VT100 do log_vt100.
+ANSI = re.compile(r"\x1b\[[0-9;]*[A-Za-z]")
+
+# Linhas do cliente que encerram o teste com falha em qualquer etapa.
+FAILURES = [
+    "Download do registro não iniciado",
+    "Download do registro recusado",
+    "Handles guardados recusados",
+    "Falha na descoberta",
+]
+
+
+class Device:
+    """Processo de um dispositivo, com o log em arquivo."""
+
+    def __init__(self, name, path, addr, air_dir, log_dir):
+        self.name = name
+        self.path = path
+        self.addr = addr
+        self.air_dir = air_dir
+        self.log_path = os.path.join(log_dir, name + ".log")
+        self.log = open(self.log_path, "wb")
+        self.proc = None
+
+    def start(self):
+        env = dict(os.environ, PICO_HOST_AIR_DIR=self.air_dir, PICO_HOST_BD_ADDR=self.addr)
+        # Saída sem buffer: o log chega ao arquivo linha a linha.
+        cmd = [self.path]
+        if shutil.which("stdbuf"):
+            cmd = ["stdbuf", "-o0", "-e0"] + cmd
+        self.proc = subprocess.Popen(cmd, env=env, stdout=self.log, stderr=subprocess.STDOUT)
+
+    def stop(self, sig=signal.SIGTERM):
+        if self.proc is None or self.proc.poll() is not None:
+            return
+        self.proc.send_signal(sig)
+        try:
+            self.proc.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+            self.proc.wait()
+
+    def lines(self):
+        with open(self.log_path, "rb") as f:
+            text = f.read().decode("utf-8", "replace")
+        return [ANSI.sub("", line) for line in text.splitlines()]
+
+    def tail(self, n=30):
+        return "\n".join("  " + line for line in self.lines()[-n:])
+
+
+class Failure(Exception):
+    pass
+
+
+def wait_for(device, text, count, timeout, devices):
+    """Espera a `count`-ésima linha do log de `device` que contém `text`."""
+    deadline = time.monotonic() + timeout
+    while True:
+        lines = device.lines()
+        for line in lines:
+            for failure in FAILURES:
+                if failure in line:
+                    raise Failure("%s: %s" % (device.name, line.strip()))
+        if sum(text in line for line in lines) >= count:
+            return
+        for d in devices:
+            if d.proc is not None and d.proc.poll() not in (None, 128 + signal.SIGTERM, -signal.SIGTERM):
+                raise Failure("%s terminou com código %d" % (d.name, d.proc.returncode))
+        if time.monotonic() > deadline:
+            raise Failure("%s: \"%s\" (%dª vez) não apareceu em %d s" % (device.name, text, count, timeout))
+        time.sleep(0.1)
+
+
+def step(name):
+    print("etapa=%s" % name, flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Teste ponta a ponta no ar virtual")
+    parser.add_argument("server", help="executável do servidor (build de host)")
+    parser.add_argument("client", help="executável do cliente (build de host)")
+    parser.add_argument("--cenario", choices=["notificacao", "reconexao"], default="notificacao")
+    parser.add_argument("--prazo", type=float, default=20.0, help="prazo de cada etapa, em segundos")
+    args = parser.parse_args()
+
+    work = tempfile.mkdtemp(prefix="pico-host-link-")
+    air_dir = os.path.join(work, "air")
+    os.mkdir(air_dir)
+    server = Device("servidor", args.server, SERVER_ADDR, air_dir, work)
+    client = Device("cliente", args.client, CLIENT_ADDR, air_dir, work)
+    devices = [server, client]
+
+    ok = False
+    try:
+        server.start()
+        client.start()
+        step("scan")
+        wait_for(client, "Servidor encontrado", 1, args.prazo, devices)
+        step("conexao")
+        wait_for(client, "Conectado a", 1, args.prazo, devices)
+        step("descoberta")
+        wait_for(client, "CLIENTE PRONTO", 1, args.prazo, devices)
+        step("notificacao")
+        wait_for(client, "Primeira notificação", 1, args.prazo, devices)
+
+        if args.cenario == "reconexao":
+            step("desconexao")
+            server.stop()
+            wait_for(client, "Desconectado de", 1, args.prazo, devices)
+            server.start()
+            step("reconexao_rapida")
+            wait_for(client, "Reconexão rápida", 1, args.prazo, devices)
+            step("registro_em_flash")
+            wait_for(client, "Registro em flash baixado", 1, args.prazo, devices)
+            step("notificacao")
+            wait_for(client, "Primeira notificação", 2, args.prazo, devices)
+        ok = True
+    except Failure as e:
+        print("erro: %s" % e, file=sys.stderr)
+        for d in devices:
+            print("--- %s (%s)" % (d.name, d.log_path), file=sys.stderr)
+            print(d.tail(), file=sys.stderr)
+    finally:
+        client.stop()
+        server.stop()
+
+    if ok:
+        shutil.rmtree(work, ignore_errors=True)
+    print("cenario=%s %s" % (args.cenario, "ok" if ok else "FALHOU"))
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,175 +2,558 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+// No Pico SDK, a reserva de espaço no anel assíncrono e a inserção de
+// tags na tabela são feitas sob um spinlock de hardware, que também
+// mascara as interrupções do núcleo: logs de handlers (IRQ), do laço
+// principal e do core 1 não se intercalam. Fora do SDK não há proteção
+// extra.
+#if __has_include("hardware/sync.h")
+#include "hardware/sync.h"
+// Spinlock de hardware do log (um dos reservados pelo SDK para uso do
+// sistema, livre de `spin_lock_claim_unused`).
+#ifndef LOG_SPINLOCK_ID
+#define LOG_SPINLOCK_ID PICO_SPINLOCK_ID_OS1
+#endif
+#define LOG_CRITICAL_ENTER() uint32_t log_irq_state_ = spin_lock_blocking(spin_lock_instance(LOG_SPINLOCK_ID))
+#define LOG_CRITICAL_EXIT()  spin_unlock(spin_lock_instance(LOG_SPINLOCK_ID), log_irq_state_)
+#else
+#define LOG_CRITICAL_ENTER() do { } while (0)
+#define LOG_CRITICAL_EXIT()  do { } while (0)
+#endif
+
+// Saída binária sem tradução de '\n' para "\r\n" (quadros tokenizados)
+// e relógio para os timestamps.
+#if __has_include("pico/stdio.h")
+#include "pico/stdio.h"
+#include "pico/time.h"
+#define LOG_PUTCHAR_RAW(c) putchar_raw(c)
+#define LOG_TIMESTAMP_US() time_us_32()
+#else
+#define LOG_PUTCHAR_RAW(c) putchar(c)
+#define LOG_TIMESTAMP_US() 0u
+#endif
+
+#if (LOG_ASYNC_BUFFER_SIZE & (LOG_ASYNC_BUFFER_SIZE - 1)) != 0
+#error "LOG_ASYNC_BUFFER_SIZE deve ser potência de 2"
+#endif
+
+#define LOG_RECORD_HEADER_SIZE 2
+#define LOG_RING_MASK (LOG_ASYNC_BUFFER_SIZE - 1)
+
+// Marca, no byte de nível de um registro do anel, que o conteúdo é um
+// quadro tokenizado (binário) e não texto.
+#define LOG_RECORD_BINARY 0x80u
+
+// Bytes de sincronismo e limites do quadro tokenizado. A carga é limitada
+// para que o quadro inteiro (3 + carga + 1) caiba em um registro do anel.
+#define LOG_TOKEN_SYNC0 0xA5u
+#define LOG_TOKEN_SYNC1 0x5Au
+#define LOG_TOKEN_MAX_PAYLOAD 251u
 
 static log_level_t current_level = LOG_DEFAULT_LEVEL;
+static volatile log_mode_t current_mode = LOG_MODE_SYNC;
 
-static void append_char(char *buf, size_t size, size_t *idx, char c) {
-    if (*idx + 1 < size) {
-        buf[*idx] = c;
-        (*idx)++;
-    }
+// Anel de bytes do modo assíncrono. Cada registro é
+// [nível (1 byte)][tamanho (1 byte)][texto sem '\0'].
+// `log_ring_head` só é escrito pelos produtores (`log_write`) e
+// `log_ring_tail` só pelo consumidor (`log_flush`).
+static uint8_t log_ring[LOG_ASYNC_BUFFER_SIZE];
+static volatile uint32_t log_ring_head;
+static volatile uint32_t log_ring_tail;
+static volatile uint32_t log_dropped;
+static uint32_t log_dropped_reported;
+
+// Tabela de tags com nível próprio. `level` < 0 indica que a tag segue o
+// nível global.
+typedef struct {
+    const char *name;
+    int8_t level;
+} log_tag_entry_t;
+
+static log_tag_entry_t log_tags[LOG_MAX_TAGS];
+static uint8_t log_tag_count;
+
+// Limitação de taxa por ponto de chamada (0 = desativada).
+static uint16_t rate_per_second;
+static uint16_t rate_burst;
+
+// Formatador próprio, em uma única passagem sobre a string de formato.
+//
+// Suporta o subconjunto usual de `printf`: flags `-0+ #`, largura e
+// precisão (inclusive `*`), modificadores `hh h l ll j z t` e as
+// conversões `d i u o x X c s p f F e E g G %`, além do extra `%b`
+// (binário). Trechos literais e strings são copiados em blocos com
+// `memcpy`, e inteiros de até 32 bits são convertidos sem divisão de
+// 64 bits (lenta no Cortex-M0+). A saída é sempre terminada em '\0' e
+// truncada em `size - 1` caracteres.
+typedef struct {
+    char *out;
+    size_t size;   // capacidade útil (sem o '\0')
+    size_t idx;
+} fmt_buf_t;
+
+// Flags de uma conversão.
+#define FMT_LEFT   0x01u  // '-'
+#define FMT_ZERO   0x02u  // '0'
+#define FMT_PLUS   0x04u  // '+'
+#define FMT_SPACE  0x08u  // ' '
+#define FMT_ALT    0x10u  // '#'
+#define FMT_UPPER  0x20u
+
+static void fmt_put(fmt_buf_t *b, const char *src, size_t n) {
+    size_t room = b->size - b->idx;
+    if (n > room) n = room;
+    memcpy(b->out + b->idx, src, n);
+    b->idx += n;
 }
 
-static void append_str(char *buf, size_t size, size_t *idx, const char *s) {
-    if (!s) s = "(null)";
-    while (*s) {
-        append_char(buf, size, idx, *s++);
+static void fmt_fill(fmt_buf_t *b, char c, int n) {
+    if (n <= 0) return;
+    size_t room = b->size - b->idx;
+    if ((size_t)n > room) n = (int)room;
+    memset(b->out + b->idx, c, (size_t)n);
+    b->idx += (size_t)n;
+}
+
+// Escreve `body` (`len` bytes) precedido de `prefix` (sinal, "0x"),
+// aplicando largura, zeros de precisão (`zeros`) e alinhamento.
+static void fmt_field(fmt_buf_t *b, const char *prefix, int prefix_len, int zeros,
+                      const char *body, int len, int width, unsigned flags) {
+    int pad = width - prefix_len - zeros - len;
+    if ((flags & (FMT_LEFT | FMT_ZERO)) == FMT_ZERO) {
+        zeros += (pad > 0) ? pad : 0;
+        pad = 0;
     }
+    if (!(flags & FMT_LEFT)) fmt_fill(b, ' ', pad);
+    fmt_put(b, prefix, (size_t)prefix_len);
+    fmt_fill(b, '0', zeros);
+    fmt_put(b, body, (size_t)len);
+    if (flags & FMT_LEFT) fmt_fill(b, ' ', pad);
 }
 
-static void append_uint(char *buf, size_t size, size_t *idx, unsigned int v) {
-    char tmp[16];
-    int t = 0;
-    if (v == 0) {
-        tmp[t++] = '0';
-    } else {
-        while (v > 0 && t < (int)sizeof(tmp)) {
-            tmp[t++] = (char)('0' + (v % 10));
-            v /= 10;
+// Converte `v` na base `base` (2, 8, 10 ou 16), escrevendo os dígitos
+// do fim para o começo de `end`. Retorna o início dos dígitos.
+static char *fmt_utoa(char *end, uint64_t v, unsigned base, unsigned flags) {
+    const char *digits = (flags & FMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+    if (base == 10) {
+        while (v > UINT32_MAX) {
+            *--p = (char)('0' + (unsigned)(v % 10u));
+            v /= 10u;
         }
+        uint32_t w = (uint32_t)v;
+        do {
+            *--p = (char)('0' + w % 10u);
+            w /= 10u;
+        } while (w);
+    } else {
+        unsigned shift = (base == 16) ? 4u : (base == 8) ? 3u : 1u;
+        do {
+            *--p = digits[(unsigned)v & (base - 1u)];
+            v >>= shift;
+        } while (v);
     }
-    while (t-- > 0) {
-        append_char(buf, size, idx, tmp[t]);
-    }
+    return p;
 }
 
-static void append_int(char *buf, size_t size, size_t *idx, int v) {
-    if (v < 0) {
-        append_char(buf, size, idx, '-');
-        v = -v;
+static void fmt_integer(fmt_buf_t *b, uint64_t v, int negative, unsigned base,
+                        int width, int precision, unsigned flags) {
+    char tmp[66];
+    char *end = tmp + sizeof tmp;
+    char *digits = end;
+    // Precisão 0 com valor 0 não escreve dígitos (como no printf).
+    if (v != 0 || precision != 0) digits = fmt_utoa(end, v, base, flags);
+    int len = (int)(end - digits);
+
+    char prefix[2];
+    int prefix_len = 0;
+    if (negative) prefix[prefix_len++] = '-';
+    else if (flags & FMT_PLUS) prefix[prefix_len++] = '+';
+    else if (flags & FMT_SPACE) prefix[prefix_len++] = ' ';
+
+    if ((flags & FMT_ALT) && v != 0) {
+        if (base == 16) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = (flags & FMT_UPPER) ? 'X' : 'x';
+        } else if (base == 8 && precision <= len) {
+            precision = len + 1;
+        }
     }
-    append_uint(buf, size, idx, (unsigned int)v);
+
+    int zeros = (precision > len) ? precision - len : 0;
+    if (precision >= 0) flags &= ~FMT_ZERO;
+    fmt_field(b, prefix, prefix_len, zeros, digits, len, width, flags);
 }
 
-static void append_hex(char *buf, size_t size, size_t *idx, unsigned int v, int upper) {
-    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
-    char tmp[16];
-    int t = 0;
-    if (v == 0) {
-        tmp[t++] = '0';
-    } else {
-        while (v > 0 && t < (int)sizeof(tmp)) {
-            tmp[t++] = digits[v & 0xFU];
-            v >>= 4;
-        }
+// Algarismos decimais exatos de um double 0 <= v < 2^64, lidos um a um:
+// primeiro os da parte inteira, depois os da fração. A fração (exata:
+// v - parte inteira não arredonda) fica num número de 128 bits em ponto
+// fixo, W / 2^124, em quatro palavras de 32 bits (w[0] a menos
+// significativa); multiplicar W por 10 deixa o próximo algarismo nos 4
+// bits do topo. Só frações com bits abaixo de 2^-124 (v < 2^-71) perdem
+// esses bits.
+typedef struct {
+    char int_digits[20];
+    int int_len;
+    int pos;
+    uint32_t w[4];
+} fmt_digits_t;
+
+static void fmt_digits_init(fmt_digits_t *d, double v) {
+    uint64_t ipart = (uint64_t)v;
+    char *end = d->int_digits + sizeof d->int_digits;
+    char *s = fmt_utoa(end, ipart, 10, 0);
+    d->int_len = (int)(end - s);
+    memmove(d->int_digits, s, (size_t)d->int_len);
+    d->pos = 0;
+
+    double frac = v - (double)ipart;
+    uint64_t bits;
+    memcpy(&bits, &frac, sizeof bits);
+    int exponent = (int)((bits >> 52) & 0x7FFu);
+    uint64_t mant = (bits & ((1ull << 52) - 1u)) | (exponent ? (1ull << 52) : 0u);
+    // frac = mant / 2^(1075 - exponent); em W, mant fica `offset` bits
+    // acima do bit 0.
+    int offset = 124 - (1075 - (exponent ? exponent : 1));
+    if (frac == 0) {
+        mant = 0;
+        offset = 0;
+    } else if (offset < 0) {
+        mant = (-offset < 64) ? mant >> -offset : 0u;
+        offset = 0;
     }
-    while (t-- > 0) {
-        append_char(buf, size, idx, tmp[t]);
+    uint64_t hi = 0, lo = mant;
+    if (offset >= 64) {
+        hi = mant << (offset - 64);
+        lo = 0;
+    } else if (offset > 0) {
+        hi = mant >> (64 - offset);
+        lo = mant << offset;
     }
+    d->w[0] = (uint32_t)lo;
+    d->w[1] = (uint32_t)(lo >> 32);
+    d->w[2] = (uint32_t)hi;
+    d->w[3] = (uint32_t)(hi >> 32);
 }
 
-static void append_binary(char *buf, size_t size, size_t *idx, unsigned int value) {
-    int started = 0;
-    for (int i = (int)(sizeof(unsigned int) * 8 - 1); i >= 0; --i) {
-        unsigned int bit = (value >> i) & 1U;
-        if (bit) {
-            started = 1;
-            append_char(buf, size, idx, '1');
-        } else if (started) {
-            append_char(buf, size, idx, '0');
-        }
+static char fmt_digits_next(fmt_digits_t *d) {
+    if (d->pos < d->int_len) return d->int_digits[d->pos++];
+    uint32_t carry = 0;
+    for (int k = 0; k < 4; k++) {
+        uint64_t x = ((uint64_t)d->w[k] << 3) + ((uint64_t)d->w[k] << 1) + carry;
+        d->w[k] = (uint32_t)x;
+        carry = (uint32_t)(x >> 32);
     }
-    if (!started) {
-        append_char(buf, size, idx, '0');
+    char c = (char)('0' + (d->w[3] >> 28));
+    d->w[3] &= 0x0FFFFFFFu;
+    return c;
+}
+
+// Algum algarismo ainda não lido é diferente de zero?
+static bool fmt_digits_rest(const fmt_digits_t *d) {
+    for (int i = d->pos; i < d->int_len; i++) {
+        if (d->int_digits[i] != '0') return true;
     }
+    return (d->w[0] | d->w[1] | d->w[2] | d->w[3]) != 0;
 }
 
-static int format_has_binary(const char *fmt) {
-    while (*fmt) {
-        if (*fmt == '%' && *(fmt + 1) == 'b') {
-            return 1;
+// Completa `out` até `n` algarismos (os `start` primeiros já lidos) e
+// arredonda o último para o mais próximo; empates vão para o algarismo
+// par. Retorna true se o arredondamento transbordou ("99" → "00"): falta
+// um '1' à esquerda.
+static bool fmt_digits_take(fmt_digits_t *d, char *out, int start, int n) {
+    for (int i = start; i < n; i++) out[i] = fmt_digits_next(d);
+    char next = fmt_digits_next(d);
+    if (next < '5' || (next == '5' && !fmt_digits_rest(d) && !((out[n - 1] - '0') & 1))) return false;
+    int i = n - 1;
+    while (i >= 0 && out[i] == '9') out[i--] = '0';
+    if (i < 0) return true;
+    out[i]++;
+    return false;
+}
+
+// Ponto flutuante sem depender da libc: suficiente para logs (valores
+// até ~1.8e19 na parte inteira em %f; acima disso use %e). Os algarismos
+// saem exatos da representação binária, como na libc, para 2^-71 <= v <
+// 2^64; fora disso, em %e e %g, `v` é normalizado por divisões e os
+// últimos algarismos podem diferir. A precisão vai até
+// LOG_FLOAT_MAX_PRECISION casas.
+static void fmt_float(fmt_buf_t *b, double v, char conv, int width, int precision, unsigned flags) {
+    char tmp[24 + LOG_FLOAT_MAX_PRECISION + 8];
+    char digits[20 + LOG_FLOAT_MAX_PRECISION + 1];
+    char *p = tmp;
+    char sign = 0;
+    if (v != v) {
+        fmt_field(b, "", 0, 0, (flags & FMT_UPPER) ? "NAN" : "nan", 3, width, flags & ~FMT_ZERO);
+        return;
+    }
+    // `signbit` também pega o -0.0, que `v < 0` não vê.
+    if (signbit(v)) { sign = '-'; v = -v; }
+    else if (flags & FMT_PLUS) sign = '+';
+    else if (flags & FMT_SPACE) sign = ' ';
+    if (v > DBL_MAX) {
+        fmt_field(b, &sign, sign ? 1 : 0, 0, (flags & FMT_UPPER) ? "INF" : "inf", 3, width, flags & ~FMT_ZERO);
+        return;
+    }
+    if (precision < 0) precision = 6;
+    if (precision > LOG_FLOAT_MAX_PRECISION) precision = LOG_FLOAT_MAX_PRECISION;
+    bool is_g = (conv == 'g');
+    if (v >= 1.8e19) conv = 'e';
+
+    // Fora da faixa exata, %e e %g partem de v normalizado em [1, 10).
+    int exp10 = 0;
+    if (conv != 'f' && v != 0 && (v >= 1.8e19 || v < 0x1p-71)) {
+        while (v >= 10.0) { v /= 10.0; exp10++; }
+        while (v < 1.0) { v *= 10.0; exp10--; }
+    }
+    fmt_digits_t d;
+    fmt_digits_init(&d, v);
+
+    int int_len = 0;      // algarismos antes do ponto (%f)
+    int n;                // algarismos em `digits`
+    if (conv == 'f') {
+        n = d.int_len + precision;
+        int_len = d.int_len;
+        if (fmt_digits_take(&d, digits + 1, 0, n)) {
+            digits[0] = '1';
+            n++;
+            int_len++;
+        } else {
+            memmove(digits, digits + 1, (size_t)n);
+        }
+    } else {
+        // %e (e %g): `precision` + 1 algarismos significativos, a partir
+        // do primeiro diferente de zero.
+        int significant = is_g ? (precision ? precision : 1) : precision + 1;
+        int start = 0;
+        if (v == 0) {
+            memset(digits, '0', (size_t)significant);
+        } else {
+            if (d.int_digits[0] != '0') {
+                exp10 += d.int_len - 1;
+            } else {
+                d.pos = 1;
+                char c;
+                while ((c = fmt_digits_next(&d)) == '0') exp10--;
+                exp10--;
+                digits[start++] = c;
+            }
+            if (fmt_digits_take(&d, digits, start, significant)) {
+                digits[0] = '1';
+                exp10++;
+            }
+        }
+        n = significant;
+        // %g escolhe o estilo pelo expoente já arredondado.
+        if (is_g && exp10 >= -4 && exp10 < significant) {
+            conv = 'f';
+            precision = significant - 1 - exp10;
+            if (exp10 >= 0) {
+                int_len = exp10 + 1;
+            } else {
+                // 0,000ddd: os zeros à esquerda entram antes dos
+                // algarismos significativos.
+                memmove(digits - exp10, digits, (size_t)n);
+                memset(digits, '0', (size_t)-exp10);
+                n -= exp10;
+                int_len = 1;
+            }
+        } else {
+            int_len = 1;
+            if (is_g) precision = significant - 1;
         }
-        ++fmt;
     }
-    return 0;
+
+    memcpy(p, digits, (size_t)int_len);
+    p += int_len;
+    if (precision > 0 || (flags & FMT_ALT)) *p++ = '.';
+    memcpy(p, digits + int_len, (size_t)(n - int_len));
+    p += n - int_len;
+    if (is_g && !(flags & FMT_ALT) && precision > 0) {
+        // %g remove zeros à direita da parte fracionária.
+        while (p[-1] == '0') p--;
+        if (p[-1] == '.') p--;
+    }
+    if (conv != 'f') {
+        *p++ = (flags & FMT_UPPER) ? 'E' : 'e';
+        *p++ = (exp10 < 0) ? '-' : '+';
+        int e = (exp10 < 0) ? -exp10 : exp10;
+        if (e >= 100) *p++ = (char)('0' + e / 100);
+        *p++ = (char)('0' + (e / 10) % 10);
+        *p++ = (char)('0' + e % 10);
+    }
+    fmt_field(b, &sign, sign ? 1 : 0, 0, tmp, (int)(p - tmp), width, flags);
 }
 
-// Formatter simplificado com suporte a %b, escrevendo em buffer
-static void log_vsnprintf(char *out, size_t size, const char *fmt, va_list ap) {
-    size_t idx = 0;
+size_t log_vsnprintf(char *out, size_t size, const char *fmt, va_list ap) {
+    if (size == 0) return 0;
+    fmt_buf_t b = { out, size - 1, 0 };
 
     while (*fmt) {
-        if (*fmt != '%') {
-            append_char(out, size, &idx, *fmt++);
-            continue;
+        // Copia o trecho literal até o próximo '%' de uma vez.
+        const char *lit = fmt;
+        while (*fmt && *fmt != '%') fmt++;
+        if (fmt != lit) fmt_put(&b, lit, (size_t)(fmt - lit));
+        if (!*fmt) break;
+        fmt++; // pula '%'
+
+        unsigned flags = 0;
+        for (;; fmt++) {
+            if (*fmt == '-') flags |= FMT_LEFT;
+            else if (*fmt == '0') flags |= FMT_ZERO;
+            else if (*fmt == '+') flags |= FMT_PLUS;
+            else if (*fmt == ' ') flags |= FMT_SPACE;
+            else if (*fmt == '#') flags |= FMT_ALT;
+            else break;
         }
 
-        ++fmt; // skip '%'
-        if (*fmt == '%') {
-            append_char(out, size, &idx, '%');
-            ++fmt;
-            continue;
+        int width = 0;
+        if (*fmt == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) { flags |= FMT_LEFT; width = -width; }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
         }
 
-        char spec = *fmt++;
-        switch (spec) {
-            case 'c': {
-                int c = va_arg(ap, int);
-                append_char(out, size, &idx, (char)c);
-                break;
-            }
-            case 's': {
-                const char *s = va_arg(ap, const char *);
-                append_str(out, size, &idx, s);
-                break;
+        int precision = -1;
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(ap, int);
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') precision = precision * 10 + (*fmt++ - '0');
             }
+        }
+
+        // Tamanho do argumento: 0 = int, 1 = long, 2 = long long/intmax,
+        // 3 = size_t, 4 = ptrdiff_t, 5 = long double, -1 = short, -2 = char.
+        int wide = 0;
+        for (;; fmt++) {
+            if (*fmt == 'l') wide = (wide == 1) ? 2 : 1;
+            else if (*fmt == 'h') wide = (wide == -1) ? -2 : -1;
+            else if (*fmt == 'j') wide = 2;
+            else if (*fmt == 'z') wide = 3;
+            else if (*fmt == 't') wide = 4;
+            else if (*fmt == 'L') wide = 5;
+            else break;
+        }
+
+        char conv = *fmt;
+        if (conv == '\0') break;
+        fmt++;
+
+        switch (conv) {
             case 'd':
             case 'i': {
-                int v = va_arg(ap, int);
-                append_int(out, size, &idx, v);
+                int64_t v;
+                switch (wide) {
+                    case 1: v = va_arg(ap, long); break;
+                    case 2: v = va_arg(ap, long long); break;
+                    case 3: v = (int64_t)va_arg(ap, size_t); break;
+                    case 4: v = va_arg(ap, ptrdiff_t); break;
+                    case -1: v = (short)va_arg(ap, int); break;
+                    case -2: v = (signed char)va_arg(ap, int); break;
+                    default: v = va_arg(ap, int); break;
+                }
+                uint64_t mag = (v < 0) ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+                fmt_integer(&b, mag, v < 0, 10, width, precision, flags);
                 break;
             }
-            case 'u': {
-                unsigned int v = va_arg(ap, unsigned int);
-                append_uint(out, size, &idx, v);
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'b': {
+                uint64_t v;
+                switch (wide) {
+                    case 1: v = va_arg(ap, unsigned long); break;
+                    case 2: v = va_arg(ap, unsigned long long); break;
+                    case 3: v = va_arg(ap, size_t); break;
+                    case 4: v = (uint64_t)va_arg(ap, ptrdiff_t); break;
+                    case -1: v = (unsigned short)va_arg(ap, unsigned int); break;
+                    case -2: v = (unsigned char)va_arg(ap, unsigned int); break;
+                    default: v = va_arg(ap, unsigned int); break;
+                }
+                unsigned base = (conv == 'u') ? 10u : (conv == 'o') ? 8u : (conv == 'b') ? 2u : 16u;
+                if (conv == 'X') flags |= FMT_UPPER;
+                fmt_integer(&b, v, 0, base, width, precision, flags & ~(FMT_PLUS | FMT_SPACE));
                 break;
             }
-            case 'x': {
-                unsigned int v = va_arg(ap, unsigned int);
-                append_hex(out, size, &idx, v, 0);
+            case 'p': {
+                uintptr_t v = (uintptr_t)va_arg(ap, void *);
+                fmt_integer(&b, v, 0, 16, width, precision, (flags | FMT_ALT) & ~FMT_ZERO);
                 break;
             }
-            case 'X': {
-                unsigned int v = va_arg(ap, unsigned int);
-                append_hex(out, size, &idx, v, 1);
+            case 'c': {
+                char c = (char)va_arg(ap, int);
+                fmt_field(&b, "", 0, 0, &c, 1, width, flags & ~FMT_ZERO);
                 break;
             }
-            case 'p': {
-                void *ptr = va_arg(ap, void *);
-                unsigned int v = (unsigned int)(uintptr_t)ptr;
-                append_str(out, size, &idx, "0x");
-                append_hex(out, size, &idx, v, 0);
+            case 's': {
+                const char *s = va_arg(ap, const char *);
+                if (!s) s = "(null)";
+                size_t len = 0;
+                if (precision >= 0) {
+                    while (len < (size_t)precision && s[len]) len++;
+                } else {
+                    len = strlen(s);
+                }
+                fmt_field(&b, "", 0, 0, s, (int)len, width, flags & ~FMT_ZERO);
                 break;
             }
-            case 'b': {
-                unsigned int v = va_arg(ap, unsigned int);
-                append_binary(out, size, &idx, v);
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                // `long double` é formatado com a precisão de `double`.
+                double v = (wide == 5) ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                if (conv == 'F' || conv == 'E' || conv == 'G') flags |= FMT_UPPER;
+                fmt_float(&b, v, (char)(conv | 0x20), width, precision, flags);
                 break;
             }
+            case '%':
+                fmt_put(&b, "%", 1);
+                break;
             default:
-                // Unknown specifier, print it literally
-                append_char(out, size, &idx, '%');
-                append_char(out, size, &idx, spec);
+                // Especificador desconhecido: escreve literalmente.
+                fmt_put(&b, "%", 1);
+                fmt_put(&b, &conv, 1);
                 break;
         }
     }
 
-    if (size > 0) {
-        out[(idx < size) ? idx : (size - 1)] = '\0';
-    }
+    out[b.idx] = '\0';
+    return b.idx;
 }
 
-void log_set_level(log_level_t level) {
-    current_level = level;
+size_t log_snprintf(char *out, size_t size, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t n = log_vsnprintf(out, size, fmt, ap);
+    va_end(ap);
+    return n;
 }
 
-void log_write(log_level_t level, const char *fmt, ...) {
-    if (level < current_level) {
-        return;
+// Escreve bytes sem tradução de fim de linha.
+static void log_emit_raw(const uint8_t *data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        LOG_PUTCHAR_RAW(data[i]);
     }
+}
 
+// Escreve uma mensagem já formatada, com prefixo e cor do nível.
+static void log_emit(log_level_t level, const char *msg) {
     /* Códigos de cor VT100 / ANSI */
     const char *color_reset = "\x1b[0m";
     const char *color_code = "";
@@ -183,16 +566,6 @@ void log_write(log_level_t level, const char *fmt, ...) {
         default:              color_code = "\x1b[0m";  break;
     }
 
-    char msg[256];
-    va_list ap;
-    va_start(ap, fmt);
-    if (format_has_binary(fmt)) {
-        log_vsnprintf(msg, sizeof msg, fmt, ap);
-    } else {
-        vsnprintf(msg, sizeof msg, fmt, ap);
-    }
-    va_end(ap);
-
     const char *prefix;
     switch (level) {
         case LOG_LEVEL_TRACE: prefix = "[TRACE] "; break;
@@ -205,3 +578,367 @@ void log_write(log_level_t level, const char *fmt, ...) {
     printf("%s%s%s%s\n", color_code, prefix, msg, color_reset);
 }
 
+static void ring_copy_in(uint32_t pos, const void *src, uint32_t len) {
+    uint32_t first = pos & LOG_RING_MASK;
+    uint32_t chunk = LOG_ASYNC_BUFFER_SIZE - first;
+    if (chunk > len) chunk = len;
+    memcpy(&log_ring[first], src, chunk);
+    memcpy(log_ring, (const uint8_t *)src + chunk, len - chunk);
+}
+
+static void ring_copy_out(uint32_t pos, void *dst, uint32_t len) {
+    uint32_t first = pos & LOG_RING_MASK;
+    uint32_t chunk = LOG_ASYNC_BUFFER_SIZE - first;
+    if (chunk > len) chunk = len;
+    memcpy(dst, &log_ring[first], chunk);
+    memcpy((uint8_t *)dst + chunk, log_ring, len - chunk);
+}
+
+// Copia um registro formatado para o anel assíncrono. Nunca bloqueia:
+// sem espaço, o registro é descartado e contabilizado.
+static void log_enqueue(uint8_t level, const void *msg, size_t len) {
+    if (len > 255) len = 255;
+    uint8_t header[LOG_RECORD_HEADER_SIZE] = { level, (uint8_t)len };
+    uint32_t needed = LOG_RECORD_HEADER_SIZE + (uint32_t)len;
+
+    LOG_CRITICAL_ENTER();
+    uint32_t head = log_ring_head;
+    uint32_t tail = log_ring_tail;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (LOG_ASYNC_BUFFER_SIZE - (head - tail) < needed) {
+        log_dropped++;
+    } else {
+        ring_copy_in(head, header, LOG_RECORD_HEADER_SIZE);
+        ring_copy_in(head + LOG_RECORD_HEADER_SIZE, msg, (uint32_t)len);
+        // Publica o texto antes de avançar o índice lido por `log_flush`.
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        log_ring_head = head + needed;
+    }
+    LOG_CRITICAL_EXIT();
+}
+
+void log_set_level(log_level_t level) {
+    current_level = level;
+}
+
+void log_set_mode(log_mode_t mode) {
+    if (mode == LOG_MODE_SYNC && current_mode == LOG_MODE_ASYNC) {
+        current_mode = LOG_MODE_SYNC;
+        log_flush(0);
+        return;
+    }
+    current_mode = mode;
+}
+
+log_mode_t log_get_mode(void) {
+    return current_mode;
+}
+
+uint32_t log_dropped_count(void) {
+    return log_dropped;
+}
+
+uint32_t log_flush(uint32_t max_records) {
+    uint32_t written = 0;
+    char msg[256];
+    while (max_records == 0 || written < max_records) {
+        uint32_t tail = log_ring_tail;
+        uint32_t head = log_ring_head;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (head == tail) break;
+
+        uint8_t header[LOG_RECORD_HEADER_SIZE];
+        ring_copy_out(tail, header, LOG_RECORD_HEADER_SIZE);
+        ring_copy_out(tail + LOG_RECORD_HEADER_SIZE, msg, header[1]);
+        msg[header[1]] = '\0';
+
+        // Libera o espaço antes da escrita lenta em `printf`.
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        log_ring_tail = tail + LOG_RECORD_HEADER_SIZE + header[1];
+
+        if (header[0] & LOG_RECORD_BINARY) {
+            log_emit_raw((const uint8_t *)msg, header[1]);
+        } else {
+            log_emit((log_level_t)header[0], msg);
+        }
+        written++;
+    }
+
+    // Os descartes ocorreram depois dos registros que já estavam no anel.
+    uint32_t dropped = log_dropped;
+    if (dropped != log_dropped_reported) {
+        log_snprintf(msg, sizeof msg, "%u registros de log descartados (anel cheio)", (unsigned)(dropped - log_dropped_reported));
+        log_dropped_reported = dropped;
+        log_emit(LOG_LEVEL_WARN, msg);
+    }
+    return written;
+}
+
+// Procura `tag` entre as `count` primeiras entradas da tabela.
+static int scan_tags(const char *tag, int count) {
+    for (int i = 0; i < count; i++) {
+        if (log_tags[i].name == tag || strcmp(log_tags[i].name, tag) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Procura `tag` na tabela; se `create`, insere quando não existir.
+// Retorna o índice ou -1. A busca não trava: entradas nunca são
+// removidas e só ficam visíveis depois de preenchidas. A inserção, que
+// pode vir de IRQ ou do core 1 (primeiro uso de um ponto de chamada), é
+// feita sob o mesmo spinlock do anel, refazendo a busca.
+static int find_tag(const char *tag, bool create) {
+    int i = scan_tags(tag, __atomic_load_n(&log_tag_count, __ATOMIC_ACQUIRE));
+    if (i >= 0 || !create) return i;
+
+    LOG_CRITICAL_ENTER();
+    int count = log_tag_count;
+    i = scan_tags(tag, count);
+    if (i < 0 && count < LOG_MAX_TAGS) {
+        log_tags[count].name = tag;
+        log_tags[count].level = -1;
+        // Publica a entrada antes de contá-la.
+        __atomic_store_n(&log_tag_count, (uint8_t)(count + 1), __ATOMIC_RELEASE);
+        i = count;
+    }
+    LOG_CRITICAL_EXIT();
+    return i;
+}
+
+int log_set_tag_level(const char *tag, log_level_t level) {
+    if (tag == NULL) return -1;
+    int i = find_tag(tag, true);
+    if (i < 0) return -1;
+    log_tags[i].level = (int8_t)level;
+    return 0;
+}
+
+void log_clear_tag_level(const char *tag) {
+    if (tag == NULL) return;
+    int i = find_tag(tag, false);
+    if (i >= 0) log_tags[i].level = -1;
+}
+
+void log_set_rate_limit(uint16_t per_second, uint16_t burst) {
+    rate_burst = (burst == 0) ? 1 : burst;
+    rate_per_second = per_second;
+}
+
+// Recarrega o balde de tokens do ponto e consome um token, se houver.
+static bool site_take_token(log_site_t *site) {
+    uint32_t now = LOG_TIMESTAMP_US();
+    uint32_t capacity = (uint32_t)rate_burst * 1000u;
+    if (site->tokens_milli == UINT32_MAX) {
+        // Primeira mensagem deste ponto: balde cheio.
+        site->tokens_milli = capacity;
+    } else {
+        uint64_t refill = ((uint64_t)(now - site->last_us) * rate_per_second) / 1000u;
+        uint64_t tokens = site->tokens_milli + refill;
+        site->tokens_milli = (tokens > capacity) ? capacity : (uint32_t)tokens;
+    }
+    site->last_us = now;
+
+    if (site->tokens_milli < 1000u) return false;
+    site->tokens_milli -= 1000u;
+    return true;
+}
+
+bool log_site_check(log_site_t *site, log_level_t level) {
+    if (site->tag_index < 0 && site->tag != NULL) {
+        site->tag_index = (int8_t)find_tag(site->tag, true);
+    }
+
+    int threshold = current_level;
+    if (site->tag_index >= 0 && log_tags[site->tag_index].level >= 0) {
+        threshold = log_tags[site->tag_index].level;
+    }
+    if ((int)level < threshold) return false;
+
+    if (rate_per_second == 0) return true;
+    if (!site_take_token(site)) {
+        site->suppressed++;
+        return false;
+    }
+    if (site->suppressed) {
+        uint32_t suppressed = site->suppressed;
+        site->suppressed = 0;
+        LOG_BACKEND_WRITE(LOG_LEVEL_WARN, site->tag, "%u mensagens suprimidas: \"%s\"", (unsigned)suppressed, site->fmt);
+    }
+    return true;
+}
+
+void log_vwrite_tagged(log_level_t level, const char *tag, const char *fmt, va_list ap) {
+    char msg[256];
+    size_t len = 0;
+    if (tag != NULL) {
+        len = log_snprintf(msg, sizeof msg, "[%s] ", tag);
+    }
+    len += log_vsnprintf(msg + len, sizeof msg - len, fmt, ap);
+
+    if (current_mode == LOG_MODE_ASYNC) {
+        log_enqueue((uint8_t)level, msg, len);
+        return;
+    }
+    log_emit(level, msg);
+}
+
+void log_write_tagged(log_level_t level, const char *tag, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite_tagged(level, tag, fmt, ap);
+    va_end(ap);
+}
+
+void log_write(log_level_t level, const char *fmt, ...) {
+    if (level < current_level) {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite_tagged(level, NULL, fmt, ap);
+    va_end(ap);
+}
+
+static size_t token_put(uint8_t *out, size_t idx, const void *src, size_t len) {
+    if (idx + len > LOG_TOKEN_MAX_PAYLOAD) return LOG_TOKEN_MAX_PAYLOAD + 1;
+    memcpy(out + idx, src, len);
+    return idx + len;
+}
+
+// Percorre `fmt` apenas para saber o tipo de cada argumento e copia os
+// valores brutos (sem conversão para texto) a partir de `out[idx]`.
+// Retorna o novo índice, ou LOG_TOKEN_MAX_PAYLOAD + 1 se não couber.
+static size_t token_pack_args(uint8_t *out, size_t idx, const char *fmt, va_list ap) {
+    while (*fmt && idx <= LOG_TOKEN_MAX_PAYLOAD) {
+        if (*fmt++ != '%') continue;
+        if (*fmt == '%') { fmt++; continue; }
+
+        // flags, largura e precisão ('*' consome um int)
+        while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0') fmt++;
+        if (*fmt == '*') { int32_t w = va_arg(ap, int); idx = token_put(out, idx, &w, 4); fmt++; }
+        while (*fmt >= '0' && *fmt <= '9') fmt++;
+        if (*fmt == '.') {
+            fmt++;
+            if (*fmt == '*') { int32_t p = va_arg(ap, int); idx = token_put(out, idx, &p, 4); fmt++; }
+            while (*fmt >= '0' && *fmt <= '9') fmt++;
+        }
+
+        // modificador de tamanho: só importa para saber o tipo C do
+        // argumento (0 = int, 1 = long, 2 = long long/intmax_t,
+        // 3 = size_t, 4 = ptrdiff_t, 5 = long double)
+        int wide = 0;
+        for (;; fmt++) {
+            if (*fmt == 'h') continue;
+            if (*fmt == 'L') { wide = 5; continue; }
+            if (*fmt == 'l') { wide = (fmt[1] == 'l') ? 2 : 1; if (wide == 2) fmt++; continue; }
+            if (*fmt == 'j') { wide = 2; continue; }
+            if (*fmt == 'z') { wide = 3; continue; }
+            if (*fmt == 't') { wide = 4; continue; }
+            break;
+        }
+
+        char spec = *fmt;
+        if (spec == '\0') break;
+        fmt++;
+        switch (spec) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b': case 'c': {
+                if (wide == 0) {
+                    uint32_t v = va_arg(ap, unsigned int);
+                    idx = token_put(out, idx, &v, 4);
+                } else {
+                    uint64_t v;
+                    switch (wide) {
+                        case 1:  v = (uint64_t)va_arg(ap, unsigned long); break;
+                        case 3:  v = (uint64_t)va_arg(ap, size_t); break;
+                        case 4:  v = (uint64_t)va_arg(ap, ptrdiff_t); break;
+                        default: v = (uint64_t)va_arg(ap, unsigned long long); break;
+                    }
+                    // sinal estendido para que o decodificador leia int64
+                    if ((spec == 'd' || spec == 'i') && wide == 1 && sizeof(long) == 4) {
+                        v = (uint64_t)(int64_t)(long)v;
+                    }
+                    idx = token_put(out, idx, &v, 8);
+                }
+                break;
+            }
+            case 'p': {
+                uint64_t v = (uint64_t)(uintptr_t)va_arg(ap, void *);
+                idx = token_put(out, idx, &v, 8);
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+                // `long double` vai como `double`: o quadro tem 8 bytes.
+                double v = (wide == 5) ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                idx = token_put(out, idx, &v, 8);
+                break;
+            }
+            case 's': {
+                const char *str = va_arg(ap, const char *);
+                if (!str) str = "(null)";
+                size_t n = strlen(str);
+                if (n > 64) n = 64;
+                uint8_t n8 = (uint8_t)n;
+                idx = token_put(out, idx, &n8, 1);
+                idx = token_put(out, idx, str, n);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return idx;
+}
+
+static void log_vwrite_tokenized(log_level_t level, const char *tag, const char *fmt, va_list ap) {
+    // 3 bytes de sincronismo/tamanho + carga + 1 byte de verificação
+    uint8_t frame[3 + LOG_TOKEN_MAX_PAYLOAD + 1];
+    uint8_t *payload = frame + 3;
+    uint32_t token = (uint32_t)(uintptr_t)fmt;
+    // A tag também vai como endereço (0 = sem tag).
+    uint32_t tag_token = (uint32_t)(uintptr_t)tag;
+    uint32_t timestamp = LOG_TIMESTAMP_US();
+
+    size_t idx = 0;
+    payload[idx++] = (uint8_t)level;
+    memcpy(payload + idx, &token, 4);     idx += 4;
+    memcpy(payload + idx, &tag_token, 4); idx += 4;
+    memcpy(payload + idx, &timestamp, 4); idx += 4;
+
+    size_t end = token_pack_args(payload, idx, fmt, ap);
+    if (end > LOG_TOKEN_MAX_PAYLOAD) {
+        // Argumentos não couberam: envia apenas o cabeçalho; o
+        // decodificador indica os argumentos ausentes.
+        end = idx;
+    }
+
+    uint8_t check = 0;
+    for (size_t i = 0; i < end; i++) check ^= payload[i];
+    frame[0] = LOG_TOKEN_SYNC0;
+    frame[1] = LOG_TOKEN_SYNC1;
+    frame[2] = (uint8_t)end;
+    payload[end] = check;
+    size_t frame_len = 3 + end + 1;
+
+    if (current_mode == LOG_MODE_ASYNC) {
+        log_enqueue(LOG_RECORD_BINARY | (uint8_t)level, frame, frame_len);
+        return;
+    }
+    log_emit_raw(frame, (uint32_t)frame_len);
+}
+
+void log_write_tokenized_tagged(log_level_t level, const char *tag, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite_tokenized(level, tag, fmt, ap);
+    va_end(ap);
+}
+
+void log_write_tokenized(log_level_t level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite_tokenized(level, NULL, fmt, ap);
+    va_end(ap);
+}
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Decodificador dos quadros de log tokenizados do log_vt100.
+
+Lê o fluxo binário emitido por `log_write_tokenized` (arquivo capturado ou
+porta serial) e reconstrói as mensagens de texto a partir das strings de
+formato contidas no ELF do firmware. O token de cada quadro é o endereço da
+string de formato e o da tag, o endereço da string da tag (0 sem tag), então
+o mesmo ELF que foi gravado na placa precisa ser usado na decodificação.
+
+Bytes fora de quadros (ex.: `printf` comuns) são repassados como texto.
+
+Uso:
+    log_token_decode.py server.elf captura.bin
+    log_token_decode.py server.elf /dev/ttyACM0
+    log_token_decode.py server.elf --dump-table     # lista as strings
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+LEVELS = {0: "TRACE", 1: "DEBUG", 2: "INFO ", 3: "WARN "}
+COLORS = {0: "\x1b[90m", 1: "\x1b[34m", 2: "\x1b[32m", 3: "\x1b[33m"}
+RESET = "\x1b[0m"
+# level + token + tag + timestamp
+HEADER_SIZE = 13
+
+SPEC_RE = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diuxXobcpfFeEgGs%])")
+
+
+class StringTable:
+    """Segmentos carregáveis do ELF, para ler strings pelo endereço."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError(f"{path}: não é um arquivo ELF")
+        is64 = data[4] == 2
+        if is64:
+            phoff, = struct.unpack_from("<Q", data, 0x20)
+            phentsize, phnum = struct.unpack_from("<HH", data, 0x36)
+        else:
+            phoff, = struct.unpack_from("<I", data, 0x1C)
+            phentsize, phnum = struct.unpack_from("<HH", data, 0x2A)
+
+        self.segments = []
+        for i in range(phnum):
+            off = phoff + i * phentsize
+            if is64:
+                p_type, _, p_offset, p_vaddr, _, p_filesz = struct.unpack_from("<IIQQQQ", data, off)
+            else:
+                p_type, p_offset, p_vaddr, _, p_filesz = struct.unpack_from("<IIIII", data, off)
+            if p_type == 1 and p_filesz:  # PT_LOAD
+                self.segments.append((p_vaddr & 0xFFFFFFFF, data[p_offset:p_offset + p_filesz]))
+        self.cache = {}
+
+    def lookup(self, address):
+        if address in self.cache:
+            return self.cache[address]
+        text = None
+        for base, blob in self.segments:
+            if base <= address < base + len(blob):
+                start = address - base
+                end = blob.find(b"\0", start)
+                if end < 0:
+                    end = len(blob)
+                text = blob[start:end].decode("utf-8", errors="replace")
+                break
+        self.cache[address] = text
+        return text
+
+
+def format_message(fmt, args):
+    """Aplica os argumentos brutos à string de formato, no estilo printf."""
+    out = []
+    pos = 0
+    idx = 0
+
+    def take(n):
+        nonlocal idx
+        if idx + n > len(args):
+            raise IndexError
+        chunk = args[idx:idx + n]
+        idx += n
+        return chunk
+
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        try:
+            if width == "*":
+                width = str(struct.unpack("<i", take(4))[0])
+            if prec == "*":
+                prec = str(struct.unpack("<i", take(4))[0])
+            spec = "%" + (flags or "") + (width or "") + ("." + prec if prec is not None else "")
+            wide = length in ("l", "ll", "j", "z", "t")
+            if conv in "di":
+                v = struct.unpack("<q" if wide else "<i", take(8 if wide else 4))[0]
+                out.append((spec + "d") % v)
+            elif conv in "uxXoc":
+                v = struct.unpack("<Q" if wide else "<I", take(8 if wide else 4))[0]
+                if conv == "c":
+                    out.append((spec + "c") % chr(v & 0xFF))
+                else:
+                    out.append((spec + ("d" if conv == "u" else conv)) % v)
+            elif conv == "b":
+                v = struct.unpack("<Q" if wide else "<I", take(8 if wide else 4))[0]
+                out.append(format(v, "b"))
+            elif conv == "p":
+                v = struct.unpack("<Q", take(8))[0]
+                out.append("0x%x" % v)
+            elif conv in "fFeEgG":
+                v = struct.unpack("<d", take(8))[0]
+                out.append((spec + conv) % v)
+            elif conv == "s":
+                n = take(1)[0]
+                out.append((spec + "s") % take(n).decode("utf-8", errors="replace"))
+        except IndexError:
+            out.append("<?>")
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode_stream(stream, table, color, out):
+    buf = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buf += chunk
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                # mantém um possível primeiro byte de sincronismo no fim
+                keep = 1 if buf.endswith(SYNC[:1]) else 0
+                text = buf[:len(buf) - keep]
+                if text:
+                    out.write(text.decode("utf-8", errors="replace"))
+                buf = buf[len(buf) - keep:]
+                break
+            if start > 0:
+                out.write(buf[:start].decode("utf-8", errors="replace"))
+                buf = buf[start:]
+            if len(buf) < 3:
+                break
+            length = buf[2]
+            if len(buf) < 3 + length + 1:
+                break
+            payload = buf[3:3 + length]
+            check = 0
+            for b in payload:
+                check ^= b
+            if length < HEADER_SIZE or check != buf[3 + length]:
+                # falso sincronismo: repassa o byte e continua
+                out.write(buf[:1].decode("latin-1"))
+                buf = buf[1:]
+                continue
+            buf = buf[3 + length + 1:]
+
+            level = payload[0]
+            token, tag_token, timestamp = struct.unpack_from("<III", payload, 1)
+            fmt = table.lookup(token)
+            if fmt is None:
+                message = f"<token desconhecido 0x{token:08x}>"
+            else:
+                message = format_message(fmt, payload[HEADER_SIZE:])
+            if tag_token:
+                tag = table.lookup(tag_token)
+                message = f"[{tag if tag is not None else f'0x{tag_token:08x}'}] {message}"
+            prefix = f"[{LEVELS.get(level, 'LOG  ')}] {timestamp / 1e6:12.6f} "
+            if color:
+                out.write(f"{COLORS.get(level, RESET)}{prefix}{message}{RESET}\n")
+            else:
+                out.write(f"{prefix}{message}\n")
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodifica logs tokenizados do log_vt100")
+    parser.add_argument("elf", help="ELF do firmware que gerou o log")
+    parser.add_argument("input", nargs="?", default="-", help="arquivo ou porta serial (padrão: stdin)")
+    parser.add_argument("--no-color", action="store_true", help="não usar cores VT100")
+    parser.add_argument("--dump-table", action="store_true", help="lista as strings de formato do ELF e sai")
+    args = parser.parse_args()
+
+    table = StringTable(args.elf)
+    if args.dump_table:
+        for base, blob in table.segments:
+            for m in re.finditer(rb"[\x20-\x7e\xc0-\xff][^\0]*%[^\0]*\0", blob):
+                print(f"0x{base + m.start():08x}: {m.group()[:-1].decode('utf-8', errors='replace')}")
+        return
+
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb", buffering=0)
+    try:
+        decode_stream(stream, table, not args.no_color, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+#include "notify_policy.h"
+
+#include <stddef.h>
+
+void notify_policy_init(notify_policy_t *policy, const notify_policy_config_t *config) {
+    policy->config = *config;
+    policy->evaluated = 0;
+    policy->sent = 0;
+    notify_policy_reset(policy);
+}
+
+void notify_policy_configure(notify_policy_t *policy, const notify_policy_config_t *config) {
+    policy->config = *config;
+}
+
+void notify_policy_reset(notify_policy_t *policy) {
+    policy->last_value = 0;
+    policy->last_us = 0;
+    policy->has_sent = false;
+    policy->changed = false;
+}
+
+bool notify_policy_update(notify_policy_t *policy, uint16_t sample, uint32_t now_us) {
+    policy->evaluated++;
+    if (!policy->has_sent) return true;
+
+    uint16_t delta = (sample > policy->last_value) ? (uint16_t)(sample - policy->last_value)
+                                                   : (uint16_t)(policy->last_value - sample);
+    if (delta > policy->config.deadband) policy->changed = true;
+
+    uint32_t elapsed_us = now_us - policy->last_us;
+    if (policy->changed && elapsed_us >= policy->config.min_interval_us) return true;
+    if (policy->config.max_interval_us != 0 && elapsed_us >= policy->config.max_interval_us) return true;
+    return false;
+}
+
+void notify_policy_sent(notify_policy_t *policy, uint16_t value, uint32_t now_us) {
+    policy->last_value = value;
+    policy->last_us = now_us;
+    policy->has_sent = true;
+    policy->changed = false;
+    policy->sent++;
+}
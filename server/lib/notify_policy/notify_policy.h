@@ -0,0 +1,61 @@
+#ifndef NOTIFY_POLICY_H
+#define NOTIFY_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Política de notificação dirigida por mudança.
+//
+// Cada amostra é avaliada contra o último valor notificado:
+//  - variação maior que `deadband` marca uma mudança pendente, que é
+//    notificada assim que tiver passado `min_interval_us` desde a última
+//    notificação (limite de taxa);
+//  - sem mudanças, uma notificação de manutenção ("keep-alive") sai a
+//    cada `max_interval_us` (0 desativa);
+//  - a primeira avaliação após `notify_policy_reset` sempre notifica.
+//
+// Com `deadband` 0 e `min_interval_us` 0, qualquer mudança é notificada
+// de imediato. A política não envia nada: quem a usa chama
+// `notify_policy_sent` quando a notificação efetivamente sai.
+typedef struct {
+    uint16_t deadband;         // variação mínima, em contagens do ADC
+    uint32_t min_interval_us;  // intervalo mínimo entre notificações
+    uint32_t max_interval_us;  // intervalo máximo (keep-alive); 0 = nunca
+} notify_policy_config_t;
+
+typedef struct {
+    notify_policy_config_t config;
+    uint16_t last_value;       // último valor notificado
+    uint32_t last_us;          // instante da última notificação
+    bool has_sent;             // false até a primeira notificação
+    bool changed;              // mudança acima da banda aguardando envio
+    uint32_t evaluated;        // amostras avaliadas
+    uint32_t sent;             // notificações enviadas (mudança + keep-alive)
+} notify_policy_t;
+
+// Inicializa a política com `config`.
+void notify_policy_init(notify_policy_t *policy, const notify_policy_config_t *config);
+
+// Troca a configuração, mantendo o estado (último valor e instante).
+void notify_policy_configure(notify_policy_t *policy, const notify_policy_config_t *config);
+
+// Esquece o último valor notificado: a próxima avaliação notifica
+// (ex.: quando o cliente habilita as notificações).
+void notify_policy_reset(notify_policy_t *policy);
+
+// Avalia uma amostra no instante `now_us`. Retorna true se uma
+// notificação deve ser enviada agora.
+bool notify_policy_update(notify_policy_t *policy, uint16_t sample, uint32_t now_us);
+
+// Registra que `value` foi notificado no instante `now_us`.
+void notify_policy_sent(notify_policy_t *policy, uint16_t value, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NOTIFY_POLICY_H
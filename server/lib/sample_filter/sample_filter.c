@@ -0,0 +1,179 @@
+#include "sample_filter.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static int config_valid(const sample_filter_config_t *config) {
+    switch (config->type) {
+        case SAMPLE_FILTER_NONE:
+            return 1;
+        case SAMPLE_FILTER_DECIMATE:
+            return config->shift >= 1 && config->shift <= SAMPLE_FILTER_MAX_DECIMATE_SHIFT;
+        case SAMPLE_FILTER_MOVING_AVERAGE:
+            return config->shift >= 1 && config->shift <= SAMPLE_FILTER_MAX_AVERAGE_SHIFT;
+        case SAMPLE_FILTER_CIC:
+            return config->shift >= 1 && config->shift <= SAMPLE_FILTER_MAX_CIC_SHIFT &&
+                   config->order >= 1 && config->order <= SAMPLE_FILTER_MAX_CIC_ORDER &&
+                   config->order * config->shift <= SAMPLE_FILTER_MAX_CIC_GROWTH;
+        case SAMPLE_FILTER_IIR:
+            return config->shift >= 1 && config->shift <= SAMPLE_FILTER_MAX_IIR_SHIFT;
+    }
+    return 0;
+}
+
+int sample_filter_init(sample_filter_t *filter, const sample_filter_config_t *config) {
+    int ok = config != NULL && config_valid(config);
+    if (ok) {
+        filter->config = *config;
+    } else {
+        filter->config.type = SAMPLE_FILTER_NONE;
+        filter->config.shift = 0;
+        filter->config.order = 0;
+    }
+
+    switch (filter->config.type) {
+        case SAMPLE_FILTER_DECIMATE: filter->decimation = 1u << (2u * filter->config.shift); break;
+        case SAMPLE_FILTER_CIC:      filter->decimation = 1u << filter->config.shift; break;
+        default:                     filter->decimation = 1; break;
+    }
+    sample_filter_reset(filter);
+    return ok ? 0 : -1;
+}
+
+void sample_filter_reset(sample_filter_t *filter) {
+    filter->phase = 0;
+    filter->primed = 0;
+    filter->acc = 0;
+    filter->pos = 0;
+    memset(filter->integrator, 0, sizeof(filter->integrator));
+    memset(filter->comb, 0, sizeof(filter->comb));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Soma 4^shift entradas e desloca `shift` bits, com arredondamento.
+static uint32_t process_decimate(sample_filter_t *f, const uint16_t *in, uint32_t count, uint16_t *out) {
+    const uint32_t shift = f->config.shift;
+    const uint32_t round = 1u << (shift - 1);
+    uint32_t acc = f->acc;
+    uint32_t phase = f->phase;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        acc += in[i];
+        if (++phase == f->decimation) {
+            out[n++] = (uint16_t)((acc + round) >> shift);
+            acc = 0;
+            phase = 0;
+        }
+    }
+    f->acc = acc;
+    f->phase = phase;
+    return n;
+}
+
+// Soma corrente da janela: entra a amostra nova, sai a mais antiga.
+// O histórico começa preenchido com a primeira entrada, sem transitório
+// a partir de zero.
+static uint32_t process_moving_average(sample_filter_t *f, const uint16_t *in, uint32_t count, uint16_t *out) {
+    const uint32_t shift = f->config.shift;
+    const uint32_t mask = (1u << shift) - 1;
+    const uint32_t round = 1u << (shift - 1);
+    if (count == 0) return 0;
+    if (!f->primed) {
+        for (uint32_t i = 0; i <= mask; i++) f->history[i] = in[0];
+        f->acc = (uint32_t)in[0] << shift;
+        f->primed = 1;
+    }
+    uint32_t acc = f->acc;
+    uint32_t pos = f->pos;
+    uint16_t *history = f->history;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t x = in[i];
+        acc += x - history[pos];
+        history[pos] = x;
+        pos = (pos + 1) & mask;
+        out[i] = (uint16_t)((acc + round) >> shift);
+    }
+    f->acc = acc;
+    f->pos = pos;
+    return count;
+}
+
+// Integradores na taxa de entrada e pentes (atraso diferencial 1) na
+// taxa de saída. A aritmética modular de 32 bits dispensa saturação:
+// o resultado final cabe em 12 + order * shift <= 32 bits, então os
+// estouros intermediários se cancelam. As primeiras `order` saídas são
+// transitórias.
+static uint32_t process_cic(sample_filter_t *f, const uint16_t *in, uint32_t count, uint16_t *out) {
+    const uint32_t order = f->config.order;
+    const uint32_t growth = order * f->config.shift;
+    const uint32_t round = 1u << (growth - 1);
+    uint32_t *integrator = f->integrator;
+    uint32_t *comb = f->comb;
+    uint32_t phase = f->phase;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t v = in[i];
+        for (uint32_t s = 0; s < order; s++) {
+            integrator[s] += v;
+            v = integrator[s];
+        }
+        if (++phase == f->decimation) {
+            phase = 0;
+            for (uint32_t s = 0; s < order; s++) {
+                uint32_t previous = comb[s];
+                comb[s] = v;
+                v -= previous;
+            }
+            out[n++] = (uint16_t)((v + round) >> growth);
+        }
+    }
+    f->phase = phase;
+    return n;
+}
+
+// y += (x - y) >> shift em Q16 (16 bits fracionários), o que mantém a
+// resolução do estado mesmo com constantes de tempo longas. O estado
+// começa na primeira entrada.
+static uint32_t process_iir(sample_filter_t *f, const uint16_t *in, uint32_t count, uint16_t *out) {
+    const uint32_t shift = f->config.shift;
+    if (count == 0) return 0;
+    if (!f->primed) {
+        f->acc = (uint32_t)in[0] << 16;
+        f->primed = 1;
+    }
+    int32_t y = (int32_t)f->acc;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t x = (int32_t)in[i] << 16;
+        y += (x - y) >> shift;
+        out[i] = (uint16_t)((y + 0x8000) >> 16);
+    }
+    f->acc = (uint32_t)y;
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t sample_filter_process(sample_filter_t *filter, const uint16_t *in, uint32_t count, uint16_t *out) {
+    switch (filter->config.type) {
+        case SAMPLE_FILTER_DECIMATE:       return process_decimate(filter, in, count, out);
+        case SAMPLE_FILTER_MOVING_AVERAGE: return process_moving_average(filter, in, count, out);
+        case SAMPLE_FILTER_CIC:            return process_cic(filter, in, count, out);
+        case SAMPLE_FILTER_IIR:            return process_iir(filter, in, count, out);
+        case SAMPLE_FILTER_NONE:
+            break;
+    }
+    if (out != in) memmove(out, in, count * sizeof(uint16_t));
+    return count;
+}
+
+const char *sample_filter_name(sample_filter_type_t type) {
+    switch (type) {
+        case SAMPLE_FILTER_NONE:           return "nenhum";
+        case SAMPLE_FILTER_DECIMATE:       return "dizimação";
+        case SAMPLE_FILTER_MOVING_AVERAGE: return "média móvel";
+        case SAMPLE_FILTER_CIC:            return "CIC";
+        case SAMPLE_FILTER_IIR:            return "IIR";
+    }
+    return "?";
+}
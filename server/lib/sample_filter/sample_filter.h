@@ -0,0 +1,91 @@
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Estágio de filtragem entre o ADC e o caminho de notificação.
+//
+// Toda a aritmética é inteira (sem FPU no Cortex-M0+ do RP2040) e o
+// processamento é feito em blocos: cada chamada de `sample_filter_process`
+// consome um vetor de amostras de 12 bits e produz as saídas prontas, com
+// o estado preservado entre blocos. Os tipos com dizimação produzem uma
+// saída a cada `sample_filter_decimation()` entradas.
+typedef enum {
+    // Repassa as amostras sem alteração.
+    SAMPLE_FILTER_NONE = 0,
+    // Sobreamostragem e dizimação: soma 4^shift entradas e desloca
+    // `shift` bits, ganhando `shift` bits efetivos (saída de 12 + shift bits).
+    SAMPLE_FILTER_DECIMATE,
+    // Média móvel de 2^shift entradas, uma saída por entrada.
+    SAMPLE_FILTER_MOVING_AVERAGE,
+    // CIC (cascata integrador-pente) de `order` estágios com dizimação
+    // 2^shift; ganho normalizado, saída de 12 bits.
+    SAMPLE_FILTER_CIC,
+    // Passa-baixas de um polo, y += (x - y) / 2^shift, com estado em Q16;
+    // uma saída por entrada.
+    SAMPLE_FILTER_IIR,
+} sample_filter_type_t;
+
+// Limites da configuração.
+#define SAMPLE_FILTER_MAX_DECIMATE_SHIFT 4u    // 256 entradas, saída de 16 bits
+#define SAMPLE_FILTER_MAX_AVERAGE_SHIFT  6u    // janela de 64 amostras
+#define SAMPLE_FILTER_MAX_CIC_ORDER      4u
+#define SAMPLE_FILTER_MAX_CIC_SHIFT      8u    // dizimação até 256
+#define SAMPLE_FILTER_MAX_CIC_GROWTH     20u   // order * shift: 12 + 20 bits cabem em 32
+#define SAMPLE_FILTER_MAX_IIR_SHIFT      15u
+
+// Maior número de entradas por saída entre todos os tipos.
+#define SAMPLE_FILTER_MAX_DECIMATION     256u
+
+// Configuração do filtro.
+//  - type: um dos SAMPLE_FILTER_*;
+//  - shift: log2 do fator (dizimação, janela ou constante de tempo);
+//  - order: número de estágios do CIC (ignorado pelos demais tipos).
+typedef struct {
+    sample_filter_type_t type;
+    uint8_t shift;
+    uint8_t order;
+} sample_filter_config_t;
+
+typedef struct {
+    sample_filter_config_t config;
+    uint32_t decimation;   // entradas por saída
+    uint32_t phase;        // entradas acumuladas para a próxima saída
+    uint32_t primed;       // 0 até a primeira entrada (média móvel e IIR)
+    uint32_t acc;          // soma (dizimação e média móvel) ou estado Q16 (IIR)
+    uint32_t pos;          // posição do histórico da média móvel
+    uint32_t integrator[SAMPLE_FILTER_MAX_CIC_ORDER];
+    uint32_t comb[SAMPLE_FILTER_MAX_CIC_ORDER];
+    uint16_t history[1u << SAMPLE_FILTER_MAX_AVERAGE_SHIFT];
+} sample_filter_t;
+
+// Inicializa o filtro com `config` e zera o estado.
+// Retorna 0 em caso de sucesso ou valor negativo se a configuração
+// estiver fora dos limites (o filtro fica como SAMPLE_FILTER_NONE).
+int sample_filter_init(sample_filter_t *filter, const sample_filter_config_t *config);
+
+// Zera o estado, mantendo a configuração.
+void sample_filter_reset(sample_filter_t *filter);
+
+// Entradas consumidas por saída (1 para os tipos sem dizimação).
+static inline uint32_t sample_filter_decimation(const sample_filter_t *filter) {
+    return filter->decimation;
+}
+
+// Filtra `count` amostras de `in`, escrevendo as saídas em `out`, que
+// precisa comportar count / decimação + 1 amostras. `out` pode ser igual
+// a `in` (filtragem no próprio buffer). Retorna o número de saídas.
+uint32_t sample_filter_process(sample_filter_t *filter, const uint16_t *in, uint32_t count, uint16_t *out);
+
+// Nome do tipo, para logs.
+const char *sample_filter_name(sample_filter_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_FILTER_H
@@ -0,0 +1,31 @@
+#include "link_profile.h"
+
+#include <stddef.h>
+
+// O tempo de supervisão precisa ser maior que
+// (1 + latency) * interval_max * 2 (Core Spec, Vol 6, Part B, 4.5.2).
+static const link_profile_params_t profiles[LINK_PROFILE_COUNT] = {
+    [LINK_PROFILE_LOW_LATENCY]  = { "baixa latência", 6, 6, 0, 100 },
+    [LINK_PROFILE_BALANCED]     = { "equilibrado", 24, 40, 0, 400 },
+    [LINK_PROFILE_POWER_SAVING] = { "economia de energia", 80, 160, 4, 600 },
+};
+
+const link_profile_params_t *link_profile_params(link_profile_t profile) {
+    if ((unsigned)profile >= LINK_PROFILE_COUNT) return NULL;
+    return &profiles[profile];
+}
+
+int link_profile_matches(link_profile_t profile, uint16_t interval, uint16_t latency) {
+    const link_profile_params_t *params = link_profile_params(profile);
+    if (params == NULL) return 0;
+    return interval >= params->interval_min && interval <= params->interval_max && latency == params->latency;
+}
+
+const char *link_phy_name(uint8_t phy) {
+    switch (phy) {
+        case LINK_PHY_1M:    return "1M";
+        case LINK_PHY_2M:    return "2M";
+        case LINK_PHY_CODED: return "Coded";
+        default:             return "?";
+    }
+}
@@ -0,0 +1,67 @@
+#include "sample_broadcast.h"
+
+#include <stddef.h>
+
+uint8_t sample_broadcast_encode(uint8_t *out, uint8_t out_size, uint16_t first_index,
+                                const uint16_t *samples, uint8_t count) {
+    uint8_t len = (uint8_t)(SAMPLE_BROADCAST_HEADER_SIZE + 2 * count);
+    if (out == NULL || count > SAMPLE_BROADCAST_MAX_SAMPLES || len > out_size) return 0;
+
+    out[0] = (uint8_t)(len - 1);
+    out[1] = 0x16;
+    out[2] = (uint8_t)(SAMPLE_BROADCAST_UUID16 & 0xFF);
+    out[3] = (uint8_t)(SAMPLE_BROADCAST_UUID16 >> 8);
+    out[4] = (uint8_t)(first_index & 0xFF);
+    out[5] = (uint8_t)(first_index >> 8);
+    out[6] = count;
+
+    uint8_t *p = out + SAMPLE_BROADCAST_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++) {
+        *p++ = (uint8_t)(samples[i] & 0xFF);
+        *p++ = (uint8_t)(samples[i] >> 8);
+    }
+    return len;
+}
+
+int sample_broadcast_decode(const uint8_t *adv_data, uint8_t adv_len, uint16_t *first_index,
+                            const uint8_t **samples) {
+    uint8_t pos = 0;
+    while (pos + 1 < adv_len) {
+        uint8_t field_len = adv_data[pos];
+        if (field_len == 0 || pos + 1 + field_len > adv_len) return -1;
+        const uint8_t *field = &adv_data[pos];
+        pos = (uint8_t)(pos + 1 + field_len);
+        if (field[1] != 0x16 || field_len + 1 < SAMPLE_BROADCAST_HEADER_SIZE) continue;
+        if ((field[2] | (field[3] << 8)) != SAMPLE_BROADCAST_UUID16) continue;
+        uint8_t count = field[6];
+        if (SAMPLE_BROADCAST_HEADER_SIZE + 2 * count != field_len + 1) return -1;
+        *first_index = (uint16_t)(field[4] | (field[5] << 8));
+        *samples = field + SAMPLE_BROADCAST_HEADER_SIZE;
+        return count;
+    }
+    return -1;
+}
+
+uint8_t sample_broadcast_rx_update(sample_broadcast_rx_t *rx, uint16_t first_index, uint8_t count) {
+    rx->reports++;
+    uint16_t end = (uint16_t)(first_index + count);
+    uint8_t start = 0;
+    if (rx->valid) {
+        int16_t ahead = (int16_t)(end - rx->next_index);
+        if (ahead <= 0 && ahead > -(int16_t)(2 * SAMPLE_BROADCAST_MAX_SAMPLES)) {
+            // Repetição (o mesmo anúncio é emitido várias vezes) ou atraso.
+            return count;
+        }
+        int16_t skip = (int16_t)(rx->next_index - first_index);
+        if (ahead > 0 && skip >= 0) {
+            start = (uint8_t)skip;
+        } else if (ahead > 0) {
+            // Atualizações perdidas: amostras entre a última vista e a janela.
+            rx->lost += (uint16_t)(first_index - rx->next_index);
+        }
+    }
+    rx->valid = 1;
+    rx->next_index = end;
+    rx->delivered += count - start;
+    return start;
+}
@@ -0,0 +1,88 @@
+#include "sample_codec.h"
+
+#include <stddef.h>
+
+uint16_t sample_codec_pack12(uint8_t *out, uint16_t out_size, const uint16_t *samples, uint16_t count) {
+    uint16_t len = SAMPLE_CODEC_PACKED12_SIZE(count);
+    if (out == NULL || count == 0 || len > out_size) return 0;
+
+    uint16_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint16_t a = samples[i];
+        uint16_t b = samples[i + 1];
+        if ((a | b) > SAMPLE_CODEC_MAX_12BIT) return 0;
+        *out++ = (uint8_t)a;
+        *out++ = (uint8_t)((a >> 8) | (b << 4));
+        *out++ = (uint8_t)(b >> 4);
+    }
+    if (i < count) {
+        if (samples[i] > SAMPLE_CODEC_MAX_12BIT) return 0;
+        *out++ = (uint8_t)samples[i];
+        *out = (uint8_t)(samples[i] >> 8);
+    }
+    return len;
+}
+
+int sample_codec_unpack12(const uint8_t *in, uint16_t len, uint16_t *samples, uint16_t count) {
+    uint16_t size = SAMPLE_CODEC_PACKED12_SIZE(count);
+    if (in == NULL || len < size) return -1;
+
+    uint16_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        samples[i] = (uint16_t)(in[0] | ((in[1] & 0x0F) << 8));
+        samples[i + 1] = (uint16_t)((in[1] >> 4) | (in[2] << 4));
+        in += 3;
+    }
+    if (i < count) {
+        samples[i] = (uint16_t)(in[0] | ((in[1] & 0x0F) << 8));
+    }
+    return size;
+}
+
+uint16_t sample_codec_delta_encode(uint8_t *out, uint16_t out_size, const uint16_t *samples, uint16_t *count) {
+    if (out == NULL || *count == 0 || out_size < 2) {
+        *count = 0;
+        return 0;
+    }
+
+    out[0] = (uint8_t)samples[0];
+    out[1] = (uint8_t)(samples[0] >> 8);
+    uint16_t len = 2;
+    uint16_t i = 1;
+    for (; i < *count; i++) {
+        uint16_t value = sample_codec_zigzag((int16_t)(samples[i] - samples[i - 1]));
+        uint16_t size = (value < 0x80) ? 1 : (value < 0x4000) ? 2 : 3;
+        if (len + size > out_size) break;
+        while (value >= 0x80) {
+            out[len++] = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        out[len++] = (uint8_t)value;
+    }
+    *count = i;
+    return len;
+}
+
+int sample_codec_delta_decode(const uint8_t *in, uint16_t len, uint16_t *samples, uint16_t count) {
+    if (count == 0) return 0;
+    if (in == NULL || len < 2) return -1;
+
+    uint16_t sample = (uint16_t)(in[0] | (in[1] << 8));
+    samples[0] = sample;
+    uint16_t pos = 2;
+    for (uint16_t i = 1; i < count; i++) {
+        uint16_t value = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+        do {
+            if (pos >= len) return -1;
+            if (shift > 14) return -2;
+            byte = in[pos++];
+            value |= (uint16_t)((byte & 0x7F) << shift);
+            shift += 7;
+        } while (byte & 0x80);
+        sample = (uint16_t)(sample + sample_codec_unzigzag(value));
+        samples[i] = sample;
+    }
+    return pos;
+}
@@ -0,0 +1,70 @@
+#ifndef SAMPLE_CONTROL_H
+#define SAMPLE_CONTROL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Formato da característica "Sample Control" (ponto de controle), com a
+// qual o cliente ajusta a amostragem e as notificações do servidor em
+// tempo de execução, sem regravar o firmware nem derrubar a conexão.
+// Compartilhado entre o servidor (aplica) e o cliente (escreve).
+//
+//  byte 0      : fields             - máscara SAMPLE_CONTROL_*: campos a aplicar
+//  bytes 1..4  : sample_rate_hz     - taxa de amostragem (uint32)
+//  bytes 5..6  : notify_interval_ms - intervalo mínimo entre notificações (uint16)
+//  byte 7      : batch_size         - máximo de amostras por lote (0 = o que couber no MTU)
+//  byte 8      : averaging          - conversões por amostra (média)
+//  bytes 9..10 : deadband           - banda morta da política de notificação (uint16)
+//  bytes 11..12: keepalive_ms       - intervalo máximo entre notificações (uint16, 0 = sem)
+//
+// Todos os campos são little endian. Na escrita, só os campos marcados em
+// `fields` são aplicados (os demais são ignorados); se algum valor for
+// recusado, nenhum é aplicado. A leitura devolve a configuração em uso,
+// com os campos suportados marcados.
+
+// UUID de 128 bits da característica "Sample Control" (mesmo valor usado
+// em `temp_sensor.gatt`), em ordem big endian como esperado pela BTstack.
+#define SAMPLE_CONTROL_CHARACTERISTIC_UUID128 \
+    { 0x5A, 0x1E, 0x00, 0x03, 0x6C, 0x3B, 0x4D, 0x2C, \
+      0x9A, 0x5E, 0x2F, 0x0B, 0x7E, 0x1C, 0x0A, 0x01 }
+
+// Tamanho do valor da característica, em bytes.
+#define SAMPLE_CONTROL_SIZE 13
+
+// Bits de `fields`.
+#define SAMPLE_CONTROL_SAMPLE_RATE     0x01
+#define SAMPLE_CONTROL_NOTIFY_INTERVAL 0x02
+#define SAMPLE_CONTROL_BATCH_SIZE      0x04
+#define SAMPLE_CONTROL_AVERAGING       0x08
+#define SAMPLE_CONTROL_DEADBAND        0x10
+#define SAMPLE_CONTROL_KEEPALIVE       0x20
+#define SAMPLE_CONTROL_ALL             0x3F
+
+// Valor decodificado da característica.
+typedef struct {
+    uint8_t fields;
+    uint32_t sample_rate_hz;
+    uint16_t notify_interval_ms;
+    uint8_t batch_size;
+    uint8_t averaging;
+    uint16_t deadband;
+    uint16_t keepalive_ms;
+} sample_control_t;
+
+// Codifica `control` em `out` (até `out_size` bytes).
+// Retorna SAMPLE_CONTROL_SIZE ou 0 se não couber.
+uint16_t sample_control_encode(uint8_t *out, uint16_t out_size, const sample_control_t *control);
+
+// Decodifica um valor escrito na característica.
+// Retorna 0 em caso de sucesso ou valor negativo se o tamanho for
+// inválido ou houver bits desconhecidos em `fields`.
+int sample_control_decode(const uint8_t *in, uint16_t len, sample_control_t *control);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_CONTROL_H
@@ -0,0 +1,153 @@
+#include "sample_packet.h"
+
+#include <stddef.h>
+
+#include "sample_codec.h"
+
+uint16_t sample_packet_header_size(uint8_t flags) {
+    return (flags & SAMPLE_PACKET_FLAG_TIMESTAMP) ? SAMPLE_PACKET_MAX_HEADER_SIZE : SAMPLE_PACKET_HEADER_SIZE;
+}
+
+uint16_t sample_packet_capacity(uint16_t payload_size, uint8_t flags) {
+    uint16_t header_size = sample_packet_header_size(flags);
+    if (payload_size <= header_size) return 0;
+    uint16_t room = (uint16_t)(payload_size - header_size);
+    uint16_t n;
+    switch (flags & SAMPLE_PACKET_ENCODING_MASK) {
+        case SAMPLE_PACKET_ENCODING_PACKED12:
+            n = (uint16_t)(room * 2 / 3);
+            break;
+        case SAMPLE_PACKET_ENCODING_DELTA:
+            n = (room < 2) ? 0 : (uint16_t)(room - 1);
+            break;
+        default:
+            n = (uint16_t)(room / 2);
+            break;
+    }
+    return (n > SAMPLE_PACKET_MAX_SAMPLES) ? SAMPLE_PACKET_MAX_SAMPLES : n;
+}
+
+uint16_t sample_packet_encode(uint8_t *out, uint16_t out_size, sample_packet_header_t *header,
+                              const uint16_t *samples) {
+    if (header == NULL) return 0;
+    uint16_t header_size = sample_packet_header_size(header->flags);
+    if (out == NULL || header_size > out_size) return 0;
+
+    uint8_t *p = out + header_size;
+    uint16_t room = (uint16_t)(out_size - header_size);
+    uint16_t size;
+    switch (header->flags & SAMPLE_PACKET_ENCODING_MASK) {
+        case SAMPLE_PACKET_ENCODING_RAW16:
+            size = (uint16_t)(2 * header->count);
+            if (size > room) return 0;
+            for (uint8_t i = 0; i < header->count; i++) {
+                *p++ = (uint8_t)(samples[i] & 0xFF);
+                *p++ = (uint8_t)(samples[i] >> 8);
+            }
+            break;
+        case SAMPLE_PACKET_ENCODING_PACKED12:
+            if (header->count == 0) {
+                size = 0;
+                break;
+            }
+            size = sample_codec_pack12(p, room, samples, header->count);
+            if (size == 0) return 0;
+            break;
+        case SAMPLE_PACKET_ENCODING_DELTA: {
+            uint16_t count = header->count;
+            size = sample_codec_delta_encode(p, room, samples, &count);
+            if (count == 0 && header->count != 0) return 0;
+            header->count = (uint8_t)count;
+            break;
+        }
+        default:
+            return 0;
+    }
+
+    out[0] = header->count;
+    out[1] = header->flags;
+    out[2] = (uint8_t)(header->first_index & 0xFF);
+    out[3] = (uint8_t)(header->first_index >> 8);
+    if (header->flags & SAMPLE_PACKET_FLAG_TIMESTAMP) {
+        out[4] = (uint8_t)(header->capture_us & 0xFF);
+        out[5] = (uint8_t)(header->capture_us >> 8);
+        out[6] = (uint8_t)(header->capture_us >> 16);
+        out[7] = (uint8_t)(header->capture_us >> 24);
+    }
+    return (uint16_t)(header_size + size);
+}
+
+uint16_t sample_packet_encode_best(uint8_t *out, uint16_t out_size, sample_packet_header_t *header,
+                                   const uint16_t *samples) {
+    if (header == NULL) return 0;
+    uint8_t flags = (uint8_t)(header->flags & ~SAMPLE_PACKET_ENCODING_MASK);
+    uint16_t header_size = sample_packet_header_size(flags);
+    uint8_t count = header->count;
+
+    // A delta é a única de tamanho variável: só codificando se sabe
+    // quantas amostras ela leva. As de tamanho fixo são calculadas.
+    header->flags = flags | SAMPLE_PACKET_ENCODING_DELTA;
+    uint16_t len = sample_packet_encode(out, out_size, header, samples);
+    uint8_t best_encoding = SAMPLE_PACKET_ENCODING_DELTA;
+    uint8_t best_count = (len != 0) ? header->count : 0;
+    uint16_t best_len = len;
+
+    static const uint8_t fixed[] = { SAMPLE_PACKET_ENCODING_PACKED12, SAMPLE_PACKET_ENCODING_RAW16 };
+    for (uint8_t k = 0; k < sizeof(fixed); k++) {
+        uint16_t n = sample_packet_capacity(out_size, flags | fixed[k]);
+        if (n > count) n = count;
+        uint16_t size;
+        if (fixed[k] == SAMPLE_PACKET_ENCODING_PACKED12) {
+            uint16_t bits = 0;
+            for (uint16_t i = 0; i < n; i++) bits |= samples[i];
+            if (bits > SAMPLE_CODEC_MAX_12BIT) continue;
+            size = (uint16_t)(header_size + SAMPLE_CODEC_PACKED12_SIZE(n));
+        } else {
+            size = (uint16_t)(header_size + 2 * n);
+        }
+        if (n > best_count || (n == best_count && n != 0 && size < best_len)) {
+            best_encoding = fixed[k];
+            best_count = (uint8_t)n;
+            best_len = size;
+        }
+    }
+
+    if (best_encoding == SAMPLE_PACKET_ENCODING_DELTA) return len;
+    header->flags = flags | best_encoding;
+    header->count = best_count;
+    return sample_packet_encode(out, out_size, header, samples);
+}
+
+int sample_packet_decode(const uint8_t *in, uint16_t len, sample_packet_header_t *header,
+                         uint16_t *samples) {
+    if (in == NULL || len < SAMPLE_PACKET_HEADER_SIZE) return -1;
+
+    header->count = in[0];
+    header->flags = in[1];
+    header->first_index = (uint16_t)(in[2] | (in[3] << 8));
+    header->capture_us = 0;
+
+    uint16_t header_size = sample_packet_header_size(header->flags);
+    if (len < header_size) return -2;
+    if (header->flags & SAMPLE_PACKET_FLAG_TIMESTAMP) {
+        header->capture_us = (uint32_t)in[4] | ((uint32_t)in[5] << 8) |
+                             ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    }
+
+    const uint8_t *payload = in + header_size;
+    uint16_t payload_len = (uint16_t)(len - header_size);
+    switch (header->flags & SAMPLE_PACKET_ENCODING_MASK) {
+        case SAMPLE_PACKET_ENCODING_RAW16:
+            if (payload_len < 2 * header->count) return -2;
+            for (uint8_t i = 0; i < header->count; i++) {
+                samples[i] = sample_packet_get(payload, i);
+            }
+            return 0;
+        case SAMPLE_PACKET_ENCODING_PACKED12:
+            return (sample_codec_unpack12(payload, payload_len, samples, header->count) < 0) ? -2 : 0;
+        case SAMPLE_PACKET_ENCODING_DELTA:
+            return (sample_codec_delta_decode(payload, payload_len, samples, header->count) < 0) ? -2 : 0;
+        default:
+            return -3;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef SAMPLE_PACKET_H
+#define SAMPLE_PACKET_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Formato das notificações em lote da característica "Sample Stream",
+// compartilhado entre o servidor (empacota) e o cliente (desempacota).
+//
+//  byte 0     : count       - número de amostras no pacote
+//  byte 1     : flags       - SAMPLE_PACKET_FLAG_* e SAMPLE_PACKET_ENCODING_*
+//                             (demais bits reservados, 0)
+//  bytes 2..3 : first_index - índice da primeira amostra (uint16, little endian)
+//  [bytes 4..7: capture_us  - só com SAMPLE_PACKET_FLAG_TIMESTAMP]
+//  bytes 4.. (ou 8..) : count amostras, em ordem de captura, na
+//                       codificação indicada em `flags`
+//
+// `first_index` é contínuo entre pacotes: o pacote seguinte começa em
+// `first_index + count` (módulo 2^16), o que permite ao cliente detectar
+// amostras perdidas.
+//
+// Com SAMPLE_PACKET_FLAG_TIMESTAMP, `capture_us` traz o instante de
+// captura da última amostra do pacote, em microssegundos do relógio do
+// servidor (uint32 little endian, com volta a cada ~71 min). Usado na
+// medição de latência de ponta a ponta pelo cliente.
+//
+// A codificação das amostras é escolhida a cada pacote: uint16 little
+// endian (original), 12 bits empacotados ou delta (ver sample_codec.h).
+
+// UUID de 128 bits da característica "Sample Stream" (mesmo valor usado
+// em `temp_sensor.gatt`), em ordem big endian como esperado pela BTstack.
+#define SAMPLE_STREAM_CHARACTERISTIC_UUID128 \
+    { 0x5A, 0x1E, 0x00, 0x01, 0x6C, 0x3B, 0x4D, 0x2C, \
+      0x9A, 0x5E, 0x2F, 0x0B, 0x7E, 0x1C, 0x0A, 0x01 }
+
+// Tamanho do cabeçalho de cada pacote, em bytes (sem campos opcionais).
+#define SAMPLE_PACKET_HEADER_SIZE 4
+
+// Tamanho máximo do cabeçalho, com todos os campos opcionais.
+#define SAMPLE_PACKET_MAX_HEADER_SIZE 8
+
+// Bits de `flags`.
+#define SAMPLE_PACKET_FLAG_TIMESTAMP 0x01   // cabeçalho inclui `capture_us`
+
+// Campo de codificação das amostras em `flags` (bits 1..2).
+#define SAMPLE_PACKET_ENCODING_MASK     0x06
+#define SAMPLE_PACKET_ENCODING_RAW16    0x00  // uint16 little endian
+#define SAMPLE_PACKET_ENCODING_PACKED12 0x02  // 12 bits, 2 amostras em 3 bytes
+#define SAMPLE_PACKET_ENCODING_DELTA    0x04  // delta + zigzag + varint
+
+// Número máximo de amostras em um pacote (limitado pelo campo `count`).
+#define SAMPLE_PACKET_MAX_SAMPLES 255
+
+// Cabeçalho decodificado de um pacote.
+typedef struct {
+    uint8_t count;
+    uint8_t flags;
+    uint16_t first_index;
+    uint32_t capture_us;    // válido só com SAMPLE_PACKET_FLAG_TIMESTAMP
+} sample_packet_header_t;
+
+// Tamanho do cabeçalho de um pacote com as `flags` indicadas.
+uint16_t sample_packet_header_size(uint8_t flags);
+
+// Quantas amostras cabem em um pacote de até `payload_size` bytes
+// (para notificações: ATT MTU - 3) com as `flags` indicadas. Na
+// codificação delta o tamanho depende dos dados: o valor é o limite
+// superior, com 1 byte por amostra.
+uint16_t sample_packet_capacity(uint16_t payload_size, uint8_t flags);
+
+// Empacota até `header->count` amostras em `out` (até `out_size` bytes),
+// com os campos opcionais e a codificação indicados em `header->flags`.
+// Nas codificações de tamanho fixo, todas precisam caber; na delta,
+// entram as que couberem e `header->count` passa a indicar quantas.
+// Retorna o tamanho do pacote em bytes ou 0 se não couber (ou, em 12
+// bits, se alguma amostra passar de 12 bits).
+uint16_t sample_packet_encode(uint8_t *out, uint16_t out_size, sample_packet_header_t *header,
+                              const uint16_t *samples);
+
+// Como `sample_packet_encode`, escolhendo a codificação (campo
+// SAMPLE_PACKET_ENCODING_* de `header->flags`) que leva mais amostras
+// em `out_size` bytes e, no empate, o pacote menor.
+uint16_t sample_packet_encode_best(uint8_t *out, uint16_t out_size, sample_packet_header_t *header,
+                                   const uint16_t *samples);
+
+// Valida e decodifica um pacote recebido: o cabeçalho em `*header` e as
+// amostras em `samples` (espaço para SAMPLE_PACKET_MAX_SAMPLES).
+// Retorna 0 em caso de sucesso ou valor negativo se o pacote for
+// inválido.
+int sample_packet_decode(const uint8_t *in, uint16_t len, sample_packet_header_t *header,
+                         uint16_t *samples);
+
+// Lê a amostra `i` de uma sequência de uint16 little endian (codificação
+// original, também usada pelo anúncio do modo broadcast).
+static inline uint16_t sample_packet_get(const uint8_t *samples, uint8_t i) {
+    return (uint16_t)(samples[2 * i] | (samples[2 * i + 1] << 8));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_PACKET_H
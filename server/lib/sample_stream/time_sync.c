@@ -0,0 +1,144 @@
+#include "time_sync.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Estende o instante de 32 bits do servidor a 64 bits, a partir do
+// último instante conhecido (as trocas são bem mais próximas que a volta
+// do contador, de cerca de 71 minutos).
+static uint64_t extend_server_us(const time_sync_t *sync, uint32_t server_us) {
+    if (!sync->server_valid) return server_us;
+    return sync->server_us + (uint64_t)(int64_t)(int32_t)(server_us - (uint32_t)sync->server_us);
+}
+
+void time_sync_reset(time_sync_t *sync) {
+    memset(sync, 0, sizeof(*sync));
+}
+
+uint16_t time_sync_encode(uint8_t *out, uint16_t out_size, uint32_t server_us) {
+    if (out == NULL || out_size < TIME_SYNC_SIZE) return 0;
+    out[0] = (uint8_t)server_us;
+    out[1] = (uint8_t)(server_us >> 8);
+    out[2] = (uint8_t)(server_us >> 16);
+    out[3] = (uint8_t)(server_us >> 24);
+    return TIME_SYNC_SIZE;
+}
+
+int time_sync_decode(const uint8_t *in, uint16_t len, uint32_t *server_us) {
+    if (in == NULL || len != TIME_SYNC_SIZE) return -1;
+    *server_us = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    return 0;
+}
+
+void time_sync_add(time_sync_t *sync, uint64_t request_us, uint32_t server_us, uint64_t response_us,
+                   uint32_t interval_us) {
+    if (sync->round_count >= TIME_SYNC_ROUND_EXCHANGES || response_us < request_us) return;
+    uint64_t server = extend_server_us(sync, server_us);
+    sync->server_us = server;
+    sync->server_valid = true;
+
+    uint64_t rtt = response_us - request_us;
+    uint64_t local;
+    if (interval_us != 0 && rtt >= interval_us) {
+        // O servidor recebeu o pedido no início do evento anterior ao da
+        // resposta.
+        local = response_us - interval_us;
+        sync->round_anchored++;
+    } else {
+        local = request_us + rtt / 2;
+    }
+    uint8_t i = sync->round_count++;
+    sync->round_local[i] = local;
+    sync->round_offset[i] = (int64_t)(server - local);
+    if (i == 0 || rtt < sync->round_min_rtt_us) sync->round_min_rtt_us = (rtt > UINT32_MAX) ? UINT32_MAX : (uint32_t)rtt;
+}
+
+// Ajuste linear (mínimos quadrados) da diferença em função do instante
+// local sobre o histórico: a reta passa pelo centroide dos pontos, e a
+// inclinação é a deriva.
+static void fit_history(time_sync_t *sync) {
+    uint8_t n = sync->history_count;
+    uint8_t first = (uint8_t)((sync->history_next + TIME_SYNC_HISTORY - n) % TIME_SYNC_HISTORY);
+    uint64_t local0 = sync->history_local[first];
+    int64_t offset0 = sync->history_offset[first];
+
+    double sum_x = 0, sum_y = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t i = (uint8_t)((first + k) % TIME_SYNC_HISTORY);
+        sum_x += (double)(int64_t)(sync->history_local[i] - local0);
+        sum_y += (double)(sync->history_offset[i] - offset0);
+    }
+    double mean_x = sum_x / n, mean_y = sum_y / n;
+    double sxx = 0, sxy = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t i = (uint8_t)((first + k) % TIME_SYNC_HISTORY);
+        double dx = (double)(int64_t)(sync->history_local[i] - local0) - mean_x;
+        double dy = (double)(sync->history_offset[i] - offset0) - mean_y;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    double slope = (sxx > 0) ? sxy / sxx : 0;
+    if (slope > TIME_SYNC_MAX_DRIFT_PPB / 1e9) slope = TIME_SYNC_MAX_DRIFT_PPB / 1e9;
+    if (slope < -TIME_SYNC_MAX_DRIFT_PPB / 1e9) slope = -TIME_SYNC_MAX_DRIFT_PPB / 1e9;
+
+    sync->base_local_us = local0 + (uint64_t)(int64_t)mean_x;
+    sync->base_offset_us = offset0 + (int64_t)mean_y;
+    sync->drift_ppb = (int32_t)(slope * 1e9);
+    sync->valid = true;
+
+    double residual = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t i = (uint8_t)((first + k) % TIME_SYNC_HISTORY);
+        double dx = (double)(int64_t)(sync->history_local[i] - local0) - mean_x;
+        double dy = (double)(sync->history_offset[i] - offset0) - mean_y;
+        double r = dy - slope * dx;
+        if (r < 0) r = -r;
+        if (r > residual) residual = r;
+    }
+    sync->residual_us = (uint32_t)residual;
+}
+
+bool time_sync_finish_round(time_sync_t *sync) {
+    uint8_t n = sync->round_count;
+    if (n == 0) return false;
+
+    // Ordena as trocas pela diferença (inserção; no máximo 8).
+    uint8_t order[TIME_SYNC_ROUND_EXCHANGES];
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t j = i;
+        while (j > 0 && sync->round_offset[order[j - 1]] > sync->round_offset[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    uint8_t median = order[n / 2];
+    sync->dispersion_us = (uint32_t)(sync->round_offset[order[(3 * n) / 4]] - sync->round_offset[order[n / 4]]);
+    sync->rtt_us = sync->round_min_rtt_us;
+    sync->anchored = sync->round_anchored;
+
+    sync->history_local[sync->history_next] = sync->round_local[median];
+    sync->history_offset[sync->history_next] = sync->round_offset[median];
+    sync->history_next = (uint8_t)((sync->history_next + 1) % TIME_SYNC_HISTORY);
+    if (sync->history_count < TIME_SYNC_HISTORY) sync->history_count++;
+    fit_history(sync);
+
+    sync->rounds++;
+    sync->round_count = 0;
+    sync->round_anchored = 0;
+    return true;
+}
+
+int64_t time_sync_offset_at(const time_sync_t *sync, uint64_t local_us) {
+    int64_t elapsed = (int64_t)(local_us - sync->base_local_us);
+    return sync->base_offset_us + (elapsed * sync->drift_ppb) / 1000000000;
+}
+
+uint64_t time_sync_to_local(const time_sync_t *sync, uint32_t server_us) {
+    if (!sync->valid) return 0;
+    uint64_t server = extend_server_us(sync, server_us);
+    // A diferença varia pouco: uma aproximação do instante local basta
+    // para avaliá-la.
+    uint64_t local = server - (uint64_t)sync->base_offset_us;
+    return server - (uint64_t)time_sync_offset_at(sync, local);
+}
@@ -0,0 +1,172 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fila lock-free de um único produtor e um único consumidor (SPSC).
+//
+// Pensada para ligar os dois núcleos do RP2040 (ex.: amostragem no
+// core 1, pilha BLE no core 0) sem spinlocks nem desabilitar
+// interrupções: o produtor só escreve `head`, o consumidor só escreve
+// `tail`, e as barreiras de memória garantem que os dados do elemento
+// fiquem visíveis antes do índice que os publica. O Cortex-M0+ não tem
+// LDREX/STREX, mas a fila só precisa de leituras e escritas de 32 bits,
+// que são atômicas.
+//
+// Diferente de `sample_ring_t`, a fila não sobrescreve dados: se estiver
+// cheia, `spsc_queue_push` falha e o produtor decide o que fazer
+// (tipicamente, contar a amostra como descartada).
+//
+// `head` e `tail` são contadores livres; `head - tail` é o número de
+// elementos na fila. A capacidade precisa ser potência de 2.
+typedef struct {
+    uint8_t *buffer;         // armazenamento: capacity * elem_size bytes
+    uint32_t elem_size;      // tamanho de cada elemento, em bytes
+    uint32_t capacity;       // número de elementos (potência de 2)
+    uint32_t mask;           // capacity - 1
+    volatile uint32_t head;  // escrito apenas pelo produtor
+    volatile uint32_t tail;  // escrito apenas pelo consumidor
+} spsc_queue_t;
+
+// Inicializa a fila sobre `storage` (capacity * elem_size bytes).
+// Retorna 0 em caso de sucesso ou valor negativo se os parâmetros forem
+// inválidos.
+static inline int spsc_queue_init(spsc_queue_t *q, void *storage, uint32_t elem_size, uint32_t capacity) {
+    if (q == NULL || storage == NULL || elem_size == 0 || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return -1;
+    }
+    q->buffer = (uint8_t *)storage;
+    q->elem_size = elem_size;
+    q->capacity = capacity;
+    q->mask = capacity - 1;
+    q->head = 0;
+    q->tail = 0;
+    return 0;
+}
+
+// Número de elementos na fila (válido em qualquer um dos lados).
+static inline uint32_t spsc_queue_size(const spsc_queue_t *q) {
+    return q->head - q->tail;
+}
+
+// Espaço livre, em elementos (válido em qualquer um dos lados).
+static inline uint32_t spsc_queue_free(const spsc_queue_t *q) {
+    return q->capacity - (q->head - q->tail);
+}
+
+// Copia `n` elementos a partir do índice livre `index`, tratando a volta
+// do buffer. Uso interno.
+static inline void spsc_queue_copy_out_(const spsc_queue_t *q, uint32_t index, void *dst, uint32_t n) {
+    uint32_t first = index & q->mask;
+    uint32_t chunk = q->capacity - first;
+    if (chunk > n) chunk = n;
+    memcpy(dst, q->buffer + first * q->elem_size, chunk * q->elem_size);
+    memcpy((uint8_t *)dst + chunk * q->elem_size, q->buffer, (n - chunk) * q->elem_size);
+}
+
+static inline void spsc_queue_copy_in_(spsc_queue_t *q, uint32_t index, const void *src, uint32_t n) {
+    uint32_t first = index & q->mask;
+    uint32_t chunk = q->capacity - first;
+    if (chunk > n) chunk = n;
+    memcpy(q->buffer + first * q->elem_size, src, chunk * q->elem_size);
+    memcpy(q->buffer, (const uint8_t *)src + chunk * q->elem_size, (n - chunk) * q->elem_size);
+}
+
+// --- Lado produtor ---------------------------------------------------------
+
+// Insere até `n` elementos de `src`. Retorna quantos couberam.
+static inline uint32_t spsc_queue_push_n(spsc_queue_t *q, const void *src, uint32_t n) {
+    uint32_t head = q->head;
+    uint32_t tail = q->tail;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    uint32_t space = q->capacity - (head - tail);
+    if (n > space) n = space;
+    if (n == 0) return 0;
+
+    spsc_queue_copy_in_(q, head, src, n);
+    // Publica os dados antes de avançar `head`.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    q->head = head + n;
+    return n;
+}
+
+// Insere um elemento. Retorna false se a fila estiver cheia.
+static inline bool spsc_queue_push(spsc_queue_t *q, const void *elem) {
+    return spsc_queue_push_n(q, elem, 1) == 1;
+}
+
+// --- Lado consumidor -------------------------------------------------------
+
+// Remove até `max` elementos para `dst`. Retorna quantos foram removidos.
+static inline uint32_t spsc_queue_pop_n(spsc_queue_t *q, void *dst, uint32_t max) {
+    uint32_t tail = q->tail;
+    uint32_t head = q->head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    uint32_t n = head - tail;
+    if (n > max) n = max;
+    if (n == 0) return 0;
+
+    spsc_queue_copy_out_(q, tail, dst, n);
+    // Libera as posições só depois de copiá-las.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    q->tail = tail + n;
+    return n;
+}
+
+// Remove um elemento. Retorna false se a fila estiver vazia.
+static inline bool spsc_queue_pop(spsc_queue_t *q, void *elem) {
+    return spsc_queue_pop_n(q, elem, 1) == 1;
+}
+
+// Copia o elemento mais recente (último inserido) para `elem` sem
+// removê-lo. Retorna false se a fila estiver vazia.
+static inline bool spsc_queue_peek_newest(const spsc_queue_t *q, void *elem) {
+    uint32_t head = q->head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (head == q->tail) return false;
+    memcpy(elem, q->buffer + ((head - 1) & q->mask) * q->elem_size, q->elem_size);
+    return true;
+}
+
+// Copia até `max` elementos para `dst` sem removê-los, a partir da
+// posição `offset` (0 = elemento mais antigo). Retorna quantos foram
+// copiados.
+static inline uint32_t spsc_queue_peek_n(const spsc_queue_t *q, uint32_t offset, void *dst, uint32_t max) {
+    uint32_t tail = q->tail;
+    uint32_t head = q->head;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    uint32_t size = head - tail;
+    if (offset >= size) return 0;
+    uint32_t n = size - offset;
+    if (n > max) n = max;
+
+    spsc_queue_copy_out_(q, tail + offset, dst, n);
+    return n;
+}
+
+// Descarta até `n` elementos sem copiá-los. Retorna quantos foram
+// descartados.
+static inline uint32_t spsc_queue_skip(spsc_queue_t *q, uint32_t n) {
+    uint32_t tail = q->tail;
+    uint32_t size = q->head - tail;
+    if (n > size) n = size;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    q->tail = tail + n;
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark do formatador de log (lib/log_vt100) contra o vsnprintf da libc
+// Só no build de host. Formata linhas representativas dos logs do servidor
+// (bt_server_setup.cpp) e do cliente (bt_client_setup.cpp), com argumentos
+// típicos, e dois casos de borda do ponto flutuante (precisão acima de 9
+// casas e -0.0), pelos dois formatadores:
+//  - confere que o texto produzido é idêntico;
+//  - mede o custo por chamada (ciclos com `rdtsc` no x86 e ns) de cada um
+//    e a razão log_vsnprintf / vsnprintf, por linha e na média da mistura.
+//
+// Uso:
+//   log_format_bench [repetições por linha]
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+#include "log_vt100.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Repetições padrão de cada linha na medição.
+#define BENCH_DEFAULT_ROUNDS 200000U
+
+// Buffer de formatação (o mesmo tamanho de mensagem de `log_write`).
+#define BENCH_MESSAGE_SIZE 256U
+
+typedef size_t (*format_fn)(char* out, size_t size, const char* fmt, ...);
+
+static size_t libc_format(char* out, size_t size, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out, size, fmt, ap);
+    va_end(ap);
+    return (n < 0) ? 0 : (size_t)n;
+}
+
+static size_t log_format(char* out, size_t size, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t n = log_vsnprintf(out, size, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+static int failures;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if BENCH_HAS_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Linhas representativas. Os argumentos variam com `i` para que nenhum
+// formatador se beneficie de valores constantes.
+static const char* const line_names[] = {
+    "servidor_heartbeat",
+    "servidor_conexao_encerrada",
+    "servidor_parametros_enlace",
+    "servidor_vazao",
+    "servidor_ponto_de_controle",
+    "servidor_registro_baixado",
+    "servidor_mtu",
+    "cliente_servidor_guardado",
+    "cliente_cccd",
+    "cliente_broadcast",
+    "cliente_registro",
+    "cliente_erro_att",
+    "float_precisao_alta",
+    "float_zero_negativo",
+};
+
+#define LINE_COUNT (sizeof(line_names) / sizeof(line_names[0]))
+
+static size_t format_line(format_fn f, uint32_t line, uint32_t i, char* out, size_t size) {
+    switch (line) {
+        case 0:
+            return f(out, size, "Heartbeat #%u - Valor atual: %d", i, (int)(i % 4096U));
+        case 1:
+            return f(out, size, "Conexão 0x%04X encerrada: %u notificações, %u bytes, %u amostras, %u perdidas",
+                     0x40U + (i & 7U), i * 3U, i * 244U, i * 120U, i & 15U);
+        case 2:
+            return f(out, size, "Conexão 0x%04X (%s): intervalo %u.%02u ms, latência %u, supervisão %u ms%s",
+                     0x40U + (i & 7U), "concedidos", 7U + (i & 31U), (i * 7U) % 100U, i & 3U, 1000U,
+                     (i & 1U) ? "" : " (fora do perfil)");
+        case 3:
+            return f(out, size,
+                     "Conexão 0x%04X: %u notificações/s, %u B/s, %u amostras/s, %u.%02u B/amostra (MTU %u, PHY %s, "
+                     "PDU %u B, %u perdidas, %u envios adiados)",
+                     0x40U + (i & 7U), 133U + (i & 63U), 32000U + i % 1000U, 16000U + i % 500U, 1U, i % 100U,
+                     247U, (i & 1U) ? "2M" : "1M", 251U, i & 7U, i & 3U);
+        case 4:
+            return f(out, size,
+                     "Ponto de controle (0x%04X): %u Hz, média de %u, notificação a cada %u ms (banda %u, "
+                     "keep-alive %u ms), lote até %u amostras",
+                     0x40U + (i & 7U), 1000U + i % 9000U, 1U << (i & 3U), 100U, 8U, 5000U, 120U);
+        case 5:
+            return f(out, size, "Registro em flash baixado por 0x%04X: %u registros, %u amostras, %u bytes em %u ms (%u kbit/s)",
+                     0x40U + (i & 7U), i % 500U, i % 500U * 120U, i % 500U * 244U, 1U + i % 3000U, 64U + i % 200U);
+        case 6:
+            return f(out, size, "ATT MTU negociado: %u bytes (até %u amostras/notificação)", 23U + i % 225U,
+                     (23U + i % 225U - 12U) / 2U);
+        case 7:
+            return f(out, size, "[%u] Servidor guardado: %s", i & 3U, "28:CD:C1:0A:4B:7E");
+        case 8:
+            return f(out, size, "[%u] Habilitando notificações (Write CCCD 0x%04x)...", i & 3U, 0x000EU + (i & 15U));
+        case 9:
+            return f(out, size, "[%u] Broadcast: %u anúncios/s (1 a cada %u ms), %u amostras/s entregues, %u perdidas",
+                     i & 3U, 10U + (i & 7U), 100U, 80U + (i & 31U), i & 7U);
+        case 10:
+            return f(out, size, "[%u] Registro #%u: %u amostras a partir de #%u", i & 3U, i & 0xFFFFU, 120U,
+                     (i * 120U) & 0xFFFFU);
+        case 11:
+            return f(out, size, "[%u] Ponto de controle: escrita recusada pelo servidor, ATT Error 0x%02x", i & 3U,
+                     0x13U);
+        case 12:
+            return f(out, size, "Deriva %.12f s, offset %.15e s, %.20g, %.17f", (double)i * 1.0e-7 + 1.0 / 3.0,
+                     (double)i * -3.7e-9, 0.1 * (double)(i & 255U), 1.0e-5 / (double)(1U + (i & 15U)));
+        case 13:
+            // `-0.0 * n` é -0.0 para n = 0 e negativo para os demais.
+            return f(out, size, "Temperatura %.1f C (%+.2f, % f, %g, %e, %5.1f)", -0.0 * (double)(i % 3U),
+                     -0.0, -0.0 * (double)(i & 1U), -0.0, -0.0 * (double)(i % 5U) / 8.0, -0.0);
+    }
+    return 0;
+}
+
+// Tempo médio por chamada de `f` na linha `line`.
+static void measure(format_fn f, uint32_t line, uint32_t rounds, double* cycles, double* ns) {
+    static char out[BENCH_MESSAGE_SIZE];
+    size_t sink = 0;
+    uint64_t start_ns = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for (uint32_t i = 0; i < rounds; i++) {
+        sink += format_line(f, line, i, out, sizeof(out));
+    }
+    uint64_t elapsed_cycles = now_cycles() - start_cycles;
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    // Impede que o laço seja descartado pelo compilador.
+    if (sink == 0) printf(" ");
+    *cycles = (double)elapsed_cycles / rounds;
+    *ns = (double)elapsed_ns / rounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    uint32_t rounds = BENCH_DEFAULT_ROUNDS;
+    if (argc > 1) rounds = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (rounds == 0) {
+        fprintf(stderr, "número de repetições inválido\n");
+        return 2;
+    }
+
+    printf("repeticoes=%u cycles=%s\n", rounds, BENCH_HAS_CYCLES ? "rdtsc" : "n/a");
+    double total_log_ns = 0, total_libc_ns = 0;
+    for (uint32_t line = 0; line < LINE_COUNT; line++) {
+        // Os dois formatadores devem produzir o mesmo texto.
+        char expected[BENCH_MESSAGE_SIZE], actual[BENCH_MESSAGE_SIZE];
+        bool same = true;
+        for (uint32_t i = 0; i < 1000U && same; i++) {
+            size_t n_expected = format_line(libc_format, line, i * 7919U, expected, sizeof(expected));
+            size_t n_actual = format_line(log_format, line, i * 7919U, actual, sizeof(actual));
+            same = n_expected == n_actual && strcmp(expected, actual) == 0;
+        }
+        if (!same) {
+            failures++;
+            printf("linha=%s texto diferente: libc=\"%s\" log=\"%s\" FALHOU\n", line_names[line], expected, actual);
+            continue;
+        }
+
+        double log_cycles, log_ns, libc_cycles, libc_ns;
+        measure(libc_format, line, rounds, &libc_cycles, &libc_ns);
+        measure(log_format, line, rounds, &log_cycles, &log_ns);
+        total_libc_ns += libc_ns;
+        total_log_ns += log_ns;
+        printf("linha=%s bytes=%u log_ns=%.1f libc_ns=%.1f", line_names[line], (unsigned)strlen(actual), log_ns,
+               libc_ns);
+        if (BENCH_HAS_CYCLES) printf(" log_ciclos=%.0f libc_ciclos=%.0f", log_cycles, libc_cycles);
+        printf(" razao=%.2f ok\n", log_ns / libc_ns);
+    }
+
+    printf("media log_ns=%.1f libc_ns=%.1f razao=%.2f\n", total_log_ns / LINE_COUNT, total_libc_ns / LINE_COUNT,
+           total_log_ns / total_libc_ns);
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
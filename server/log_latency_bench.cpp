@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// Latência por chamada das macros LOG_* (lib/log_vt100), síncrono x assíncrono
+// Só no build de host. Mede, chamada a chamada, o tempo gasto no ponto do
+// LOG_* para:
+//  - LOG_MODE_SYNC: formata e escreve em `printf` na hora;
+//  - LOG_MODE_ASYNC: formata e copia para o anel; `log_flush` roda entre
+//    as rajadas, fora da medição, como no laço ocioso do firmware (o seu
+//    custo por registro é reportado à parte);
+//  - mensagem abaixo do nível em tempo de execução (só o filtro do ponto
+//    de chamada).
+// Cada cenário reporta média, p50, p99 e máximo em ns (e ciclos `rdtsc`
+// no x86) e os registros descartados. A saída padrão fica sem buffer,
+// para que cada mensagem síncrona custe uma escrita no descritor, como a
+// escrita bloqueante na USB/UART; os resultados vão para stderr.
+//
+// Uso:
+//   log_latency_bench [chamadas por cenário] > /dev/null
+//   log_latency_bench [chamadas por cenário] > log.txt
+////////////////////////////////////////////////////////////////////////////////
+
+// Mantém LOG_DEBUG compilado para medir o filtro em tempo de execução.
+#define LOG_LEVEL 2
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+#include "log_vt100.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Chamadas padrão por cenário.
+#define BENCH_DEFAULT_CALLS 20000U
+
+// Chamadas entre dois `log_flush` no modo assíncrono. Cabem no anel
+// padrão (2048 bytes) com a mensagem mais longa do benchmark.
+#define BENCH_ASYNC_BURST 8U
+
+typedef enum {
+    SCENARIO_SYNC,
+    SCENARIO_ASYNC,
+    SCENARIO_FILTERED,
+} scenario_t;
+
+static const char* const scenario_names[] = { "sincrono", "assincrono", "filtrado" };
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if BENCH_HAS_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Uma chamada de LOG_* de um dos tipos medidos: a linha curta do
+// heartbeat e a longa do relatório de vazão do servidor.
+static void log_call(scenario_t scenario, uint32_t i) {
+    if (scenario == SCENARIO_FILTERED) {
+        LOG_DEBUG("Heartbeat #%u - Valor atual: %d", i, (int)(i % 4096U));
+    } else if (i & 1U) {
+        LOG_INFO("Heartbeat #%u - Valor atual: %d", i, (int)(i % 4096U));
+    } else {
+        LOG_INFO("Conexão 0x%04X: %u notificações/s, %u B/s, %u amostras/s, %u.%02u B/amostra (MTU %u, PHY %s, "
+                 "PDU %u B, %u perdidas, %u envios adiados)",
+                 0x40U + (i & 7U), 133U + (i & 63U), 32000U + i % 1000U, 16000U + i % 500U, 1U, i % 100U, 247U,
+                 (i & 2U) ? "2M" : "1M", 251U, i & 7U, i & 3U);
+    }
+}
+
+static void run_scenario(scenario_t scenario, uint32_t calls, uint32_t* ns, uint32_t* cycles) {
+    log_set_mode(scenario == SCENARIO_ASYNC ? LOG_MODE_ASYNC : LOG_MODE_SYNC);
+    uint32_t dropped_before = log_dropped_count();
+    uint64_t flush_ns = 0;
+    uint32_t flushed = 0;
+
+    for (uint32_t i = 0; i < calls; i++) {
+        uint64_t start_ns = now_ns();
+        uint64_t start_cycles = now_cycles();
+        log_call(scenario, i);
+        uint64_t end_cycles = now_cycles();
+        uint64_t end_ns = now_ns();
+        ns[i] = (uint32_t)(end_ns - start_ns);
+        cycles[i] = (uint32_t)(end_cycles - start_cycles);
+
+        if (scenario == SCENARIO_ASYNC && (i + 1) % BENCH_ASYNC_BURST == 0) {
+            uint64_t flush_start = now_ns();
+            flushed += log_flush(0);
+            flush_ns += now_ns() - flush_start;
+        }
+    }
+    if (scenario == SCENARIO_ASYNC) {
+        uint64_t flush_start = now_ns();
+        flushed += log_flush(0);
+        flush_ns += now_ns() - flush_start;
+    }
+
+    uint64_t total_ns = 0;
+    for (uint32_t i = 0; i < calls; i++) total_ns += ns[i];
+    qsort(ns, calls, sizeof(uint32_t), compare_u32);
+    qsort(cycles, calls, sizeof(uint32_t), compare_u32);
+
+    fprintf(stderr, "modo=%s chamadas=%u media_ns=%.0f p50_ns=%u p99_ns=%u max_ns=%u", scenario_names[scenario],
+            calls, (double)total_ns / calls, ns[calls / 2], ns[calls * 99 / 100], ns[calls - 1]);
+    if (BENCH_HAS_CYCLES) {
+        fprintf(stderr, " p50_ciclos=%u p99_ciclos=%u", cycles[calls / 2], cycles[calls * 99 / 100]);
+    }
+    fprintf(stderr, " descartados=%u", log_dropped_count() - dropped_before);
+    if (scenario == SCENARIO_ASYNC && flushed > 0) {
+        fprintf(stderr, " flush_ns_registro=%.0f", (double)flush_ns / flushed);
+    }
+    fprintf(stderr, "\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    uint32_t calls = BENCH_DEFAULT_CALLS;
+    if (argc > 1) calls = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (calls < 100) {
+        fprintf(stderr, "mínimo de 100 chamadas por cenário\n");
+        return 2;
+    }
+
+    // Sem buffer: cada mensagem síncrona vai ao descritor na hora.
+    setvbuf(stdout, NULL, _IONBF, 0);
+    log_set_level(LOG_LEVEL_INFO);
+
+    // Custo do próprio relógio, a descontar das medições.
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < 1000U; i++) {
+        now_ns();
+        now_cycles();
+    }
+    fprintf(stderr, "relogio_ns=%.0f cycles=%s\n", (double)(now_ns() - start) / 1000.0,
+            BENCH_HAS_CYCLES ? "rdtsc" : "n/a");
+
+    uint32_t* ns = (uint32_t*)malloc(calls * sizeof(uint32_t));
+    uint32_t* cycles = (uint32_t*)malloc(calls * sizeof(uint32_t));
+    run_scenario(SCENARIO_SYNC, calls, ns, cycles);
+    run_scenario(SCENARIO_ASYNC, calls, ns, cycles);
+    run_scenario(SCENARIO_FILTERED, calls, ns, cycles);
+    log_set_mode(LOG_MODE_SYNC);
+    free(ns);
+    free(cycles);
+    return 0;
+}
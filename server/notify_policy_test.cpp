@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Testes da política de notificação (lib/notify_policy)
+// Só no build de host. Relógio virtual (os instantes são passados à
+// política), então o resultado não depende da carga da máquina:
+//  - primeira avaliação após `init`/`reset` sempre notifica;
+//  - banda morta: variações até `deadband` não notificam;
+//  - limite de taxa: mudança antes de `min_interval_us` fica pendente e
+//    sai assim que o intervalo passa, mesmo se o valor voltar à banda;
+//  - keep-alive a cada `max_interval_us` sem mudanças (0 desativa);
+//  - `configure` mantém o estado; contadores `evaluated`/`sent`;
+//  - relógio de 32 bits dando a volta.
+// Depois simula o laço do servidor (1 kHz, ruído dentro da banda e
+// degraus) e confere o total de notificações e a latência dos degraus.
+//
+// Uso:
+//   notify_policy_test
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "notify_policy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int failures;
+
+static void check(bool ok, const char* name) {
+    if (ok) return;
+    printf("teste=%s FALHOU\n", name);
+    failures++;
+}
+
+// Avalia `sample` em `now_us` e, se a política pedir, registra o envio
+// (como faz o servidor quando a notificação sai).
+static bool step(notify_policy_t* policy, uint16_t sample, uint32_t now_us) {
+    if (!notify_policy_update(policy, sample, now_us)) return false;
+    notify_policy_sent(policy, sample, now_us);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_first_and_reset(void) {
+    const notify_policy_config_t config = { 16, 20000, 1000000 };
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+    check(step(&policy, 1000, 5), "primeira_notifica");
+    check(!step(&policy, 1000, 10), "repetida_nao_notifica");
+    notify_policy_reset(&policy);
+    check(step(&policy, 1000, 15), "reset_notifica");
+    check(policy.evaluated == 3 && policy.sent == 2, "contadores");
+}
+
+static void test_deadband(void) {
+    const notify_policy_config_t config = { 16, 0, 0 };
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+    step(&policy, 1000, 0);
+    check(!step(&policy, 1016, 100), "banda_limite_superior");
+    check(!step(&policy, 984, 200), "banda_limite_inferior");
+    check(step(&policy, 1017, 300), "banda_excedida_acima");
+    check(step(&policy, 1000, 400), "banda_excedida_abaixo");
+    // A referência é o último valor notificado, não a última amostra:
+    // uma deriva lenta acaba notificando.
+    bool drifted = false;
+    for (uint16_t v = 1001; v <= 1017 && !drifted; v++) drifted = step(&policy, v, 500u + v);
+    check(drifted && policy.last_value == 1017, "deriva_lenta");
+}
+
+static void test_rate_cap(void) {
+    const notify_policy_config_t config = { 16, 20000, 0 };
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+    step(&policy, 1000, 0);
+    check(!step(&policy, 2000, 5000), "taxa_mudanca_cedo");
+    // O valor volta à banda, mas a mudança continua pendente.
+    check(!step(&policy, 1000, 15000), "taxa_pendente");
+    check(step(&policy, 1000, 20000), "taxa_pendente_sai_no_intervalo");
+    check(!step(&policy, 1000, 60000), "taxa_sem_mudanca");
+}
+
+static void test_keep_alive(void) {
+    const notify_policy_config_t config = { 16, 20000, 1000000 };
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+    step(&policy, 1000, 0);
+    check(!step(&policy, 1005, 999999), "keep_alive_antes");
+    check(step(&policy, 1005, 1000000), "keep_alive_no_intervalo");
+    check(policy.last_value == 1005, "keep_alive_valor");
+
+    notify_policy_config_t no_keep_alive = config;
+    no_keep_alive.max_interval_us = 0;
+    notify_policy_configure(&policy, &no_keep_alive);
+    check(policy.has_sent && policy.last_value == 1005, "configure_mantem_estado");
+    check(!step(&policy, 1005, 100000000), "keep_alive_desligado");
+}
+
+static void test_clock_wrap(void) {
+    const notify_policy_config_t config = { 16, 20000, 1000000 };
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+    step(&policy, 1000, UINT32_MAX - 5000);
+    check(!step(&policy, 2000, 4999), "volta_relogio_cedo");
+    check(step(&policy, 2000, 15000), "volta_relogio_intervalo");
+    check(step(&policy, 2000, 15000 + 1000000), "volta_relogio_keep_alive");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Laço do servidor por 10 s a 1 kHz: sinal parado com ruído de ±8
+// contagens (dentro da banda de 16) e um degrau de 500 contagens a cada
+// 2 s. Cada degrau deve sair em até `min_interval_us`, e o resto do
+// tempo só o keep-alive.
+static void test_simulation(void) {
+    const notify_policy_config_t config = { 16, 20000, 1000000 };
+    const uint32_t period_us = 1000;
+    const uint32_t samples = 10000;
+    notify_policy_t policy;
+    notify_policy_init(&policy, &config);
+
+    uint32_t noise = 0x1234567u;
+    uint32_t steps = 0, steps_late = 0, step_us = 0;
+    bool step_pending = false;
+    for (uint32_t i = 0; i < samples; i++) {
+        uint32_t now_us = i * period_us;
+        uint16_t level = (uint16_t)(1000u + 500u * ((i / 2000u) & 1u));
+        if (i > 0 && i % 2000u == 0) {
+            steps++;
+            step_pending = true;
+            step_us = now_us;
+        }
+        noise = noise * 1664525u + 1013904223u;
+        uint16_t sample = (uint16_t)(level + (noise >> 28) - 8u);
+        if (step(&policy, sample, now_us) && step_pending) {
+            if (now_us - step_us > config.min_interval_us) steps_late++;
+            step_pending = false;
+        }
+    }
+
+    // Primeira + 1 por degrau + keep-alive no resto (no máximo 2 por
+    // trecho de 2 s parado).
+    uint32_t max_sent = 1 + steps + 2 * (steps + 1);
+    bool ok = steps == 4 && steps_late == 0 && !step_pending && policy.sent <= max_sent && policy.sent >= 1 + steps;
+    printf("simulacao amostras=%u degraus=%u notificacoes=%u maximo=%u atrasados=%u %s\n", policy.evaluated, steps,
+           policy.sent, max_sent, steps_late, ok ? "ok" : "FALHOU");
+    check(ok, "simulacao");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+    test_first_and_reset();
+    test_deadband();
+    test_rate_cap();
+    test_keep_alive();
+    test_clock_wrap();
+    printf("testes de unidade %s\n", failures ? "FALHOU" : "ok");
+
+    test_simulation();
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
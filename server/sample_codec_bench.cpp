@@ -0,0 +1,294 @@
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark das codificações dos lotes (lib/sample_stream/sample_codec.h)
+// Só no build de host. Para cada série de amostras e cada codificação,
+// divide a série em lotes de "Sample Stream" com o ATT MTU indicado e
+// mede bytes por amostra, razão de compressão sobre uint16, número de
+// notificações e o custo de codificar e decodificar (ciclos e ns por
+// amostra). Confere também que a decodificação devolve a série original.
+//
+// Uso:
+//   sample_codec_bench [--mtu N] [série.txt ...]
+//
+// Cada arquivo é uma série gravada, um valor decimal por linha (linhas
+// que não começam com um número são ignoradas, ex.: cabeçalhos). Sem
+// arquivos, usa séries sintéticas: a rampa do ADC simulado, uma
+// temperatura de variação lenta, uma senoide e ruído branco de 12 bits.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+#include "sample_packet.h"
+#include "sample_codec.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// ATT MTU padrão dos lotes (o mesmo do benchmark do enlace).
+#define BENCH_DEFAULT_MTU 247U
+
+// Amostras de cada série sintética (100 s a 1 kHz).
+#define SYNTHETIC_SAMPLES 100000U
+
+// Repetições de cada passada de codificação/decodificação na medição.
+#define TIMING_ROUNDS 20U
+
+// Pseudo-codificação: a escolhida a cada lote (sample_packet_encode_best).
+#define ENCODING_AUTO 0xFF
+
+typedef struct {
+    char name[64];
+    uint16_t* samples;
+    uint32_t count;
+} trace_t;
+
+typedef struct {
+    const char* name;
+    uint8_t encoding;
+} encoding_t;
+
+static const encoding_t encodings[] = {
+    { "RAW16",    SAMPLE_PACKET_ENCODING_RAW16 },
+    { "PACKED12", SAMPLE_PACKET_ENCODING_PACKED12 },
+    { "DELTA",    SAMPLE_PACKET_ENCODING_DELTA },
+    { "AUTO",     ENCODING_AUTO },
+};
+
+static uint32_t noise_state = 0x1234567u;
+
+// Gerador pseudoaleatório (o mesmo do ADC simulado).
+static uint32_t noise(void) {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return noise_state;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if BENCH_HAS_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static trace_t* new_trace(const char* name, uint32_t count) {
+    trace_t* trace = (trace_t*)calloc(1, sizeof(trace_t));
+    snprintf(trace->name, sizeof(trace->name), "%s", name);
+    trace->samples = (uint16_t*)malloc(count * sizeof(uint16_t));
+    trace->count = count;
+    return trace;
+}
+
+// Séries sintéticas, a 1 kHz.
+static int synthetic_traces(trace_t** traces) {
+    // Rampa triangular de 12 bits com período de 1 s e ruído no bit menos
+    // significativo, como o ADC simulado (lib/adc_capture).
+    trace_t* ramp = new_trace("rampa", SYNTHETIC_SAMPLES);
+    for (uint32_t i = 0; i < ramp->count; i++) {
+        uint32_t phase = i % 1000U;
+        uint32_t value = (phase < 500U) ? phase * 4095U / 500U : (1000U - phase) * 4095U / 500U;
+        ramp->samples[i] = (uint16_t)((value ^ (noise() >> 31)) & 0x0FFFU);
+    }
+    // Sensor de temperatura: nível quase constante, deriva lenta e ruído
+    // de ±2 contagens.
+    trace_t* temperature = new_trace("temperatura", SYNTHETIC_SAMPLES);
+    for (uint32_t i = 0; i < temperature->count; i++) {
+        double drift = 12.0 * sin(2.0 * M_PI * i / 60000.0);
+        temperature->samples[i] = (uint16_t)(876 + (int)drift + (int)(noise() >> 30) - 2);
+    }
+    // Senoide de 10 Hz e amplitude de 1500 contagens.
+    trace_t* sine = new_trace("senoide", SYNTHETIC_SAMPLES);
+    for (uint32_t i = 0; i < sine->count; i++) {
+        sine->samples[i] = (uint16_t)(2048 + (int)(1500.0 * sin(2.0 * M_PI * 10.0 * i / 1000.0)));
+    }
+    // Ruído branco de 12 bits: o pior caso para a codificação delta.
+    trace_t* white = new_trace("ruido", SYNTHETIC_SAMPLES);
+    for (uint32_t i = 0; i < white->count; i++) {
+        white->samples[i] = (uint16_t)(noise() >> 20);
+    }
+    traces[0] = ramp;
+    traces[1] = temperature;
+    traces[2] = sine;
+    traces[3] = white;
+    return 4;
+}
+
+// Lê uma série gravada, um valor por linha. Retorna NULL se o arquivo não
+// puder ser lido ou não tiver amostras.
+static trace_t* load_trace(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "%s: não foi possível abrir\n", path);
+        return NULL;
+    }
+    uint32_t capacity = 4096;
+    trace_t* trace = new_trace(path, capacity);
+    trace->count = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (!isdigit((unsigned char)*p)) continue;
+        unsigned long value = strtoul(p, NULL, 10);
+        if (value > 0xFFFF) continue;
+        if (trace->count == capacity) {
+            capacity *= 2;
+            trace->samples = (uint16_t*)realloc(trace->samples, capacity * sizeof(uint16_t));
+        }
+        trace->samples[trace->count++] = (uint16_t)value;
+    }
+    fclose(file);
+    if (trace->count == 0) {
+        fprintf(stderr, "%s: nenhuma amostra\n", path);
+        free(trace->samples);
+        free(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Codifica a série inteira em lotes de até `payload_size` bytes, em
+// `packets` (lotes consecutivos, tamanhos em `lengths`). Retorna o número
+// de lotes, ou 0 se a codificação não se aplicar à série (12 bits com
+// amostras maiores).
+static uint32_t encode_trace(const trace_t* trace, uint8_t encoding, uint16_t payload_size,
+                             uint8_t* packets, uint16_t* lengths) {
+    uint32_t n_packets = 0;
+    uint32_t pos = 0;
+    uint8_t* out = packets;
+    uint8_t flags = (encoding == ENCODING_AUTO) ? SAMPLE_PACKET_ENCODING_DELTA : encoding;
+    uint16_t capacity = sample_packet_capacity(payload_size, flags);
+    while (pos < trace->count) {
+        uint32_t left = trace->count - pos;
+        sample_packet_header_t header = {
+            .count = (uint8_t)((left < capacity) ? left : capacity),
+            .flags = flags,
+            .first_index = (uint16_t)pos,
+            .capture_us = 0,
+        };
+        uint16_t len = (encoding == ENCODING_AUTO)
+            ? sample_packet_encode_best(out, payload_size, &header, &trace->samples[pos])
+            : sample_packet_encode(out, payload_size, &header, &trace->samples[pos]);
+        if (len == 0) return 0;
+        lengths[n_packets++] = len;
+        out += len;
+        pos += header.count;
+    }
+    return n_packets;
+}
+
+// Decodifica os lotes em `samples`. Retorna o número de amostras, ou -1
+// se algum lote for inválido.
+static int32_t decode_trace(const uint8_t* packets, const uint16_t* lengths, uint32_t n_packets,
+                            uint16_t* samples) {
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < n_packets; i++) {
+        sample_packet_header_t header;
+        if (sample_packet_decode(packets, lengths[i], &header, &samples[pos]) != 0) return -1;
+        packets += lengths[i];
+        pos += header.count;
+    }
+    return (int32_t)pos;
+}
+
+static void run_trace(const trace_t* trace, uint16_t payload_size) {
+    // Pior caso: lotes de uma amostra em uint16 (cabeçalho + 2 bytes).
+    uint8_t* packets = (uint8_t*)malloc((size_t)trace->count * (SAMPLE_PACKET_MAX_HEADER_SIZE + 2));
+    uint16_t* lengths = (uint16_t*)malloc(trace->count * sizeof(uint16_t));
+    uint16_t* decoded = (uint16_t*)malloc(trace->count * sizeof(uint16_t) + SAMPLE_PACKET_MAX_SAMPLES * sizeof(uint16_t));
+    uint64_t raw_bytes = 0;
+
+    for (size_t e = 0; e < sizeof(encodings) / sizeof(encodings[0]); e++) {
+        uint32_t n_packets = encode_trace(trace, encodings[e].encoding, payload_size, packets, lengths);
+        if (n_packets == 0) {
+            printf("trace=%s encoding=%s n/a (amostras acima de 12 bits)\n", trace->name, encodings[e].name);
+            continue;
+        }
+        uint64_t bytes = 0;
+        for (uint32_t i = 0; i < n_packets; i++) bytes += lengths[i];
+        if (encodings[e].encoding == SAMPLE_PACKET_ENCODING_RAW16) raw_bytes = bytes;
+
+        uint64_t start_ns = now_ns();
+        uint64_t start_cycles = now_cycles();
+        for (uint32_t r = 0; r < TIMING_ROUNDS; r++) {
+            encode_trace(trace, encodings[e].encoding, payload_size, packets, lengths);
+        }
+        uint64_t encode_cycles = now_cycles() - start_cycles;
+        uint64_t encode_ns = now_ns() - start_ns;
+
+        int32_t decoded_count = 0;
+        start_ns = now_ns();
+        start_cycles = now_cycles();
+        for (uint32_t r = 0; r < TIMING_ROUNDS; r++) {
+            decoded_count = decode_trace(packets, lengths, n_packets, decoded);
+        }
+        uint64_t decode_cycles = now_cycles() - start_cycles;
+        uint64_t decode_ns = now_ns() - start_ns;
+
+        bool ok = decoded_count == (int32_t)trace->count &&
+                  memcmp(decoded, trace->samples, trace->count * sizeof(uint16_t)) == 0;
+        double per_sample = (double)TIMING_ROUNDS * trace->count;
+        printf("trace=%s encoding=%s samples=%u packets=%u bytes_per_sample=%.3f ratio=%.3f "
+               "enc_ns=%.1f dec_ns=%.1f",
+               trace->name, encodings[e].name, (unsigned)trace->count, (unsigned)n_packets,
+               (double)bytes / trace->count, raw_bytes ? (double)bytes / raw_bytes : 1.0,
+               encode_ns / per_sample, decode_ns / per_sample);
+        if (BENCH_HAS_CYCLES) {
+            printf(" enc_cycles=%.1f dec_cycles=%.1f", encode_cycles / per_sample, decode_cycles / per_sample);
+        }
+        printf(" roundtrip=%s\n", ok ? "ok" : "FALHOU");
+    }
+
+    free(packets);
+    free(lengths);
+    free(decoded);
+}
+
+int main(int argc, char** argv) {
+    uint16_t mtu = BENCH_DEFAULT_MTU;
+    trace_t** traces = (trace_t**)calloc((size_t)argc + 4, sizeof(trace_t*));
+    int n_traces = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mtu") == 0 && i + 1 < argc) {
+            mtu = (uint16_t)strtoul(argv[++i], NULL, 10);
+            continue;
+        }
+        trace_t* trace = load_trace(argv[i]);
+        if (trace == NULL) return 1;
+        traces[n_traces++] = trace;
+    }
+    if (mtu < 23 || mtu > 512) {
+        fprintf(stderr, "MTU fora da faixa (23 a 512)\n");
+        return 1;
+    }
+    if (n_traces == 0) n_traces = synthetic_traces(traces);
+
+    printf("mtu=%u payload=%u cycles=%s\n", mtu, mtu - 3U, BENCH_HAS_CYCLES ? "rdtsc" : "n/a");
+    for (int i = 0; i < n_traces; i++) {
+        run_trace(traces[i], (uint16_t)(mtu - 3));
+        free(traces[i]->samples);
+        free(traces[i]);
+    }
+    free(traces);
+    return 0;
+}
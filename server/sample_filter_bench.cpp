@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark e exatidão do filtro de amostras (lib/sample_filter)
+// Só no build de host. Para cada configuração da tabela do README, filtra
+// uma senoide de 12 bits com ruído em blocos de 128 amostras e:
+//  - mede o custo por amostra de entrada (ciclos com `rdtsc` no x86 e ns);
+//  - compara cada saída com uma referência em `double` do mesmo filtro,
+//    calculada em paralelo, e reporta o maior erro em LSB da saída.
+// O erro admitido é o do arredondamento da saída (0,5 LSB); no IIR soma-se
+// o viés do truncamento do estado Q16, até 2^shift / 65536 LSB.
+//
+// Uso:
+//   sample_filter_bench [log2 do número de amostras]
+////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+#include "sample_filter.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Amostras da série (padrão 2^20).
+#define BENCH_DEFAULT_LOG2_SAMPLES 20U
+
+// Tamanho do bloco de cada chamada de `sample_filter_process` (o do anel
+// do ADC no modo contínuo).
+#define BENCH_BLOCK_SIZE 128U
+
+// Repetições de cada passada na medição de tempo.
+#define TIMING_ROUNDS 10U
+
+static const sample_filter_config_t configs[] = {
+    { SAMPLE_FILTER_NONE,           0, 0 },
+    { SAMPLE_FILTER_DECIMATE,       2, 0 },
+    { SAMPLE_FILTER_DECIMATE,       4, 0 },
+    { SAMPLE_FILTER_MOVING_AVERAGE, 3, 0 },
+    { SAMPLE_FILTER_MOVING_AVERAGE, 6, 0 },
+    { SAMPLE_FILTER_CIC,            3, 3 },
+    { SAMPLE_FILTER_CIC,            4, 4 },
+    { SAMPLE_FILTER_IIR,            3, 0 },
+    { SAMPLE_FILTER_IIR,            8, 0 },
+};
+
+static int failures;
+
+static uint32_t noise_state = 0x1234567u;
+
+// Gerador pseudoaleatório (o mesmo do ADC simulado).
+static uint32_t noise(void) {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return noise_state;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if BENCH_HAS_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Referência em `double` dos filtros, amostra a amostra.
+typedef struct {
+    sample_filter_config_t config;
+    uint32_t decimation;
+    uint32_t phase;
+    bool primed;
+    double acc;
+    double y;
+    // Janelas do CIC (estágio s ocupa stage[s * decimation ..]) e da média
+    // móvel (estágio 0), com somas correntes exatas.
+    double* window;
+    double sum[SAMPLE_FILTER_MAX_CIC_ORDER];
+    uint32_t pos;
+} reference_t;
+
+static void reference_init(reference_t* r, const sample_filter_config_t* config, uint32_t decimation) {
+    memset(r, 0, sizeof(*r));
+    r->config = *config;
+    r->decimation = decimation;
+    uint32_t window = (config->type == SAMPLE_FILTER_MOVING_AVERAGE) ? (1u << config->shift) : decimation;
+    r->window = (double*)calloc((size_t)window * SAMPLE_FILTER_MAX_CIC_ORDER, sizeof(double));
+}
+
+// Processa uma entrada; retorna true e escreve `*out` quando há saída.
+static bool reference_step(reference_t* r, uint16_t x, double* out) {
+    const uint32_t shift = r->config.shift;
+    switch (r->config.type) {
+        case SAMPLE_FILTER_NONE:
+            *out = x;
+            return true;
+
+        case SAMPLE_FILTER_DECIMATE:
+            r->acc += x;
+            if (++r->phase < r->decimation) return false;
+            *out = r->acc / (double)(1u << shift);
+            r->acc = 0;
+            r->phase = 0;
+            return true;
+
+        case SAMPLE_FILTER_MOVING_AVERAGE: {
+            const uint32_t window = 1u << shift;
+            if (!r->primed) {
+                for (uint32_t i = 0; i < window; i++) r->window[i] = x;
+                r->sum[0] = (double)x * window;
+                r->primed = true;
+            }
+            r->sum[0] += x - r->window[r->pos];
+            r->window[r->pos] = x;
+            r->pos = (r->pos + 1) % window;
+            *out = r->sum[0] / window;
+            return true;
+        }
+
+        case SAMPLE_FILTER_CIC: {
+            // Cascata de `order` somas móveis de `decimation` entradas, a
+            // partir de estado zero, amostrada a cada `decimation` entradas:
+            // a mesma resposta de integradores e pentes.
+            double v = x;
+            for (uint32_t s = 0; s < r->config.order; s++) {
+                double* w = &r->window[s * r->decimation];
+                r->sum[s] += v - w[r->pos];
+                w[r->pos] = v;
+                v = r->sum[s];
+            }
+            r->pos = (r->pos + 1) % r->decimation;
+            if (++r->phase < r->decimation) return false;
+            r->phase = 0;
+            *out = v / pow((double)r->decimation, r->config.order);
+            return true;
+        }
+
+        case SAMPLE_FILTER_IIR:
+            if (!r->primed) {
+                r->y = x;
+                r->primed = true;
+            }
+            r->y += (x - r->y) / (double)(1u << shift);
+            *out = r->y;
+            return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Filtra a série em blocos, comparando com a referência. Retorna o maior
+// erro em LSB e o número de saídas em `*outputs`.
+static double check_accuracy(const sample_filter_config_t* config, const uint16_t* samples, uint32_t count,
+                             uint32_t* outputs) {
+    sample_filter_t filter;
+    sample_filter_init(&filter, config);
+    reference_t ref;
+    reference_init(&ref, config, sample_filter_decimation(&filter));
+
+    uint16_t block[BENCH_BLOCK_SIZE + 1];
+    double expected[BENCH_BLOCK_SIZE + 1];
+    double max_error = 0;
+    *outputs = 0;
+    for (uint32_t pos = 0; pos < count; pos += BENCH_BLOCK_SIZE) {
+        uint32_t len = (count - pos < BENCH_BLOCK_SIZE) ? count - pos : BENCH_BLOCK_SIZE;
+        uint32_t n_expected = 0;
+        for (uint32_t i = 0; i < len; i++) {
+            if (reference_step(&ref, samples[pos + i], &expected[n_expected])) n_expected++;
+        }
+        // No próprio buffer, como no servidor.
+        memcpy(block, &samples[pos], len * sizeof(uint16_t));
+        uint32_t n = sample_filter_process(&filter, block, len, block);
+        if (n != n_expected) {
+            free(ref.window);
+            return INFINITY;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            double error = fabs((double)block[i] - expected[i]);
+            if (error > max_error) max_error = error;
+        }
+        *outputs += n;
+    }
+    free(ref.window);
+    return max_error;
+}
+
+// Tempo de filtrar a série inteira em blocos, por amostra de entrada.
+static void measure(const sample_filter_config_t* config, const uint16_t* samples, uint32_t count,
+                    double* cycles, double* ns) {
+    sample_filter_t filter;
+    sample_filter_init(&filter, config);
+    static uint16_t block[BENCH_BLOCK_SIZE + 1];
+    uint32_t sink = 0;
+
+    uint64_t start_ns = now_ns();
+    uint64_t start_cycles = now_cycles();
+    for (uint32_t r = 0; r < TIMING_ROUNDS; r++) {
+        for (uint32_t pos = 0; pos + BENCH_BLOCK_SIZE <= count; pos += BENCH_BLOCK_SIZE) {
+            sink += sample_filter_process(&filter, &samples[pos], BENCH_BLOCK_SIZE, block);
+            sink += block[0];
+        }
+    }
+    uint64_t elapsed_cycles = now_cycles() - start_cycles;
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    // Impede que o laço seja descartado pelo compilador.
+    if (sink == 0xFFFFFFFFu) printf(" ");
+
+    double per_sample = (double)TIMING_ROUNDS * count;
+    *cycles = elapsed_cycles / per_sample;
+    *ns = elapsed_ns / per_sample;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    uint32_t log2_samples = BENCH_DEFAULT_LOG2_SAMPLES;
+    if (argc > 1) log2_samples = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (log2_samples < 10 || log2_samples > 26) {
+        fprintf(stderr, "log2 do número de amostras fora da faixa (10 a 26)\n");
+        return 2;
+    }
+
+    // Senoide de 12 bits (amplitude de 1500 contagens, 1000 amostras por
+    // período) com ruído uniforme de ±32 contagens.
+    uint32_t count = 1u << log2_samples;
+    uint16_t* samples = (uint16_t*)malloc(count * sizeof(uint16_t));
+    for (uint32_t i = 0; i < count; i++) {
+        int value = 2048 + (int)lround(1500.0 * sin(2.0 * M_PI * i / 1000.0)) + (int)(noise() >> 26) - 32;
+        samples[i] = (uint16_t)(value < 0 ? 0 : (value > 4095 ? 4095 : value));
+    }
+
+    printf("amostras=%u bloco=%u cycles=%s\n", count, BENCH_BLOCK_SIZE, BENCH_HAS_CYCLES ? "rdtsc" : "n/a");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const sample_filter_config_t* config = &configs[c];
+        uint32_t outputs;
+        double error = check_accuracy(config, samples, count, &outputs);
+        double tolerance = 0.5;
+        if (config->type == SAMPLE_FILTER_IIR) tolerance += (double)(1u << config->shift) / 65536.0;
+        bool ok = error <= tolerance + 1e-9;
+        if (!ok) failures++;
+
+        double cycles, ns;
+        measure(config, samples, count, &cycles, &ns);
+        printf("filtro=%s shift=%u ordem=%u saidas=%u ns_amostra=%.2f", sample_filter_name(config->type),
+               config->shift, config->order, outputs, ns);
+        if (BENCH_HAS_CYCLES) printf(" ciclos_amostra=%.1f", cycles);
+        printf(" erro_max_lsb=%.3f %s\n", error, ok ? "ok" : "FALHOU");
+    }
+
+    free(samples);
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hardware/adc.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+
+#include "sampling_core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Configuração e fila compartilhadas com o core 1. São escritas pelo
+// core 0 antes de `multicore_launch_core1` e apenas lidas depois.
+static sampling_core_config_t core1_config;
+static spsc_queue_t* core1_queue;
+
+// Taxa e média em uso, relidas pelo core 1 a cada ciclo; o core 0 as
+// altera em `sampling_core_reconfigure` (escritas de 32 e 8 bits, atômicas).
+static volatile uint32_t core1_rate_hz;
+static volatile uint8_t core1_oversample;
+
+// Entradas convertidas a cada ciclo, na ordem do round-robin do hardware
+// (a primeira é `core1_config.input`).
+static uint8_t core1_order[5];
+static uint8_t core1_channels;
+
+// Estatísticas escritas apenas pelo core 1.
+static volatile sampling_core_stats_t core1_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Laço de amostragem do core 1. Só o corpo do laço fica na RAM: as
+// funções chamadas (ADC, filtro, temporização do SDK) rodam da flash via
+// XIP, e o core 1 é pausado pelo core 0 durante cada gravação na flash
+// (`multicore_lockout_victim_init`). Essas pausas aparecem como lacunas
+// nas estatísticas; ao voltar, os ciclos perdidos são convertidos em
+// sequência, atrasados, para manter a contagem de amostras no tempo.
+// Fluxo:
+//  1. Calcula o próximo prazo absoluto (sem acumular deriva): o período
+//     de 1 s / taxa é a parte inteira em us mais o resto, acumulado e
+//     somado como 1 us extra quando completa uma unidade, de modo que a
+//     taxa média é exatamente a nominal;
+//  2. Espera ativamente até o prazo e mede o atraso ao acordar;
+//  3. Faz `oversample` passadas de conversões pelas entradas do
+//     round-robin e tira a média de cada uma; as entradas extras vão
+//     para os seus anéis;
+//  4. Passa a amostra pelo filtro, se houver; com dizimação, segue
+//     apenas quando o filtro produz uma saída;
+//  5. Insere a amostra na fila SPSC, ou a contabiliza como descartada.
+static void __not_in_flash_func(sampling_core_entry)(void) {
+    // Permite que o core 0 pause este núcleo com segurança durante
+    // escritas na flash (ex.: banco TLV da BTstack).
+    multicore_lockout_victim_init();
+
+    absolute_time_t deadline = get_absolute_time();
+    bool in_gap = false;
+    uint32_t rate_hz = 0;
+    uint32_t period_us = 0;
+    uint32_t period_rem = 0;
+    uint32_t rem_acc = 0;
+    while (true) {
+        if (core1_rate_hz != rate_hz) {
+            rate_hz = core1_rate_hz;
+            period_us = 1000000u / rate_hz;
+            period_rem = 1000000u % rate_hz;
+            rem_acc = 0;
+        }
+        uint32_t step_us = period_us;
+        rem_acc += period_rem;
+        if (rem_acc >= rate_hz) {
+            rem_acc -= rate_hz;
+            step_us++;
+        }
+        deadline = delayed_by_us(deadline, step_us);
+        busy_wait_until(deadline);
+
+        int64_t lateness = absolute_time_diff_us(deadline, get_absolute_time());
+        if (lateness > 0) {
+            core1_stats.late++;
+            if ((uint32_t)lateness > core1_stats.max_lateness_us) {
+                core1_stats.max_lateness_us = (uint32_t)lateness;
+            }
+        }
+        // Atraso de um período ou mais: o laço ficou parado (pausa do
+        // core 0, parada de XIP). Conta uma lacuna por pausa, não por
+        // ciclo recuperado.
+        if (lateness >= (int64_t)period_us) {
+            if (!in_gap) {
+                core1_stats.gaps++;
+                core1_stats.gap_us += (uint32_t)lateness;
+            }
+            in_gap = true;
+        } else {
+            in_gap = false;
+        }
+
+        // Cada ciclo começa pela entrada principal; o hardware avança o
+        // round-robin a cada conversão.
+        adc_select_input(core1_config.input);
+        uint8_t oversample = core1_oversample;
+        uint32_t acc[5] = {0};
+        for (uint8_t i = 0; i < oversample; i++) {
+            for (uint8_t c = 0; c < core1_channels; c++) {
+                acc[c] += adc_read();
+            }
+        }
+        for (uint8_t c = 1; c < core1_channels; c++) {
+            sample_ring_t* ring = core1_config.channel_rings[core1_order[c]];
+            if (ring != NULL) sample_ring_push(ring, (uint16_t)(acc[c] / oversample));
+        }
+        uint16_t sample = (uint16_t)(acc[0] / oversample);
+
+        if (core1_config.filter != NULL &&
+            sample_filter_process(core1_config.filter, &sample, 1, &sample) == 0) {
+            continue;
+        }
+
+        if (spsc_queue_push(core1_queue, &sample)) {
+            core1_stats.produced++;
+        } else {
+            core1_stats.dropped++;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int sampling_core_start(const sampling_core_config_t* config, spsc_queue_t* queue) {
+    if (config == NULL || queue == NULL || queue->elem_size != sizeof(uint16_t)) return -1;
+    if (config->sample_rate_hz == 0 || config->sample_rate_hz > 1000000u) return -1;
+    if (config->oversample == 0 || config->input > 4) return -1;
+
+    if (config->round_robin != 0 && config->channel_rings == NULL) return -1;
+
+    core1_config = *config;
+    core1_queue = queue;
+    core1_channels = 0;
+    for (uint8_t i = 0; i < 5; i++) {
+        uint8_t input = (uint8_t)((config->input + i) % 5);
+        if (input == config->input || (config->round_robin & (1u << input))) {
+            core1_order[core1_channels++] = input;
+        }
+    }
+    adc_set_round_robin(config->round_robin);
+    core1_rate_hz = config->sample_rate_hz;
+    core1_oversample = config->oversample;
+    multicore_launch_core1(sampling_core_entry);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int sampling_core_reconfigure(uint32_t sample_rate_hz, uint8_t oversample) {
+    if (sample_rate_hz == 0 || sample_rate_hz > 1000000u || oversample == 0) return -1;
+
+    core1_config.sample_rate_hz = sample_rate_hz;
+    core1_config.oversample = oversample;
+    core1_rate_hz = sample_rate_hz;
+    core1_oversample = oversample;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void sampling_core_get_stats(sampling_core_stats_t* stats) {
+    stats->produced = core1_stats.produced;
+    stats->dropped = core1_stats.dropped;
+    stats->late = core1_stats.late;
+    stats->max_lateness_us = core1_stats.max_lateness_us;
+    stats->gaps = core1_stats.gaps;
+    stats->gap_us = core1_stats.gap_us;
+}
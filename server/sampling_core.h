@@ -0,0 +1,76 @@
+// Pipeline de amostragem no core 1.
+//
+// Neste modo a leitura do ADC e o pré-processamento (média de várias
+// conversões) rodam em um laço de tempo real no core 1, com prazos
+// absolutos, e cada amostra resultante é inserida em uma fila SPSC
+// lock-free. O core 0 fica livre para a pilha BLE, o LED e o log, que
+// apenas drenam a fila quando recebem `ATT_EVENT_CAN_SEND_NOW`. Assim o
+// jitter de amostragem independe dos eventos de rádio e da saída serial.
+
+#include <stdint.h>
+
+#include "sample_filter.h"
+#include "sample_ring.h"
+#include "spsc_queue.h"
+
+// Configuração da amostragem no core 1.
+//  - sample_rate_hz: taxa do laço, uma amostra (após a média) por ciclo;
+//  - input: entrada do ADC (0..3 = GPIO 26..29, 4 = sensor de temperatura);
+//  - oversample: conversões somadas e divididas por amostra (1 = sem média);
+//  - filter: filtro aplicado a cada amostra antes da fila (NULL = nenhum).
+//    Com dizimação, só as saídas do filtro entram na fila, então a taxa
+//    da fila é sample_rate_hz / sample_filter_decimation(filter). Depois
+//    do início, o estado do filtro pertence ao core 1;
+//  - round_robin: máscara de entradas convertidas em sequência a cada
+//    ciclo, a partir de `input`, que deve estar na máscara (0 = só
+//    `input`). A média das demais entradas vai, sem filtro, para
+//    `channel_rings[entrada]`;
+//  - channel_rings: anéis das demais entradas, indexados pela entrada
+//    (NULL descarta a entrada).
+// Cada conversão leva ~2 us, então sample_rate_hz * oversample * número
+// de entradas deve ficar abaixo de 500 kS/s, com folga para a inserção
+// na fila.
+typedef struct {
+    uint32_t sample_rate_hz;
+    uint8_t input;
+    uint8_t oversample;
+    sample_filter_t* filter;
+    uint8_t round_robin;
+    sample_ring_t* const* channel_rings;
+} sampling_core_config_t;
+
+// Estatísticas atualizadas pelo core 1 (leitura sem trava pelo core 0).
+//  - produced: amostras inseridas na fila (saídas do filtro);
+//  - dropped: amostras descartadas por fila cheia;
+//  - late: ciclos em que o prazo já havia passado ao acordar;
+//  - max_lateness_us: maior atraso observado em relação ao prazo;
+//  - gaps: pausas do laço de um período ou mais (ex.: core 1 pausado
+//    durante gravações na flash); os ciclos perdidos são convertidos em
+//    sequência na volta e também contam em `late`;
+//  - gap_us: soma da duração dessas pausas.
+typedef struct {
+    uint32_t produced;
+    uint32_t dropped;
+    uint32_t late;
+    uint32_t max_lateness_us;
+    uint32_t gaps;
+    uint32_t gap_us;
+} sampling_core_stats_t;
+
+// Inicia o laço de amostragem no core 1, produzindo amostras de 16 bits
+// em `queue` (elem_size deve ser sizeof(uint16_t)). O ADC precisa ter sido
+// inicializado (`adc_init`, `adc_gpio_init`) pelo core 0.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo se a configuração for inválida.
+int sampling_core_start(const sampling_core_config_t* config, spsc_queue_t* queue);
+
+// Altera a taxa de amostragem e a média com o laço em execução; valem a
+// partir do próximo prazo do core 1, sem parar a amostragem.
+// Retorno:
+//  - 0 em caso de sucesso;
+//  - valor negativo se os valores forem inválidos.
+int sampling_core_reconfigure(uint32_t sample_rate_hz, uint8_t oversample);
+
+// Copia as estatísticas atuais do core 1 para `stats`.
+void sampling_core_get_stats(sampling_core_stats_t* stats);
@@ -10,10 +10,18 @@
 #include "hardware/adc.h"
 #include "pico/stdlib.h"
 
+#define LOG_TAG "APP"     // tag deste módulo nos logs
 #include "log_vt100.h"
+#include "adc_capture.h"
+#include "sample_filter.h"
+#include "sampling_core.h"
 
 #include "bt_server_setup.h"  // interface de configuração e inicialização do servidor BLE
 
+#if PICO_NO_HARDWARE
+#include "btstack_run_loop.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Canal GPIO utilizado como entrada analógica.
@@ -23,24 +31,348 @@
 // Canal interno do ADC associado ao GPIO 26.
 #define PIN_26_ADC_CHANNEL  0U
 
+// Entradas do ADC (0..3 = GPIO 26..29, 4 = sensor de temperatura).
+#define ADC_INPUTS 5U
+
 // Variável global que armazena a última leitura do ADC (16 bits).
 // Este valor será enviado periodicamente via BLE para o cliente.
 uint16_t _adc_reading_;
 
+// Conversões somadas e divididas por leitura no modo de leitura única
+// (ajustável pelo ponto de controle).
+uint8_t _adc_averaging_ = 1;
+
+// Modo de captura contínua do ADC via DMA (definido pelo CMake).
+// 0: uma leitura com `adc_read()` a cada heartbeat (comportamento original);
+// 1: ADC em modo livre alimentando um anel de amostras por DMA.
+#ifndef SERVER_ADC_STREAM
+#define SERVER_ADC_STREAM 0
+#endif
+
+// Taxa de amostragem do modo contínuo, em Hz (até 500 kS/s).
+#ifndef SERVER_ADC_SAMPLE_RATE_HZ
+#define SERVER_ADC_SAMPLE_RATE_HZ 1000U
+#endif
+
+// Pipeline de dois núcleos (definido pelo CMake).
+// 1: amostragem e média no core 1, entregues por fila SPSC ao core 0.
+#ifndef SERVER_DUAL_CORE
+#define SERVER_DUAL_CORE 0
+#endif
+
+// Conversões somadas por amostra no modo de dois núcleos.
+#ifndef SERVER_ADC_OVERSAMPLE
+#define SERVER_ADC_OVERSAMPLE 4U
+#endif
+
+#if SERVER_ADC_STREAM && SERVER_DUAL_CORE
+#error "SERVER_ADC_STREAM e SERVER_DUAL_CORE são modos exclusivos"
+#endif
+
+// Filtro entre o ADC e o caminho de notificação (definido pelo CMake):
+// um dos SAMPLE_FILTER_*, com log2 do fator em SERVER_SAMPLE_FILTER_SHIFT
+// e os estágios do CIC em SERVER_SAMPLE_FILTER_ORDER. Com dizimação, o
+// ADC converte `sample_filter_decimation()` vezes mais rápido e a taxa
+// entregue ao cliente continua sendo a taxa de amostragem configurada.
+#ifndef SERVER_SAMPLE_FILTER
+#define SERVER_SAMPLE_FILTER SAMPLE_FILTER_NONE
+#endif
+#ifndef SERVER_SAMPLE_FILTER_SHIFT
+#define SERVER_SAMPLE_FILTER_SHIFT 2U
+#endif
+#ifndef SERVER_SAMPLE_FILTER_ORDER
+#define SERVER_SAMPLE_FILTER_ORDER 3U
+#endif
+
+// Entradas do ADC amostradas em round-robin (definido pelo CMake), bit n
+// = entrada n: 0..2 = GPIO 26..28, 4 = sensor de temperatura. O ADC0 é
+// sempre a entrada principal (característica de temperatura, lotes e
+// filtro); cada entrada extra é exposta na sua própria característica.
+// O ADC3 (GPIO 29) fica de fora: no Pico W ele é compartilhado com o
+// barramento do CYW43.
+#ifndef SERVER_ADC_CHANNELS
+#define SERVER_ADC_CHANNELS 0x01U
+#endif
+
+// Perfil de parâmetros de conexão pedido às centrais (definido pelo
+// CMake): um dos LINK_PROFILE_* de lib/sample_stream/link_profile.h.
+#ifndef SERVER_LINK_PROFILE
+#define SERVER_LINK_PROFILE LINK_PROFILE_LOW_LATENCY
+#endif
+
+#if !(SERVER_ADC_CHANNELS & 0x01U) || (SERVER_ADC_CHANNELS & ~0x17U)
+#error "SERVER_ADC_CHANNELS precisa incluir o ADC0 e só aceita as entradas 0, 1, 2 e 4"
+#endif
+
+// Capacidade do anel de cada entrada extra (potência de 2).
+#define CHANNEL_RING_SIZE 256U
+
+// Limite de conversões por leitura no modo de leitura única (média vezes
+// dizimação vezes entradas), ~8 ms de ADC dentro do heartbeat.
+#define READ_ADC_MAX_CONVERSIONS 4096U
+
+// Capacidade da fila SPSC entre os núcleos (potência de 2).
+#define CORE1_QUEUE_SIZE 1024U
+
+// Intervalo, em milissegundos, entre drenagens do log assíncrono no
+// laço principal.
+#define LOG_DRAIN_PERIOD_MS 10U
+
+// Limitação de taxa dos logs: cada ponto de chamada emite até
+// LOG_RATE_BURST mensagens seguidas e, depois, no máximo
+// LOG_RATE_PER_SECOND por segundo.
+#define LOG_RATE_PER_SECOND 5U
+#define LOG_RATE_BURST      10U
+
+// Taxa e média em uso nos modos contínuo e de dois núcleos (ajustáveis
+// pelo ponto de controle).
+uint32_t sample_rate_hz = SERVER_ADC_SAMPLE_RATE_HZ;
+uint8_t sample_oversample = SERVER_ADC_OVERSAMPLE;
+
+// Tamanho do anel de amostras (potência de 2) e do bloco de DMA.
+#define ADC_RING_SIZE      1024U
+#define ADC_DMA_BLOCK_LEN  128U
+
+// Área de armazenamento e anel de amostras do modo contínuo.
+static uint16_t adc_ring_storage[ADC_RING_SIZE];
+static sample_ring_t adc_ring;
+
+// Área de armazenamento e fila SPSC do modo de dois núcleos.
+static uint16_t core1_queue_storage[CORE1_QUEUE_SIZE];
+static spsc_queue_t core1_queue;
+
+// Filtro de amostras e bloco de trabalho (entradas da leitura única ou
+// amostras do ADC0 de um trecho do anel no modo contínuo).
+sample_filter_t sample_filter;
+static uint16_t filter_block[SAMPLE_FILTER_MAX_DECIMATION + 1];
+
+// Anel do ADC0 no modo contínuo quando há filtro ou round-robin: recebe
+// as saídas do filtro sobre as amostras do ADC0 separadas do anel do
+// DMA. Caso contrário, a pilha BLE lê direto de `adc_ring`.
+static uint16_t primary_ring_storage[ADC_RING_SIZE];
+static sample_ring_t primary_ring;
+static sample_ring_t* stream_ring = &adc_ring;
+
+// Entradas na ordem do round-robin (o ADC0 primeiro, depois em ordem
+// crescente) e anéis das entradas extras, indexados pela entrada.
+uint8_t adc_channel_order[ADC_INPUTS];
+uint8_t adc_channel_count;
+static uint16_t channel_ring_storage[ADC_INPUTS][CHANNEL_RING_SIZE];
+static sample_ring_t channel_ring_area[ADC_INPUTS];
+sample_ring_t* channel_rings[ADC_INPUTS];
+
+// Posição, no round-robin, da próxima amostra entregue pelo DMA.
+static uint8_t stream_slot;
+
 ////////////////////////////////////////////////////////////////////////////////
 
+// Máscara de round-robin do hardware: 0 com uma única entrada.
+uint8_t adc_round_robin_mask(void) {
+    return (adc_channel_count > 1) ? (uint8_t)SERVER_ADC_CHANNELS : 0;
+}
+
+// Monta a ordem do round-robin a partir de SERVER_ADC_CHANNELS, prepara
+// os anéis das entradas extras e liga os seus pinos ao ADC.
+void init_adc_channels(void) {
+    adc_channel_count = 0;
+    for (uint8_t input = 0; input < ADC_INPUTS; input++) {
+        if ((SERVER_ADC_CHANNELS & (1U << input)) == 0) continue;
+        adc_channel_order[adc_channel_count++] = input;
+        if (input == PIN_26_ADC_CHANNEL) continue;
+        sample_ring_init(&channel_ring_area[input], channel_ring_storage[input], CHANNEL_RING_SIZE);
+        channel_rings[input] = &channel_ring_area[input];
+        if (input < 4) adc_gpio_init(PIN_26_GPIO_CHANNEL + input);
+    }
+    adc_set_round_robin(adc_round_robin_mask());
+}
+
 // Função de callback chamada periodicamente pelo código BLE.
 // Responsável por realizar uma nova leitura do ADC e atualizar
-// a variável global `_adc_reading_` com o valor lido.
+// a variável global `_adc_reading_` com o valor lido: um bloco de
+// `sample_filter_decimation()` médias de `_adc_averaging_` conversões,
+// passado pelo filtro, que produz exatamente uma saída. Com round-robin,
+// cada passada converte também as entradas extras, cuja média do bloco
+// vai para os seus anéis.
 void read_adc(void) {
-    // Seleciona o canal ADC correspondente ao pino configurado.
-    adc_select_input(PIN_26_GPIO_CHANNEL);
-    // Realiza a conversão analógica-digital e armazena o resultado.
-    _adc_reading_ = adc_read();
+    // Seleciona o canal do ADC0; o round-robin avança a cada conversão.
+    adc_select_input(PIN_26_ADC_CHANNEL);
+    // Realiza as conversões analógico-digitais e armazena as médias.
+    uint32_t decimation = sample_filter_decimation(&sample_filter);
+    uint32_t extra[ADC_INPUTS] = {0};
+    for (uint32_t n = 0; n < decimation; n++) {
+        uint32_t acc = 0;
+        for (uint8_t i = 0; i < _adc_averaging_; i++) {
+            acc += adc_read();
+            for (uint8_t c = 1; c < adc_channel_count; c++) {
+                extra[c] += adc_read();
+            }
+        }
+        filter_block[n] = (uint16_t)(acc / _adc_averaging_);
+    }
+    for (uint8_t c = 1; c < adc_channel_count; c++) {
+        sample_ring_push(channel_rings[adc_channel_order[c]], (uint16_t)(extra[c] / (decimation * _adc_averaging_)));
+    }
+    if (sample_filter_process(&sample_filter, filter_block, decimation, filter_block) > 0) {
+        _adc_reading_ = filter_block[0];
+    }
  }
 
+// Filtra `count` amostras do ADC0 em `filter_block` e as publica em
+// `primary_ring`.
+void publish_primary_samples(uint32_t count) {
+    uint32_t produced = sample_filter_process(&sample_filter, filter_block, count, filter_block);
+    for (uint32_t i = 0; i < produced; i++) {
+        sample_ring_push(&primary_ring, filter_block[i]);
+    }
+}
+
+// Tratador de blocos do modo contínuo (interrupção do DMA no hardware):
+// desentrelaça as amostras recém-capturadas pela ordem do round-robin;
+// as do ADC0 passam pelo filtro até `primary_ring`, as demais vão para
+// os anéis das suas entradas.
+void split_adc_block(const uint16_t* samples, uint32_t count) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t input = adc_channel_order[stream_slot];
+        stream_slot = (uint8_t)((stream_slot + 1 == adc_channel_count) ? 0 : stream_slot + 1);
+        if (input != PIN_26_ADC_CHANNEL) {
+            sample_ring_push(channel_rings[input], samples[i]);
+            continue;
+        }
+        filter_block[n++] = samples[i];
+        if (n == SAMPLE_FILTER_MAX_DECIMATION) {
+            publish_primary_samples(n);
+            n = 0;
+        }
+    }
+    publish_primary_samples(n);
+}
+
+// Callback de heartbeat do modo contínuo. As amostras já chegam ao anel
+// pelo DMA; no build de host, avança o ADC simulado até o instante atual.
+void poll_adc_stream(void) {
+    adc_capture_poll();
+}
+
+// Configura a captura contínua do ADC no canal `PIN_26_ADC_CHANNEL` (e
+// nas entradas extras, em round-robin), alimentando `adc_ring` e, com
+// filtro ou round-robin, `primary_ring` (o anel lido pela pilha BLE fica
+// em `stream_ring`). Retorna 0 em caso de sucesso.
+int start_adc_stream(void) {
+    if (sample_ring_init(&adc_ring, adc_ring_storage, ADC_RING_SIZE) != 0) {
+        return -1;
+    }
+    uint32_t decimation = sample_filter_decimation(&sample_filter);
+    adc_capture_config_t config = {
+        .sample_rate_hz = SERVER_ADC_SAMPLE_RATE_HZ * decimation * adc_channel_count,
+        .input = PIN_26_ADC_CHANNEL,
+        .block_len = ADC_DMA_BLOCK_LEN,
+        .round_robin = adc_round_robin_mask(),
+    };
+    if (adc_capture_init(&config, &adc_ring) != 0) {
+        return -1;
+    }
+    if (sample_filter.config.type != SAMPLE_FILTER_NONE || adc_channel_count > 1) {
+        if (sample_ring_init(&primary_ring, primary_ring_storage, ADC_RING_SIZE) != 0) {
+            return -1;
+        }
+        stream_slot = 0;
+        adc_capture_set_block_handler(&split_adc_block);
+        stream_ring = &primary_ring;
+    }
+    // A primeira conversão fica pronta um período após o início.
+    bt_server_set_sample_timebase(time_us_32() + 1000000U / SERVER_ADC_SAMPLE_RATE_HZ, 0, SERVER_ADC_SAMPLE_RATE_HZ);
+    adc_capture_start();
+    return 0;
+}
+
+// Callback de heartbeat do modo de dois núcleos (executado no core 0).
+// A amostragem é feita pelo core 1; aqui apenas se reportam, a cada
+// 10 s, as estatísticas de produção, perdas e atraso do laço.
+void report_sampling_core(void) {
+    static uint32_t last_report_us = 0;
+    if (time_us_32() - last_report_us < 10000000U) return;
+    last_report_us = time_us_32();
+
+    sampling_core_stats_t stats;
+    sampling_core_get_stats(&stats);
+    LOG_INFO("Core 1: %u amostras, %u descartadas, %u atrasos (máx. %u us), %u lacunas (%u us), fila %u/%u",
+             (unsigned)stats.produced, (unsigned)stats.dropped, (unsigned)stats.late,
+             (unsigned)stats.max_lateness_us, (unsigned)stats.gaps, (unsigned)stats.gap_us,
+             (unsigned)spsc_queue_size(&core1_queue), CORE1_QUEUE_SIZE);
+}
+
+// Inicia a amostragem no core 1, produzindo em `core1_queue`.
+// Retorna 0 em caso de sucesso.
+int start_sampling_core(void) {
+    if (spsc_queue_init(&core1_queue, core1_queue_storage, sizeof(uint16_t), CORE1_QUEUE_SIZE) != 0) {
+        return -1;
+    }
+    sampling_core_config_t config = {
+        .sample_rate_hz = SERVER_ADC_SAMPLE_RATE_HZ * sample_filter_decimation(&sample_filter),
+        .input = PIN_26_ADC_CHANNEL,
+        .oversample = SERVER_ADC_OVERSAMPLE,
+        .filter = (sample_filter.config.type != SAMPLE_FILTER_NONE) ? &sample_filter : NULL,
+        .round_robin = adc_round_robin_mask(),
+        .channel_rings = channel_rings,
+    };
+    // O core 1 publica a primeira amostra um período após iniciar.
+    bt_server_set_sample_timebase(time_us_32() + 1000000U / SERVER_ADC_SAMPLE_RATE_HZ, 0, SERVER_ADC_SAMPLE_RATE_HZ);
+    return sampling_core_start(&config, &core1_queue);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
+// Conversões do ADC por amostra entregue ao cliente (dizimação do filtro
+// vezes entradas do round-robin).
+uint32_t adc_conversions(void) {
+    return sample_filter_decimation(&sample_filter) * adc_channel_count;
+}
+
+// Reancora a base de tempo da medição de latência depois de uma mudança
+// de taxa: a amostra de índice `next_index` sai um período após agora.
+void retime_samples(uint32_t next_index, uint32_t rate_hz) {
+    bt_server_set_sample_timebase(time_us_32() + 1000000U / rate_hz, next_index, rate_hz);
+}
+
+// Callback do ponto de controle ("Sample Control"): reprograma a taxa de
+// amostragem e a média sem parar a captura nem derrubar a conexão. A
+// taxa é a de saída do filtro; o ADC converte `decimation` vezes mais,
+// em cada entrada do round-robin.
+// Retorna 0 se aceitou todos os campos marcados, ou -1 sem alterar nada.
+int apply_sampling_control(const sample_control_t* control) {
+    uint32_t conversions = adc_conversions();
+#if SERVER_ADC_STREAM
+    // O DMA entrega cada conversão: não há média neste modo.
+    if ((control->fields & SAMPLE_CONTROL_AVERAGING) && control->averaging != 1) return -1;
+    if (control->fields & SAMPLE_CONTROL_SAMPLE_RATE) {
+        // Taxa do ADC em 64 bits: o produto não pode dar a volta.
+        uint64_t adc_rate = (uint64_t)control->sample_rate_hz * conversions;
+        if (adc_rate < ADC_CAPTURE_MIN_RATE_HZ || adc_rate > ADC_CAPTURE_MAX_RATE_HZ) return -1;
+        if (adc_capture_set_rate((uint32_t)adc_rate) != 0) return -1;
+        sample_rate_hz = control->sample_rate_hz;
+        retime_samples(stream_ring->head, sample_rate_hz);
+    }
+#elif SERVER_DUAL_CORE
+    uint32_t rate = (control->fields & SAMPLE_CONTROL_SAMPLE_RATE) ? control->sample_rate_hz : sample_rate_hz;
+    uint8_t oversample = (control->fields & SAMPLE_CONTROL_AVERAGING) ? control->averaging : sample_oversample;
+    if (rate == 0 || oversample == 0 || (uint64_t)rate * conversions * oversample > ADC_CAPTURE_MAX_RATE_HZ) return -1;
+    if (sampling_core_reconfigure(rate * sample_filter_decimation(&sample_filter), oversample) != 0) return -1;
+    sample_rate_hz = rate;
+    sample_oversample = oversample;
+    sampling_core_stats_t stats;
+    sampling_core_get_stats(&stats);
+    retime_samples(stats.produced, sample_rate_hz);
+#else
+    // A taxa é a do heartbeat, ajustada pelo próprio servidor BLE.
+    if (control->fields & SAMPLE_CONTROL_AVERAGING) {
+        if ((uint32_t)control->averaging * conversions > READ_ADC_MAX_CONVERSIONS) return -1;
+        _adc_averaging_ = control->averaging;
+    }
+#endif
+    return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Função principal do firmware do servidor BLE.
@@ -65,6 +397,7 @@ int main() {
 
     // Configura nível de log padrão
     log_set_level(LOG_LEVEL_INFO);
+    log_set_rate_limit(LOG_RATE_PER_SECOND, LOG_RATE_BURST);
 
     LOG_INFO("Iniciando servidor BLE - Demo Pico W");
     LOG_INFO("Passo 1: Inicializando entrada/saída padrão (stdio_init_all)");
@@ -75,27 +408,94 @@ int main() {
     adc_gpio_init(PIN_26_GPIO_CHANNEL);
     adc_select_input(PIN_26_ADC_CHANNEL);
     adc_set_temp_sensor_enabled(true);
-    LOG_DEBUG("ADC inicializado, sensor de temperatura ativado");
+    init_adc_channels();
+    LOG_DEBUG("ADC inicializado, sensor de temperatura ativado, %u entradas (máscara 0x%02X)", adc_channel_count, SERVER_ADC_CHANNELS);
+
+    // Configura o filtro entre o ADC e o caminho de notificação
+    sample_filter_config_t filter_config = {
+        .type = SERVER_SAMPLE_FILTER,
+        .shift = SERVER_SAMPLE_FILTER_SHIFT,
+        .order = SERVER_SAMPLE_FILTER_ORDER,
+    };
+    if (sample_filter_init(&sample_filter, &filter_config) != 0) {
+        LOG_WARN("Configuração de filtro inválida!");
+        return -1;
+    }
+    LOG_INFO("Filtro de amostras: %s (shift %u, ordem %u, dizimação %u)",
+             sample_filter_name(sample_filter.config.type), sample_filter.config.shift,
+             sample_filter.config.order, (unsigned)sample_filter_decimation(&sample_filter));
 
     // Inicializa o servidor Bluetooth LE
+#if SERVER_ADC_STREAM
+    LOG_INFO("Passo 3: Iniciando captura contínua do ADC (%u Hz) e servidor BLE (bt_server_init_stream)", SERVER_ADC_SAMPLE_RATE_HZ);
+    if (start_adc_stream() != 0) {
+        LOG_WARN("Falha ao configurar captura contínua do ADC!");
+        return -1;
+    }
+    if (bt_server_init_stream(&poll_adc_stream, stream_ring) != 0) {
+        LOG_WARN("Falha ao inicializar servidor BT!");
+        return -1;
+    }
+    bt_server_set_control_handler(&apply_sampling_control, sample_rate_hz, 1);
+    bt_server_set_control_rate_range((ADC_CAPTURE_MIN_RATE_HZ + adc_conversions() - 1) / adc_conversions(),
+                                     ADC_CAPTURE_MAX_RATE_HZ / adc_conversions());
+#elif SERVER_DUAL_CORE
+    LOG_INFO("Passo 3: Iniciando amostragem no core 1 (%u Hz, média de %u) e servidor BLE (bt_server_init_queue)", SERVER_ADC_SAMPLE_RATE_HZ, SERVER_ADC_OVERSAMPLE);
+    if (start_sampling_core() != 0) {
+        LOG_WARN("Falha ao iniciar amostragem no core 1!");
+        return -1;
+    }
+    if (bt_server_init_queue(&report_sampling_core, &core1_queue) != 0) {
+        LOG_WARN("Falha ao inicializar servidor BT!");
+        return -1;
+    }
+    bt_server_set_control_handler(&apply_sampling_control, sample_rate_hz, sample_oversample);
+    // O core 1 é ritmado por timer: qualquer taxa até o limite do ADC
+    // (sem média; a média é conferida pelo callback).
+    bt_server_set_control_rate_range(1U, ADC_CAPTURE_MAX_RATE_HZ / adc_conversions());
+#else
     LOG_INFO("Passo 3: Inicializando servidor Bluetooth LE (bt_server_init)");
     if (bt_server_init(&read_adc, &_adc_reading_) != 0) {
         LOG_WARN("Falha ao inicializar servidor BT!");
         return -1;
     }
+    bt_server_set_control_handler(&apply_sampling_control, 1000U / HEARTBEAT_PERIOD_MS, _adc_averaging_);
+#endif
+    // Parâmetros de conexão pedidos a cada central.
+    bt_server_set_link_profile(SERVER_LINK_PROFILE);
+
+    // Cada entrada extra do round-robin ganha a sua característica.
+    for (uint8_t c = 1; c < adc_channel_count; c++) {
+        uint8_t input = adc_channel_order[c];
+        if (bt_server_set_channel(input, channel_rings[input]) != 0) {
+            LOG_WARN("Entrada %u do ADC sem característica no GATT", input);
+        }
+    }
     
     // Inicia a pilha BLE
     LOG_INFO("Passo 4: Iniciando pilha BLE (bt_server_start)");
     bt_server_start();
     
-    LOG_INFO("Passo 5: Entrando no loop principal infinito");
+#if PICO_NO_HARDWARE
+    // No host não há IRQ do CYW43 rodando a BTstack em segundo plano: o
+    // laço principal é o run loop POSIX, e o log permanece síncrono.
+    LOG_INFO("Passo 5: Entrando no run loop da BTstack (host)");
+    btstack_run_loop_execute();
+#else
+    LOG_INFO("Passo 5: Entrando no loop principal infinito (log assíncrono)");
+    // A partir daqui os handlers BLE apenas enfileiram as mensagens de
+    // log; a escrita na USB é feita pelo laço principal.
+    log_set_mode(LOG_MODE_ASYNC);
     while(true) {   
         // Loop principal ocioso: toda a atividade fica
-        // a cargo dos handlers internos da pilha BLE.
-        sleep_ms(1000);
+        // a cargo dos handlers internos da pilha BLE; aqui apenas
+        // drenamos o log assíncrono para a saída padrão.
+        log_flush(0);
+        sleep_ms(LOG_DRAIN_PERIOD_MS);
         // Opcional: log periódico de "heartbeat" do main loop em nível debug
         // LOG_DEBUG("Loop principal ativo...");
     }
+#endif
     
     return 0;
 }
@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////
+// Testes e benchmark da fila SPSC (lib/spsc_queue/spsc_queue.h)
+// Só no build de host. Primeiro os testes de unidade, em uma thread:
+//  - parâmetros de `spsc_queue_init` (capacidade potência de 2, >= 2);
+//  - fila vazia e cheia, `size`/`free`, ordem FIFO;
+//  - volta do buffer em `push_n`/`pop_n`/`peek_n` com lotes que cruzam
+//    o fim do armazenamento;
+//  - `peek_newest`, `peek_n` com deslocamento e `skip`;
+//  - contadores livres perto da volta de 32 bits.
+// Depois, um teste de estresse com produtor e consumidor em threads
+// separadas (como core 1 e core 0), que confere cada elemento de uma
+// sequência, e a vazão (elementos por segundo e ns por elemento) para
+// alguns tamanhos de lote.
+//
+// Uso:
+//   spsc_queue_test [milhões de elementos por medição]
+////////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "spsc_queue.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Elementos transferidos por medição de vazão (padrão, em milhões).
+#define BENCH_DEFAULT_MILLIONS 20U
+
+// Capacidade da fila no estresse e no benchmark (a do modo de dois
+// núcleos do servidor).
+#define BENCH_QUEUE_SIZE 1024U
+
+// Maior lote do benchmark.
+#define BENCH_MAX_BATCH 128U
+
+static int failures;
+
+static void check(bool ok, const char* name) {
+    if (ok) return;
+    printf("teste=%s FALHOU\n", name);
+    failures++;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void test_init(void) {
+    spsc_queue_t q;
+    uint16_t storage[8];
+    check(spsc_queue_init(&q, storage, sizeof(uint16_t), 8) == 0, "init");
+    check(spsc_queue_init(&q, storage, sizeof(uint16_t), 6) < 0, "init_nao_potencia_de_2");
+    check(spsc_queue_init(&q, storage, sizeof(uint16_t), 1) < 0, "init_capacidade_1");
+    check(spsc_queue_init(&q, NULL, sizeof(uint16_t), 8) < 0, "init_sem_armazenamento");
+    check(spsc_queue_init(&q, storage, 0, 8) < 0, "init_elemento_vazio");
+    check(spsc_queue_init(NULL, storage, sizeof(uint16_t), 8) < 0, "init_sem_fila");
+}
+
+static void test_full_empty(void) {
+    spsc_queue_t q;
+    uint16_t storage[8];
+    spsc_queue_init(&q, storage, sizeof(uint16_t), 8);
+    uint16_t value = 0;
+    check(!spsc_queue_pop(&q, &value), "pop_vazia");
+    check(!spsc_queue_peek_newest(&q, &value), "peek_newest_vazia");
+    check(spsc_queue_size(&q) == 0 && spsc_queue_free(&q) == 8, "tamanho_vazia");
+
+    for (uint16_t i = 0; i < 8; i++) check(spsc_queue_push(&q, &i), "push");
+    uint16_t extra = 99;
+    check(!spsc_queue_push(&q, &extra), "push_cheia");
+    check(spsc_queue_size(&q) == 8 && spsc_queue_free(&q) == 0, "tamanho_cheia");
+    check(spsc_queue_peek_newest(&q, &value) && value == 7, "peek_newest");
+
+    bool ordered = true;
+    for (uint16_t i = 0; i < 8; i++) {
+        ordered = ordered && spsc_queue_pop(&q, &value) && value == i;
+    }
+    check(ordered, "ordem_fifo");
+    check(spsc_queue_size(&q) == 0, "esvaziada");
+}
+
+static void test_wraparound(void) {
+    spsc_queue_t q;
+    uint32_t storage[16];
+    spsc_queue_init(&q, storage, sizeof(uint32_t), 16);
+    uint32_t in[16], out[16];
+    uint32_t next_in = 0, next_out = 0;
+    bool ok = true;
+    // Lotes de 5 e 7 elementos: as posições cruzam o fim do armazenamento
+    // em pontos diferentes a cada volta.
+    for (uint32_t round = 0; round < 100; round++) {
+        for (uint32_t i = 0; i < 7; i++) in[i] = next_in + i;
+        uint32_t pushed = spsc_queue_push_n(&q, in, 7);
+        next_in += pushed;
+
+        // Sem remover, a partir do segundo elemento.
+        uint32_t size = spsc_queue_size(&q);
+        uint32_t expected = (size > 1) ? size - 1 : 0;
+        if (expected > 3) expected = 3;
+        uint32_t peeked = spsc_queue_peek_n(&q, 1, out, 3);
+        ok = ok && peeked == expected;
+        for (uint32_t i = 0; i < peeked; i++) ok = ok && out[i] == next_out + 1 + i;
+
+        uint32_t popped = spsc_queue_pop_n(&q, out, 5);
+        for (uint32_t i = 0; i < popped; i++) ok = ok && out[i] == next_out + i;
+        next_out += popped;
+        ok = ok && spsc_queue_size(&q) == next_in - next_out;
+    }
+    check(ok, "volta_do_buffer");
+
+    // Garante elementos suficientes e descarta os 3 mais antigos.
+    for (uint32_t i = 0; i < 7; i++) in[i] = next_in + i;
+    next_in += spsc_queue_push_n(&q, in, 7);
+    check(spsc_queue_skip(&q, 3) == 3, "skip");
+    next_out += 3;
+    uint32_t value = 0;
+    check(spsc_queue_pop(&q, &value) && value == next_out, "skip_proximo");
+    next_out++;
+    uint32_t rest = next_in - next_out;
+    check(spsc_queue_skip(&q, 1000) == rest && spsc_queue_size(&q) == 0, "skip_alem_do_tamanho");
+}
+
+static void test_counter_wrap(void) {
+    spsc_queue_t q;
+    uint16_t storage[4];
+    spsc_queue_init(&q, storage, sizeof(uint16_t), 4);
+    // Contadores livres logo antes da volta de 32 bits.
+    q.head = q.tail = UINT32_MAX - 2;
+    uint16_t in[4] = {10, 11, 12, 13}, out[4] = {0};
+    check(spsc_queue_push_n(&q, in, 4) == 4 && spsc_queue_size(&q) == 4 && spsc_queue_free(&q) == 0, "contador_volta_push");
+    check(spsc_queue_pop_n(&q, out, 4) == 4 && out[0] == 10 && out[3] == 13, "contador_volta_pop");
+    check(spsc_queue_size(&q) == 0 && q.head == 1, "contador_volta_tamanho");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    spsc_queue_t* queue;
+    uint32_t total;
+    uint32_t batch;
+    uint32_t errors;
+} transfer_t;
+
+// Produtor: insere a sequência 0, 1, 2... em lotes de `batch`.
+static void* producer(void* arg) {
+    transfer_t* t = (transfer_t*)arg;
+    uint32_t buffer[BENCH_MAX_BATCH];
+    uint32_t next = 0;
+    while (next < t->total) {
+        uint32_t n = t->total - next;
+        if (n > t->batch) n = t->batch;
+        for (uint32_t i = 0; i < n; i++) buffer[i] = next + i;
+        uint32_t pushed = spsc_queue_push_n(t->queue, buffer, n);
+        // Fila cheia: cede a CPU (no host pode haver um único núcleo).
+        if (pushed == 0) sched_yield();
+        next += pushed;
+    }
+    return NULL;
+}
+
+// Consumidor: retira em lotes de `batch` e confere a sequência.
+static void* consumer(void* arg) {
+    transfer_t* t = (transfer_t*)arg;
+    uint32_t buffer[BENCH_MAX_BATCH];
+    uint32_t expected = 0;
+    while (expected < t->total) {
+        uint32_t n = spsc_queue_pop_n(t->queue, buffer, t->batch);
+        if (n == 0) sched_yield();
+        for (uint32_t i = 0; i < n; i++) {
+            if (buffer[i] != expected + i) t->errors++;
+        }
+        expected += n;
+    }
+    return NULL;
+}
+
+// Transfere `total` elementos entre duas threads. Retorna ns decorridos.
+static uint64_t transfer(uint32_t total, uint32_t batch, uint32_t* errors) {
+    static uint32_t storage[BENCH_QUEUE_SIZE];
+    spsc_queue_t q;
+    spsc_queue_init(&q, storage, sizeof(uint32_t), BENCH_QUEUE_SIZE);
+    transfer_t t = { &q, total, batch, 0 };
+
+    pthread_t producer_thread, consumer_thread;
+    uint64_t start = now_ns();
+    pthread_create(&consumer_thread, NULL, consumer, &t);
+    pthread_create(&producer_thread, NULL, producer, &t);
+    pthread_join(producer_thread, NULL);
+    pthread_join(consumer_thread, NULL);
+    uint64_t elapsed = now_ns() - start;
+    *errors = t.errors;
+    return elapsed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    uint32_t millions = BENCH_DEFAULT_MILLIONS;
+    if (argc > 1) millions = (uint32_t)strtoul(argv[1], NULL, 0);
+    if (millions == 0 || millions > 4000) {
+        fprintf(stderr, "quantidade fora da faixa (1 a 4000 milhões)\n");
+        return 2;
+    }
+
+    test_init();
+    test_full_empty();
+    test_wraparound();
+    test_counter_wrap();
+    printf("testes de unidade %s\n", failures ? "FALHOU" : "ok");
+
+    // Estresse entre threads: toda a sequência chega, na ordem.
+    uint32_t errors;
+    transfer(millions * 1000000U, 1, &errors);
+    check(errors == 0, "estresse_threads");
+    printf("estresse elementos=%u erros=%u %s\n", millions * 1000000U, errors, errors ? "FALHOU" : "ok");
+
+    static const uint32_t batches[] = { 1, 16, BENCH_MAX_BATCH };
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        uint32_t total = millions * 1000000U;
+        uint64_t ns = transfer(total, batches[i], &errors);
+        check(errors == 0, "vazao_sequencia");
+        printf("lote=%u elementos=%u melem_s=%.1f ns_elem=%.2f erros=%u\n", batches[i], total,
+               (double)total * 1e3 / (double)ns, (double)ns / (double)total, errors);
+    }
+
+    printf("%s\n", failures ? "FALHOU" : "ok");
+    return failures ? 1 : 0;
+}